@@ -67,6 +67,38 @@ namespace aliLuaCore {
 		 const LuaFn       &luaFn) {
     InternalRun(future, luaFn);
   }
+  void Exec::Run(const FuturePtr           &future,
+		 const LuaFn               &luaFn,
+		 const aliSystem::Time::TP &deadline) {
+    InternalRunDeadline(future, luaFn, deadline);
+  }
+  void Exec::RunBatch(const LuaFnVec &luaFns) {
+    FutureVec futures(luaFns.size());
+    InternalRunBatch(futures, luaFns);
+  }
+  void Exec::RunBatch(const FutureVec &futures,
+		      const LuaFnVec  &luaFns) {
+    THROW_IF(futures.size()!=luaFns.size(),
+	     "Batch has " << futures.size() << " futures for " << luaFns.size() << " functions");
+    InternalRunBatch(futures, luaFns);
+  }
+  void Exec::InternalRunBatch(const FutureVec &futures,
+			      const LuaFnVec  &luaFns) {
+    for (size_t i=0;i<luaFns.size();++i) {
+      InternalRun(futures[i], luaFns[i]);
+    }
+  }
+  void Exec::InternalRunDeadline(const FuturePtr           &future,
+				 const LuaFn               &luaFn,
+				 const aliSystem::Time::TP &deadline) {
+    if (deadline<aliSystem::Time::Now()) {
+      if (future) {
+	future->SetTimeout();
+      }
+    } else {
+      InternalRun(future, luaFn);
+    }
+  }
   Exec::~Exec() {}
 
   std::ostream &operator<<(std::ostream &out, const Exec &o) {
@@ -9,6 +9,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace aliLuaCore {
 
@@ -23,6 +24,7 @@ namespace aliLuaCore {
     using WPtr      = std::weak_ptr<Exec>;                 ///< weak pointer
     using OBJ       = StaticObject<Exec>;                  ///< object accessor
     using FuturePtr = std::shared_ptr<Future>;             ///< future
+    using FutureVec = std::vector<FuturePtr>;              ///< futures
     using Listener  = aliSystem::Listener<const WPtr &>;   ///< exec listener
     using Listeners = aliSystem::Listeners<const WPtr &>;  ///< exec listener collection
 
@@ -94,6 +96,35 @@ namespace aliLuaCore {
     ///       will be run in the background on a separate thread
     ///       after this call returns.
     void Run(const FuturePtr &future, const LuaFn &luaFn);
+
+    /// @brief Run a Lua function that must start by a deadline,
+    ///        retrieving any returned values in a future.
+    /// @param future to catch any returned valued (or error), may be null
+    /// @param luaFn the function to run.
+    /// @param deadline the latest time at which the function may start.
+    ///        If the function is still waiting to run when the deadline
+    ///        passes, it is dropped and the future is set to a timeout
+    ///        (Future::SetTimeout).
+    /// @note Once the function has started it runs to completion, the
+    ///       deadline does not interrupt it.
+    void Run(const FuturePtr &future, const LuaFn &luaFn, const aliSystem::Time::TP &deadline);
+
+    /// @brief Run a batch of Lua functions
+    /// @param luaFns are the functions to run, in order
+    /// @note Equivalent to calling Run for each function, but derived
+    ///       classes may queue the whole batch at once, which is much
+    ///       cheaper when fanning out many small calls.
+    void RunBatch(const LuaFnVec &luaFns);
+
+    /// @brief Run a batch of Lua functions, retrieving any returned
+    ///        values in futures.
+    /// @param futures to catch any returned values (or errors), the
+    ///        i'th future is paired with the i'th function and may be
+    ///        null.
+    /// @param luaFns are the functions to run, in order
+    /// @note Throws an exception if the number of futures and functions
+    ///       differ.
+    void RunBatch(const FutureVec &futures, const LuaFnVec &luaFns);
     
     /// @brief Retrieve a shared pointer to the given exec.
     /// @return a shared pointer
@@ -145,6 +176,30 @@ namespace aliLuaCore {
     ///       within this API.
     virtual void InternalRun(const FuturePtr   &future,
 			     const LuaFn       &luaFn) = 0;
+
+    /// @brief a virtual batch run function.
+    /// @param futures where any errors or returned values
+    ///        should be captured, paired with luaFns (same size).
+    /// @param luaFns the functions to run
+    /// @note The default implementation calls InternalRun for each
+    ///       function.  Derived classes that queue work should override
+    ///       it to queue the batch as a unit.
+    virtual void InternalRunBatch(const FutureVec &futures,
+				  const LuaFnVec  &luaFns);
+
+    /// @brief a virtual run function for calls with a deadline.
+    /// @param future where any error or returned values
+    ///        should be captured, may be null.
+    /// @param luaFn the function to run
+    /// @param deadline the latest time at which luaFn may start
+    /// @note The default implementation only checks the deadline when
+    ///       the call is made: an expired call sets the future to a
+    ///       timeout, any other is passed to InternalRun.  Derived
+    ///       classes that queue work should override it to drop calls
+    ///       that expire while queued.
+    virtual void InternalRunDeadline(const FuturePtr           &future,
+				     const LuaFn               &luaFn,
+				     const aliSystem::Time::TP &deadline);
     
   private:
     std::string              execType;  ///< exec type
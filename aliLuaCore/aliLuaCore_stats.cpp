@@ -3,10 +3,29 @@
 #include <aliLuaCore_functionMap.hpp>
 #include <aliLuaCore_makeTableUtil.hpp>
 #include <aliLuaCore_module.hpp>
+#include <aliLuaCore_table.hpp>
+#include <mutex>
 
 namespace {
 
-  using OBJ = aliLuaCore::Stats::OBJ;
+  using OBJ      = aliLuaCore::Stats::OBJ;
+  using Exporter = aliSystem::StatsExporter;
+
+  // the exporter started from Lua, one per process
+  std::mutex    exporterLock;
+  Exporter::Ptr exporter;
+
+  Exporter::Format GetFormat(const std::string &format) {
+    if (format=="prometheus") { return Exporter::Format::PROMETHEUS; }
+    if (format=="json"      ) { return Exporter::Format::JSON;       }
+    THROW("unknown stats export format '" << format << "', expecting prometheus or json");
+  }
+  // replace the process's exporter, the previous one's thread is stopped
+  // outside the lock.
+  void SetExporter(Exporter::Ptr &ptr) {
+    std::lock_guard<std::mutex> g(exporterLock);
+    exporter.swap(ptr);
+  }
 
   int Create(lua_State *L) {
     const std::string name = aliLuaCore::Values::GetString(L,1);
@@ -25,9 +44,28 @@ namespace {
     return 0;
   }
   
+  int StartExporter(lua_State *L) {
+    std::string path;
+    std::string format;
+    double      period = 0;
+    aliLuaCore::Table::GetString(L,1, "path",   path,   false);
+    aliLuaCore::Table::GetString(L,1, "format", format, true, "prometheus");
+    aliLuaCore::Table::GetDouble(L,1, "period", period, true, 10);
+    Exporter::Ptr ptr = Exporter::Create(path, GetFormat(format), aliSystem::Time::FromSeconds(period));
+    SetExporter(ptr);
+    return 0;
+  }
+  int StopExporter(lua_State *) {
+    Exporter::Ptr ptr;
+    SetExporter(ptr);
+    return 0;
+  }
+
   void Init() {
     aliLuaCore::FunctionMap::Ptr fnMap = aliLuaCore::FunctionMap::Create("stats functions");
-    fnMap->Add("Create", Create);
+    fnMap->Add("Create",        Create);
+    fnMap->Add("StartExporter", StartExporter);
+    fnMap->Add("StopExporter",  StopExporter);
     aliLuaCore::FunctionMap::Ptr mtMap = aliLuaCore::FunctionMap::Create("stats MT");
     mtMap->Add("GetInfo", GetInfo);
     mtMap->Add("Inc",     Inc);
@@ -39,6 +77,8 @@ namespace {
 			     });
   }
   void Fini() {
+    Exporter::Ptr ptr;
+    SetExporter(ptr);
     OBJ::Fini();
   }
   
@@ -58,6 +98,12 @@ namespace aliLuaCore {
     mtu.SetString("name",    ptr->Name());
     mtu.SetNumber("count",   (double)ptr->Count());
     mtu.SetNumber("runTime", aliSystem::Time::ToSeconds(ptr->RunTime()));
+    // percentiles in seconds, read from one merged histogram
+    aliSystem::Histogram latency;
+    ptr->Latencies(latency);
+    mtu.SetNumber("p50",     latency.Percentile(0.5)  /1e9);
+    mtu.SetNumber("p99",     latency.Percentile(0.99) /1e9);
+    mtu.SetNumber("p999",    latency.Percentile(0.999)/1e9);
     return mtu.GetMakeFn();
   }
 
@@ -9,6 +9,11 @@ namespace aliLuaCore {
   /// @brief aliSystem:Stats provides a simple mechanism for tracking usage
   ///        as a number of occurances and a time/use. The aliLuaCore::Stats
   ///        exposes this object to Lua.
+  ///
+  /// Lua scripts can also export every live stats object to a file with
+  /// lib.aliLua.stats.StartExporter{path=..., format='prometheus'|'json',
+  /// period=seconds} (see aliSystem::StatsExporter), which replaces any
+  /// exporter started before, and StopExporter().
   struct Stats {
 
     /// @brief a static object for system stats
@@ -22,7 +27,9 @@ namespace aliLuaCore {
     
     /// @brief a aliSystem::Stats info function
     /// @param ptr the stats pointer to use for generating the info
-    /// @return a MakeFn which builds a of stats information.
+    /// @return a MakeFn which builds a table of stats information: name,
+    ///         count, runTime and the p50, p99 and p999 run times, all
+    ///         times in seconds.
     static MakeFn Info(const aliSystem::Stats::Ptr &ptr);
     
   };
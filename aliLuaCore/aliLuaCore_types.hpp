@@ -21,6 +21,9 @@ namespace aliLuaCore {
   ///        onto the Lua stack.
   using LuaFn     = std::function<int(lua_State*)>;
 
+  /// @brief A vector of LuaFn's.  See LuaFn for more information.
+  using LuaFnVec  = std::vector<LuaFn>;
+
   /// @brief A WrapperFn is a LuaFn function that also has a LuaFn
   ///        as an argument.
   ///
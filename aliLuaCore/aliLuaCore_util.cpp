@@ -41,7 +41,8 @@ namespace {
     FnObject *p = (FnObject*)lua_touserdata(L, lua_upvalueindex(UP_FN_OBJECT_PTR));
     if (p) {
       try {
-	aliSystem::StatsGuard sg(p->Stats());
+	aliSystem::Trace::Span span(p->Stats()->Name(), "lua");
+	aliSystem::StatsGuard  sg(p->Stats(), aliSystem::StatsGuard::Clock::CHEAP);
 	return p->Fn(L);
       } catch (std::exception &e) {
 	lua_pushstring(L, e.what());
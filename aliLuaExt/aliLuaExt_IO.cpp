@@ -36,10 +36,44 @@ namespace {
     out << aliLuaExt::IO(L,opt);
     return aliLuaCore::Values::MakeString(L,out.str());
   }
+  int GetLogLevel(lua_State *L) {
+    std::stringstream ss;
+    ss << aliSystem::Logging::GetLevel();
+    return aliLuaCore::Values::MakeString(L,ss.str());
+  }
+  int SetLogLevel(lua_State *L) {
+    const std::string name = aliLuaCore::Values::GetString(L,1);
+    aliSystem::Logging::SetLevel(aliSystem::Logging::ToLevel(name));
+    return 0;
+  }
+  int StartAsyncLog(lua_State *L) {
+    int         capacity = 4096;
+    std::string overflow = "block";
+    if (!lua_isnil(L,1) && !lua_isnone(L,1)) {
+      THROW_IF(!lua_istable(L,1), "expecting a table of options");
+      aliLuaCore::Table::GetInteger(L, 1, "capacity", capacity, true, capacity);
+      aliLuaCore::Table::GetString (L, 1, "overflow", overflow, true, overflow);
+    }
+    THROW_IF(capacity<=0, "Expecting a positive log ring capacity, not " << capacity);
+    aliSystem::Logging::StartAsync(capacity, aliSystem::Logging::ToOverflow(overflow));
+    return 0;
+  }
+  int StopAsyncLog(lua_State *) {
+    aliSystem::Logging::StopAsync();
+    return 0;
+  }
+  int IsAsyncLog(lua_State *L) {
+    return aliSystem::Logging::IsAsync() ? aliLuaCore::Values::MakeTrue(L) : aliLuaCore::Values::MakeFalse(L);
+  }
   void Init() {
     aliLuaCore::FunctionMap::Ptr fnMap = aliLuaCore::FunctionMap::Create("IO functions");
     fnMap->Add("ToString",    ToString);
     fnMap->Add("Log",         aliLuaExt::IO::Log);
+    fnMap->Add("GetLogLevel", GetLogLevel);
+    fnMap->Add("SetLogLevel", SetLogLevel);
+    fnMap->Add("StartAsyncLog", StartAsyncLog);
+    fnMap->Add("StopAsyncLog",  StopAsyncLog);
+    fnMap->Add("IsAsyncLog",    IsAsyncLog);
     aliLuaCore::Module::Register("load luaIO functions",
 				 [=](const aliLuaCore::Exec::Ptr &ePtr) {
 				   aliLuaCore::Util::LoadFnMap(ePtr, "lib.aliLua.io",  fnMap);
@@ -250,18 +284,22 @@ namespace aliLuaExt {
   }
   
   int IO::Log(lua_State *L) {
-    lua_Debug dbg;
-    IOOptions opt;
+    if (!aliSystem::Logging::IsEnabled(aliSystem::Logging::Level::INFO)) {
+      return 0;
+    }
+    lua_Debug         dbg;
+    IOOptions         opt;
+    std::stringstream ss;
     opt.SetSeparator(" ");
     memset(&dbg, 0, sizeof(lua_Debug));
     int rc = lua_getstack(L,1,&dbg);
     if (rc!=1) {
-      BASE("INFO (<lua>) " << IO(L,opt));
+      ss << "INFO  (<lua>) " << IO(L,opt);
     } else {
       rc = lua_getinfo(L, "nSlL", &dbg);
       lua_pop(L,1);
       if (rc==0) {
-	BASE("INFO (<lua>) " << IO(L,opt));
+	ss << "INFO  (<lua>) " << IO(L,opt);
       } else {
 	const char *src  = dbg.short_src ? dbg.short_src : "?";
 	const char *name = dbg.name;
@@ -270,12 +308,13 @@ namespace aliLuaExt {
 	  src = fwd+1;
 	}
 	if (name) {
-	  BASE("INFO ("<< src << ":" << name << ":" << dbg.currentline  << ") " << IO(L,opt));
+	  ss << "INFO  ("<< src << ":" << name << ":" << dbg.currentline  << ") " << IO(L,opt);
 	} else {
-	  BASE("INFO ("<< src << ":" << dbg.currentline  << ") " << IO(L,opt));
+	  ss << "INFO  ("<< src << ":" << dbg.currentline  << ") " << IO(L,opt);
 	}
       }
     }
+    aliSystem::Logging::Write(ss.str());
     return 0;
   }
 
@@ -19,6 +19,13 @@ namespace aliLuaExt {
   ///
   /// IOOptions provides a means of specializing the behavior of the
   /// IO object.
+  ///
+  /// Besides ToString and Log, lib.aliLua.io lets scripts control
+  /// logging: GetLogLevel and SetLogLevel, and StartAsyncLog,
+  /// StopAsyncLog and IsAsyncLog (see aliSystem::Logging::StartAsync).
+  /// StartAsyncLog takes an optional table of options, capacity (lines
+  /// per thread, 4096 by default) and overflow ('block', the default,
+  /// or 'drop').
   struct IO {
 
     /// @brief Initialize IO module
@@ -33,7 +40,9 @@ namespace aliLuaExt {
     ///
     /// This function primarily targets debugging uses or generic
     /// logging from Lua a call to this function is registered
-    /// for Exec interpreters.
+    /// for Exec interpreters.  The values are logged at
+    /// aliSystem::Logging::Level::INFO, and only formatted if that
+    /// level is enabled (see lib.aliLua.io.SetLogLevel).
     ///
     /// @param L is the Lua State from which values should be logged.
     /// @return This function should always return 0 since it does
@@ -3,6 +3,8 @@
 #include <aliLuaExt_threading.hpp>
 #include <lua.hpp>
 #include <iostream>
+#include <sstream>
+#include <utility>
 
 namespace {
   static std::string engineExecType = "execEngine";
@@ -10,11 +12,27 @@ namespace {
   using QListener  = aliSystem::Threading::Queue::QListener;
   using QListeners = aliSystem::Threading::Queue::QListeners;
   int engineKey;
+  aliSystem::Stats::Ptr stateStats;
 
+  aliSystem::Threading::Worker::Idle GetIdle(const std::string &idle) {
+    if (idle=="spin" ) { return aliSystem::Threading::Worker::Idle::SPIN;  }
+    if (idle=="yield") { return aliSystem::Threading::Worker::Idle::YIELD; }
+    if (idle=="park" ) { return aliSystem::Threading::Worker::Idle::PARK;  }
+    THROW("unknown idle policy '" << idle << "', expecting spin, yield or park");
+  }
   int CreateEngine(lua_State *L) {
     std::string                     name;
+    bool                            pinned = false;
+    std::string                     idle   = "park";
+    int                             cpu    = -1;
     aliSystem::Threading::Pool::Ptr pool;
-    aliLuaCore::Table::GetString (L,1, "name", name, false);
+    aliLuaCore::Table::GetString (L,1, "name",   name,   false);
+    aliLuaCore::Table::GetBool   (L,1, "pinned", pinned, true);
+    if (pinned) {
+      aliLuaCore::Table::GetString (L,1, "idle", idle, true, "park");
+      aliLuaCore::Table::GetInteger(L,1, "cpu",  cpu,  true, -1);
+      return OBJ::Make(L,aliLuaExt::ExecEngine::CreatePinned(name, GetIdle(idle), cpu));
+    }
     aliLuaExt::Threading::PoolOBJ::GetTableValue(L,1,"threadPool", pool, false);
     return OBJ::Make(L,aliLuaExt::ExecEngine::Create(name, pool));
   }
@@ -77,6 +95,7 @@ namespace {
 				   aliLuaCore::Util::LoadFnMap(ePtr, "lib.aliLua.exec",  fnMap);
 				   OBJ::Register(ePtr);
 				 });
+    stateStats = aliSystem::Stats::Create("execEngine state creation");
   }
   void Fini() {
     OBJ::Fini();
@@ -112,7 +131,44 @@ namespace aliLuaExt {
 	aliLuaCore::MakeFn fn =  GetInfo(wRtn.lock());
 	return fn(L);
       });
-    luaL_openlibs(rtn->L);
+    if (pool->GetOptions().GetAffinity()!=aliSystem::Threading::PoolOptions::Affinity::NONE &&
+	!pool->IsPoolThread() && pool->GetNumThreads()>0) {
+      // build the interpreter on one of the pool's threads so its memory
+      // is allocated on their node.
+      // a failure is rethrown here rather than lost on the pool thread.
+      aliSystem::Threading::Work::RunAndWait(stateStats,
+					     [&](aliSystem::Threading::Work::Ptr &&w) { qPtr->AddWork(std::move(w)); },
+					     [&]() { rtn->InitState(); });
+    } else {
+      rtn->InitState();
+    }
+    aliLuaCore::Module::InitEngine(rtn);
+    return rtn;
+  }
+  ExecEngine::Ptr ExecEngine::CreatePinned(const std::string &name,
+					   Worker::Idle       idle,
+					   int                cpu) {
+    Ptr  rtn(new ExecEngine(name));
+    WPtr wRtn = rtn;
+    rtn->THIS   = rtn;
+    rtn->worker = Worker::Create(name, idle, aliSystem::Stats::Create("execEngine worker"), cpu);
+    rtn->onIdle = Listeners::Create(name);
+    rtn->workerListener = Worker::WListener::Create(name+"wListener", [=](const Worker::WPtr &) {
+	Ptr ptr = wRtn.lock();
+	if (ptr) {
+	  ptr->onIdle->Notify(wRtn);
+	}
+      });
+    Worker::WListeners::Register(rtn->worker->OnIdle(), rtn->workerListener, true);
+    rtn->SetInfo("engineInfo", [=](lua_State *L) {
+	aliLuaCore::MakeFn fn =  GetInfo(wRtn.lock());
+	return fn(L);
+      });
+    // build the interpreter on the engine's thread, its heap is then
+    // allocated near, and cached by, the core that will use it.
+    aliSystem::Threading::Work::RunAndWait(stateStats,
+					   [&](aliSystem::Threading::Work::Ptr &&w) { rtn->worker->AddWork(std::move(w)); },
+					   [&]() { rtn->InitState(); });
     aliLuaCore::Module::InitEngine(rtn);
     return rtn;
   }
@@ -130,22 +186,40 @@ namespace aliLuaExt {
     THROW_IF(!ptr, "Uninitialized pointer");
     aliLuaCore::MakeTableUtil tbl;
     tbl.SetString ("name",       ptr->Name());
-    tbl.SetNumber ("numPending", (int)(ptr->queue ? ptr->queue->NumPending() : 0));
+    tbl.SetNumber ("numPending", (int)(ptr->queue  ? ptr->queue->NumPending()  :
+				       ptr->worker ? ptr->worker->NumPending() : 0));
     tbl.SetBoolean("isBusy",     ptr->IsBusy());
     tbl.SetString ("execType",   engineExecType);
+    tbl.SetNumber ("node",       ptr->GetNode());
     tbl.SetMakeFn ("engine",     ExecEngine::OBJ::GetMakeWeakFn(ptr));
+    tbl.SetBoolean("pinned",     bool(ptr->worker));
+    if (ptr->worker) {
+      std::ostringstream idle;
+      idle << ptr->worker->GetIdle();
+      tbl.SetString ("idle",     idle.str());
+      tbl.SetNumber ("cpu",      ptr->worker->GetCpu());
+    }
     return tbl.GetMakeFn();
   }
   aliLuaCore::Exec::Ptr ExecEngine::GetExec() const {
     return THIS.lock();
   }
   bool ExecEngine::IsBusy() const {
-    return queue ? queue->IsBusy() : isBusy;
+    return queue ? queue->IsBusy() : worker ? worker->IsBusy() : isBusy;
   }
   const aliLuaCore::Exec::Listeners::Ptr &ExecEngine::OnIdle() const {
     return onIdle;
   }
+  int ExecEngine::GetNode() const {
+    return node;
+  }
+  const ExecEngine::Worker::Ptr &ExecEngine::GetWorker() const {
+    return worker;
+  }
   ExecEngine::~ExecEngine() {
+    if (worker) {
+      worker->Stop();
+    }
     if (L) {
       std::lock_guard<std::recursive_mutex> g(runLock);
       lua_close(L);
@@ -154,24 +228,38 @@ namespace aliLuaExt {
   }
   ExecEngine::ExecEngine(const std::string &name_)
     : Exec(engineExecType, name_),
-      L(luaL_newstate()) {
+      L(nullptr),
+      node(-1) {
+  }
+  void ExecEngine::InitState() {
+    std::lock_guard<std::recursive_mutex> g(runLock);
+    L    = luaL_newstate();
+    THROW_IF(!L, "Unable to create the Lua state for engine " << Name());
+    node = Pool::CurrentNode();
     lua_checkstack(L,1);
     lua_pushlightuserdata(L,this);
     aliLuaCore::Util::RegistrySet(L, engineKey);
+    luaL_openlibs(L);
   }
   std::ostream &operator<<(std::ostream &out, const ExecEngine &o) {
     return out << "ExecEngine(" << (const aliLuaCore::Exec&)o << ")";
   }
 
+  void ExecEngine::AddWork(aliSystem::Threading::Work::Ptr &&work) {
+    if (queue) {
+      queue->AddWork(std::move(work));
+    } else {
+      worker->AddWork(std::move(work));
+    }
+  }
   void ExecEngine::InternalRun(const aliLuaCore::Future::Ptr &future,
 			       const aliLuaCore::LuaFn       &luaFn) {
-    if (queue) {
-      aliSystem::Threading::Work::Ptr work = ExecEngineWork::Create(Stats(),
-								    THIS,
-								    luaFn,
-								    future,
-								    PrivateRun);
-      queue->AddWork(work);
+    if (queue || worker) {
+      AddWork(ExecEngineWork::Create(Stats(),
+				     THIS,
+				     luaFn,
+				     future,
+				     PrivateRun));
     } else {
       isBusy = true;
       {
@@ -182,11 +270,52 @@ namespace aliLuaExt {
       onIdle->Notify(THIS);
     }
   }
+  void ExecEngine::InternalRunBatch(const FutureVec            &futures,
+				    const aliLuaCore::LuaFnVec &luaFns) {
+    if (queue || worker) {
+      Queue::WorkVec works;
+      works.reserve(luaFns.size());
+      for (size_t i=0;i<luaFns.size();++i) {
+	works.push_back(ExecEngineWork::Create(Stats(),
+					       THIS,
+					       luaFns[i],
+					       futures[i],
+					       PrivateRun));
+      }
+      if (queue) {
+	queue->AddWorkBatch(works);
+      } else {
+	worker->AddWorkBatch(works.data(), works.size());
+      }
+    } else {
+      aliLuaCore::Exec::InternalRunBatch(futures, luaFns);
+    }
+  }
+  void ExecEngine::InternalRunDeadline(const aliLuaCore::Future::Ptr &future,
+				       const aliLuaCore::LuaFn       &luaFn,
+				       const aliSystem::Time::TP     &deadline) {
+    if (queue || worker) {
+      AddWork(ExecEngineWork::Create(Stats(),
+				     THIS,
+				     luaFn,
+				     future,
+				     PrivateRun,
+				     deadline));
+    } else {
+      aliLuaCore::Exec::InternalRunDeadline(future, luaFn, deadline);
+    }
+  }
   void ExecEngine::PrivateRun(const Ptr         &ePtr,
 			      const aliLuaCore::Future::Ptr &future,
 			      const aliLuaCore::LuaFn       &luaFn) {
-    std::lock_guard<std::recursive_mutex> g1(ePtr->runLock);
-    aliLuaCore::StackGuard                            g2(ePtr->L);
+    // a pinned engine's calls all run on its own thread, one at a time
+    std::unique_lock<std::recursive_mutex> g1(ePtr->runLock, std::defer_lock);
+    if (!ePtr->worker) {
+      aliSystem::Trace::Span span("lock", "engine", "engine", ePtr->Name());
+      g1.lock();
+    }
+    aliSystem::Trace::Span                 span("exec", "engine", "engine", ePtr->Name());
+    aliLuaCore::StackGuard                 g2(ePtr->L);
     try {
       luaFn(ePtr->L);
       if (future) {
@@ -25,6 +25,23 @@ namespace aliLuaExt {
   ///
   /// OnIdle noficiations are sent when work completes and there is nothing in
   /// the queue.
+  ///
+  /// When the thread pool pins its threads (see
+  /// aliSystem::Threading::PoolOptions::Affinity), the Lua interpreter is
+  /// created on one of the pool's threads, so its memory is first touched,
+  /// and therefore allocated, on that thread's NUMA node (see GetNode).
+  /// Calls are not bound to that node: any of the pool's threads may run
+  /// them.  With Affinity::SINGLE_NODE or a CPU set within one node every
+  /// thread is local to the interpreter, but with Affinity::SPREAD_NODES
+  /// the interpreter lives on whichever node its creating thread was on
+  /// and calls served from other nodes reach it remotely.  An engine that
+  /// must stay node local should use a single node pool or CreatePinned.
+  ///
+  /// A pinned engine (see CreatePinned) runs on its own dedicated
+  /// aliSystem::Threading::Worker thread instead of a pool queue.  Every
+  /// call, and the creation of the interpreter, happens on that one thread,
+  /// so calls do not take the run lock and the interpreter's heap stays in
+  /// that thread's cache.
   struct ExecEngine : public aliLuaCore::Exec {
     using Ptr       = std::shared_ptr<ExecEngine>;  ///< shared pointer
     using WPtr      = std::weak_ptr<ExecEngine>;    ///< weak pointer
@@ -32,6 +49,7 @@ namespace aliLuaExt {
     using Pool      = aliSystem::Threading::Pool;           ///< Thread pool
     using Queue     = aliSystem::Threading::Queue;              ///< Thread pool's queue
     using QListener = aliSystem::Listener<const Queue::WPtr&>;  ///< Listener
+    using Worker    = aliSystem::Threading::Worker;             ///< Dedicated thread
     /// @brief Initialize hold module
     /// @param cr is a component registry to which any initialzation
     ///        and finalization logic should be registered.
@@ -43,7 +61,24 @@ namespace aliLuaExt {
     ///        troubleshooting will likly be easier if it is.
     /// @param pool is a thread pool through which work should be executed.
     /// @return An ExecEngine pointer
+    /// @note If the pool pins its threads and the caller is not one of them,
+    ///       this waits for one of the pool's threads to create the
+    ///       interpreter.  On a pool spread over several nodes, only that
+    ///       thread's node is local to the interpreter.
     static Ptr Create(const std::string &name, const Pool::Ptr &pool);
+
+    /// @brief CreatePinned will construct an ExecEngine bound to a
+    ///        dedicated thread.
+    /// @param name is the name of the engine.
+    /// @param idle what the engine's thread does while it has no calls
+    ///        to run.
+    /// @param cpu the CPU to pin the engine's thread to, -1 leaves it
+    ///        unpinned.
+    /// @return An ExecEngine pointer
+    /// @note This waits for the engine's thread to create the interpreter.
+    static Ptr CreatePinned(const std::string &name,
+			    Worker::Idle       idle = Worker::Idle::PARK,
+			    int                cpu  = -1);
     
     /// @brief Retrieve the ExecEngine for an arbitrary Lua interpreter.
     /// @param L the Lua state from which the ExecEngine is sought.
@@ -83,6 +118,15 @@ namespace aliLuaExt {
     ///       is public, its possble for external code to trigger OnIdle messages at
     ///       arbitrary points in time.
     const Listeners::Ptr &OnIdle() const override;
+
+    /// @brief retrieve the NUMA node on which the Lua interpreter was created
+    /// @return the node, -1 if it was not created on a pool thread
+    int GetNode() const;
+
+    /// @brief retrieve the engine's dedicated thread
+    /// @return the worker running the engine's calls, null unless the
+    ///         engine was created by CreatePinned
+    const Worker::Ptr &GetWorker() const;
     
     /// @brief destructor
     ~ExecEngine();
@@ -104,6 +148,25 @@ namespace aliLuaExt {
     ///       destroyed, it may never be executed.
     void InternalRun(const aliLuaCore::Future::Ptr &future,
 		     const aliLuaCore::LuaFn       &luaFn) override;
+
+    /// @brief Internal batch run function.  This is called from aliLuaCore::Exec's
+    ///        RunBatch function.
+    /// @param futures are containers for the results of the calls (paired with luaFns).
+    /// @param luaFns are the functions to run.
+    /// @note The whole batch is added to the engine's queue at once.
+    void InternalRunBatch(const FutureVec            &futures,
+			  const aliLuaCore::LuaFnVec &luaFns) override;
+
+    /// @brief Internal run function for calls with a deadline.  This is called
+    ///        from aliLuaCore::Exec's Run function.
+    /// @param future is a container for the results (if any) from the given Lua call.
+    /// @param luaFn is the function to run.
+    /// @param deadline the latest time at which the call may start, the engine's
+    ///        queue drops the call and sets the future to a timeout if it is
+    ///        still queued at that time.
+    void InternalRunDeadline(const aliLuaCore::Future::Ptr &future,
+			     const aliLuaCore::LuaFn       &luaFn,
+			     const aliSystem::Time::TP     &deadline) override;
     
   private:
     /// @brief PrivateRun is an internal helper function that is called when a
@@ -119,14 +182,25 @@ namespace aliLuaExt {
     /// @brief Constructor
     /// @param name is the name of the ExecEngine
     ExecEngine(const std::string &name);
+
+    /// @brief create the Lua interpreter and load the standard libraries,
+    ///        recording the NUMA node of the calling thread.
+    void InitState();
+
+    /// @brief hand a call to the engine's queue or worker
+    /// @param work the call
+    void AddWork(aliSystem::Threading::Work::Ptr &&work);
     
     WPtr                 THIS;          ///< internal "self" pointer
-    std::recursive_mutex runLock;        ///< mutex to prevent concurrent access to L
+    std::recursive_mutex runLock;        ///< mutex to prevent concurrent access to L (unused when pinned)
     lua_State           *L;              ///< Lua State
+    int                  node;           ///< NUMA node L was created on
     Queue::Ptr           queue;          ///< work queue
     bool                 isBusy;         ///< busy flag
     Listeners::Ptr       onIdle;         ///< on idle listener container
     QListener::Ptr       queueListener;  ///< An idle listener for the instance's thread queue
+    Worker::Ptr          worker;         ///< dedicated thread of a pinned engine
+    Worker::WListener::Ptr workerListener; ///< An idle listener for the instance's worker
   };
 
 }
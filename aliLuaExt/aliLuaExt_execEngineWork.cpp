@@ -1,13 +1,13 @@
 #include <aliLuaExt_execEngineWork.hpp>
 
-namespace aliLuaExt {
-    
-  aliSystem::Threading::Work::Ptr ExecEngineWork::Create(const aliSystem::Stats::Ptr       &stats,
-							 const aliLuaExt::ExecEngine::WPtr &wePtr,
-							 const aliLuaCore::LuaFn           &fn,
-							 const aliLuaCore::Future::Ptr     &future,
-							 const RunFn                       &runFn) {
-    aliSystem::Threading::Work::WorkFn workFn = [=](bool &requeue) {
+namespace {
+
+  template<typename RunFnType>
+  aliSystem::Threading::Task MakeTask(const aliLuaExt::ExecEngine::WPtr &wePtr,
+				      const aliLuaCore::LuaFn           &fn,
+				      const aliLuaCore::Future::Ptr     &future,
+				      const RunFnType                   &runFn) {
+    return aliSystem::Threading::Task([=](bool &requeue) {
       requeue = false;
       aliLuaExt::ExecEngine::Ptr ePtr = wePtr.lock();
       if (ePtr) {
@@ -15,8 +15,45 @@ namespace aliLuaExt {
       } else {
 	WARN("Released engine, dropping call");
       }
-    };
-    return aliSystem::Threading::Work::Create(stats, workFn);
+    });
+  }
+
+}
+
+namespace aliLuaExt {
+    
+  aliSystem::Threading::Work::Ptr ExecEngineWork::Create(const aliSystem::Stats::Ptr       &stats,
+							 const aliLuaExt::ExecEngine::WPtr &wePtr,
+							 const aliLuaCore::LuaFn           &fn,
+							 const aliLuaCore::Future::Ptr     &future,
+							 const RunFn                       &runFn) {
+    return aliSystem::Threading::Work::Create(stats, MakeTask(wePtr, fn, future, runFn));
+  }
+  aliSystem::Threading::Work::Ptr ExecEngineWork::Create(const aliSystem::Stats::Ptr       &stats,
+							 const aliLuaExt::ExecEngine::WPtr &wePtr,
+							 const aliLuaCore::LuaFn           &fn,
+							 const aliLuaCore::Future::Ptr     &future,
+							 RunPtr                             runFn) {
+    THROW_IF(!runFn, "Attempt to create engine work without a run function");
+    return aliSystem::Threading::Work::Create(stats, MakeTask(wePtr, fn, future, runFn));
+  }
+  aliSystem::Threading::Work::Ptr ExecEngineWork::Create(const aliSystem::Stats::Ptr       &stats,
+							 const aliLuaExt::ExecEngine::WPtr &wePtr,
+							 const aliLuaCore::LuaFn           &fn,
+							 const aliLuaCore::Future::Ptr     &future,
+							 RunPtr                             runFn,
+							 const aliSystem::Time::TP         &deadline) {
+    THROW_IF(!runFn, "Attempt to create engine work without a run function");
+    aliSystem::Threading::Work::ExpireFn onExpire;
+    if (future) {
+      onExpire = [future]() {
+	if (!future->IsSet()) {
+	  future->SetTimeout();
+	}
+      };
+    }
+    return aliSystem::Threading::Work::Create(stats, MakeTask(wePtr, fn, future, runFn),
+					      deadline, onExpire);
   }
     
 }
@@ -19,6 +19,11 @@ namespace aliLuaExt {
 				     const aliLuaCore::Future::Ptr     &,
 				     const aliLuaCore::LuaFn           &)>;
 
+    /// @brief A plain function form of RunFn.
+    using RunPtr = void (*)(const aliLuaExt::ExecEngine::Ptr  &,
+			    const aliLuaCore::Future::Ptr     &,
+			    const aliLuaCore::LuaFn           &);
+
     /// @brief Construct a work object for insertion into a Thread queue.
     /// @param statsPtr is the object on which execution stats for the call
     ///        will be recorded.
@@ -31,6 +36,40 @@ namespace aliLuaExt {
 						  const aliLuaCore::LuaFn           &fn,
 						  const aliLuaCore::Future::Ptr     &future,
 						  const RunFn                       &runFn);
+
+    /// @brief Construct a work object for insertion into a Thread queue.
+    /// This is the form ExecEngine uses.  The work's task captures the
+    /// function pointer rather than wrapping runFn in a std::function,
+    /// so it fits the task's inline storage and queueing a call does
+    /// not allocate beyond copying fn.
+    /// @param statsPtr is the object on which execution stats for the call
+    ///        will be recorded.
+    /// @param wePtr is a weak pointer to the ExecEngine.
+    /// @param fn is the functor to execute
+    /// @param future is the call's results container
+    /// @param runFn is the function to call when executing a work unit.
+    static aliSystem::Threading::Work::Ptr Create(const aliSystem::Stats::Ptr       &statsPtr,
+						  const aliLuaExt::ExecEngine::WPtr &wePtr,
+						  const aliLuaCore::LuaFn           &fn,
+						  const aliLuaCore::Future::Ptr     &future,
+						  RunPtr                             runFn);
+
+    /// @brief Construct a work object that must start by a deadline.
+    /// If the work is still queued when the deadline passes, the queue
+    /// drops it and the future (if any) is set to a timeout.
+    /// @param statsPtr is the object on which execution stats for the call
+    ///        will be recorded.
+    /// @param wePtr is a weak pointer to the ExecEngine.
+    /// @param fn is the functor to execute
+    /// @param future is the call's results container
+    /// @param runFn is the function to call when executing a work unit.
+    /// @param deadline the latest time at which the work may start
+    static aliSystem::Threading::Work::Ptr Create(const aliSystem::Stats::Ptr       &statsPtr,
+						  const aliLuaExt::ExecEngine::WPtr &wePtr,
+						  const aliLuaCore::LuaFn           &fn,
+						  const aliLuaCore::Future::Ptr     &future,
+						  RunPtr                             runFn,
+						  const aliSystem::Time::TP         &deadline);
   };
 
 }
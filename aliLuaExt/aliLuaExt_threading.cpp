@@ -1,24 +1,95 @@
 #include <aliLuaExt_threading.hpp>
 #include <aliSystem.hpp>
+#include <sstream>
 
 namespace {
 
   using PoolOBJ  = aliLuaExt::Threading::PoolOBJ;
   using QueueOBJ = aliLuaExt::Threading::QueueOBJ;
   using WorkOBJ  = aliLuaExt::Threading::WorkOBJ;
+  using PoolOpt  = aliSystem::Threading::PoolOptions;
+  using Overflow = aliSystem::Threading::Queue::Overflow;
+  using Limiter  = aliSystem::Threading::Limiter;
+
+  Overflow GetOverflow(const std::string &overflow) {
+    if (overflow=="block"      ) { return Overflow::BLOCK;         }
+    if (overflow=="reject"     ) { return Overflow::REJECT;        }
+    if (overflow=="dropOldest" ) { return Overflow::DROP_OLDEST;   }
+    if (overflow=="runOnCaller") { return Overflow::RUN_ON_CALLER; }
+    THROW("unknown overflow policy '" << overflow
+	  << "', expecting block, reject, dropOldest or runOnCaller");
+  }
+
+  Limiter::Algorithm GetAlgorithm(const std::string &algorithm) {
+    if (algorithm=="aimd"    ) { return Limiter::Algorithm::AIMD;     }
+    if (algorithm=="gradient") { return Limiter::Algorithm::GRADIENT; }
+    THROW("unknown limiter algorithm '" << algorithm << "', expecting aimd or gradient");
+  }
 
   // ****************************************************************************************
   // Threading pool
   int Pool_Create(lua_State *L) {
     std::string           name;
-    int                   numThreads = 0;
+    int                   numThreads   = 0;
+    bool                  workStealing = false;
+    bool                  weightedFair = false;
+    bool                  spreadNodes  = false;
+    std::string           cpus;
+    int                   node         = -1;
+    int                   minThreads   = 0;
+    int                   maxThreads   = 0;
+    double                idleTimeout  = 0;
+    double                spinBudget   = 0;
     aliSystem::Stats::Ptr stats;
-    aliLuaCore::Table::GetString       (L, 1, "name",       name,       false);
-    aliLuaCore::Table::GetInteger      (L, 1, "numThreads", numThreads, false);
+    PoolOpt               opt;
+    aliLuaCore::Table::GetString       (L, 1, "name",         name,         false);
+    aliLuaCore::Table::GetInteger      (L, 1, "numThreads",   numThreads,   false);
+    aliLuaCore::Table::GetBool         (L, 1, "workStealing", workStealing, true);
+    aliLuaCore::Table::GetBool         (L, 1, "weightedFair", weightedFair, true);
+    aliLuaCore::Table::GetBool         (L, 1, "spreadNodes",  spreadNodes,  true);
+    aliLuaCore::Table::GetString       (L, 1, "cpus",         cpus,         true);
+    aliLuaCore::Table::GetInteger      (L, 1, "node",         node,         true, -1);
+    aliLuaCore::Table::GetInteger      (L, 1, "minThreads",   minThreads,   true);
+    aliLuaCore::Table::GetInteger      (L, 1, "maxThreads",   maxThreads,   true);
+    aliLuaCore::Table::GetDouble       (L, 1, "idleTimeout",  idleTimeout,  true);
+    aliLuaCore::Table::GetDouble       (L, 1, "spinBudget",   spinBudget,   true);
     aliLuaCore::Stats::OBJ::GetTableValue(L, 1, "stats", stats, true);
     THROW_IF(numThreads<0,
 	     "numThreads must be greater than or equal to zero, passed " << numThreads);
-    PoolOBJ::TPtr ptr = aliSystem::Threading::Pool::Create(name,numThreads, stats);
+    THROW_IF(workStealing && weightedFair,
+	     "workStealing and weightedFair are exclusive scheduling options");
+    if (workStealing) {
+      opt.SetScheduling(PoolOpt::Scheduling::WORK_STEALING);
+    }
+    if (weightedFair) {
+      opt.SetScheduling(PoolOpt::Scheduling::WEIGHTED_FAIR);
+    }
+    THROW_IF(int(spreadNodes) + int(!cpus.empty()) + int(node>=0) > 1,
+	     "spreadNodes, cpus and node are exclusive affinity options");
+    if (spreadNodes) {
+      opt.SetAffinity(PoolOpt::Affinity::SPREAD_NODES);
+    }
+    if (!cpus.empty()) {
+      aliSystem::Threading::Topology::CpuVec cpuVec;
+      aliSystem::Threading::Topology::ParseCpuList(cpus, cpuVec);
+      opt.SetAffinity(PoolOpt::Affinity::CPU_SET);
+      opt.SetCpus(cpuVec);
+    }
+    if (node>=0) {
+      opt.SetAffinity(PoolOpt::Affinity::SINGLE_NODE);
+      opt.SetNode(node);
+    }
+    THROW_IF(minThreads<0 || maxThreads<0,
+	     "minThreads and maxThreads must be greater than or equal to zero");
+    if (maxThreads>0) {
+      opt.SetAutoScale(minThreads, maxThreads);
+      if (idleTimeout>0) {
+	opt.SetIdleTimeout(aliSystem::Time::FromSeconds(idleTimeout));
+      }
+    }
+    THROW_IF(spinBudget<0, "spinBudget must be greater than or equal to zero");
+    opt.SetSpinBudget(aliSystem::Time::FromSeconds(spinBudget));
+    PoolOBJ::TPtr ptr = aliSystem::Threading::Pool::Create(name,numThreads, stats, opt);
     return PoolOBJ::Make(L, ptr);
   }
   int Pool_Flush(lua_State *L) {
@@ -39,22 +110,73 @@ namespace {
     return 0;
   }
   int Pool_GetInfo(lua_State *L) {
-    PoolOBJ::TPtr                  ptr = PoolOBJ::Get(L,1,false);
-    aliLuaCore::MakeTableUtil      rtn;
+    PoolOBJ::TPtr                    ptr = PoolOBJ::Get(L,1,false);
+    aliLuaCore::MakeTableUtil        rtn;
+    aliLuaCore::MakeTableUtil        shares;
+    aliLuaCore::MakeTableUtil        nodes;
+    aliSystem::Threading::Pool::QVec queues;
+    aliSystem::Threading::Pool::NodeMap nodeMap;
+    uint64_t                         total = 0;
+    ptr->GetQueues(queues);
+    ptr->GetThreadNodes(nodeMap);
+    for (aliSystem::Threading::Pool::NodeMap::const_iterator it=nodeMap.begin(); it!=nodeMap.end(); ++it) {
+      nodes.SetNumberForIndex(it->first, (int)it->second);
+    }
+    for (size_t i=0;i<queues.size();++i) {
+      total += queues[i]->NumDispatched();
+    }
+    for (size_t i=0;i<queues.size();++i) {
+      aliLuaCore::MakeTableUtil share;
+      uint64_t                  dispatched = queues[i]->NumDispatched();
+      share.SetString("name",       queues[i]->Name());
+      share.SetNumber("weight",     (int)queues[i]->GetWeight());
+      share.SetNumber("priority",   (int)queues[i]->GetPriority());
+      share.SetNumber("dispatched", (double)dispatched);
+      share.SetNumber("share",      total ? double(dispatched)/total : 0.0);
+      shares.SetMakeFnForIndex(i+1, share.GetMakeFn());
+    }
     rtn.SetString("name",       ptr->Name());
     rtn.SetNumber("numThreads", (int)ptr->GetNumThreads());
+    rtn.SetBoolean("workStealing",
+		   ptr->GetOptions().GetScheduling()==PoolOpt::Scheduling::WORK_STEALING);
+    rtn.SetBoolean("weightedFair",
+		   ptr->GetOptions().GetScheduling()==PoolOpt::Scheduling::WEIGHTED_FAIR);
     rtn.SetMakeFn("stats",      aliLuaCore::Stats::OBJ::GetMakeFn(ptr->GetStats()));
+    rtn.SetMakeFn("shares",     shares.GetMakeFn());
+    std::ostringstream affinity;
+    affinity << ptr->GetOptions().GetAffinity();
+    rtn.SetString("affinity",   affinity.str());
+    rtn.SetMakeFn("nodes",      nodes.GetMakeFn());
+    rtn.SetBoolean("autoScale", ptr->GetOptions().IsAutoScale());
+    rtn.SetNumber("minThreads", (int)ptr->GetOptions().GetMinThreads());
+    rtn.SetNumber("maxThreads", (int)ptr->GetOptions().GetMaxThreads());
+    rtn.SetNumber("numIdle",    (int)ptr->GetNumIdle());
+    rtn.SetNumber("spinBudget", aliSystem::Time::ToSeconds(ptr->GetOptions().GetSpinBudget()));
+    rtn.SetMakeFn("growStats",  aliLuaCore::Stats::OBJ::GetMakeFn(ptr->GetGrowStats()));
+    rtn.SetMakeFn("shrinkStats", aliLuaCore::Stats::OBJ::GetMakeFn(ptr->GetShrinkStats()));
     return rtn.GetMakeFn()(L);
   }
   int Pool_AddQueue(lua_State *L) {
     std::string           queueName;
     int                   maxConcurrency;
+    int                   weight   = 1;
+    int                   priority = 0;
+    int                   capacity = 0;
+    std::string           overflow = "block";
     aliSystem::Stats::Ptr stats;
     PoolOBJ::TPtr             ptr = PoolOBJ::Get(L,1,false);
     aliLuaCore::Table::GetString       (L, 2, "queueName",      queueName,      false);
     aliLuaCore::Table::GetInteger      (L, 2, "maxConcurrency", maxConcurrency, false);
+    aliLuaCore::Table::GetInteger      (L, 2, "weight",         weight,         true, 1);
+    aliLuaCore::Table::GetInteger      (L, 2, "priority",       priority,       true);
+    aliLuaCore::Table::GetInteger      (L, 2, "capacity",       capacity,       true);
+    aliLuaCore::Table::GetString       (L, 2, "overflow",       overflow,       true, "block");
     aliLuaCore::Stats::OBJ::GetTableValue(L, 2, "stats",          stats,          false);
-    QueueOBJ::TPtr     queue = ptr->AddQueue(queueName, maxConcurrency, stats);
+    THROW_IF(weight<1,   "weight must be greater than zero, passed " << weight);
+    THROW_IF(priority<0, "priority must be greater than or equal to zero, passed " << priority);
+    THROW_IF(capacity<0, "capacity must be greater than or equal to zero, passed " << capacity);
+    QueueOBJ::TPtr     queue = ptr->AddQueue(queueName, maxConcurrency, stats, weight, priority,
+					     capacity, GetOverflow(overflow));
     return QueueOBJ::Make(L,queue);;
   }
 
@@ -72,6 +194,37 @@ namespace {
     rtn.SetNumber ("currentConcurrency", (int)ptr->CurrentConcurrency());
     rtn.SetNumber ("maxConcurrency",     (int)ptr->GetMaxConcurrency());
     rtn.SetNumber ("numberPending",      (int)ptr->NumPending());
+    rtn.SetNumber ("weight",             (int)ptr->GetWeight());
+    rtn.SetNumber ("priority",           (int)ptr->GetPriority());
+    rtn.SetNumber ("dispatched",      (double)ptr->NumDispatched());
+    rtn.SetNumber ("capacity",           (int)ptr->GetCapacity());
+    rtn.SetNumber ("highWaterMark",      (int)ptr->GetHighWaterMark());
+    rtn.SetNumber ("rejected",        (double)ptr->NumRejected());
+    rtn.SetNumber ("dropped",         (double)ptr->NumDropped());
+    rtn.SetNumber ("ranOnCaller",     (double)ptr->NumRanOnCaller());
+    rtn.SetNumber ("blocked",         (double)ptr->NumBlocked());
+    rtn.SetNumber ("expired",         (double)ptr->NumExpired());
+    rtn.SetNumber ("activeKeys",         (int)ptr->NumActiveKeys());
+    Limiter::Ptr limiter = ptr->GetLimiter();
+    if (limiter) {
+      aliLuaCore::MakeTableUtil adaptive;
+      std::ostringstream        algorithm;
+      algorithm << limiter->GetAlgorithm();
+      adaptive.SetString("algorithm",         algorithm.str());
+      adaptive.SetNumber("limit",          (int)limiter->GetLimit());
+      adaptive.SetNumber("minConcurrency", (int)limiter->GetMinLimit());
+      adaptive.SetNumber("maxConcurrency", (int)limiter->GetMaxLimit());
+      adaptive.SetNumber("window",         (int)limiter->GetWindow());
+      adaptive.SetNumber("tolerance",           limiter->GetTolerance());
+      adaptive.SetNumber("backoff",             limiter->GetBackoff());
+      adaptive.SetNumber("latency",             aliSystem::Time::ToSeconds(limiter->GetLatency()));
+      adaptive.SetNumber("baseline",            aliSystem::Time::ToSeconds(limiter->GetBaseline()));
+      adaptive.SetNumber("updates",     (double)limiter->NumUpdates());
+      rtn.SetMakeFn("adaptive", adaptive.GetMakeFn());
+    }
+    std::ostringstream overflow;
+    overflow << ptr->GetOverflow();
+    rtn.SetString ("overflow",                overflow.str());
     return rtn.GetMakeFn()(L);
   }
   int Queue_Freeze(lua_State *L) {
@@ -85,12 +238,67 @@ namespace {
     queue->SetMaxConcurrency(val);
     return 0;
   }
+  int Queue_SetCapacity(lua_State *L) {
+    QueueOBJ::TPtr queue    = QueueOBJ::Get(L,1,false);
+    int            capacity = lua_tointeger(L,2);
+    std::string    overflow = lua_isstring(L,3) ? lua_tostring(L,3) : "block";
+    THROW_IF(capacity<0, "capacity must be greater than or equal to zero, passed " << capacity);
+    queue->SetCapacity(capacity, GetOverflow(overflow));
+    return 0;
+  }
+  int Queue_SetAdaptiveConcurrency(lua_State *L) {
+    QueueOBJ::TPtr queue = QueueOBJ::Get(L,1,false);
+    if (!lua_istable(L,2)) {
+      queue->SetAdaptiveConcurrency(Limiter::Ptr());
+      return 0;
+    }
+    std::string algorithm;
+    int         minConcurrency = 1;
+    int         maxConcurrency;
+    int         window         = 0;
+    double      tolerance      = 0;
+    double      backoff        = 0;
+    aliLuaCore::Table::GetString (L, 2, "algorithm",      algorithm,      true, "aimd");
+    aliLuaCore::Table::GetInteger(L, 2, "minConcurrency", minConcurrency, true, 1);
+    aliLuaCore::Table::GetInteger(L, 2, "maxConcurrency", maxConcurrency, false);
+    aliLuaCore::Table::GetInteger(L, 2, "window",         window,         true);
+    aliLuaCore::Table::GetDouble (L, 2, "tolerance",      tolerance,      true);
+    aliLuaCore::Table::GetDouble (L, 2, "backoff",        backoff,        true);
+    THROW_IF(minConcurrency<1,              "minConcurrency must be at least 1, passed " << minConcurrency);
+    THROW_IF(maxConcurrency<minConcurrency, "maxConcurrency must be at least minConcurrency, passed " << maxConcurrency);
+    Limiter::Ptr limiter = Limiter::Create(GetAlgorithm(algorithm), minConcurrency, maxConcurrency,
+					   queue->GetMaxConcurrency());
+    if (window>0)    { limiter->SetWindow(window);       }
+    if (tolerance>0) { limiter->SetTolerance(tolerance); }
+    if (backoff>0)   { limiter->SetBackoff(backoff);     }
+    queue->SetAdaptiveConcurrency(limiter);
+    return 0;
+  }
+  int Queue_ResetHighWaterMark(lua_State *L) {
+    QueueOBJ::TPtr queue = QueueOBJ::Get(L,1,false);
+    queue->ResetHighWaterMark();
+    return 0;
+  }
   int Queue_AddWork(lua_State *L) {
     QueueOBJ::TPtr     queue = QueueOBJ::Get(L,1,false);
     WorkOBJ::TPtr work  = WorkOBJ::Get(L,2,false);
     queue->AddWork(work);
     return 0;
   }
+  int Queue_AddWorkBatch(lua_State *L) {
+    QueueOBJ::TPtr                       queue = QueueOBJ::Get(L,1,false);
+    aliSystem::Threading::Queue::WorkVec works;
+    THROW_IF(!lua_istable(L,2), "Expecting a table of work units");
+    size_t num = lua_rawlen(L,2);
+    works.reserve(num);
+    for (size_t i=1;i<=num;++i) {
+      WorkOBJ::TPtr work;
+      WorkOBJ::GetTableIndex(L, 2, i, work, false);
+      works.push_back(work);
+    }
+    queue->AddWorkBatch(works);
+    return 0;
+  }
   int Queue_Stop(lua_State *L) {
     QueueOBJ::TPtr queue = QueueOBJ::Get(L,1,false);
     queue->Stop();
@@ -121,6 +329,9 @@ namespace {
     WorkOBJ::TPtr         ptr = WorkOBJ::Get(L,1,false);
     aliLuaCore::MakeTableUtil rtn;
     rtn.SetMakeFn("stats", aliLuaCore::Stats::OBJ::GetMakeFn(ptr->GetStats()));
+    if (ptr->HasKey()) {
+      rtn.SetNumber("key", (double)ptr->GetKey());
+    }
     return rtn.GetMakeFn()(L);
   }
   
@@ -139,7 +350,11 @@ namespace {
     queue_mtMap->Add("GetInfo",           Queue_GetInfo);
     queue_mtMap->Add("Freeze",            Queue_Freeze);
     queue_mtMap->Add("SetMaxConcurrency", Queue_SetMaxConcurrency);
+    queue_mtMap->Add("SetCapacity",       Queue_SetCapacity);
+    queue_mtMap->Add("ResetHighWaterMark", Queue_ResetHighWaterMark);
+    queue_mtMap->Add("SetAdaptiveConcurrency", Queue_SetAdaptiveConcurrency);
     queue_mtMap->Add("AddWork",           Queue_AddWork);
+    queue_mtMap->Add("AddWorkBatch",      Queue_AddWorkBatch);
     queue_mtMap->Add("Stop",              Queue_Stop);
     queue_mtMap->Add("StopAfter",         Queue_StopAfter);
     queue_mtMap->Add("Start",             Queue_Start);
@@ -145,7 +145,16 @@ namespace aliLuaExt2 {
 					 [=] (bool &) {
 					   OnTimeout(wPtr);
 					 });
-    aliSystem::Threading::Scheduler::Schedule(utcTimeout, timeoutWork);
+    aliSystem::Threading::Scheduler::Timer timer =
+      aliSystem::Threading::Scheduler::Schedule(utcTimeout, timeoutWork);
+    if (true) {
+      std::lock_guard<std::mutex> g(rtn->lock);
+      if (rtn->hasRun) {
+	timer.Cancel(); // finished before the timeout was even scheduled
+      } else {
+	rtn->timeoutTimer = timer;
+      }
+    }
     return rtn;
   }
   const std::string                 &Action::GetName  () const { return name;   }
@@ -176,6 +185,7 @@ namespace aliLuaExt2 {
     std::lock_guard<std::mutex> g(lock);
     if (!hasRun) {
       hasRun = true;
+      timeoutTimer.Cancel();
       result->SetTimeout();
     }
   }
@@ -183,6 +193,7 @@ namespace aliLuaExt2 {
     std::lock_guard<std::mutex> g(lock);
     if (!hasRun) {
       hasRun = true;
+      timeoutTimer.Cancel();
       result->SetError(err);
     }
   }
@@ -190,6 +201,7 @@ namespace aliLuaExt2 {
     std::lock_guard<std::mutex> g(lock);
     if (!hasRun && IsReady()) {
       hasRun = true; // prevent double queuing
+      timeoutTimer.Cancel();
       target->Run(exec, result, args);
     }
   }
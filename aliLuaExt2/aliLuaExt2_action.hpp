@@ -67,6 +67,8 @@ namespace aliLuaExt2 {
     ///        timed out.
     /// @return A pointer to a new Action object.
     /// @note The target will only be called if the timeout has not triggered.
+    /// @note The scheduled timeout is cancelled as soon as the action runs,
+    ///       errors or times out, so it does not linger until utcTimeout.
     static Ptr Create(const std::string                 &name,
 		      const aliLuaCore::CallTarget::Ptr &target,
 		      const aliLuaCore::Exec::Ptr       &exec,
@@ -161,6 +163,7 @@ namespace aliLuaExt2 {
     aliLuaCore::Future::Ptr     result;         ///< Action's result
     DepVec                      dependencies;   ///< Action's dependencies
     bool                        hasRun;         ///< Action's execution status flag
+    aliSystem::Threading::Scheduler::Timer timeoutTimer; ///< pending timeout, cancelled once the action has run
   };
     
 }
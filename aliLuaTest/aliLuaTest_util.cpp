@@ -1,10 +1,17 @@
 #include <aliLuaTest_util.hpp>
 #include <aliSystem.hpp>
+#include <chrono>
 #include <lua.hpp>
 #include <unistd.h>
 
 namespace {
   namespace locals {
+
+    // how long Wait waits for a future before giving up
+    const std::chrono::seconds WAIT_LIMIT(10);
+
+    // round trips through the engine Wait makes without a future
+    const int DRAIN_ROUNDS = 10;
     
     int Sleep(lua_State *L) {
       double delayInSeconds = lua_tonumber(L,1);
@@ -33,12 +40,20 @@ namespace aliLuaTest {
     return rtn;
   }
   void Util::Wait(const aliLuaCore::Exec::Ptr &exec, const aliLuaCore::Future::Ptr &fPtr) {
-    aliSystem::Threading::Semaphore::Ptr sem(new aliSystem::Threading::Semaphore);
-    for (int i=0; i<100; ++i) {
-      if (fPtr && fPtr->IsSet()) {
-	break;
+    using Semaphore = aliSystem::Threading::Semaphore;
+    using FL        = aliSystem::Listeners<aliLuaCore::Future*>;
+    Semaphore::Ptr sem(new Semaphore);
+    if (fPtr) {
+      // woken by the future itself, the listener is dropped on return
+      FL::LPtr lPtr = FL::Register(fPtr->OnSet(), "aliLuaTest::Util::Wait",
+				   [=](aliLuaCore::Future *) { sem->Post(); }, true);
+      if (!fPtr->IsSet()) {
+	sem->TimedWait(locals::WAIT_LIMIT);
       }
-      usleep(1000);
+      return;
+    }
+    // without a future, let the work already given to the engine drain
+    for (int i=0; i<locals::DRAIN_ROUNDS; ++i) {
       exec->Run([=](lua_State *) {
 	  sem->Post();
 	  return 0;
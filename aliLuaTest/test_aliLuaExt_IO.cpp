@@ -342,3 +342,46 @@ TEST(aliLuaExtIO, scriptLog) {
   ASSERT_FALSE(fPtr->IsError());
 }
 
+TEST(aliLuaExtIO, scriptLogLevel) {
+  const std::string name = "Lua IO - scriptLogLevel";
+  Pool::Ptr         pool = Pool::Create(name, 1);
+  ExecEngine::Ptr   exec = ExecEngine::Create(name, pool);
+  Future::Ptr       fPtr = Future::Create();
+  Util::LoadString(exec, fPtr,
+		   "-- ioTest scriptLogLevel"
+		   "\n local io = lib.aliLua.io"
+		   "\n assert(io.GetLogLevel()=='info', 'unexpected default level '..io.GetLogLevel())"
+		   "\n io.SetLogLevel('warn')"
+		   "\n assert(io.GetLogLevel()=='warn', 'level not set')"
+		   "\n io.Log('not logged')"
+		   "\n io.SetLogLevel('info')"
+		   "\n assert(not pcall(io.SetLogLevel, 'loud'), 'accepted a bad level')");
+  TestUtil::Wait(exec,fPtr);
+  ASSERT_TRUE(fPtr->IsSet());
+  ASSERT_FALSE(fPtr->IsError()) << fPtr->GetError();
+  ASSERT_EQ(aliSystem::Logging::GetLevel(), aliSystem::Logging::Level::INFO);
+}
+
+TEST(aliLuaExtIO, scriptAsyncLog) {
+  const std::string name = "Lua IO - scriptAsyncLog";
+  Pool::Ptr         pool = Pool::Create(name, 1);
+  ExecEngine::Ptr   exec = ExecEngine::Create(name, pool);
+  Future::Ptr       fPtr = Future::Create();
+  Util::LoadString(exec, fPtr,
+		   "-- ioTest scriptAsyncLog"
+		   "\n local io = lib.aliLua.io"
+		   "\n assert(not io.IsAsyncLog(), 'async by default')"
+		   "\n io.StartAsyncLog{capacity=128, overflow='drop'}"
+		   "\n assert(io.IsAsyncLog(), 'not started')"
+		   "\n io.Log('logged from the writer thread')"
+		   "\n io.StopAsyncLog()"
+		   "\n assert(not io.IsAsyncLog(), 'not stopped')"
+		   "\n io.StartAsyncLog()"
+		   "\n io.StopAsyncLog()"
+		   "\n assert(not pcall(io.StartAsyncLog, {overflow='spill'}), 'accepted a bad overflow')"
+		   "\n assert(not pcall(io.StartAsyncLog, {capacity=0}), 'accepted an empty ring')");
+  TestUtil::Wait(exec,fPtr);
+  ASSERT_TRUE(fPtr->IsSet());
+  ASSERT_FALSE(fPtr->IsError()) << fPtr->GetError();
+  ASSERT_FALSE(aliSystem::Logging::IsAsync());
+}
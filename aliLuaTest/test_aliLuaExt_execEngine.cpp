@@ -63,6 +63,24 @@ TEST(aliLuaExtExecEngine, general) {
   ASSERT_FALSE(fPtr->IsError()) << fPtr->GetError();
 }
 
+TEST(aliLuaExtExecEngine, nodePlacement) {
+  using Opt = aliSystem::Threading::PoolOptions;
+  Opt opt;
+  opt.SetAffinity(Opt::Affinity::SINGLE_NODE);
+  opt.SetNode(0);
+  Pool::Ptr       plain  = Pool::Create("unpinned engine pool", 1);
+  Pool::Ptr       pinned = Pool::Create("pinned engine pool", 1, nullptr, opt);
+  ExecEngine::Ptr engine = ExecEngine::Create("unpinned engine", plain);
+  ASSERT_EQ(engine->GetNode(), -1) << "created off the pool";
+  engine = ExecEngine::Create("pinned engine", pinned);
+  ASSERT_EQ(engine->GetNode(), 0) << "should be created on the pool's node";
+  Future::Ptr fPtr = Future::Create();
+  Util::LoadString(engine, fPtr, "return 1+1");
+  TestUtil::Wait(engine, fPtr);
+  ASSERT_TRUE(fPtr->IsSet());
+  ASSERT_FALSE(fPtr->IsError()) << fPtr->GetError();
+}
+
 TEST(aliLuaExtExecEngine, onIdle) {
   const std::string name   = "my engine";
   Pool::Ptr         pool   = Pool::Create("engine pool", 2);
@@ -92,6 +110,106 @@ TEST(aliLuaExtExecEngine, onIdle) {
   }
 }
 
+TEST(aliLuaExtExecEngine, runBatch) {
+  const size_t         num    = 100;
+  Pool::Ptr            pool   = Pool::Create("engine pool", 2);
+  ExecEngine::Ptr      engine = ExecEngine::Create("batch engine", pool);
+  Exec::FutureVec      futures;
+  aliLuaCore::LuaFnVec luaFns;
+  for (size_t i=0;i<num;++i) {
+    futures.push_back(Future::Create());
+    luaFns.push_back([=](lua_State *L) {
+	lua_pushinteger(L, i);
+	return 1;
+      });
+  }
+  engine->RunBatch(futures, luaFns);
+  TestUtil::Wait(engine, futures.back());
+  for (size_t i=0;i<num;++i) {
+    ASSERT_TRUE(futures[i]->IsSet());
+    ASSERT_FALSE(futures[i]->IsError()) << futures[i]->GetError();
+  }
+  futures.pop_back();
+  ASSERT_THROW(engine->RunBatch(futures, luaFns), std::exception);
+}
+
+TEST(aliLuaExtExecEngine, pinned) {
+  const size_t         num    = 50;
+  ExecEngine::Ptr      engine = ExecEngine::CreatePinned("pinned engine",
+							 aliSystem::Threading::Worker::Idle::YIELD);
+  IPtr                 offThread(new int(0));
+  Exec::FutureVec      futures;
+  aliLuaCore::LuaFnVec luaFns;
+  ASSERT_TRUE(engine->GetWorker());
+  for (size_t i=0;i<num;++i) {
+    futures.push_back(Future::Create());
+    luaFns.push_back([=](lua_State *L) {
+	if (!engine->GetWorker()->IsWorkerThread()) {
+	  ++(*offThread);
+	}
+	lua_pushinteger(L, i);
+	return 1;
+      });
+  }
+  engine->RunBatch(futures, luaFns);
+  TestUtil::Wait(engine, futures.back());
+  for (size_t i=0;i<num;++i) {
+    ASSERT_TRUE(futures[i]->IsSet());
+    ASSERT_FALSE(futures[i]->IsError()) << futures[i]->GetError();
+  }
+  ASSERT_EQ(*offThread, 0) << "a call ran off the engine's thread";
+  Future::Ptr fPtr = Future::Create();
+  Util::LoadString(engine, fPtr,
+		   "\n local info = lib.aliLua.exec.GetEngine():GetInfo().engineInfo"
+		   "\n assert(info.pinned == true, 'engine is not pinned')"
+		   "\n assert(info.idle == 'yield', 'bad idle policy ' .. tostring(info.idle))"
+		   "\n assert(info.cpu == -1, 'engine should not be pinned to a cpu')"
+		   "\n");
+  TestUtil::Wait(engine, fPtr);
+  ASSERT_TRUE(fPtr->IsSet());
+  ASSERT_FALSE(fPtr->IsError()) << fPtr->GetError();
+  while (engine->IsBusy()) {
+    usleep(100);
+  }
+  engine.reset();
+}
+
+TEST(aliLuaExtExecEngine, deadline) {
+  using Time = aliSystem::Time;
+  Pool::Ptr       pool    = Pool::Create("engine pool", 1);
+  ExecEngine::Ptr engine  = ExecEngine::Create("deadline engine", pool);
+  Future::Ptr     blocker = Future::Create();
+  Future::Ptr     late    = Future::Create();
+  Future::Ptr     onTime  = Future::Create();
+  BPtr            ran(new bool(false));
+  // hold the engine past the first call's deadline
+  engine->Run(blocker, [](lua_State *) {
+      usleep(50000);
+      return 0;
+    });
+  engine->Run(late, [=](lua_State *) {
+      *ran = true;
+      return 0;
+    }, Time::Now()+std::chrono::milliseconds(10));
+  engine->Run(onTime, [](lua_State *) { return 0; },
+	      Time::Now()+std::chrono::seconds(60));
+  TestUtil::Wait(engine, onTime);
+  ASSERT_TRUE(late->IsSet());
+  ASSERT_TRUE(late->IsError());
+  ASSERT_EQ(late->GetError(), "timeout");
+  ASSERT_FALSE(*ran) << "expired call was run";
+  ASSERT_FALSE(onTime->IsError()) << onTime->GetError();
+  // a call whose deadline has already passed never runs
+  Future::Ptr past = Future::Create();
+  engine->Run(past, [=](lua_State *) {
+      *ran = true;
+      return 0;
+    }, Time::Now()-std::chrono::seconds(1));
+  TestUtil::Wait(engine, past);
+  ASSERT_EQ(past->GetError(), "timeout");
+  ASSERT_FALSE(*ran);
+}
+
 TEST(aliLuaExtExecEngine, scriptInterface) {
   std::string     name   = "myExecEngine";
   Pool::Ptr       pool   = Pool::Create(name, 1);
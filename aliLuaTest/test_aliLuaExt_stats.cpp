@@ -3,6 +3,10 @@
 #include <aliLuaExt.hpp>
 #include <aliSystem.hpp>
 #include <aliLuaTest_util.hpp>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
 
 namespace {
   
@@ -30,6 +34,8 @@ TEST(aliLuaCoreStats, statsInfo) {
   lua_getfield(L,1,"runTime");
   ASSERT_EQ(1,lua_tointeger(L,2)) << "verify count";
   ASSERT_EQ(5,lua_tointeger(L,3)) << "verify runTime";
+  lua_getfield(L,1,"p99");
+  ASSERT_NEAR(5,lua_tonumber(L,4),5.0/8) << "verify p99";
 }
 
 TEST(aliLuaCoreStats, scriptInterface) {
@@ -53,8 +59,42 @@ TEST(aliLuaCoreStats, scriptInterface) {
 		   "\n Verify(stats, name, 1, 3.4)"
 		   "\n stats:Inc(1.9)"
 		   "\n Verify(stats, name, 2, 3.4+1.9)"
+		   "\n for i=1,98 do stats:Inc(0.001) end"
+		   "\n local info = stats:GetInfo()"
+		   "\n assert(math.abs(info.p50-0.001) < 0.001/8, 'bad p50 '..info.p50)"
+		   "\n assert(math.abs(info.p99-1.9)   < 1.9/8,   'bad p99 '..info.p99)"
+		   "\n assert(math.abs(info.p999-3.4)  < 3.4/8,   'bad p999 '..info.p999)"
 		   "\n");
   TestUtil::Wait(exec,fPtr);
   ASSERT_TRUE(fPtr->IsSet());
-  ASSERT_FALSE(fPtr->IsError());
+  ASSERT_FALSE(fPtr->IsError()) << fPtr->GetError();
+}
+
+TEST(aliLuaCoreStats, exporter) {
+  const std::string name = "stats exporter tests";
+  const std::string path = testing::TempDir() + "aliLuaCoreStats.prom";
+  Pool::Ptr         pool = Pool::Create(name, 1);
+  ExecEngine::Ptr   exec = ExecEngine::Create(name, pool);
+  Future::Ptr       fPtr = Future::Create();
+  std::remove(path.c_str());
+  Util::LoadString(exec,fPtr,
+		   "-- stats exporter script interfaces"
+		   "\n local path = '" + path + "'"
+		   "\n assert(not pcall(lib.aliLua.stats.StartExporter, { path=path, format='xml' }),"
+		   "\n        'unknown format accepted')"
+		   "\n lib.aliLua.stats.StartExporter({ path=path, format='prometheus', period=0.005 })"
+		   "\n");
+  TestUtil::Wait(exec,fPtr);
+  ASSERT_TRUE(fPtr->IsSet());
+  ASSERT_FALSE(fPtr->IsError()) << fPtr->GetError();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  fPtr = Future::Create();
+  Util::LoadString(exec,fPtr,"lib.aliLua.stats.StopExporter()");
+  TestUtil::Wait(exec,fPtr);
+  ASSERT_FALSE(fPtr->IsError()) << fPtr->GetError();
+  std::ifstream in(path);
+  std::string   first;
+  ASSERT_TRUE(std::getline(in, first).good()) << "no export written to " << path;
+  ASSERT_EQ(first, "# HELP ali_stats_count number of times the stats object was incremented");
+  std::remove(path.c_str());
 }
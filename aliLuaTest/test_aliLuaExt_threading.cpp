@@ -155,6 +155,12 @@ TEST_F(ThreadTests, poolTests) {
    		   "\n lib.aliLuaTest.testUtil.Sleep(0.1)" // letting threads start up
 		   "\n EQ(pInfo, 'name',       pName)"
 		   "\n EQ(pInfo, 'numThreads', 1)"
+		   "\n EQ(pInfo, 'workStealing', false)"
+		   "\n EQ(pInfo, 'weightedFair', false)"
+		   "\n EQ(pInfo, 'affinity', 'none')"
+		   "\n EQ(pInfo, 'autoScale', false)"
+		   "\n EQ(pInfo.shares[1], 'name',   qName)"
+		   "\n EQ(pInfo.shares[1], 'weight', 1)"
 		   "\n EQ(sInfo, 'name',       pStatsName)"
 		   "\n EQ(sInfo, 'count',      0)"
 		   "\n EQ(sInfo, 'runTime',    0)"
@@ -169,6 +175,15 @@ TEST_F(ThreadTests, poolTests) {
 		   "\n GE(sInfo, 'runTime', 0.019)"
 		   "\n LE(sInfo, 'runTime', 0.021)"
 		   "\n "
+		   "\n -- run a batch of work units"
+		   "\n "
+		   "\n queue:AddWorkBatch {work, work, work}"
+   		   "\n lib.aliLuaTest.testUtil.Sleep(0.1)" // letting work finish
+		   "\n sInfo = pStats:GetInfo()"
+		   "\n EQ(sInfo, 'count',   5)"
+		   "\n GE(sInfo, 'runTime', 0.049)"
+		   "\n LE(sInfo, 'runTime', 0.051)"
+		   "\n "
 		   "\n -- check info"
 		   "\n "
 		   "\n pool:SetNumThreads(2)"
@@ -193,6 +208,11 @@ TEST_F(ThreadTests, queueTests) {
 		   "\n    isFrozen = false,"
 		   "\n    numberPending = 0,"
 		   "\n    maxConcurrency = 1,"
+		   "\n    weight = 1,"
+		   "\n    priority = 0,"
+		   "\n    capacity = 0,"
+		   "\n    overflow = 'block',"
+		   "\n    highWaterMark = 0,"
 		   "\n }"
 		   "\n QEQ(queue, expected)"
 		   "\n ST(qInfo, 'queueStats',         qStatsName, 0, 0, 0)"
@@ -209,6 +229,7 @@ TEST_F(ThreadTests, queueTests) {
 		   "\n end"
 		   "\n expected.numberPending = 10"
 		   "\n expected.isBusy        = true"
+		   "\n expected.highWaterMark = 10"
 		   "\n QEQ(queue, expected)"
 		   "\n queue:SetMaxConcurrency(10)"
 		   "\n expected.maxConcurrency = 10" // still limited by pool
@@ -230,8 +251,70 @@ TEST_F(ThreadTests, queueTests) {
 		   "\n qInfo = queue:GetInfo()"
 		   "\n sInfo = qInfo.queueStats:GetInfo()"
 		   "\n EQ(sInfo, 'count', 10, 'queue.queueStats.')"
+		   "\n EQ(queue:GetInfo(), 'dispatched', 10)"
 		   "\n");
   TestUtil::Wait(exec, fPtr);
   ASSERT_TRUE(fPtr->IsSet());
   ASSERT_FALSE(fPtr->IsError());
 }
+
+TEST_F(ThreadTests, boundedQueue) {
+  Util::LoadString(exec, init);
+  Util::LoadString(exec, fPtr,
+		   "\n bounded = pool:AddQueue {"
+		   "\n   queueName      = 'bounded',"
+		   "\n   maxConcurrency = 1,"
+		   "\n   stats          = qStats,"
+		   "\n   capacity       = 2,"
+		   "\n   overflow       = 'reject',"
+		   "\n }"
+		   "\n bounded:Stop()"
+		   "\n bounded:AddWork(work)"
+		   "\n bounded:AddWork(work)"
+		   "\n if pcall(bounded.AddWork, bounded, work) then"
+		   "\n    error('work added to a full queue')"
+		   "\n end"
+		   "\n QEQ(bounded, { capacity = 2, overflow = 'reject', numberPending = 2,"
+		   "\n                highWaterMark = 2, rejected = 1 })"
+		   "\n bounded:SetCapacity(3, 'dropOldest')"
+		   "\n bounded:AddWork(work)"
+		   "\n bounded:AddWork(work)"
+		   "\n QEQ(bounded, { overflow = 'drop oldest', numberPending = 3, dropped = 1 })"
+		   "\n bounded:Clear()"
+		   "\n bounded:ResetHighWaterMark()"
+		   "\n QEQ(bounded, { numberPending = 0, highWaterMark = 0 })"
+		   "\n");
+  TestUtil::Wait(exec, fPtr);
+  ASSERT_TRUE(fPtr->IsSet());
+  ASSERT_FALSE(fPtr->IsError()) << fPtr->GetError();
+}
+
+TEST_F(ThreadTests, adaptiveQueue) {
+  Util::LoadString(exec, init);
+  Util::LoadString(exec, fPtr,
+		   "\n adaptive = pool:AddQueue {"
+		   "\n   queueName      = 'adaptive',"
+		   "\n   maxConcurrency = 2,"
+		   "\n   stats          = qStats,"
+		   "\n }"
+		   "\n adaptive:SetAdaptiveConcurrency {"
+		   "\n   algorithm      = 'gradient',"
+		   "\n   minConcurrency = 1,"
+		   "\n   maxConcurrency = 4,"
+		   "\n   window         = 8,"
+		   "\n }"
+		   "\n local info = adaptive:GetInfo()"
+		   "\n assert(info.adaptive, 'queue is not adaptive')"
+		   "\n assert(info.adaptive.algorithm == 'gradient', info.adaptive.algorithm)"
+		   "\n assert(info.adaptive.limit == info.maxConcurrency, 'limit is not the max concurrency')"
+		   "\n assert(info.adaptive.maxConcurrency == 4 and info.adaptive.window == 8)"
+		   "\n if pcall(adaptive.SetAdaptiveConcurrency, adaptive, { algorithm = 'none', maxConcurrency = 4 }) then"
+		   "\n    error('accepted an unknown algorithm')"
+		   "\n end"
+		   "\n adaptive:SetAdaptiveConcurrency(nil)"
+		   "\n assert(adaptive:GetInfo().adaptive == nil, 'queue is still adaptive')"
+		   "\n");
+  TestUtil::Wait(exec, fPtr);
+  ASSERT_TRUE(fPtr->IsSet());
+  ASSERT_FALSE(fPtr->IsError()) << fPtr->GetError();
+}
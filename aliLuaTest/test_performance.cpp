@@ -55,6 +55,34 @@ TEST(aliLua, highLevelPerformance) {
   ASSERT_GE(callsPerSecond, 50*kilo);
 }
 
+TEST(aliLua, highLevelPerformanceSpinning) {
+  //
+  // same as highLevelPerformance, but the pool's thread spins briefly
+  // for work rather than parking after every call.
+  int                                  numRuns = 100 * kilo;
+  std::string                          name    = "spinning performance";
+  Stats::Ptr                           stats   = Stats::Create(name);
+  aliSystem::Threading::PoolOptions    opt;
+  opt.SetSpinBudget(std::chrono::microseconds(50));
+  Pool::Ptr       pool    = Pool::Create(name, 1, nullptr, opt);
+  ExecEngine::Ptr exec    = ExecEngine::Create(name,pool);
+  {
+    Future::Ptr fPtr;
+    StatsGuard  g(stats);
+    for (int i=0;i<numRuns;++i) {
+      fPtr = Future::Create();
+      Util::Run(exec, fPtr, [=](lua_State *) {
+	  return 0;
+	});
+    }
+    TestUtil::Wait(exec, fPtr);
+  }
+  double runTime        = Time::ToSeconds(stats->RunTime());
+  double callsPerSecond = numRuns/runTime;
+  //INFO("calls/second " << callsPerSecond);
+  ASSERT_GE(callsPerSecond, 50*kilo);
+}
+
 TEST(aliLua, lowLevelPerformance) {
   //
   // begin testing
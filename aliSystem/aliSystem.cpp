@@ -7,10 +7,12 @@ namespace aliSystem {
     ptr->AddDependency("aliSystem::BasicCodec");
     ptr->AddDependency("aliSystem::Hold");
     ptr->AddDependency("aliSystem::Threading::Scheduler");
+    ptr->AddDependency("aliSystem::Time");
     
     BasicCodec          ::RegisterInitFini(cr);
     Hold                ::RegisterInitFini(cr);
     Threading::Scheduler::RegisterInitFini(cr);
+    Time                ::RegisterInitFini(cr);
   }
 
 }
@@ -9,20 +9,32 @@
 #include <aliSystem_codecSerializer.hpp>
 #include <aliSystem_component.hpp>
 #include <aliSystem_componentRegistry.hpp>
+#include <aliSystem_histogram.hpp>
 #include <aliSystem_hold.hpp>
 #include <aliSystem_listener.hpp>
 #include <aliSystem_listeners.hpp>
 #include <aliSystem_logging.hpp>
 #include <aliSystem_registry.hpp>
 #include <aliSystem_stats.hpp>
+#include <aliSystem_statsExporter.hpp>
 #include <aliSystem_statsGuard.hpp>
+#include <aliSystem_statsRegistry.hpp>
 #include <aliSystem_threading.hpp>
+#include <aliSystem_threadingFreeList.hpp>
+#include <aliSystem_threadingLimiter.hpp>
 #include <aliSystem_threadingPool.hpp>
+#include <aliSystem_threadingPoolOptions.hpp>
 #include <aliSystem_threadingQueue.hpp>
 #include <aliSystem_threadingScheduler.hpp>
 #include <aliSystem_threadingSemaphore.hpp>
+#include <aliSystem_threadingTask.hpp>
+#include <aliSystem_threadingTimerWheel.hpp>
+#include <aliSystem_threadingTopology.hpp>
 #include <aliSystem_threadingWork.hpp>
+#include <aliSystem_threadingWorkList.hpp>
+#include <aliSystem_threadingWorker.hpp>
 #include <aliSystem_time.hpp>
+#include <aliSystem_trace.hpp>
 #include <aliSystem_util.hpp>
 
 /// @brief The aliSystem namespace defines the basic application level
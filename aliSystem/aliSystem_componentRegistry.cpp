@@ -1,8 +1,11 @@
 #include <aliSystem_componentRegistry.hpp>
 #include <aliSystem_logging.hpp>
 #include <algorithm>
+#include <condition_variable>
+#include <exception>
 #include <iterator>
 #include <mutex>
+#include <sstream>
 #include <vector>
 #include <unordered_map>
 
@@ -10,6 +13,11 @@ namespace {
   namespace locals {
     using Component = aliSystem::Component;
     using CR        = aliSystem::ComponentRegistry;
+    using Time      = aliSystem::Time;
+    using Pool      = aliSystem::Threading::Pool;
+    using Queue     = aliSystem::Threading::Queue;
+    using Work      = aliSystem::Threading::Work;
+    using IVec      = std::vector<size_t>;
 
     void DoNothing() {}
     
@@ -161,7 +169,115 @@ namespace {
       }
     }
 
+    // the indexes of each component's dependencies, components are in
+    // init order so dependencies have lower indexes.
+    std::vector<IVec> DependencyIndexes(const CR::Vec &components) {
+      std::unordered_map<std::string, size_t> idx;
+      std::vector<IVec>                       rtn(components.size());
+      for (size_t i=0;i<components.size();++i) {
+	idx[components[i]->Name()] = i;
+      }
+      for (size_t i=0;i<components.size();++i) {
+	const Component::SSet &depSet = components[i]->GetDependencies();
+	for (Component::SSet::const_iterator it=depSet.begin(); it!=depSet.end(); ++it) {
+	  rtn[i].push_back(idx[*it]);
+	}
+      }
+      return rtn;
+    }
 
+    // Runs the init functions of components on a queue, each once its
+    // dependencies finish.
+    struct ParallelInit {
+      ParallelInit(const CR::Vec &components_, const Queue::Ptr &queue_)
+	: components(components_),
+	  queue(queue_),
+	  deps(DependencyIndexes(components_)),
+	  dependents(components_.size()),
+	  waiting(components_.size()),
+	  errors(components_.size()),
+	  started(components_.size(), false),
+	  starts(components_.size()),
+	  ends(components_.size()),
+	  running(0),
+	  failed(false) {
+	for (size_t i=0;i<deps.size();++i) {
+	  waiting[i] = deps[i].size();
+	  for (IVec::const_iterator it=deps[i].begin(); it!=deps[i].end(); ++it) {
+	    dependents[*it].push_back(i);
+	  }
+	}
+      }
+      void Run() {
+	IVec ready;
+	std::unique_lock<std::mutex> g(lock);
+	for (size_t i=0;i<waiting.size();++i) {
+	  if (waiting[i]==0) {
+	    ready.push_back(i);
+	  }
+	}
+	running += ready.size();
+	g.unlock();
+	Submit(ready);
+	g.lock();
+	cv.wait(g, [this]() { return running==0; });
+      }
+      void Submit(const IVec &ready) {
+	for (IVec::const_iterator it=ready.begin(); it!=ready.end(); ++it) {
+	  size_t idx = *it;
+	  queue->AddWork(Work::Create(nullptr, [this, idx](bool &) { RunOne(idx); }));
+	}
+      }
+      void RunOne(size_t idx) {
+	const Component::Ptr &ptr = components[idx];
+	std::exception_ptr    err;
+	Time::TP              start = Time::Now();
+	try {
+	  INFO("Init " << *ptr);
+	  ptr->GetInitFn()();
+	} catch (...) {
+	  err = std::current_exception();
+	}
+	Time::TP end = Time::Now();
+	IVec     ready;
+	std::unique_lock<std::mutex> g(lock);
+	started[idx] = true;
+	starts [idx] = start;
+	ends   [idx] = end;
+	if (err) {
+	  errors[idx] = err;
+	  failed      = true;
+	} else if (!failed) {
+	  for (IVec::const_iterator it=dependents[idx].begin(); it!=dependents[idx].end(); ++it) {
+	    if (--waiting[*it]==0) {
+	      ready.push_back(*it);
+	    }
+	  }
+	}
+	running += ready.size();
+	// the queue may run work on the calling thread, so submit unlocked
+	g.unlock();
+	Submit(ready);
+	g.lock();
+	// Run returns, destroying this, once it sees running reach zero
+	if (--running==0) {
+	  cv.notify_all();
+	}
+      }
+      const CR::Vec                  &components;
+      Queue::Ptr                      queue;
+      std::vector<IVec>               deps;        // indexes of each component's dependencies
+      std::vector<IVec>               dependents;  // indexes of the components depending on each
+      std::mutex                      lock;        // guards the members below
+      std::condition_variable         cv;          // signalled when nothing is running
+      IVec                            waiting;     // unfinished dependencies of each component
+      std::vector<std::exception_ptr> errors;      // failure of each component
+      std::vector<bool>               started;     // the init function ran
+      std::vector<Time::TP>           starts;      // start of each init function
+      std::vector<Time::TP>           ends;        // end of each init function
+      size_t                          running;     // submitted and not finished
+      bool                            failed;      // an init function failed
+    };
     
   }
 }
@@ -205,17 +321,8 @@ namespace aliSystem {
   }
   void ComponentRegistry::Init() {
     std::lock_guard<std::mutex> g(lock);
-    THROW_IF(hasInit, "Attempt to re-run init");
-    hasInit = true;
-    SSet depSet;
-    for (Vec::iterator it=components.begin(); it!=components.end(); ++it) {
-      Component::Ptr ptr = *it;
-      ptr->Freeze();
-      ptr->GetDependencies(depSet);
-    }
-    THROW_IF(!locals::AllDepValid(srcSet, depSet), "undefined dependencies exist, aborting init");
-    locals::SortAll(components, depSet);
-    locals::VerifyDependencies(components);
+    Prepare(g);
+    Time::TP begin = Time::Now();
     for (Vec::const_iterator it = components.begin();
 	 it!=components.end();
 	 ++it) {
@@ -223,10 +330,55 @@ namespace aliSystem {
       if (ptr) {
 	const Component::Fn &initFn = ptr->GetInitFn();
 	INFO("Init " << *ptr);
+	Time::TP start = Time::Now();
 	initFn();
+	timings.push_back(Timing { ptr, start-begin, Time::Now()-start });
       }
     }
-    INFO("Init complete");
+    Report(g, Time::Now()-begin);
+  }
+  void ComponentRegistry::Init(const Threading::Pool::Ptr &pool) {
+    THROW_IF(!pool, "Attempt to init components on an uninitialized pool");
+    THROW_IF(pool->IsPoolThread(), "Attempt to init components from a thread of the pool running them");
+    std::lock_guard<std::mutex> g(lock);
+    Prepare(g);
+    Threading::Queue::Ptr queue = pool->AddQueue("ComponentRegistry::Init",
+						 std::max<size_t>(components.size(), 1),
+						 Stats::Create("ComponentRegistry::Init"));
+    Time::TP              begin = Time::Now();
+    locals::ParallelInit  init(components, queue);
+    init.Run();
+    Time::Dur             elapsed = Time::Now()-begin;
+    pool->RemoveQueue(queue);
+    std::exception_ptr    err;
+    for (size_t i=0;i<components.size();++i) {
+      if (init.errors[i]) {
+	try {
+	  std::rethrow_exception(init.errors[i]);
+	} catch (std::exception &e) {
+	  ERROR("Init " << *components[i] << " failed: " << e.what());
+	} catch (...) {
+	  ERROR("Init " << *components[i] << " failed");
+	}
+	if (!err) {
+	  err = init.errors[i];
+	}
+      } else if (init.started[i]) {
+	timings.push_back(Timing { components[i], init.starts[i]-begin, init.ends[i]-init.starts[i] });
+      }
+    }
+    if (err) {
+      std::rethrow_exception(err);
+    }
+    Report(g, elapsed);
+  }
+  void ComponentRegistry::GetTimings(TimingVec &vec) {
+    std::lock_guard<std::mutex> g(lock);
+    std::copy(timings.begin(), timings.end(), std::back_inserter(vec));
+  }
+  void ComponentRegistry::GetCriticalPath(TimingVec &vec) {
+    std::lock_guard<std::mutex> g(lock);
+    std::copy(criticalPath.begin(), criticalPath.end(), std::back_inserter(vec));
   }
   void ComponentRegistry::Fini() {
     std::lock_guard<std::mutex> g(lock);
@@ -248,6 +400,66 @@ namespace aliSystem {
   }
 
 
+  void ComponentRegistry::Prepare(std::lock_guard<std::mutex> &) {
+    THROW_IF(hasInit, "Attempt to re-run init");
+    hasInit = true;
+    SSet depSet;
+    for (Vec::iterator it=components.begin(); it!=components.end(); ++it) {
+      Component::Ptr ptr = *it;
+      ptr->Freeze();
+      ptr->GetDependencies(depSet);
+    }
+    THROW_IF(!locals::AllDepValid(srcSet, depSet), "undefined dependencies exist, aborting init");
+    locals::SortAll(components, depSet);
+    locals::VerifyDependencies(components);
+  }
+  void ComponentRegistry::Report(std::lock_guard<std::mutex> &, const Time::Dur &elapsed) {
+    // longest chain of dependencies weighted by init time, the timings
+    // are in init order so each component's dependencies come first.
+    using IVec = std::vector<size_t>;
+    std::unordered_map<std::string, size_t> idx;
+    std::vector<Time::Dur>                  finish(timings.size());
+    IVec                                    prev(timings.size());
+    Time::Dur                               total = Time::Dur::zero();
+    size_t                                  last  = 0;
+    for (size_t i=0;i<timings.size();++i) {
+      const Component::SSet &depSet = timings[i].component->GetDependencies();
+      finish[i] = Time::Dur::zero();
+      prev  [i] = i;
+      for (Component::SSet::const_iterator it=depSet.begin(); it!=depSet.end(); ++it) {
+	size_t dep = idx[*it];
+	if (finish[dep]>finish[i]) {
+	  finish[i] = finish[dep];
+	  prev  [i] = dep;
+	}
+      }
+      finish[i] += timings[i].duration;
+      total     += timings[i].duration;
+      idx[timings[i].component->Name()] = i;
+      if (finish[i]>finish[last]) {
+	last = i;
+      }
+    }
+    criticalPath.clear();
+    if (!timings.empty()) {
+      for (size_t i=last; ; i=prev[i]) {
+	criticalPath.push_back(timings[i]);
+	if (prev[i]==i) {
+	  break;
+	}
+      }
+      std::reverse(criticalPath.begin(), criticalPath.end());
+    }
+    std::ostringstream path;
+    for (TimingVec::const_iterator it=criticalPath.begin(); it!=criticalPath.end(); ++it) {
+      path << (it==criticalPath.begin() ? "" : " -> ")
+	   << it->component->Name() << " " << Time::ToSeconds(it->duration) << "s";
+    }
+    INFO("Init complete in " << Time::ToSeconds(elapsed) << "s"
+	 << ", init functions took " << Time::ToSeconds(total) << "s"
+	 << ", critical path " << Time::ToSeconds(timings.empty() ? Time::Dur::zero() : finish[last]) << "s"
+	 << (criticalPath.empty() ? "" : ": ") << path.str());
+  }
   void ComponentRegistry::GetSrcSet(SSet &sSet) {
     std::lock_guard<std::mutex> g(lock);
     std::copy(srcSet.begin(), srcSet.end(), std::inserter(sSet, sSet.begin()));
@@ -2,6 +2,8 @@
 #define INCLUDED_COMPONENT_REGISTRY
 
 #include <aliSystem_component.hpp>
+#include <aliSystem_threadingPool.hpp>
+#include <aliSystem_time.hpp>
 #include <mutex>
 #include <unordered_set>
 #include <vector>
@@ -21,10 +23,25 @@ namespace aliSystem {
   /// When calling Fini, registered Components will have their
   /// fini funciton called.  The order of these calls will be the
   /// exact opposite of the order determined for the init sequence.
+  ///
+  /// Init may also run the init functions on a Threading::Pool, starting
+  /// each Component as soon as its dependencies have finished, so
+  /// independent Components initialize concurrently.  Either way, the
+  /// time taken by each init function is recorded, and the chain of
+  /// dependencies that bounds the startup time (the critical path) is
+  /// logged and available from GetCriticalPath.
   struct ComponentRegistry {
     using Vec  = std::vector<Component::Ptr>;     ///< Compnent vector
     using SSet = std::unordered_set<std::string>; ///< string set
 
+    /// @brief the time taken by a Component's init function
+    struct Timing {
+      Component::Ptr component;  ///< the component
+      Time::Dur      start;      ///< start of the init function, from the start of Init
+      Time::Dur      duration;   ///< run time of the init function
+    };
+    using TimingVec = std::vector<Timing>;        ///< Timing vector
+
     /// @brief constructor
     ComponentRegistry();
     
@@ -117,6 +134,36 @@ namespace aliSystem {
     ///       name.  This stable ordering is not guarenteed and might
     ///       evolve as this class evolves.
     void Init();
+
+    /// @brief Trigger the execution of the init functions for the
+    ///        registered Components on a pool.
+    /// @param pool the pool to run the init functions on, a queue is
+    ///        added to it for them.
+    /// @note The Components are ordered as for the other form of Init,
+    ///       which determines the order of Fini.  Each init function is
+    ///       run once all of its Component's dependencies have finished,
+    ///       and the call returns when every init function has run.
+    /// @note If init functions fail, no further Components are started
+    ///       and, once the running ones finish, the failures are logged
+    ///       and the exception of the failed Component that is first in
+    ///       the init order is rethrown.
+    /// @note This function will throw an exception if called from one
+    ///       of the pool's threads.
+    void Init(const Threading::Pool::Ptr &pool);
+
+    /// @brief Get the time taken by each init function
+    /// @param vec is the vector to write the timings into, in init order.
+    /// @note vec is not cleared before the timings are added
+    /// @note Components whose init function did not run are omitted.
+    void GetTimings(TimingVec &vec);
+
+    /// @brief Get the critical path of the init sequence
+    /// @param vec is the vector to write the timings into.  Each
+    ///        Component depends on the one before it, and their durations
+    ///        add up to the shortest time in which the init functions
+    ///        could have run given their dependencies.
+    /// @note vec is not cleared before the timings are added
+    void GetCriticalPath(TimingVec &vec);
     
     /// @brief Trigger the execution of the fini functions for
     ///        The registered Components.
@@ -141,12 +188,23 @@ namespace aliSystem {
     void GetDepSet(SSet &sSet);
   
   private:
+
+    /// @brief freeze and order the components for Init
+    /// @param g a lock guard that should hold the lock member
+    void Prepare(std::lock_guard<std::mutex> &g);
+
+    /// @brief compute and log the critical path once the timings are recorded
+    /// @param g a lock guard that should hold the lock member
+    /// @param elapsed the time Init took
+    void Report(std::lock_guard<std::mutex> &g, const Time::Dur &elapsed);
     
-    std::mutex lock;        ///< lock to serialize access to other members
-    bool       hasInit;     ///< flag indicating state of the object
-    bool       hasFini;     ///< flag indicating state of the object
-    Vec        components;  ///< vector of registered components
-    SSet       srcSet;      ///< string set of component names
+    std::mutex lock;          ///< lock to serialize access to other members
+    bool       hasInit;       ///< flag indicating state of the object
+    bool       hasFini;       ///< flag indicating state of the object
+    Vec        components;    ///< vector of registered components
+    SSet       srcSet;        ///< string set of component names
+    TimingVec  timings;       ///< init function run times, in init order
+    TimingVec  criticalPath;  ///< the chain of timings bounding Init
   };  
 
 }
@@ -0,0 +1,89 @@
+#include <aliSystem_histogram.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace aliSystem {
+
+  Histogram::Histogram() {
+    Clear();
+  }
+  void Histogram::Record(uint64_t value) {
+    buckets[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+  }
+  void Histogram::Add(const Histogram &o) {
+    for (size_t i=0;i<NumBuckets;++i) {
+      uint64_t n = o.buckets[i].load(std::memory_order_relaxed);
+      if (n) {
+	buckets[i].fetch_add(n, std::memory_order_relaxed);
+      }
+    }
+  }
+  void Histogram::Clear() {
+    for (size_t i=0;i<NumBuckets;++i) {
+      buckets[i].store(0, std::memory_order_relaxed);
+    }
+  }
+  uint64_t Histogram::Count() const {
+    uint64_t rtn = 0;
+    for (size_t i=0;i<NumBuckets;++i) {
+      rtn += buckets[i].load(std::memory_order_relaxed);
+    }
+    return rtn;
+  }
+  uint64_t Histogram::Percentile(double fraction) const {
+    uint64_t counts[NumBuckets];
+    uint64_t total = 0;
+    for (size_t i=0;i<NumBuckets;++i) {
+      counts[i]  = buckets[i].load(std::memory_order_relaxed);
+      total     += counts[i];
+    }
+    if (total==0) {
+      return 0;
+    }
+    fraction = std::min(1.0, std::max(0.0, fraction));
+    // the small allowance keeps, say, 0.99 of 100 values at rank 99
+    uint64_t rank = std::max<uint64_t>(1, uint64_t(std::ceil(fraction*total-1e-9)));
+    uint64_t seen = 0;
+    size_t   i    = 0;
+    for (;i<NumBuckets-1;++i) {
+      seen += counts[i];
+      if (seen>=rank) {
+	break;
+      }
+    }
+    return LowerBound(i) + Width(i)/2;
+  }
+  size_t Histogram::BucketOf(uint64_t value) {
+    if (value<SubBuckets) {
+      return size_t(value);
+    }
+    unsigned exponent = 63-__builtin_clzll(value);
+    if (exponent>=MaxExponent) {
+      return NumBuckets-1;
+    }
+    unsigned shift = exponent-SubBits;
+    return (shift+1)*SubBuckets + ((value>>shift) & (SubBuckets-1));
+  }
+  uint64_t Histogram::LowerBound(size_t bucket) {
+    if (bucket<SubBuckets) {
+      return bucket;
+    }
+    size_t shift = bucket/SubBuckets-1;
+    return uint64_t(SubBuckets + bucket%SubBuckets) << shift;
+  }
+  uint64_t Histogram::Width(size_t bucket) {
+    if (bucket<SubBuckets) {
+      return 1;
+    }
+    return uint64_t(1) << (bucket/SubBuckets-1);
+  }
+  std::ostream &operator<<(std::ostream &out, const Histogram &o) {
+    out << "Histogram(count=" << o.Count()
+	<< ", p50="           << o.Percentile(0.5)
+	<< ", p99="           << o.Percentile(0.99)
+	<< ", p999="          << o.Percentile(0.999)
+	<< ")";
+    return out;
+  }
+
+}
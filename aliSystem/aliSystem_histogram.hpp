@@ -0,0 +1,99 @@
+#ifndef INCLUDED_ALI_SYSTEM_HISTOGRAM
+#define INCLUDED_ALI_SYSTEM_HISTOGRAM
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace aliSystem {
+
+  ///
+  /// @brief A log bucketed histogram of non-negative integer values.
+  ///
+  /// Values are counted in buckets whose width grows with the value, in
+  /// the manner of an HDR histogram: each power of two is split into
+  /// SubBuckets equal buckets, so any value is recovered to within
+  /// 1/SubBuckets of itself whatever its magnitude.  Values below
+  /// SubBuckets are counted exactly and values of 2^MaxExponent and over
+  /// share the last bucket.
+  ///
+  /// Record is lock free and may be called from any number of threads;
+  /// reads while values are being recorded see each bucket's count at
+  /// some point during the read.
+  ///
+  struct Histogram {
+
+    /// @brief number of bits of a value kept below its leading bit
+    static const unsigned SubBits     = 3;
+
+    /// @brief number of buckets each power of two is split into
+    static const unsigned SubBuckets  = 1u<<SubBits;
+
+    /// @brief values of 2 to this power and over share the last bucket
+    static const unsigned MaxExponent = 36;
+
+    /// @brief total number of buckets
+    static const size_t   NumBuckets  = (MaxExponent-SubBits+1)*SubBuckets;
+
+    /// @brief constructor, all buckets are empty
+    Histogram();
+
+    /// @brief Copy constructor is deleted
+    Histogram(const Histogram &) = delete;
+
+    /// @brief Assignment operator is deleted
+    Histogram &operator=(const Histogram &) = delete;
+
+    /// @brief count one value
+    /// @param value the value to count
+    void Record(uint64_t value);
+
+    /// @brief add the counts of another histogram to this one
+    /// @param o the histogram to add
+    void Add(const Histogram &o);
+
+    /// @brief empty all buckets
+    void Clear();
+
+    /// @brief retrieve the number of values counted
+    /// @return the sum of all bucket counts
+    uint64_t Count() const;
+
+    /// @brief retrieve a percentile
+    /// @param fraction the fraction of values at or below the result,
+    ///        for example 0.99 for the 99th percentile
+    /// @return the midpoint of the bucket holding the percentile, 0 if
+    ///         the histogram is empty
+    uint64_t Percentile(double fraction) const;
+
+    /// @brief retrieve the bucket a value is counted in
+    /// @param value the value
+    /// @return the bucket's index
+    static size_t BucketOf(uint64_t value);
+
+    /// @brief retrieve the smallest value counted in a bucket
+    /// @param bucket the bucket's index
+    /// @return the bucket's lower bound
+    static uint64_t LowerBound(size_t bucket);
+
+    /// @brief retrieve the number of values a bucket covers
+    /// @param bucket the bucket's index
+    /// @return the bucket's width
+    static uint64_t Width(size_t bucket);
+
+    /// @brief Write the histogram's count and main percentiles to the
+    ///        given ostream.
+    /// @param out the stream to write to
+    /// @param o the Histogram instance to write
+    /// @return the stream passed as the out parameter
+    friend std::ostream &operator<<(std::ostream &out, const Histogram &o);
+
+  private:
+
+    std::atomic<uint64_t> buckets[NumBuckets];  ///< count of each bucket
+  };
+
+}
+
+#endif
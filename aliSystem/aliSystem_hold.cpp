@@ -4,25 +4,48 @@
 #include <aliSystem_logging.hpp>
 #include <chrono>
 #include <condition_variable>
+#include <sstream>
 #include <unordered_map>
 
 namespace {  
   using HMap = std::unordered_map<const void*, aliSystem::Hold::WPtr>;
+  using Hold = aliSystem::Hold;
+
+  // how often an unbounded WaitForHolds logs the outstanding holds
+  const std::chrono::seconds REPORT(10);
+
   std::condition_variable cv;
   std::mutex              lock;
   HMap                    holds;
   bool                    isInit   = false;
   bool                    released = false;
 
-  void Init() { isInit = true; }
+  void Init() {
+    std::lock_guard<std::mutex> g(lock);
+    isInit = true;
+    cv.notify_all();
+  }
   void Fini() {}
-  
-  bool Release() {
-    if (!released) {
-      std::lock_guard<std::mutex> g(lock);
-      released = isInit && holds.empty();
+
+  // call with the lock held
+  bool IsDrained() {
+    return isInit && holds.empty();
+  }
+
+  // the outstanding holds as "reason (file:line) xN, ..."
+  std::string Describe() {
+    Hold::Counts counts;
+    Hold::GetCounts(counts);
+    std::ostringstream out;
+    const char        *sep = "";
+    for (Hold::Counts::const_iterator it=counts.begin(); it!=counts.end(); ++it) {
+      out << sep << it->first;
+      if (it->second>1) {
+	out << " x" << it->second;
+      }
+      sep = ", ";
     }
-    return released;
+    return out.str();
   }
 }
 
@@ -43,18 +66,29 @@ namespace aliSystem {
     return rtn;
   }
   void Hold::WaitForHolds() {
-    static std::chrono::seconds  tenSeconds(10);
-    static std::mutex            waitMutex;
-    std::unique_lock<std::mutex> lock(waitMutex);
-    Vec vec;
-    while (!Release()) {
-      cv.wait_for(lock, tenSeconds, Release);
-      GetHolds(vec);
-      for (Vec::iterator it=vec.begin(); it!=vec.end(); ++it) {
-	Ptr hPtr = *it;
-	DEBUG("Waiting for " << hPtr->GetReason());
-      }
-      vec.clear();
+    while (!WaitForHolds(REPORT)) {
+      DEBUG("Waiting for " << NumHolds() << " holds: " << Describe());
+    }
+  }
+  bool Hold::WaitForHolds(const Time::Dur &timeout) {
+    std::unique_lock<std::mutex> g(lock);
+    if (cv.wait_for(g, timeout, IsDrained)) {
+      released = true;
+    }
+    return released;
+  }
+  size_t Hold::NumHolds() {
+    std::lock_guard<std::mutex> g(lock);
+    return holds.size();
+  }
+  void Hold::GetCounts(Counts &counts) {
+    std::lock_guard<std::mutex> g(lock);
+    for (HMap::const_iterator it=holds.begin(); it!=holds.end(); ++it) {
+      // a hold stays valid until its destructor removes it under the lock
+      const Hold *hold = static_cast<const Hold*>(it->first);
+      std::ostringstream key;
+      key << hold->reason << " (" << hold->file << ":" << hold->line << ")";
+      ++counts[key.str()];
     }
   }
   void Hold::GetHolds(Vec &vec) {
@@ -72,7 +106,7 @@ namespace aliSystem {
   Hold::~Hold() {
     std::lock_guard<std::mutex> g(lock);
     holds.erase(this);
-    if (isInit && holds.empty()) {
+    if (IsDrained()) {
       cv.notify_all();
     }
   }
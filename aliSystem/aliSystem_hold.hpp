@@ -1,6 +1,8 @@
 #ifndef INCLUDED_ALI_SYSTEM_HOLD
 #define INCLUDED_ALI_SYSTEM_HOLD
 
+#include <aliSystem_time.hpp>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -26,6 +28,7 @@ namespace aliSystem {
     using Ptr  = std::shared_ptr<Hold>; ///< shared pointer
     using WPtr = std::weak_ptr<Hold>;   ///< weak pointer
     using Vec  = std::vector<Ptr>;      ///< vector of shared pointers
+    using Counts = std::map<std::string,size_t>; ///< outstanding holds by reason and source
     
     /// @brief Initialize hold module
     /// @param cr is a component registry to which any initialzation
@@ -42,8 +45,26 @@ namespace aliSystem {
     static Ptr Create(const std::string &file, size_t line, const std::string &reason);
 
     /// WaitForHolds will block until all holds have been released.
+    /// @note The outstanding holds are logged at debug level every ten
+    ///       seconds while waiting.
     static void WaitForHolds();
 
+    /// @brief block until all holds have been released or the timeout
+    ///        expires.
+    /// @param timeout how long to wait
+    /// @return true if all holds were released, after which no further
+    ///         holds may be created, false on timeout.
+    static bool WaitForHolds(const Time::Dur &timeout);
+
+    /// @brief retrieve the number of outstanding holds
+    /// @return the number of holds not yet released
+    static size_t NumHolds();
+
+    /// @brief count the outstanding holds by where and why they were taken.
+    /// @param counts a map to which the count of each "reason (file:line)"
+    ///        is added.
+    static void GetCounts(Counts &counts);
+
     /// GetHolds will retrieve a list of holds that are currently outstanding.
     /// @param holds a vector to which the existing holds will be copied.
     /// @note holds returned in the vector will held by the vector as well
@@ -4,12 +4,13 @@
 #include <aliSystem_listener.hpp>
 #include <aliSystem_logging.hpp>
 #include <aliSystem_util.hpp>
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace aliSystem {
@@ -23,6 +24,25 @@ namespace aliSystem {
   /// from behind the listeners mutex so callers triggering a
   /// notification can use this class as a latch guard.
   ///
+  /// The registered listeners are kept in an immutable snapshot that is
+  /// replaced (not modified) under the mutex by Register and Unregister.
+  /// Notify iterates the current snapshot without taking the mutex, so
+  /// notifying threads do not serialize and a slow notify function does
+  /// not block registration.  A Notify that loaded a snapshot before a
+  /// listener was unregistered may still call that listener.  Weak
+  /// listeners found released during a notification are removed in
+  /// batches rather than one snapshot per release.
+  ///
+  /// Listeners used as a topic bus may instead be registered with
+  /// RegisterKeyed under their info as a key: an exact key, a key prefix
+  /// or any key (KeyMatch).  NotifyKey looks up the listeners matching a
+  /// key in a hash index, so a notification costs the number of matching
+  /// listeners (and one lookup per distinct registered prefix length)
+  /// rather than a select function call per registered listener.  Keyed
+  /// listeners are only notified by NotifyKey, and NotifyKey only
+  /// notifies keyed listeners.  The info type must be hashable, and
+  /// KeyMatch::PREFIX requires it to be a string.
+  ///
   template<typename DataType_, typename InfoType_=std::string>
   struct Listeners {
     using DataType   = DataType_;                                   ///< data type
@@ -30,12 +50,19 @@ namespace aliSystem {
     using Ptr        = std::shared_ptr<Listeners>;                  ///< shared pointer
     using LPtr       = typename Listener<DataType,InfoType>::Ptr;   ///< shared pointer to a listener
     using WLPtr      = typename Listener<DataType,InfoType>::WPtr;  ///< weak pointer to a listener
-    using LMap       = std::unordered_map<void*, LPtr>;             ///< maintain shared ptr, key is the raw address
-    using WLMap      = std::unordered_map<void*, WLPtr>;            ///< maintain weak ptr, key is the raw address
+    using LVec       = std::vector<LPtr>;                           ///< strong listeners
+    using WLVec      = std::vector<std::pair<void*, WLPtr>>;        ///< weak listeners and their raw addresses
     using NotifyFn   = Util::NotifyFn<DataType>;                    ///< specialized notify fn
     using SelectFn   = Util::SelectFn<InfoType>;                    ///< specialized select fn
     using CommitFn   = Util::CommitFn;                              ///< commit fn
 
+    /// @brief KeyMatch identifies the keys a keyed listener is notified for
+    enum class KeyMatch {
+      EXACT,   ///< keys equal to the listener's info
+      PREFIX,  ///< keys beginning with the listener's info
+      ANY      ///< every key
+    };
+
     /// @brief create a collection of listeners
     /// @param name is simply a name to describe the collection of listeners
     static Ptr  Create(const std::string &name);
@@ -78,6 +105,24 @@ namespace aliSystem {
 			 const LPtr  &lPtr,
 			 bool         useWeak);
 
+    /// @brief Create and register a keyed listener.
+    /// See Register for the ownership of the listener.
+    /// @param ptr listeners to which a listener should be registered
+    /// @param key the key, or key prefix, the listener is notified for,
+    ///        which is also the listener's info.  Ignored for KeyMatch::ANY.
+    /// @param match how keys passed to NotifyKey are compared to key
+    /// @param notifyFn the function to call when a notification is triggered
+    /// @param useWeak flag to indicate whether the listeners object should
+    ///        leave ownership to the caller (true) or should share
+    ///        ownership of the listener object (false).
+    /// @note If the passted listeners pointer is null, this call will throw
+    ///       an exception.
+    static LPtr RegisterKeyed(const Ptr      &ptr,
+			      const InfoType &key,
+			      KeyMatch        match,
+			      const NotifyFn &notifyFn,
+			      bool            useWeak);
+
     /// @brief name of the listeners object
     /// @return the name given the object when it was created
     const std::string &Name();
@@ -93,6 +138,28 @@ namespace aliSystem {
     ///       exception.
     void Register(const LPtr &lPtr, bool useWeak);
 
+    /// @brief register a keyed listener created elsewhere
+    /// @param lPtr listener to register, its info is the key
+    /// @param match how keys passed to NotifyKey are compared to the info
+    /// @param useWeak flag to indicate whether the registered listener
+    ///        should be owned only by the caller, or shared with the
+    ///        listeners object.
+    /// @note If the listener object pointer is null, the function will throw an
+    ///       exception.
+    void RegisterKeyed(const LPtr &lPtr, KeyMatch match, bool useWeak);
+
+    /// @brief unregister a listener, keyed or not
+    /// @param lPtr listener to unregister
+    /// @return true if the listener was registered
+    /// @note A notification already in progress may still call the
+    ///       listener.
+    bool Unregister(const LPtr &lPtr);
+
+    /// @brief retrieve the number of registered listeners
+    /// @return the number of strong listeners plus the number of weak
+    ///         listeners not yet found released, keyed or not
+    size_t Size() const;
+
     /// @brief notify all registered listeners.
     ///
     ///        For listeners registered with weak pointers, if they are released
@@ -123,7 +190,9 @@ namespace aliSystem {
     /// @return the same result as the commit function
     /// @note the commit function is called under the class's general mutex.  The commit
     ///       function should not call back into other fuctions (directly or indirectly)
-    ///       in this class that also lock the listeners object's mutex.
+    ///       in this class that also lock the listeners object's mutex.  The listeners
+    ///       registered when the commit function returns are notified after the mutex
+    ///       is released.
     /// @note The commit function allows classes holding a listeners object the ability
     ///       to use the atomic behavior associated with adding listeners and notifying
     ///       them to coordinate behaviors surrounding the management of registered
@@ -144,7 +213,9 @@ namespace aliSystem {
     /// @return the same result as the commit function
     /// @note The commit function is called under the class's general mutex.  The commit
     ///       function should not call back into other fuctions (directly or indirectly)
-    ///       in this class that also lock the listeners object's mutex.
+    ///       in this class that also lock the listeners object's mutex.  The listeners
+    ///       registered when the commit function returns are notified after the mutex
+    ///       is released.
     /// @note The commit function allows classes holding a listeners object the ability
     ///       to use the atomic behavior associated with adding listeners and notifying
     ///       them to coordinate behaviors surrounding the management of registered
@@ -153,11 +224,67 @@ namespace aliSystem {
 		const SelectFn &selectFn,
 		const CommitFn &commitFn);
 
+    /// @brief notify the keyed listeners matching a key.
+    /// For listeners registered with weak pointers, if they are released before
+    /// this function triggers their notification function, they will be unregistered.
+    /// @param arg is an argument that is passed to the listener's notify function
+    /// @param key the key, listeners registered for it exactly, for a prefix
+    ///        of it, or for any key are notified
+    /// @return true
+    bool NotifyKey(DataType arg, const InfoType &key);
+
+    /// @brief notify the keyed listeners matching a key.
+    /// @param arg is an argument that is passed to the listener's notify function
+    /// @param key the key, see the previous form of NotifyKey
+    /// @param commitFn The commit function is called just before notifying
+    ///        the listeners, as for Notify.  If the commit function returns
+    ///        false, no listeners are notified.
+    /// @return the same result as the commit function
+    bool NotifyKey(DataType arg, const InfoType &key, const CommitFn &commitFn);
+
     /// @brief listeners destrutor
     ~Listeners();
     
   private:
 
+    /// @brief a set of listeners
+    struct Bucket {
+      LVec  strong;  ///< strong listeners
+      WLVec weak;    ///< weak listeners (released ones purged by Prune)
+    };
+    using BucketPtr = std::shared_ptr<const Bucket>;               ///< published bucket
+    using BucketMap = std::unordered_map<InfoType, BucketPtr>;     ///< buckets by key
+    using MapPtr    = std::shared_ptr<const BucketMap>;            ///< published map
+
+    /// @brief the number of maps the exact keys are spread over, so
+    ///        registering a keyed listener copies a fraction of them.
+    static const size_t IndexShards = 64;
+
+    /// @brief the keyed listeners, never modified once published.  The
+    ///        maps and buckets are shared between successive indexes.
+    struct Index {
+      /// @brief constructor, an empty index
+      Index() : exact(IndexShards) {}
+      std::vector<MapPtr> exact;        ///< KeyMatch::EXACT listeners by shard and key
+      BucketMap           prefix;       ///< KeyMatch::PREFIX listeners by prefix
+      std::vector<size_t> prefixSizes;  ///< distinct sizes of the prefixes, ascending
+      BucketPtr           any;          ///< KeyMatch::ANY listeners, may be null
+    };
+    using IndexPtr = std::shared_ptr<const Index>;                 ///< published index
+
+    /// @brief the registered listeners, never modified once published
+    struct Snapshot : Bucket {
+      /// @brief constructor, an empty snapshot
+      Snapshot() : numKeyed(0) {}
+      IndexPtr index;     ///< keyed listeners, null if none were registered
+      size_t   numKeyed;  ///< number of keyed listeners in index
+    };
+    using SnapshotPtr = std::shared_ptr<const Snapshot>;  ///< published snapshot
+
+    /// @brief the number of released weak listeners a notification
+    ///        tolerates before purging them.
+    static const size_t PruneBatch = 16;
+
     /// @brief listeners construtor
     Listeners();
 
@@ -170,10 +297,66 @@ namespace aliSystem {
     //         by both the caller and the listeners object (false);
     void Register(std::lock_guard<std::mutex> &g, const LPtr  &lPtr, bool useWeak);
 
-    std::string name;  ///< name of listeners
-    std::mutex  lock;  ///< lock for serializing updates to lMap & wlMap
-    LMap        lMap;  ///< map of strong listners
-    WLMap       wlMap; ///< map of weak listeners (purged in notification routines)
+    /// @brief notify the selected listeners of a bucket
+    /// @param arg is an argument that is passed to the listener's notify function
+    /// @param selectFn Function used to determine which listeners to notify,
+    ///        all are notified if null.
+    /// @param bucket the listeners to consider
+    /// @param numWeak incremented by the number of weak listeners considered
+    /// @return the number of weak listeners found released
+    static size_t Deliver(DataType        arg,
+			  const SelectFn *selectFn,
+			  const Bucket   &bucket,
+			  size_t         &numWeak);
+
+    /// @brief notify the keyed listeners of a snapshot matching a key
+    /// @param arg is an argument that is passed to the listener's notify function
+    /// @param key the key
+    /// @param snapshot the listeners to consider
+    void DeliverKey(DataType arg, const InfoType &key, const SnapshotPtr &snapshot);
+
+    /// @brief add a listener to a bucket, replacing a weak listener at
+    ///        the same address
+    /// @param bucket the bucket to modify
+    /// @param lPtr the listener to add
+    /// @param useWeak add the listener as a weak listener
+    /// @return true if the number of listeners in the bucket grew
+    static bool Add(Bucket &bucket, const LPtr &lPtr, bool useWeak);
+
+    /// @brief remove a listener from a bucket
+    /// @param bucket the bucket to modify
+    /// @param addr the listener's address
+    /// @return the number of entries removed
+    static size_t Remove(Bucket &bucket, const void *addr);
+
+    /// @brief prune the released weak listeners of a bucket
+    /// @param bucket the bucket to modify
+    /// @return the number of entries removed
+    static size_t Prune(Bucket &bucket);
+
+    /// @brief publish a snapshot without the released weak listeners
+    void Prune();
+
+    /// @brief the shard of the exact index holding a key
+    /// @param key the key
+    /// @return the index into Index::exact
+    static size_t Shard(const InfoType &key);
+
+    /// @brief copy a shard of the exact index for modification
+    /// @param index the index being modified
+    /// @param key a key in the shard
+    /// @return the copy, published in index
+    static BucketMap &CopyShard(Index &index, const InfoType &key);
+
+    /// @brief prune the released weak listeners of a published bucket
+    /// @param bPtr the bucket, replaced if any were released and reset if
+    ///        the bucket becomes empty
+    /// @return the number of entries removed
+    static size_t Prune(BucketPtr &bPtr);
+
+    std::string name;      ///< name of listeners
+    std::mutex  lock;      ///< lock for serializing updates to snapshot
+    SnapshotPtr snapshot;  ///< registered listeners, replaced (not modified) under lock
   };
 
 
@@ -205,6 +388,18 @@ namespace aliSystem {
     ptr->Register(lPtr, useWeak);
   }
   template<typename DataType_, typename InfoType_>
+  typename Listener<DataType_,InfoType_>::Ptr
+  Listeners<DataType_,InfoType_>::RegisterKeyed(const Ptr      &ptr,
+						const InfoType &key,
+						KeyMatch        match,
+						const NotifyFn &notifyFn,
+						bool            useWeak) {
+    THROW_IF(!ptr,  "Listeners uninitialized");
+    LPtr lPtr = Listener<DataType,InfoType>::Create(key, notifyFn);
+    ptr->RegisterKeyed(lPtr, match, useWeak);
+    return lPtr;
+  }
+  template<typename DataType_, typename InfoType_>
   const std::string &Listeners<DataType_,InfoType_>::Name() { return name; }
   template<typename DataType_, typename InfoType_>
   void Listeners<DataType_,InfoType_>::Register(const LPtr  &lPtr, bool useWeak) {
@@ -212,61 +407,326 @@ namespace aliSystem {
     Register(g, lPtr, useWeak);
   }
   template<typename DataType_, typename InfoType_>
+  void Listeners<DataType_,InfoType_>::RegisterKeyed(const LPtr &lPtr, KeyMatch match, bool useWeak) {
+    THROW_IF(!lPtr, "Listener uninitialized");
+    std::lock_guard<std::mutex> g(lock);
+    Snapshot   *next  = new Snapshot(*snapshot);
+    SnapshotPtr nPtr(next);
+    Index      *index = next->index ? new Index(*next->index) : new Index;
+    next->index.reset(index);
+    BucketPtr  *bPtr  = nullptr;
+    switch (match) {
+    case KeyMatch::EXACT:
+      bPtr = &CopyShard(*index, lPtr->Info())[lPtr->Info()];
+      break;
+    case KeyMatch::PREFIX:
+      bPtr = &index->prefix[lPtr->Info()];
+      if (!*bPtr) {
+	size_t sz = lPtr->Info().size();
+	std::vector<size_t>::iterator it = std::lower_bound(index->prefixSizes.begin(),
+							     index->prefixSizes.end(), sz);
+	if (it==index->prefixSizes.end() || *it!=sz) {
+	  index->prefixSizes.insert(it, sz);
+	}
+      }
+      break;
+    case KeyMatch::ANY:
+      bPtr = &index->any;
+      break;
+    }
+    Bucket *bucket = *bPtr ? new Bucket(**bPtr) : new Bucket;
+    bPtr->reset(bucket);
+    if (Add(*bucket, lPtr, useWeak)) {
+      ++next->numKeyed;
+    }
+    std::atomic_store(&snapshot, nPtr);
+  }
+  template<typename DataType_, typename InfoType_>
+  bool Listeners<DataType_,InfoType_>::Unregister(const LPtr &lPtr) {
+    std::lock_guard<std::mutex> g(lock);
+    Snapshot   *next = new Snapshot(*snapshot);
+    SnapshotPtr nPtr(next);
+    size_t      num  = Remove(*next, lPtr.get());
+    if (next->index) {
+      // the listener's info locates it whichever way it was keyed
+      Index     *index = new Index(*next->index);
+      BucketPtr *bPtrs[3] = { nullptr, nullptr, &index->any };
+      next->index.reset(index);
+      BucketMap &exact = CopyShard(*index, lPtr->Info());
+      typename BucketMap::iterator eIt = exact.find(lPtr->Info());
+      typename BucketMap::iterator pIt = index->prefix.find(lPtr->Info());
+      if (eIt!=exact.end())         { bPtrs[0] = &eIt->second; }
+      if (pIt!=index->prefix.end()) { bPtrs[1] = &pIt->second; }
+      for (size_t i=0;i<3;++i) {
+	if (bPtrs[i] && *bPtrs[i]) {
+	  Bucket *bucket  = new Bucket(**bPtrs[i]);
+	  size_t  removed = Remove(*bucket, lPtr.get());
+	  bPtrs[i]->reset(bucket);
+	  next->numKeyed -= removed;
+	  num            += removed;
+	}
+      }
+      if (pIt!=index->prefix.end() && pIt->second->strong.empty() && pIt->second->weak.empty()) {
+	size_t sz = pIt->first.size();
+	index->prefix.erase(pIt);
+	bool used = false;
+	for (typename BucketMap::const_iterator it=index->prefix.begin(); it!=index->prefix.end() && !used; ++it) {
+	  used = it->first.size()==sz;
+	}
+	if (!used) {
+	  index->prefixSizes.erase(std::find(index->prefixSizes.begin(), index->prefixSizes.end(), sz));
+	}
+      }
+      if (eIt!=exact.end() && eIt->second->strong.empty() && eIt->second->weak.empty()) {
+	exact.erase(eIt);
+      }
+      if (index->any && index->any->strong.empty() && index->any->weak.empty()) {
+	index->any.reset();
+      }
+    }
+    if (num==0) {
+      return false;
+    }
+    std::atomic_store(&snapshot, nPtr);
+    return true;
+  }
+  template<typename DataType_, typename InfoType_>
+  size_t Listeners<DataType_,InfoType_>::Size() const {
+    SnapshotPtr sPtr = std::atomic_load(&snapshot);
+    return sPtr->strong.size()+sPtr->weak.size()+sPtr->numKeyed;
+  }
+  template<typename DataType_, typename InfoType_>
   bool Listeners<DataType_,InfoType_>::Notify(DataType arg) {
-    return Notify(arg, Util::MatchAll<InfoType>, Util::Always);
+    return Notify(arg, CommitFn());
   }
   template<typename DataType_, typename InfoType_>
   bool Listeners<DataType_,InfoType_>::Notify(DataType        arg,
 					      const SelectFn &selectFn) {
-    return Notify(arg, selectFn, Util::Always);
+    return Notify(arg, selectFn, CommitFn());
   }
   template<typename DataType_, typename InfoType_>
   bool Listeners<DataType_,InfoType_>::Notify(DataType        arg,
 					      const CommitFn &commitFn) {
-    return Notify(arg, Util::MatchAll<InfoType>, commitFn);
+    return Notify(arg, SelectFn(), commitFn);
   }
   template<typename DataType_, typename InfoType_>
   bool Listeners<DataType_,InfoType_>::Notify(DataType        arg,
 					      const SelectFn &selectFn,
 					      const CommitFn &commitFn) {
-    bool rtn = false;
-    std::lock_guard<std::mutex> g(lock);
-    if (!commitFn || commitFn()) {
-      rtn = true;
-      for (typename LMap::iterator it=lMap.begin(); it!=lMap.end(); ++it) {
-	LPtr lPtr = it->second;
-	if (selectFn(lPtr->Info())) {
-	  lPtr->Notify(arg);
-	}
+    SnapshotPtr sPtr;
+    if (!commitFn) {
+      sPtr = std::atomic_load(&snapshot);
+    } else {
+      // listeners registered before the commit are notified, later ones
+      // observe whatever the commit function changed.
+      std::lock_guard<std::mutex> g(lock);
+      if (!commitFn()) {
+	return false;
       }
-      for (typename WLMap::iterator it=wlMap.begin(); it!=wlMap.end();) {
-	LPtr lPtr = it->second.lock();
-	if (lPtr) {
-	  ++it;
-	  if (selectFn(lPtr->Info())) {
-	    lPtr->Notify(arg);
-	  }
-	} else {
-	  it = wlMap.erase(it);
-	}
+      sPtr = snapshot;
+    }
+    size_t numWeak  = 0;
+    size_t released = Deliver(arg, selectFn ? &selectFn : nullptr, *sPtr, numWeak);
+    // each purge copies the snapshot, so large sets wait for a batch
+    if (released>0 && (released>=PruneBatch || 4*released>=numWeak)) {
+      Prune();
+    }
+    return true;
+  }
+  template<typename DataType_, typename InfoType_>
+  bool Listeners<DataType_,InfoType_>::NotifyKey(DataType arg, const InfoType &key) {
+    DeliverKey(arg, key, std::atomic_load(&snapshot));
+    return true;
+  }
+  template<typename DataType_, typename InfoType_>
+  bool Listeners<DataType_,InfoType_>::NotifyKey(DataType        arg,
+						 const InfoType &key,
+						 const CommitFn &commitFn) {
+    SnapshotPtr sPtr;
+    if (true) {
+      std::lock_guard<std::mutex> g(lock);
+      if (commitFn && !commitFn()) {
+	return false;
       }
+      sPtr = snapshot;
     }
-    return rtn;
+    DeliverKey(arg, key, sPtr);
+    return true;
   }
   template<typename DataType_, typename InfoType_>
   Listeners<DataType_,InfoType_>::~Listeners() {}
   template<typename DataType_, typename InfoType_>
-  Listeners<DataType_,InfoType_>::Listeners() {}
+  Listeners<DataType_,InfoType_>::Listeners()
+    : snapshot(new Snapshot) {
+  }
   template<typename DataType_, typename InfoType_>
   void Listeners<DataType_,InfoType_>::Register(std::lock_guard<std::mutex> &,
 						const LPtr &lPtr,
 						bool useWeak) {
     THROW_IF(!lPtr, "Listener uninitialized");
+    Snapshot   *next = new Snapshot(*snapshot);
+    SnapshotPtr nPtr(next);
+    Add(*next, lPtr, useWeak);
+    std::atomic_store(&snapshot, nPtr);
+  }
+  template<typename DataType_, typename InfoType_>
+  size_t Listeners<DataType_,InfoType_>::Deliver(DataType        arg,
+						 const SelectFn *selectFn,
+						 const Bucket   &bucket,
+						 size_t         &numWeak) {
+    for (typename LVec::const_iterator it=bucket.strong.begin(); it!=bucket.strong.end(); ++it) {
+      if (!selectFn || (*selectFn)((*it)->Info())) {
+	(*it)->Notify(arg);
+      }
+    }
+    size_t released = 0;
+    for (typename WLVec::const_iterator it=bucket.weak.begin(); it!=bucket.weak.end(); ++it) {
+      LPtr lPtr = it->second.lock();
+      if (!lPtr) {
+	++released;
+      } else if (!selectFn || (*selectFn)(lPtr->Info())) {
+	lPtr->Notify(arg);
+      }
+    }
+    numWeak += bucket.weak.size();
+    return released;
+  }
+  template<typename DataType_, typename InfoType_>
+  void Listeners<DataType_,InfoType_>::DeliverKey(DataType           arg,
+						  const InfoType    &key,
+						  const SnapshotPtr &sPtr) {
+    if (!sPtr->index) {
+      return;
+    }
+    const Index &index    = *sPtr->index;
+    size_t       numWeak  = 0;
+    size_t       released = 0;
+    const MapPtr &exact = index.exact[Shard(key)];
+    typename BucketMap::const_iterator it;
+    if (exact && (it=exact->find(key))!=exact->end()) {
+      released += Deliver(arg, nullptr, *it->second, numWeak);
+    }
+    for (std::vector<size_t>::const_iterator sz=index.prefixSizes.begin();
+	 sz!=index.prefixSizes.end() && *sz<=key.size();
+	 ++sz) {
+      it = index.prefix.find(key.substr(0, *sz));
+      if (it!=index.prefix.end()) {
+	released += Deliver(arg, nullptr, *it->second, numWeak);
+      }
+    }
+    if (index.any) {
+      released += Deliver(arg, nullptr, *index.any, numWeak);
+    }
+    if (released>0 && (released>=PruneBatch || 4*released>=numWeak)) {
+      Prune();
+    }
+  }
+  template<typename DataType_, typename InfoType_>
+  bool Listeners<DataType_,InfoType_>::Add(Bucket &bucket, const LPtr &lPtr, bool useWeak) {
     if (useWeak) {
-      wlMap[lPtr.get()] = lPtr;
-    } else {
-      lMap[lPtr.get()] = lPtr;
+      typename WLVec::iterator it = bucket.weak.begin();
+      while (it!=bucket.weak.end() && it->first!=lPtr.get()) {
+	++it;
+      }
+      if (it==bucket.weak.end()) {
+	bucket.weak.emplace_back(lPtr.get(), lPtr);
+	return true;
+      }
+      it->second = lPtr;
+    } else if (std::find(bucket.strong.begin(), bucket.strong.end(), lPtr)==bucket.strong.end()) {
+      bucket.strong.push_back(lPtr);
+      return true;
+    }
+    return false;
+  }
+  template<typename DataType_, typename InfoType_>
+  size_t Listeners<DataType_,InfoType_>::Remove(Bucket &bucket, const void *addr) {
+    size_t num = bucket.strong.size()+bucket.weak.size();
+    bucket.strong.erase(std::remove_if(bucket.strong.begin(), bucket.strong.end(),
+				       [addr](const LPtr &l) { return l.get()==addr; }),
+			bucket.strong.end());
+    bucket.weak.erase(std::remove_if(bucket.weak.begin(), bucket.weak.end(),
+				     [addr](const typename WLVec::value_type &w) { return w.first==addr; }),
+		      bucket.weak.end());
+    return num-bucket.strong.size()-bucket.weak.size();
+  }
+  template<typename DataType_, typename InfoType_>
+  size_t Listeners<DataType_,InfoType_>::Prune(Bucket &bucket) {
+    size_t num = bucket.weak.size();
+    bucket.weak.erase(std::remove_if(bucket.weak.begin(), bucket.weak.end(),
+				     [](const typename WLVec::value_type &w) { return w.second.expired(); }),
+		      bucket.weak.end());
+    return num-bucket.weak.size();
+  }
+  template<typename DataType_, typename InfoType_>
+  size_t Listeners<DataType_,InfoType_>::Prune(BucketPtr &bPtr) {
+    size_t num = 0;
+    for (typename WLVec::const_iterator it=bPtr->weak.begin(); it!=bPtr->weak.end(); ++it) {
+      num += it->second.expired() ? 1 : 0;
     }
+    if (num>0) {
+      Bucket *bucket = new Bucket(*bPtr);
+      Prune(*bucket);
+      bPtr.reset(bucket);
+    }
+    return num;
+  }
+  template<typename DataType_, typename InfoType_>
+  void Listeners<DataType_,InfoType_>::Prune() {
+    std::lock_guard<std::mutex> g(lock);
+    Snapshot   *next = new Snapshot(*snapshot);
+    SnapshotPtr nPtr(next);
+    size_t      num  = Prune(*next);
+    if (next->index) {
+      // empty buckets are kept, their keys are likely to be reused
+      Index *index = new Index(*next->index);
+      next->index.reset(index);
+      size_t removed = 0;
+      for (typename std::vector<MapPtr>::iterator mIt=index->exact.begin(); mIt!=index->exact.end(); ++mIt) {
+	if (!*mIt) {
+	  continue;
+	}
+	// copy the shard only if one of its buckets changes
+	BucketMap *map = nullptr;
+	for (typename BucketMap::const_iterator it=(*mIt)->begin(); it!=(*mIt)->end(); ++it) {
+	  BucketPtr bPtr = it->second;
+	  size_t    num  = Prune(bPtr);
+	  if (num>0) {
+	    if (!map) {
+	      map = new BucketMap(**mIt);
+	    }
+	    (*map)[it->first] = bPtr;
+	    removed          += num;
+	  }
+	}
+	if (map) {
+	  mIt->reset(map);
+	}
+      }
+      for (typename BucketMap::iterator it=index->prefix.begin(); it!=index->prefix.end(); ++it) {
+	removed += Prune(it->second);
+      }
+      if (index->any) {
+	removed += Prune(index->any);
+      }
+      next->numKeyed -= removed;
+      num            += removed;
+    }
+    if (num>0) {
+      std::atomic_store(&snapshot, nPtr);
+    }
+  }
+  template<typename DataType_, typename InfoType_>
+  size_t Listeners<DataType_,InfoType_>::Shard(const InfoType &key) {
+    return std::hash<InfoType>()(key) % IndexShards;
+  }
+  template<typename DataType_, typename InfoType_>
+  typename Listeners<DataType_,InfoType_>::BucketMap &
+  Listeners<DataType_,InfoType_>::CopyShard(Index &index, const InfoType &key) {
+    MapPtr    &mPtr = index.exact[Shard(key)];
+    BucketMap *map  = mPtr ? new BucketMap(*mPtr) : new BucketMap;
+    mPtr.reset(map);
+    return *map;
   }
 
   
@@ -1,15 +1,386 @@
 #include <aliSystem_logging.hpp>
+#include <aliSystem_threading.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  using Level    = aliSystem::Logging::Level;
+  using Overflow = aliSystem::Logging::Overflow;
+  using Time     = aliSystem::Time;
+
+  // how long the writer sleeps when it is not woken by a logging thread
+  const std::chrono::milliseconds IDLE(100);
+
+  struct Record {
+    Time::TP    time;
+    std::string text;
+  };
+
+  // A single producer, single consumer ring of log lines.  The logging
+  // thread owning the ring pushes at tail, the writer takes from head and
+  // only advances head once the lines are written, so Flush can wait for
+  // head to pass a tail it has seen.  The owning thread sets writing while
+  // it is between checking that logging is asynchronous and pushing, so
+  // StopAsync can wait for it without a shared counter.
+  struct Ring {
+    explicit Ring(size_t capacity)
+      : slots(capacity),
+	closed(false),
+	head(0),
+	tail(0),
+	writing(false) {
+    }
+    bool Push(Record &rec) {
+      size_t t = tail.load(std::memory_order_relaxed);
+      if (t-head.load(std::memory_order_acquire)>=slots.size()) {
+	return false;
+      }
+      std::swap(slots[t%slots.size()], rec);
+      tail.store(t+1, std::memory_order_release);
+      return true;
+    }
+    bool IsEmpty() const {
+      return head.load(std::memory_order_acquire)==tail.load(std::memory_order_acquire);
+    }
+    std::vector<Record>   slots;
+    std::atomic<bool>     closed;  // the owning thread has exited
+    char                  pad0[aliSystem::Threading::CacheLineSize];
+    std::atomic<size_t>   head;    // written by the writer
+    char                  pad1[aliSystem::Threading::CacheLineSize];
+    std::atomic<size_t>   tail;    // written by the owning thread
+    std::atomic<bool>     writing; // written by the owning thread
+  };
+  using RingPtr = std::shared_ptr<Ring>;
+
+  struct Logger {
+    Logger()
+      : level(Level::INFO),
+	overflow(Overflow::BLOCK),
+	capacity(4096),
+	async(false),
+	dropped(0),
+	stopping(false),
+	sleeping(false) {
+    }
+    std::atomic<Level>    level;
+    std::atomic<Overflow> overflow;
+    std::atomic<size_t>   capacity;
+    std::atomic<bool>     async;
+    std::atomic<uint64_t> dropped;
+    std::mutex            syncLock;  // serializes synchronous writes
+    std::mutex            lock;      // guards rings, stopping and the writer
+    std::vector<RingPtr>  rings;
+    std::thread           writer;
+    bool                  stopping;
+    std::atomic<bool>     sleeping;
+    std::condition_variable cv;
+  };
+
+  // Logging happens in the destructors of static objects, so the logger
+  // is never destroyed; StopAsync is called at exit instead.
+  Logger &GetLogger() {
+    static Logger *logger = new Logger;
+    return *logger;
+  }
+
+  // the calling thread's ring, marked closed when the thread exits so the
+  // writer can drop it once it is drained.
+  struct RingHolder {
+    ~RingHolder() {
+      if (ring) {
+	ring->closed = true;
+      }
+    }
+    RingPtr ring;
+  };
+
+  Ring &ThreadRing(Logger &logger) {
+    thread_local RingHolder holder;
+    if (!holder.ring) {
+      holder.ring = std::make_shared<Ring>(logger.capacity.load());
+      std::lock_guard<std::mutex> g(logger.lock);
+      logger.rings.push_back(holder.ring);
+    }
+    return *holder.ring;
+  }
+
+  void Wake(Logger &logger) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (logger.sleeping) {
+      std::lock_guard<std::mutex> g(logger.lock);
+      logger.cv.notify_one();
+    }
+  }
+
+  std::string Stamp(const Time::TP &time) {
+    std::ostringstream ss;
+    ss << time;
+    return ss.str();
+  }
+
+  void Format(std::string &out, const Record &rec) {
+    out += Stamp(rec.time);
+    out += ' ';
+    out += rec.text;
+    out += '\n';
+  }
+
+  // Take every queued line, write them in time order and only then
+  // release their slots.  Returns false if there was nothing to write.
+  bool Drain(Logger &logger) {
+    std::vector<RingPtr> rings;
+    if (true) {
+      std::lock_guard<std::mutex> g(logger.lock);
+      rings = logger.rings;
+    }
+    std::vector<Record> batch;
+    std::vector<size_t> tails(rings.size());
+    for (size_t i=0;i<rings.size();++i) {
+      Ring  &ring = *rings[i];
+      size_t h    = ring.head.load(std::memory_order_relaxed);
+      tails[i]    = ring.tail.load(std::memory_order_acquire);
+      for (size_t j=h;j<tails[i];++j) {
+	batch.push_back(Record());
+	std::swap(batch.back(), ring.slots[j%ring.slots.size()]);
+      }
+    }
+    if (batch.empty()) {
+      return false;
+    }
+    // each ring is in order, lines from different threads are interleaved
+    std::stable_sort(batch.begin(), batch.end(),
+		     [](const Record &a, const Record &b) { return a.time<b.time; });
+    std::string out;
+    for (std::vector<Record>::const_iterator it=batch.begin(); it!=batch.end(); ++it) {
+      Format(out, *it);
+    }
+    if (true) {
+      std::lock_guard<std::mutex> g(logger.syncLock);
+      std::cout.write(out.data(), out.size());
+      std::cout.flush();
+    }
+    for (size_t i=0;i<rings.size();++i) {
+      rings[i]->head.store(tails[i], std::memory_order_release);
+    }
+    return true;
+  }
+
+  // call with the logger's lock held
+  bool AllEmpty(const Logger &logger) {
+    for (std::vector<RingPtr>::const_iterator it=logger.rings.begin(); it!=logger.rings.end(); ++it) {
+      if (!(*it)->IsEmpty()) {
+	return false;
+      }
+    }
+    return true;
+  }
+
+  // drop the rings of exited threads once they are empty
+  void Prune(Logger &logger) {
+    std::lock_guard<std::mutex> g(logger.lock);
+    logger.rings.erase(std::remove_if(logger.rings.begin(), logger.rings.end(),
+				      [](const RingPtr &r) { return r->closed && r->IsEmpty(); }),
+		       logger.rings.end());
+  }
+
+  void WriterMain(Logger *logger) {
+    uint64_t reported = 0;
+    while (true) {
+      bool wrote = Drain(*logger);
+      uint64_t dropped = logger->dropped.load();
+      if (dropped!=reported) {
+	Record rec;
+	rec.time = Time::Now();
+	rec.text = "WARN  (logging) " + std::to_string(dropped-reported) + " log lines dropped, the logging threads' rings were full";
+	std::string out;
+	Format(out, rec);
+	std::lock_guard<std::mutex> g(logger->syncLock);
+	std::cout << out << std::flush;
+	reported = dropped;
+      }
+      if (wrote) {
+	continue;
+      }
+      Prune(*logger);
+      std::unique_lock<std::mutex> g(logger->lock);
+      if (logger->stopping) {
+	if (AllEmpty(*logger)) {
+	  break;
+	}
+	continue;
+      }
+      // announce the sleep before the final check, so a logging thread
+      // either sees the writer sleeping or the writer sees its line.
+      logger->sleeping = true;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (AllEmpty(*logger)) {
+	logger->cv.wait_for(g, IDLE);
+      }
+      logger->sleeping = false;
+    }
+  }
+
+  void WriteSync(Logger &logger, const Time::TP &time, const std::string &text) {
+    std::string line = Stamp(time) + " " + text;
+    std::lock_guard<std::mutex> g(logger.syncLock);
+    std::cout << line << std::endl;
+  }
+
+  // wait for threads that saw logging as asynchronous to push their line
+  void WaitForWriting(Logger &logger) {
+    std::vector<RingPtr> rings;
+    if (true) {
+      std::lock_guard<std::mutex> g(logger.lock);
+      rings = logger.rings;
+    }
+    for (std::vector<RingPtr>::const_iterator it=rings.begin(); it!=rings.end(); ++it) {
+      while ((*it)->writing) {
+	std::this_thread::yield();
+      }
+    }
+  }
+
+  void StopAtExit() {
+    aliSystem::Logging::StopAsync();
+  }
+
+}
 
 namespace aliSystem {
   namespace Logging {
-    
-    bool IsDebug() { return false; }
 
+    bool IsDebug() {
+      return IsEnabled(Level::DEBUG);
+    }
+    bool IsEnabled(Level level) {
+      return level>=GetLogger().level.load(std::memory_order_relaxed) && level!=Level::NONE;
+    }
+    Level GetLevel() {
+      return GetLogger().level;
+    }
+    void SetLevel(Level level) {
+      GetLogger().level = level;
+    }
+    Level ToLevel(const std::string &name) {
+      if (name=="debug") { return Level::DEBUG; }
+      if (name=="info")  { return Level::INFO;  }
+      if (name=="warn")  { return Level::WARN;  }
+      if (name=="error") { return Level::ERROR; }
+      if (name=="none")  { return Level::NONE;  }
+      THROW("Unrecognized log level '" << name << "', expecting debug, info, warn, error or none");
+    }
+    Overflow ToOverflow(const std::string &name) {
+      if (name=="block") { return Overflow::BLOCK; }
+      if (name=="drop")  { return Overflow::DROP;  }
+      THROW("Unrecognized log overflow '" << name << "', expecting block or drop");
+    }
+    void StartAsync(size_t capacity, Overflow overflow) {
+      THROW_IF(capacity==0, "Log rings must hold at least one line");
+      static bool registered = (std::atexit(StopAtExit), true);
+      (void)registered;
+      Logger &logger = GetLogger();
+      logger.capacity = capacity;
+      logger.overflow = overflow;
+      std::lock_guard<std::mutex> g(logger.lock);
+      if (!logger.writer.joinable()) {
+	logger.stopping = false;
+	logger.writer   = std::thread(WriterMain, &logger);
+      }
+      logger.async = true;
+    }
+    void StopAsync() {
+      Logger &logger = GetLogger();
+      logger.async = false;
+      // lines logged by threads that saw async set are pushed before they
+      // leave, so the writer drains them.
+      WaitForWriting(logger);
+      std::thread writer;
+      if (true) {
+	std::lock_guard<std::mutex> g(logger.lock);
+	logger.stopping = true;
+	logger.writer.swap(writer);
+	logger.cv.notify_one();
+      }
+      if (writer.joinable()) {
+	writer.join();
+      }
+    }
+    bool IsAsync() {
+      return GetLogger().async;
+    }
+    void Flush() {
+      Logger              &logger = GetLogger();
+      std::vector<RingPtr> rings;
+      if (true) {
+	std::lock_guard<std::mutex> g(logger.lock);
+	rings = logger.rings;
+      }
+      for (std::vector<RingPtr>::const_iterator it=rings.begin(); it!=rings.end(); ++it) {
+	size_t target = (*it)->tail.load(std::memory_order_acquire);
+	while ((*it)->head.load(std::memory_order_acquire)<target && logger.async) {
+	  Wake(logger);
+	  std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+      }
+    }
+    uint64_t NumDropped() {
+      return GetLogger().dropped;
+    }
+    void Write(const std::string &text) {
+      Logger  &logger = GetLogger();
+      Time::TP now    = Time::Now();
+      if (!logger.async) {
+	WriteSync(logger, now, text);
+	return;
+      }
+      // only this thread writes its ring's flag and tail, so nothing here
+      // shares a cache line with other logging threads.
+      Ring &ring = ThreadRing(logger);
+      ring.writing = true;
+      if (!logger.async) {
+	ring.writing = false;
+	WriteSync(logger, now, text);
+	return;
+      }
+      Record rec    = { now, text };
+      bool   pushed = true;
+      while (!ring.Push(rec)) {
+	if (logger.overflow==Overflow::DROP) {
+	  ++logger.dropped;
+	  pushed = false;
+	  break;
+	}
+	Wake(logger);
+	std::this_thread::yield();
+      }
+      ring.writing.store(false, std::memory_order_release);
+      // The writer drains every ring before it sleeps, so it only needs
+      // waking when this line made the ring non empty.  Had it gone to
+      // sleep without seeing the line, it had consumed everything before
+      // it, which the fence makes visible here.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (pushed && ring.head.load(std::memory_order_relaxed)+1==ring.tail.load(std::memory_order_relaxed)) {
+	Wake(logger);
+      }
+    }
     std::string CurTime() {
-      std::ostringstream ss;
-      ss << aliSystem::Time::Now();
-      return ss.str();
+      return Stamp(aliSystem::Time::Now());
+    }
+    std::ostream &operator<<(std::ostream &out, const Level &o) {
+      switch (o) {
+      case Level::DEBUG: out << "debug"; break;
+      case Level::INFO:  out << "info";  break;
+      case Level::WARN:  out << "warn";  break;
+      case Level::ERROR: out << "error"; break;
+      case Level::NONE:  out << "none";  break;
+      }
+      return out;
     }
   }
 }
-
@@ -1,49 +1,152 @@
 #ifndef INCLUDED_ALI_SYSTEM_LOGGING
 #define INCLUDED_ALI_SYSTEM_LOGGING
 
+#include <cstdint>
 #include <iostream>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
+#include <string>
 #include <aliSystem_time.hpp>
 
 //
 // This module defines some trivial logging functions for the aliSystem library
 // and any application that leverages the library.
+//
+// Log lines are written to stdout.  By default each line is written, and
+// flushed, by the thread logging it.  Once StartAsync has been called, a
+// line is instead queued in a lock free ring owned by the logging thread
+// and a background writer thread takes the lines from every thread's ring,
+// formats their time stamps and writes them in batches, so logging never
+// waits for stdout.  Which levels are logged can be changed at any time
+// with SetLevel.
 
 namespace aliSystem {
   namespace Logging {
+
+    /// @brief Level identifies the severity of a log line
+    enum class Level {
+      DEBUG,  ///< debugging details
+      INFO,   ///< normal operation
+      WARN,   ///< unexpected but handled conditions
+      ERROR,  ///< failures, including thrown exceptions
+      NONE    ///< as a level to log, logs nothing
+    };
+
+    /// @brief Overflow identifies what a thread does when its ring is full
+    enum class Overflow {
+      BLOCK,  ///< wait for the writer thread to make room
+      DROP    ///< discard the line, see NumDropped
+    };
+
     /// @brief function for flagging wheather or not to print debug messages
     /// @return true if a debug  message should be printed
     bool IsDebug();
+
+    /// @brief test whether lines of the given level are logged
+    /// @param level the level
+    /// @return true if the level is at or above the current level
+    bool IsEnabled(Level level);
+
+    /// @brief retrieve the current level
+    /// @return the lowest level logged
+    Level GetLevel();
+
+    /// @brief Set the lowest level logged, Level::INFO by default.
+    /// @param level the lowest level to log, Level::NONE logs nothing
+    void SetLevel(Level level);
+
+    /// @brief parse a level name
+    /// @param name one of debug, info, warn, error or none
+    /// @return the level
+    /// @note throws if the name is not a level
+    Level ToLevel(const std::string &name);
+
+    /// @brief parse an overflow policy name
+    /// @param name one of block or drop
+    /// @return the policy
+    /// @note throws if the name is not a policy
+    Overflow ToOverflow(const std::string &name);
+
+    /// @brief Start writing log lines from a background thread.
+    /// @param capacity number of lines each thread's ring holds
+    /// @param overflow what a thread does when its ring is full
+    /// @note A running writer is kept, only the overflow policy and the
+    ///       capacity of rings created from then on change.
+    void StartAsync(size_t capacity=4096, Overflow overflow=Overflow::BLOCK);
+
+    /// @brief Write every queued line and go back to writing log lines
+    ///        on the logging thread.
+    /// @note Called at exit, so lines queued before then are not lost.
+    void StopAsync();
+
+    /// @brief test whether log lines are written by the background thread
+    /// @return true between StartAsync and StopAsync
+    bool IsAsync();
+
+    /// @brief wait until the lines logged so far have been written
+    void Flush();
+
+    /// @brief retrieve the number of lines discarded by Overflow::DROP
+    /// @return the number of lines discarded since the process started
+    uint64_t NumDropped();
+
+    /// @brief log a line, whatever the current level
+    /// @param text the line, without a time stamp, which is added when
+    ///        the line is written
+    void Write(const std::string &text);
+
+    /// @brief format the current time as written at the start of log lines
+    /// @return the current time
     std::string CurTime();
-    
+
+    /// @brief Level serialization operator
+    /// @param out the stream to write to
+    /// @param o the level to write
+    /// @return the stream passed as the out parameter
+    std::ostream &operator<<(std::ostream &out, const Level &o);
+
   }
 }
 
 
 /// @brief returns a log record prefix (time, file, line, function)
-#define PREFIX(X) aliSystem::Logging::CurTime() << " " << X << " (" << __FILE__ << " " << __LINE__ << " " << __func__ << ") "
+#define PREFIX(X) aliSystem::Logging::CurTime() << " " << LOCATION(X)
+
+/// @brief returns a log record prefix without the time (file, line, function)
+#define LOCATION(X) X << " (" << __FILE__ << " " << __LINE__ << " " << __func__ << ") "
 
-/// @brief logs the the passed output chain to stdout while also collecting the message.
+/// @brief logs the the passed output chain while also collecting the message.
 /// @param X data to log (and collect)
-#define BASE( X)  std::ostringstream ss; ss << X; std::cout << ss.str() << std::endl;
+#define BASE( X)  std::ostringstream ss; ss << X; aliSystem::Logging::Write(ss.str());
+
+/// @brief generate a log line if its level is enabled
+/// @param LEVEL the line's aliSystem::Logging::Level
+/// @param TAG the level's name as written in the line
+/// @param X data to log
+#define LOG_AT(LEVEL, TAG, X) do {					\
+    if (aliSystem::Logging::IsEnabled(aliSystem::Logging::Level::LEVEL)) { \
+      std::ostringstream aliLogSS;					\
+      aliLogSS << LOCATION(TAG) << X;					\
+      aliSystem::Logging::Write(aliLogSS.str());			\
+    }									\
+  } while (0)
 
 /// @brief generate a debug log line, only logged if debug logs are enabled
 /// @param X data to log
-#define DEBUG(X) do { if (aliSystem::Logging::IsDebug()) { std::cout << PREFIX("DEBUG") << X << std::endl; } } while (0)
+#define DEBUG(X) LOG_AT(DEBUG, "DEBUG", X)
 
 /// @brief generate an info log line
 /// @param X data to log
-#define INFO( X) do { std::cout << PREFIX("INFO ") << X << std::endl; } while (0)
+#define INFO( X) LOG_AT(INFO,  "INFO ", X)
 
 /// @brief generate an warning log line
 /// @param X data to log
-#define WARN( X) do { std::cout << PREFIX("WARN ") << X << std::endl; } while (0)
+#define WARN( X) LOG_AT(WARN,  "WARN ", X)
 
 /// @brief generate an error log line
 /// @param X data to log
-#define ERROR(X) do { std::cout << PREFIX("ERROR") << X << std::endl; } while (0)
+#define ERROR(X) LOG_AT(ERROR, "ERROR", X)
 
 /// @brief generate a debug log line if debugging is enabled and flagged to log
 /// @param cond condition indicating whether or not to log a line
@@ -67,9 +170,13 @@ namespace aliSystem {
 
 /// @brief generate a "throw" log line and throw a std::exception with the log message.
 /// @param X data to log
-#define THROW(X)          do {			\
-    BASE(PREFIX("THROW") << X);			\
-    throw std::runtime_error(ss.str());		\
+#define THROW(X)          do {					\
+    std::ostringstream ss;						\
+    ss << LOCATION("THROW") << X;					\
+    if (aliSystem::Logging::IsEnabled(aliSystem::Logging::Level::ERROR)) { \
+      aliSystem::Logging::Write(ss.str());				\
+    }									\
+    throw std::runtime_error(aliSystem::Logging::CurTime() + " " + ss.str()); \
   } while(0)
 
 /// @brief generate a "throw" log line and throw a std::exception with the log message if flagged to log.
@@ -1,5 +1,20 @@
 #include <aliSystem_registry.hpp>
 #include <aliSystem_logging.hpp>
+#include <cstdint>
+
+namespace {
+
+  // Addresses are aligned, so their low bits are mostly zero; mix the
+  // bits before taking the shard from the top of the product.
+  size_t ShardOf(const void *addr) {
+    uint64_t a = reinterpret_cast<uintptr_t>(addr);
+    a ^= a>>17;
+    a *= 0x9E3779B97F4A7C15ull;
+    return a>>60;
+  }
+  static_assert(aliSystem::Registry::NumShards==16, "ShardOf takes the top 4 bits");
+
+}
 
 namespace aliSystem {
 
@@ -11,27 +26,59 @@ namespace aliSystem {
   const std::string &Registry::Name() const { return name; }
   void Registry::Register(const ItemPtr &ptr) {
     if (ptr.get()) {
-      std::lock_guard<std::mutex> g(lock);
-      items[ptr.get()] = ptr;
+      Shard &shard = GetShard(ptr.get());
+      std::lock_guard<std::mutex> g(shard.lock);
+      shard.items[ptr.get()] = ptr;
     }
   }
   void Registry::Unregister(const ItemPtr &ptr) {
     Unregister(ptr.get());
   }
   void Registry::Unregister(const void *addr) {
-    std::lock_guard<std::mutex> g(lock);
-    items.erase(addr);
+    // the item is released after the lock, its destructor may use the registry
+    ItemPtr item;
+    Shard  &shard = GetShard(addr);
+    if (true) {
+      std::lock_guard<std::mutex> g(shard.lock);
+      ItemMap::iterator it = shard.items.find(addr);
+      if (it!=shard.items.end()) {
+	item.swap(it->second);
+	shard.items.erase(it);
+      }
+    }
   }
   Registry::ItemPtr Registry::Get(const void *addr) {
     ItemPtr rtn;
-    std::lock_guard<std::mutex> g(lock);
-    ItemMap::const_iterator it = items.find(addr);
-    if (it!=items.end()) {
+    Shard  &shard = GetShard(addr);
+    std::lock_guard<std::mutex> g(shard.lock);
+    ItemMap::const_iterator it = shard.items.find(addr);
+    if (it!=shard.items.end()) {
       rtn = it->second;
     }
     return rtn;
   }
+  size_t Registry::Size() const {
+    size_t rtn = 0;
+    for (size_t i=0;i<NumShards;++i) {
+      std::lock_guard<std::mutex> g(shards[i].lock);
+      rtn += shards[i].items.size();
+    }
+    return rtn;
+  }
+  Registry::Items Registry::Snapshot() const {
+    Items rtn;
+    for (size_t i=0;i<NumShards;++i) {
+      std::lock_guard<std::mutex> g(shards[i].lock);
+      for (ItemMap::const_iterator it=shards[i].items.begin(); it!=shards[i].items.end(); ++it) {
+	rtn.push_back(it->second);
+      }
+    }
+    return rtn;
+  }
   Registry::~Registry() {}
   Registry::Registry() {}
+  Registry::Shard &Registry::GetShard(const void *addr) {
+    return shards[ShardOf(addr)];
+  }
 
 }
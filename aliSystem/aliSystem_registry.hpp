@@ -1,9 +1,11 @@
 #ifndef INCLUDED_ALI_SYSTEM_REGISTRY
 #define INCLUDED_ALI_SYSTEM_REGISTRY
 
-#include <map>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace aliSystem {
 
@@ -20,10 +22,18 @@ namespace aliSystem {
   /// caller needs to share ownership for some period, it can simply retain a shared
   /// pointer.
   ///
+  /// Items are spread by address over NumShards hash maps, each behind its
+  /// own lock, so registering, unregistering and looking up items are
+  /// constant time and threads working on different items rarely contend.
+  ///
   struct Registry {
-    using Ptr     = std::shared_ptr<Registry>;      ///< shared pointer
-    using ItemPtr = std::shared_ptr<void>;          ///< item pointer
-    using ItemMap = std::map<const void*, ItemPtr>; ///< map of item pointer's address to the item pointer
+    using Ptr     = std::shared_ptr<Registry>;                ///< shared pointer
+    using ItemPtr = std::shared_ptr<void>;                    ///< item pointer
+    using ItemMap = std::unordered_map<const void*, ItemPtr>; ///< map of item pointer's address to the item pointer
+    using Items   = std::vector<ItemPtr>;                     ///< items copied by Snapshot
+
+    /// @brief the number of shards the items are spread over
+    static const size_t NumShards = 16;
 
     /// @brief Create an object registry
     /// @param name name of the registry
@@ -56,6 +66,17 @@ namespace aliSystem {
     ///       a null pointer is returned.
     ItemPtr Get(const void *addr);
 
+    /// @brief retrieve the number of registered items
+    /// @return the number of items, which may be changing concurrently
+    size_t Size() const;
+
+    /// @brief Copy the registered items, for introspection.
+    /// @return the items, in no particular order
+    /// @note Each shard is locked only while it is copied, so writers are
+    ///       not held up by the whole copy; items registered or unregistered
+    ///       during the copy may or may not be included.
+    Items Snapshot() const;
+
     /// @brief registry destructor
     ~Registry();
     
@@ -64,9 +85,20 @@ namespace aliSystem {
     /// @brief registry constructor
     Registry();
 
-    std::string name; ///< registry's name
-    std::mutex  lock;   ///< lock used to serialize access to items
-    ItemMap     items;  ///< items managed by an instance
+    /// @brief a subset of the items
+    struct Shard {
+      mutable std::mutex lock;     ///< lock used to serialize access to items
+      ItemMap            items;    ///< items in the shard
+      char               pad[64];  ///< keeps shards off each other's cache lines
+    };
+
+    /// @brief find the shard holding an address
+    /// @param addr the item's address
+    /// @return the shard
+    Shard &GetShard(const void *addr);
+
+    std::string name;               ///< registry's name
+    Shard       shards[NumShards];  ///< items managed by an instance
   };
   
 }
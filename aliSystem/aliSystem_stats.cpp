@@ -1,35 +1,103 @@
 #include <aliSystem_stats.hpp>
 #include <aliSystem_logging.hpp>
+#include <aliSystem_statsRegistry.hpp>
+#include <chrono>
 #include <cstring>
 
+namespace {
+
+  // the shard used by the calling thread, threads are spread over the
+  // shards in the order they first increment a stats object.
+  size_t ShardIndex() {
+    static std::atomic<size_t> next(0);
+    thread_local size_t        index = next++;
+    return index % aliSystem::Stats::NumShards;
+  }
+  
+}
+
 namespace aliSystem {
 
-  Stats::Ptr Stats::Create(const std::string &name) {
-    Ptr rtn(new Stats(name));
+  Stats::Ptr Stats::Create(const std::string &name, bool keepLatencies) {
+    Ptr rtn(new Stats(name, keepLatencies));
     return rtn;
   }
-  Stats::Stats(const std::string &name_)
+  Stats::Stats(const std::string &name_, bool keepLatencies_)
     : name(name_),
-      count(0),
-      runTime(Time::Dur::zero()) {
+      id(0),
+      keepLatencies(keepLatencies_) {
+    for (size_t i=0;i<NumShards;++i) {
+      shards[i].count   = 0;
+      shards[i].runTime = 0;
+      shards[i].latency = nullptr;
+    }
+    id = StatsRegistry::Add(this);
+  }
+  Stats::~Stats() {
+    StatsRegistry::Remove(id);
+    for (size_t i=0;i<NumShards;++i) {
+      delete shards[i].latency.load();
+    }
   }
-  Stats::~Stats() {}
   const std::string &Stats::Name            () const { return name; }
-  size_t             Stats::Count           () const { return count;   }
-  Time::Dur          Stats::RunTime         () const { return runTime; }
+  uint64_t           Stats::Id              () const { return id;   }
+  size_t Stats::Count() const {
+    size_t rtn = 0;
+    for (size_t i=0;i<NumShards;++i) {
+      rtn += shards[i].count.load(std::memory_order_relaxed);
+    }
+    return rtn;
+  }
+  Time::Dur Stats::RunTime() const {
+    Time::Dur::rep rtn = 0;
+    for (size_t i=0;i<NumShards;++i) {
+      rtn += shards[i].runTime.load(std::memory_order_relaxed);
+    }
+    return Time::Dur(rtn);
+  }
+  Time::Dur Stats::Percentile(double fraction) const {
+    Histogram h;
+    Latencies(h);
+    return std::chrono::duration_cast<Time::Dur>(std::chrono::nanoseconds(h.Percentile(fraction)));
+  }
+  void Stats::Latencies(Histogram &out) const {
+    for (size_t i=0;i<NumShards;++i) {
+      const Histogram *h = shards[i].latency.load(std::memory_order_acquire);
+      if (h) {
+	out.Add(*h);
+      }
+    }
+  }
   void Stats::Inc(const Time::Dur &timeInc) {
-    std::lock_guard<std::mutex> g(lock);
-    ++count;
-    runTime += timeInc;
+    Shard &shard = shards[ShardIndex()];
+    shard.count  .fetch_add(1,               std::memory_order_relaxed);
+    shard.runTime.fetch_add(timeInc.count(), std::memory_order_relaxed);
+    if (keepLatencies) {
+      int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timeInc).count();
+      GetLatency(shard).Record(ns>0 ? uint64_t(ns) : 0);
+    }
+  }
+  Histogram &Stats::GetLatency(Shard &shard) {
+    Histogram *h = shard.latency.load(std::memory_order_acquire);
+    if (!h) {
+      // racing first increments each build one, the loser drops its own
+      Histogram *mine = new Histogram;
+      if (shard.latency.compare_exchange_strong(h, mine, std::memory_order_acq_rel)) {
+	h = mine;
+      } else {
+	delete mine;
+      }
+    }
+    return *h;
   }
   std::ostream &operator<<(std::ostream &out, const Stats &o) {
     out << "Stats(name=" << o.name
-	<< ", count="    << o.count
-	<< ", runTime="  << Time::ToSeconds(o.runTime)
+	<< ", count="    << o.Count()
+	<< ", runTime="  << Time::ToSeconds(o.RunTime())
+	<< ", p50="      << Time::ToSeconds(o.Percentile(0.5))
+	<< ", p99="      << Time::ToSeconds(o.Percentile(0.99))
 	<< ")";
     return out;
   }
   
 }
-
-
@@ -1,9 +1,10 @@
 #ifndef INCLUDED_ALI_SYSTEM_STATS
 #define INCLUDED_ALI_SYSTEM_STATS
 
+#include <aliSystem_histogram.hpp>
 #include <aliSystem_time.hpp>
+#include <atomic>
 #include <memory>
-#include <mutex>
 #include <ostream>
 #include <string>
 #include <time.h>
@@ -13,26 +14,59 @@ namespace aliSystem {
   ///
   /// @brief A stats object for recording runtie statisics.
   ///
+  /// Besides a count and the total run time, a stats object keeps a
+  /// Histogram of the individual run times from which latency
+  /// percentiles are read.
+  ///
+  /// Busy stats objects are incremented from many threads at once, so
+  /// the counters are split into NumShards shards, each on its own cache
+  /// lines.  A thread always increments the same shard, without a lock,
+  /// and reads merge the shards.  Each shard has its own histogram, so
+  /// threads recording similar run times do not contend on the same
+  /// bucket.  A shard's histogram is allocated on its first increment,
+  /// and not at all for stats created without latencies.  A read made
+  /// while other threads increment the object may see some of their
+  /// increments and not others.
+  ///
+  /// Every stats object is listed in the StatsRegistry for as long as it
+  /// exists.
+  ///
   struct Stats {
     using Ptr  = std::shared_ptr<Stats>;  ///< shared pointer
     using WPtr = std::weak_ptr  <Stats>;  ///< weak pointer
 
+    /// @brief number of shards the counters are split into
+    static const size_t NumShards = 8;
+
     /// @brief create a stats object
     /// @param name a description of the stats object.
+    /// @param keepLatencies false to record only the count and run time,
+    ///        for bookkeeping stats whose percentiles are of no interest.
     /// @return a stats object
-    static Ptr Create(const std::string &name);
+    static Ptr Create(const std::string &name, bool keepLatencies=true);
 
     /// @brief stats construtor
     /// @param name of the stats object
-    Stats(const std::string &name);
+    /// @param keepLatencies false to record only the count and run time
+    Stats(const std::string &name, bool keepLatencies=true);
 
     /// @brief stats destructor
     ~Stats();
 
+    /// @brief Copy constructor is deleted
+    Stats(const Stats &) = delete;
+
+    /// @brief Assignment operator is deleted
+    Stats &operator=(const Stats &) = delete;
+
     /// @brief Name returns the name of the stats object
     /// @return the stats object's name
     const std::string &Name() const;
 
+    /// @brief Id returns the stats object's process wide unique id
+    /// @return the id, ids are assigned in creation order and never reused
+    uint64_t Id() const;
+
     /// @brief Count returns the current count of the stats object
     /// @return the current count
     size_t Count() const;
@@ -41,6 +75,18 @@ namespace aliSystem {
     /// @return the total accumulated time for the stats object.
     Time::Dur RunTime() const;
 
+    /// @brief retrieve a run time percentile
+    /// @param fraction the fraction of run times at or below the result,
+    ///        for example 0.99 for the 99th percentile
+    /// @return the percentile, to within 1/Histogram::SubBuckets of the
+    ///         run time, zero if nothing has been recorded
+    Time::Dur Percentile(double fraction) const;
+
+    /// @brief add the run time histogram to the passed one
+    /// @param out [out] histogram the run times, in nanoseconds, are
+    ///        added to
+    void Latencies(Histogram &out) const;
+
     /// @brief Inc increments the stats object's count and its execution time
     /// The incremental time is computed using the passed number of sconds.
     /// @param timeInc amount to increment the stats object's time
@@ -52,11 +98,24 @@ namespace aliSystem {
     friend std::ostream &operator<<(std::ostream &out, const Stats &o);
     
   private:
-    
-    std::mutex  lock;    ///< lock used to guard manipulations of the count & runTime
-    std::string name;    ///< name of the stats instance
-    size_t      count;   ///< stats count
-    Time::Dur   runTime; ///< stats runTime
+
+    /// @brief the counters incremented by one group of threads
+    struct Shard {
+      std::atomic<size_t>         count;    ///< stats count
+      std::atomic<Time::Dur::rep> runTime;  ///< stats runTime, in Time::Dur ticks
+      std::atomic<Histogram*>     latency;  ///< run times in nanoseconds, null until used
+      char                        pad[64];  ///< keeps shards off each other's cache lines
+    };
+
+    /// @brief retrieve a shard's histogram, allocating it on first use
+    /// @param shard the shard
+    /// @return the histogram
+    static Histogram &GetLatency(Shard &shard);
+
+    std::string             name;               ///< name of the stats instance
+    uint64_t                id;                 ///< id in the StatsRegistry
+    bool                    keepLatencies;      ///< run times are recorded in the shard histograms
+    Shard                   shards[NumShards];  ///< counters, merged on read
   };
 
 }
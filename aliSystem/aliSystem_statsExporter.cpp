@@ -0,0 +1,209 @@
+#include <aliSystem_statsExporter.hpp>
+#include <aliSystem_logging.hpp>
+#include <aliSystem_util.hpp>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+namespace {
+
+  using Sample = aliSystem::StatsRegistry::Sample;
+  using Time   = aliSystem::Time;
+
+  // the changes of a stats object since the previous export
+  struct Delta {
+    size_t count;
+    double runTime;
+    double rate;
+  };
+
+  // escape a Prometheus label value
+  std::string Label(const std::string &value) {
+    std::string rtn;
+    for (std::string::const_iterator it=value.begin(); it!=value.end(); ++it) {
+      switch (*it) {
+      case '\\': rtn += "\\\\"; break;
+      case '"':  rtn += "\\\"";  break;
+      case '\n': rtn += "\\n";  break;
+      default:   rtn += *it;    break;
+      }
+    }
+    return rtn;
+  }
+
+  void Header(std::ostream &out, const char *name, const char *type, const char *help) {
+    out << "# HELP " << name << " " << help << "\n"
+	<< "# TYPE " << name << " " << type << "\n";
+  }
+
+  void WritePrometheus(std::ostream &out, const std::vector<Sample> &samples, const std::vector<Delta> &deltas) {
+    std::vector<std::string> labels;
+    for (size_t i=0;i<samples.size();++i) {
+      labels.push_back("name=\"" + Label(samples[i].name) + "\",id=\"" + std::to_string(samples[i].id) + "\"");
+    }
+    Header(out, "ali_stats_count", "counter", "number of times the stats object was incremented");
+    for (size_t i=0;i<samples.size();++i) {
+      out << "ali_stats_count{" << labels[i] << "} " << samples[i].count << "\n";
+    }
+    Header(out, "ali_stats_run_seconds", "counter", "total run time recorded by the stats object");
+    for (size_t i=0;i<samples.size();++i) {
+      out << "ali_stats_run_seconds{" << labels[i] << "} " << Time::ToSeconds(samples[i].runTime) << "\n";
+    }
+    Header(out, "ali_stats_count_delta", "gauge", "increments since the previous export");
+    for (size_t i=0;i<samples.size();++i) {
+      out << "ali_stats_count_delta{" << labels[i] << "} " << deltas[i].count << "\n";
+    }
+    Header(out, "ali_stats_run_seconds_delta", "gauge", "run time recorded since the previous export");
+    for (size_t i=0;i<samples.size();++i) {
+      out << "ali_stats_run_seconds_delta{" << labels[i] << "} " << deltas[i].runTime << "\n";
+    }
+    Header(out, "ali_stats_rate", "gauge", "increments per second since the previous export");
+    for (size_t i=0;i<samples.size();++i) {
+      out << "ali_stats_rate{" << labels[i] << "} " << deltas[i].rate << "\n";
+    }
+    Header(out, "ali_stats_latency_seconds", "summary", "run time percentiles since the stats object was created");
+    for (size_t i=0;i<samples.size();++i) {
+      out << "ali_stats_latency_seconds{" << labels[i] << ",quantile=\"0.5\"} "   << Time::ToSeconds(samples[i].p50)     << "\n"
+	  << "ali_stats_latency_seconds{" << labels[i] << ",quantile=\"0.99\"} "  << Time::ToSeconds(samples[i].p99)     << "\n"
+	  << "ali_stats_latency_seconds{" << labels[i] << ",quantile=\"0.999\"} " << Time::ToSeconds(samples[i].p999)    << "\n"
+	  << "ali_stats_latency_seconds_sum{"   << labels[i] << "} "               << Time::ToSeconds(samples[i].runTime) << "\n"
+	  << "ali_stats_latency_seconds_count{" << labels[i] << "} "               << samples[i].count                    << "\n";
+    }
+  }
+
+  void WriteJson(std::ostream &out, double now, const std::vector<Sample> &samples, const std::vector<Delta> &deltas) {
+    for (size_t i=0;i<samples.size();++i) {
+      const Sample &s = samples[i];
+      const Delta  &d = deltas[i];
+      out << "{\"time\":"          << now
+	  << ",\"name\":"          << aliSystem::Util::JsonQuote(s.name)
+	  << ",\"id\":"            << s.id
+	  << ",\"count\":"         << s.count
+	  << ",\"runTime\":"       << Time::ToSeconds(s.runTime)
+	  << ",\"countDelta\":"    << d.count
+	  << ",\"runTimeDelta\":"  << d.runTime
+	  << ",\"rate\":"          << d.rate
+	  << ",\"p50\":"           << Time::ToSeconds(s.p50)
+	  << ",\"p99\":"           << Time::ToSeconds(s.p99)
+	  << ",\"p999\":"          << Time::ToSeconds(s.p999)
+	  << "}\n";
+    }
+  }
+
+}
+
+namespace aliSystem {
+
+  StatsExporter::Ptr StatsExporter::Create(const std::string &path,
+					   Format             format,
+					   const Time::Dur   &period) {
+    THROW_IF(path.empty(), "Stats exporter requires a path");
+    THROW_IF(period<Time::Dur::zero(), "Stats exporter period must not be negative");
+    Ptr rtn(new StatsExporter);
+    rtn->path     = path;
+    rtn->format   = format;
+    rtn->period   = period;
+    rtn->lastTime = Time::Now();
+    if (period>Time::Dur::zero()) {
+      StatsExporter *self = rtn.get();
+      rtn->thread = std::thread([self]() { self->Main(); });
+    }
+    return rtn;
+  }
+  StatsExporter::~StatsExporter() {
+    Stop();
+  }
+  const std::string          &StatsExporter::Path      () const { return path;       }
+  StatsExporter::Format       StatsExporter::GetFormat () const { return format;     }
+  const Time::Dur            &StatsExporter::GetPeriod () const { return period;     }
+  uint64_t                    StatsExporter::NumExports() const { return numExports; }
+  void StatsExporter::Export() {
+    std::lock_guard<std::mutex> g(exportLock);
+    StatsRegistry::Samples samples = StatsRegistry::Snapshot();
+    Time::TP               now     = Time::Now();
+    double                 elapsed = Time::ToSeconds(now-lastTime);
+    std::vector<Delta>     deltas(samples.size());
+    LastMap                next;
+    for (size_t i=0;i<samples.size();++i) {
+      const StatsRegistry::Sample &s  = samples[i];
+      Last                         l  = { 0, Time::Dur::zero() };
+      LastMap::const_iterator      it = last.find(s.id);
+      if (it!=last.end()) {
+	l = it->second;
+      }
+      deltas[i].count   = s.count-l.count;
+      deltas[i].runTime = Time::ToSeconds(s.runTime-l.runTime);
+      deltas[i].rate    = elapsed>0 ? deltas[i].count/elapsed : 0;
+      next[s.id]        = Last { s.count, s.runTime };
+    }
+    if (format==Format::PROMETHEUS) {
+      const std::string tmp = path+".tmp";
+      if (true) {
+	std::ofstream out(tmp, std::ios::trunc);
+	THROW_IF(!out, "Unable to open " << tmp << " for the stats exporter");
+	out << std::setprecision(9);
+	WritePrometheus(out, samples, deltas);
+	out.close();
+	THROW_IF(!out, "Unable to write " << tmp << " for the stats exporter");
+      }
+      THROW_IF(std::rename(tmp.c_str(), path.c_str())!=0,
+	       "Unable to rename " << tmp << " to " << path << " for the stats exporter");
+    } else {
+      std::ofstream out(path, std::ios::app);
+      THROW_IF(!out, "Unable to open " << path << " for the stats exporter");
+      out << std::setprecision(15);
+      WriteJson(out, Time::ToSeconds(now.time_since_epoch()), samples, deltas);
+      out.close();
+      THROW_IF(!out, "Unable to write " << path << " for the stats exporter");
+    }
+    last.swap(next);
+    lastTime = now;
+    ++numExports;
+  }
+  void StatsExporter::Stop() {
+    if (true) {
+      std::lock_guard<std::mutex> g(lock);
+      stopped = true;
+    }
+    cv.notify_all();
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+  void StatsExporter::Main() {
+    std::unique_lock<std::mutex> g(lock);
+    while (!cv.wait_for(g, period, [this]() { return stopped; })) {
+      g.unlock();
+      try {
+	Export();
+      } catch (std::exception &e) {
+	WARN("Stats export to " << path << " failed: " << e.what());
+      }
+      g.lock();
+    }
+  }
+  std::ostream &operator<<(std::ostream &out, const StatsExporter &o) {
+    out << "StatsExporter(path=" << o.path
+	<< ", format="           << o.format
+	<< ", period="           << Time::ToSeconds(o.period)
+	<< ", numExports="       << o.numExports
+	<< ")";
+    return out;
+  }
+  std::ostream &operator<<(std::ostream &out, const StatsExporter::Format &o) {
+    switch (o) {
+    case StatsExporter::Format::PROMETHEUS: out << "prometheus"; break;
+    case StatsExporter::Format::JSON:       out << "json";       break;
+    }
+    return out;
+  }
+  StatsExporter::StatsExporter()
+    : format(Format::PROMETHEUS),
+      period(Time::Dur::zero()),
+      numExports(0),
+      stopped(false) {
+  }
+
+}
@@ -0,0 +1,131 @@
+#ifndef INCLUDED_ALI_SYSTEM_STATS_EXPORTER
+#define INCLUDED_ALI_SYSTEM_STATS_EXPORTER
+
+#include <aliSystem_statsRegistry.hpp>
+#include <aliSystem_time.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+namespace aliSystem {
+
+  ///
+  /// @brief Periodically writes a snapshot of every live Stats object to
+  ///        a file.
+  ///
+  /// Each export takes a StatsRegistry::Snapshot and writes, for every
+  /// stats object, its totals, what changed since the previous export
+  /// (the count and run time deltas, and the rate in calls per second)
+  /// and its run time percentiles.
+  ///
+  /// Format::PROMETHEUS rewrites the file with the latest snapshot in the
+  /// Prometheus text exposition format, for a node exporter textfile
+  /// collector to pick up.  The file is written under a temporary name
+  /// and renamed, so readers never see a partial snapshot.
+  /// Format::JSON appends one JSON object per stats object and export
+  /// (JSON lines), keeping the history in the file.
+  ///
+  /// Stats objects are identified by name and Stats::Id, as names need
+  /// not be unique.  Times are in seconds.
+  ///
+  struct StatsExporter {
+    using Ptr  = std::shared_ptr<StatsExporter>;  ///< shared pointer
+    using WPtr = std::weak_ptr  <StatsExporter>;  ///< weak pointer
+
+    /// @brief Format identifies the file format written by an exporter
+    enum class Format {
+      PROMETHEUS,  ///< Prometheus text format, latest snapshot only
+      JSON         ///< JSON lines, one line per stats object per export
+    };
+
+    /// @brief Create an exporter.
+    /// @param path the file to write
+    /// @param format the file format
+    /// @param period the time between exports, if zero no thread is
+    ///        started and snapshots are only written by Export
+    /// @return the exporter
+    static Ptr Create(const std::string &path,
+		      Format             format,
+		      const Time::Dur   &period);
+
+    /// @brief destructor, stops the exporter's thread
+    ~StatsExporter();
+
+    /// @brief Copy constructor is deleted
+    StatsExporter(const StatsExporter &) = delete;
+
+    /// @brief Assignment operator is deleted
+    StatsExporter &operator=(const StatsExporter &) = delete;
+
+    /// @brief retrieve the file written
+    /// @return the path of the file
+    const std::string &Path() const;
+
+    /// @brief retrieve the format
+    /// @return the file format
+    Format GetFormat() const;
+
+    /// @brief retrieve the period
+    /// @return the time between exports
+    const Time::Dur &GetPeriod() const;
+
+    /// @brief retrieve the number of exports written
+    /// @return the number of snapshots written
+    uint64_t NumExports() const;
+
+    /// @brief write a snapshot now
+    /// @note throws if the file cannot be written, failures of periodic
+    ///       exports are logged instead.
+    void Export();
+
+    /// @brief Stop the exporter's thread.  Export may still be called.
+    void Stop();
+
+    /// @brief Write a short summary of the exporter to the given ostream.
+    /// @param out the stream to write to
+    /// @param o the StatsExporter instance to write
+    /// @return the stream passed as the out parameter
+    friend std::ostream &operator<<(std::ostream &out, const StatsExporter &o);
+
+  private:
+
+    /// @brief the totals of a stats object at the previous export
+    struct Last {
+      size_t    count;    ///< Stats::Count
+      Time::Dur runTime;  ///< Stats::RunTime
+    };
+    using LastMap = std::map<uint64_t, Last>;  ///< map of Stats::Id to totals
+
+    /// @brief constructor
+    StatsExporter();
+
+    /// @brief the thread's main loop
+    void Main();
+
+    std::string             path;        ///< file written
+    Format                  format;      ///< file format
+    Time::Dur               period;      ///< time between exports
+    std::mutex              exportLock;  ///< serializes exports
+    LastMap                 last;        ///< totals at the previous export
+    Time::TP                lastTime;    ///< time of the previous export
+    std::atomic<uint64_t>   numExports;  ///< snapshots written
+    std::mutex              lock;        ///< guards stopped
+    std::condition_variable cv;          ///< wakes the thread when stopped
+    bool                    stopped;     ///< set by Stop
+    std::thread             thread;      ///< the exporter's thread
+  };
+
+  /// @brief Format serialization operator
+  /// @param out the stream to write to
+  /// @param o the format to write
+  /// @return the stream passed as the out parameter
+  std::ostream &operator<<(std::ostream &out, const StatsExporter::Format &o);
+
+}
+
+#endif
@@ -4,14 +4,38 @@
 namespace aliSystem {
 
   StatsGuard::StatsGuard(Stats::Ptr sPtr_)
-    : sPtr(sPtr_) {
+    : sPtr(sPtr_),
+      elapsed(nullptr),
+      clock(Clock::PRECISE),
+      startTicks(0) {
     if (sPtr) {
       startTime = Time::Now();
     }
   }
+  StatsGuard::StatsGuard(Stats::Ptr sPtr_, Clock clock_, Time::Dur *elapsed_)
+    : sPtr(sPtr_),
+      elapsed(elapsed_),
+      clock(clock_),
+      startTicks(0) {
+    if (sPtr || elapsed) {
+      if (clock==Clock::CHEAP) {
+	startTicks = Time::Ticks();
+      } else {
+	startTime  = Time::Now();
+      }
+    }
+  }
   StatsGuard::~StatsGuard() {
-    if (sPtr) {
-      sPtr->Inc(Time::Now()-startTime);
+    if (sPtr || elapsed) {
+      Time::Dur dur = clock==Clock::CHEAP
+	? Time::FromTicks(Time::Ticks()-startTicks)
+	: Time::Now()-startTime;
+      if (sPtr) {
+	sPtr->Inc(dur);
+      }
+      if (elapsed) {
+	*elapsed = dur;
+      }
     }
   }
     
@@ -13,20 +13,41 @@ namespace aliSystem {
   /// A stats guard is used to track time for a a specific stats object
   /// and increment those stats when the guard goes out of scope.
   ///
+  /// By default the guard reads Time::Now on either side.  A guard on a
+  /// hot path can opt into Clock::CHEAP, which reads Time::Ticks instead
+  /// (see Time for its cost and resolution).
+  ///
   struct StatsGuard {
+
+    /// @brief Clock identifies the time source of a guard
+    enum class Clock {
+      PRECISE,  ///< Time::Now
+      CHEAP     ///< Time::Ticks
+    };
+
     /// @brief stats guard constructor
     /// @param sPtr pointer to a stats object
     /// @note if the passed stats pointer is null, this
     ///       class has no effect.
     StatsGuard(Stats::Ptr sPtr);
 
+    /// @brief stats guard constructor selecting the time source
+    /// @param sPtr pointer to a stats object (may be null)
+    /// @param clock the time source
+    /// @param elapsed [out] if not null, set to the time between
+    ///        construction and destruction of the guard.
+    StatsGuard(Stats::Ptr sPtr, Clock clock, Time::Dur *elapsed=nullptr);
+
     /// @brief stats guard destructor
     ~StatsGuard();
     
   private:
     
     Stats::Ptr sPtr;
+    Time::Dur *elapsed;
+    Clock      clock;
     Time::TP   startTime;
+    uint64_t   startTicks;
   };
 
   
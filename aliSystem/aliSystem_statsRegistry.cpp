@@ -0,0 +1,106 @@
+#include <aliSystem_statsRegistry.hpp>
+#include <aliSystem_stats.hpp>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+  using Stats = aliSystem::Stats;
+
+  // a registered stats object, pinned while Snapshot reads it
+  struct Entry {
+    const Stats *stats;
+    size_t       pins;
+  };
+
+  struct Items {
+    std::mutex                        lock;
+    std::condition_variable           unpinned;  // a pinned entry was released
+    uint64_t                          nextId;
+    std::map<uint64_t, Entry>         stats;
+    Items() : nextId(1) {}
+  };
+
+  // Stats objects held by other static objects may be destroyed during
+  // exit after a static registry would have been, so the registry is
+  // never destroyed.
+  Items &GetItems() {
+    static Items *items = new Items;
+    return *items;
+  }
+
+}
+
+namespace aliSystem {
+
+  size_t StatsRegistry::Size() {
+    Items &items = GetItems();
+    std::lock_guard<std::mutex> g(items.lock);
+    return items.stats.size();
+  }
+  StatsRegistry::Samples StatsRegistry::Snapshot() {
+    Items                &items = GetItems();
+    Samples               rtn;
+    Histogram             latency;
+    std::vector<uint64_t> ids;
+    if (true) {
+      std::lock_guard<std::mutex> g(items.lock);
+      ids.reserve(items.stats.size());
+      for (std::map<uint64_t, Entry>::const_iterator it=items.stats.begin(); it!=items.stats.end(); ++it) {
+	ids.push_back(it->first);
+      }
+    }
+    rtn.reserve(ids.size());
+    // each object is pinned only while it is read, merging its histogram
+    // happens without the lock that creating and destroying stats take.
+    for (std::vector<uint64_t>::const_iterator id=ids.begin(); id!=ids.end(); ++id) {
+      const Stats *s = nullptr;
+      if (true) {
+	std::lock_guard<std::mutex> g(items.lock);
+	std::map<uint64_t, Entry>::iterator it = items.stats.find(*id);
+	if (it==items.stats.end()) {
+	  continue;
+	}
+	++it->second.pins;
+	s = it->second.stats;
+      }
+      latency.Clear();
+      s->Latencies(latency);
+      Sample sample;
+      sample.id      = *id;
+      sample.name    = s->Name();
+      sample.count   = s->Count();
+      sample.runTime = s->RunTime();
+      sample.p50     = std::chrono::duration_cast<Time::Dur>(std::chrono::nanoseconds(latency.Percentile(0.5)));
+      sample.p99     = std::chrono::duration_cast<Time::Dur>(std::chrono::nanoseconds(latency.Percentile(0.99)));
+      sample.p999    = std::chrono::duration_cast<Time::Dur>(std::chrono::nanoseconds(latency.Percentile(0.999)));
+      rtn.push_back(sample);
+      std::lock_guard<std::mutex> g(items.lock);
+      if (--items.stats[*id].pins==0) {
+	items.unpinned.notify_all();
+      }
+    }
+    return rtn;
+  }
+  uint64_t StatsRegistry::Add(const Stats *stats) {
+    Items &items = GetItems();
+    std::lock_guard<std::mutex> g(items.lock);
+    uint64_t id = items.nextId++;
+    items.stats[id] = Entry { stats, 0 };
+    return id;
+  }
+  void StatsRegistry::Remove(uint64_t id) {
+    Items &items = GetItems();
+    std::unique_lock<std::mutex> g(items.lock);
+    std::map<uint64_t, Entry>::iterator it = items.stats.find(id);
+    if (it==items.stats.end()) {
+      return;
+    }
+    // a snapshot reading the object finishes before it is destroyed
+    items.unpinned.wait(g, [&]() { return it->second.pins==0; });
+    items.stats.erase(it);
+  }
+
+}
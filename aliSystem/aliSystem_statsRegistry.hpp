@@ -0,0 +1,63 @@
+#ifndef INCLUDED_ALI_SYSTEM_STATS_REGISTRY
+#define INCLUDED_ALI_SYSTEM_STATS_REGISTRY
+
+#include <aliSystem_time.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace aliSystem {
+
+  struct Stats;
+
+  ///
+  /// @brief The process wide collection of live Stats objects.
+  ///
+  /// Every Stats object adds itself on construction and removes itself
+  /// on destruction, so the registry never keeps a stats object alive and
+  /// sees the stats of queues, pools, engines and Lua functions alike
+  /// without their owners doing anything.  Snapshot is the only way to
+  /// read the registered objects.  It pins each object only while reading
+  /// it, and reads without the registry's lock, so creating and destroying
+  /// stats objects is not held up by a snapshot; a stats object being
+  /// read is destroyed once the read completes.
+  ///
+  struct StatsRegistry {
+
+    /// @brief the values of one stats object at the time of a Snapshot
+    struct Sample {
+      uint64_t    id;       ///< the stats object's Stats::Id
+      std::string name;     ///< the stats object's name
+      size_t      count;    ///< Stats::Count
+      Time::Dur   runTime;  ///< Stats::RunTime
+      Time::Dur   p50;      ///< median run time
+      Time::Dur   p99;      ///< 99th percentile run time
+      Time::Dur   p999;     ///< 99.9th percentile run time
+    };
+    using Samples = std::vector<Sample>;  ///< samples in Stats::Id order
+
+    /// @brief retrieve the number of live stats objects
+    /// @return the number of registered stats objects
+    static size_t Size();
+
+    /// @brief read every live stats object
+    /// @return a sample of each registered stats object, in the order the
+    ///         objects were created
+    static Samples Snapshot();
+
+  private:
+    friend struct Stats;
+
+    /// @brief add a stats object, called by its constructor
+    /// @param stats the stats object
+    /// @return the id assigned to the stats object
+    static uint64_t Add(const Stats *stats);
+
+    /// @brief remove a stats object, called by its destructor
+    /// @param id the id returned by Add
+    static void Remove(uint64_t id);
+  };
+
+}
+
+#endif
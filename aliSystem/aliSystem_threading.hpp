@@ -1,11 +1,26 @@
 #ifndef INCLUDED_ALI_SYSTEM_THREADING
 #define INCLUDED_ALI_SYSTEM_THREADING
 
+#include <cstddef>
+
 namespace aliSystem {
 
   /// @brief The aliSystem::Threading namespace is used to contain all
   ///        classes and methods specific to aliSystem's Threading logic.
   namespace Threading {
+
+    /// @brief CacheLineSize is the number of bytes used to keep members
+    ///        written by different threads on separate cache lines.
+    const size_t CacheLineSize = 64;
+
+    /// @brief hint to the processor that the caller is spinning
+    inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#elif defined(__aarch64__)
+      asm volatile("yield");
+#endif
+    }
     
   }
   
@@ -0,0 +1,124 @@
+#include <aliSystem_threadingFreeList.hpp>
+#include <algorithm>
+
+namespace {
+
+  void *&Next(void *block) {
+    return *static_cast<void**>(block);
+  }
+  
+}
+
+namespace aliSystem {
+  namespace Threading {
+
+    FreeList::Cache::Cache(FreeList &list_)
+      : list(list_),
+	handle(nullptr),
+	head(nullptr),
+	count(0) {}
+    FreeList::Cache::Cache(FreeList &list_, Handle &handle_)
+      : list(list_),
+	handle(&handle_),
+	head(nullptr),
+	count(0) {
+      handle->cache = this;
+    }
+    FreeList::Cache::~Cache() {
+      if (head) {
+	list.PutBatch(head, count);
+      }
+      if (handle) {
+	// blocks released by later thread exit handlers go to the depot
+	handle->cache = nullptr;
+	handle->gone  = true;
+      }
+    }
+    void *FreeList::Cache::Allocate() {
+      if (!head) {
+	head = list.TakeBatch(count);
+      }
+      void *rtn = head;
+      head = Next(rtn);
+      --count;
+      return rtn;
+    }
+    void FreeList::Cache::Release(void *block) {
+      Next(block) = head;
+      head        = block;
+      if (++count>=2*BATCH) {
+	// keep the most recently released (warmest) blocks
+	void *last = head;
+	for (size_t i=1;i<BATCH;++i) {
+	  last = Next(last);
+	}
+	void *batch = Next(last);
+	Next(last)  = nullptr;
+	list.PutBatch(batch, count-BATCH);
+	count       = BATCH;
+      }
+    }
+
+    FreeList::FreeList(size_t blockSize_)
+      : blockSize(std::max(blockSize_, sizeof(void*))),
+	numAllocated(0),
+	numFreed(0) {}
+    FreeList::~FreeList() {
+      for (std::vector<Chain>::iterator it=depot.begin(); it!=depot.end(); ++it) {
+	while (it->first) {
+	  void *next = Next(it->first);
+	  ::operator delete(it->first);
+	  it->first = next;
+	}
+      }
+    }
+    void *FreeList::Allocate() {
+      size_t count;
+      void  *rtn  = TakeBatch(count);
+      void  *rest = Next(rtn);
+      if (rest) {
+	PutBatch(rest, count-1);
+      }
+      return rtn;
+    }
+    void FreeList::Release(void *block) {
+      Next(block) = nullptr;
+      PutBatch(block, 1);
+    }
+    size_t   FreeList::BlockSize   () const { return blockSize;    }
+    uint64_t FreeList::NumAllocated() const { return numAllocated; }
+    uint64_t FreeList::NumFreed    () const { return numFreed;     }
+    void *FreeList::TakeBatch(size_t &count) {
+      if (true) {
+	std::lock_guard<std::mutex> g(lock);
+	if (!depot.empty()) {
+	  Chain rtn = depot.back();
+	  depot.pop_back();
+	  count = rtn.second;
+	  return rtn.first;
+	}
+      }
+      ++numAllocated;
+      void *rtn = ::operator new(blockSize);
+      Next(rtn) = nullptr;
+      count     = 1;
+      return rtn;
+    }
+    void FreeList::PutBatch(void *head, size_t count) {
+      if (true) {
+	std::lock_guard<std::mutex> g(lock);
+	if (depot.size()<MAX_BATCHES) {
+	  depot.push_back(Chain(head, count));
+	  return;
+	}
+      }
+      numFreed += count;
+      while (head) {
+	void *next = Next(head);
+	::operator delete(head);
+	head = next;
+      }
+    }
+
+  }
+}
@@ -0,0 +1,203 @@
+#ifndef INCLUDED_ALI_SYSTEM_THREADING_FREE_LIST
+#define INCLUDED_ALI_SYSTEM_THREADING_FREE_LIST
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace aliSystem {
+  namespace Threading {
+
+    ///
+    /// @brief Recycles fixed size blocks of memory between threads.
+    ///
+    /// Each thread keeps a small cache of free blocks and allocates from
+    /// and releases to it without any synchronization.  Blocks are
+    /// moved between a thread's cache and a shared depot a batch at a
+    /// time, which keeps the common producer/consumer pattern (one thread
+    /// allocates, another releases) from allocating: the consumer's cache
+    /// overflows into the depot and the producer's cache refills from it,
+    /// taking the depot's lock once per BATCH blocks.
+    ///
+    /// Blocks only return to the system once the depot holds more than
+    /// MAX_BATCHES batches.
+    ///
+    /// FreeList::Allocator adapts a free list to the standard allocator
+    /// interface, one free list per block size, so it can be passed to
+    /// std::allocate_shared.  Blocks allocated or released by a thread
+    /// after its cache has been destroyed (from later thread exit
+    /// handlers) go straight to the depot.
+    ///
+    struct FreeList {
+      static const size_t BATCH       = 64;   ///< blocks moved between a cache and the depot at a time
+      static const size_t MAX_BATCHES = 256;  ///< batches kept by the depot
+
+      struct Cache;
+
+      /// @brief A thread's handle on its cache.
+      ///
+      /// A handle is trivially destructible, so a thread_local handle can
+      /// still be read after the thread_local cache it refers to has been
+      /// destroyed during thread exit.
+      struct Handle {
+	Cache *cache;   ///< the thread's cache while it is alive
+	bool   gone;    ///< set once the thread's cache has been destroyed
+      };
+
+      /// @brief A thread's cache of free blocks
+      struct Cache {
+	/// @brief constructor
+	/// @param list the free list the cache draws from
+	explicit Cache(FreeList &list);
+
+	/// @brief constructor
+	/// @param list the free list the cache draws from
+	/// @param handle handle that refers to the cache until it is destroyed
+	Cache(FreeList &list, Handle &handle);
+
+	/// @brief destructor, hands the cached blocks to the depot and
+	///        marks the handle gone
+	~Cache();
+
+	/// @brief obtain a block
+	/// @return a block of the free list's block size
+	void *Allocate();
+
+	/// @brief return a block
+	/// @param block a block previously obtained from the same free list
+	void Release(void *block);
+
+      private:
+	FreeList &list;    ///< owning free list
+	Handle   *handle;  ///< handle referring to the cache, if any
+	void     *head;    ///< first cached block, each block links to the next
+	size_t    count;   ///< number of cached blocks
+      };
+
+      /// @brief standard allocator backed by a free list per type
+      template<typename T>
+      struct Allocator {
+	using value_type = T;   ///< allocated type
+
+	/// @brief constructor
+	Allocator() noexcept {}
+
+	/// @brief rebinding constructor
+	template<typename U>
+	Allocator(const Allocator<U> &) noexcept {}
+
+	/// @brief allocate storage for n objects
+	T *allocate(size_t n) {
+	  if (n==1) {
+	    Cache *cache = Local();
+	    return static_cast<T*>(cache ? cache->Allocate() : List().Allocate());
+	  }
+	  return static_cast<T*>(::operator new(n*sizeof(T)));
+	}
+
+	/// @brief release storage for n objects
+	void deallocate(T *p, size_t n) noexcept {
+	  if (n==1) {
+	    Cache *cache = Local();
+	    if (cache) {
+	      cache->Release(p);
+	    } else {
+	      List().Release(p);
+	    }
+	  } else {
+	    ::operator delete(p);
+	  }
+	}
+
+	/// @brief the free list used for single objects of type T
+	/// @return the free list, it is never destroyed
+	static FreeList &List() {
+	  static FreeList *list = new FreeList(sizeof(T));
+	  return *list;
+	}
+
+      private:
+	/// @brief the calling thread's cache
+	/// @return the cache, or nullptr once it has been destroyed
+	static Cache *Local() {
+	  static thread_local Handle handle = { nullptr, false };
+	  if (!handle.cache && !handle.gone) {
+	    static thread_local Cache cache(List(), handle);
+	  }
+	  return handle.cache;
+	}
+      };
+
+      /// @brief constructor
+      /// @param blockSize size of the blocks in the list
+      explicit FreeList(size_t blockSize);
+
+      /// @brief destructor, releases the blocks held by the depot
+      ~FreeList();
+
+      /// @brief Copy constructor is deleted
+      FreeList(const FreeList &) = delete;
+
+      /// @brief Assignment operator is deleted
+      FreeList &operator=(const FreeList &) = delete;
+
+      /// @brief obtain a block directly from the depot or the system
+      /// @return a block of the list's block size
+      /// @note This takes the depot's lock, it is meant for threads
+      ///       without a cache.
+      void *Allocate();
+
+      /// @brief return a block directly to the depot
+      /// @param block a block previously obtained from this free list
+      /// @note This takes the depot's lock, it is meant for threads
+      ///       without a cache.
+      void Release(void *block);
+
+      /// @brief retrieve the block size
+      /// @return the size of each block
+      size_t BlockSize() const;
+
+      /// @brief retrieve the number of blocks obtained from the system
+      /// @return the number of blocks allocated since construction
+      uint64_t NumAllocated() const;
+
+      /// @brief retrieve the number of blocks handed back to the system
+      /// @return the number of blocks freed since construction
+      uint64_t NumFreed() const;
+
+    private:
+      using Chain = std::pair<void*, size_t>; ///< linked blocks and their number
+
+      /// @brief obtain a batch of blocks from the depot or the system
+      /// @param count [out] the number of blocks in the returned chain
+      /// @return a chain of free blocks
+      void *TakeBatch(size_t &count);
+
+      /// @brief give a chain of blocks to the depot
+      /// @param head the chain of blocks
+      /// @param count the number of blocks in the chain
+      void PutBatch(void *head, size_t count);
+
+      size_t                blockSize;   ///< size of each block
+      std::mutex            lock;        ///< serializes the depot
+      std::vector<Chain>    depot;       ///< chains of free blocks
+      std::atomic<uint64_t> numAllocated;///< blocks obtained from the system
+      std::atomic<uint64_t> numFreed;    ///< blocks returned to the system
+    };
+
+    /// @brief all free list allocators are interchangeable
+    template<typename T, typename U>
+    bool operator==(const FreeList::Allocator<T> &, const FreeList::Allocator<U> &) { return true;  }
+
+    /// @brief all free list allocators are interchangeable
+    template<typename T, typename U>
+    bool operator!=(const FreeList::Allocator<T> &, const FreeList::Allocator<U> &) { return false; }
+
+  }
+}
+
+#endif
@@ -0,0 +1,162 @@
+#include <aliSystem_threadingLimiter.hpp>
+#include <aliSystem_logging.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+  // fraction of the distance to a window's latency that the baseline
+  // moves up each window, so a stale baseline is forgotten within a few
+  // hundred windows.
+  const double DRIFT     = 0.01;
+
+  // weight of the newly computed limit in the gradient algorithm's
+  // smoothed limit.
+  const double SMOOTHING = 0.2;
+
+}
+
+namespace aliSystem {
+  namespace Threading {
+
+    Limiter::Ptr Limiter::Create(Algorithm algorithm,
+				 size_t    minLimit,
+				 size_t    maxLimit,
+				 size_t    initialLimit) {
+      THROW_IF(minLimit==0, "Limiter minimum must be at least 1");
+      THROW_IF(minLimit>maxLimit,
+	       "Limiter minimum " << minLimit << " exceeds maximum " << maxLimit);
+      Ptr rtn(new Limiter);
+      rtn->algorithm = algorithm;
+      rtn->minLimit  = minLimit;
+      rtn->maxLimit  = maxLimit;
+      rtn->limit     = std::min(maxLimit, std::max(minLimit, initialLimit));
+      rtn->estimate  = rtn->limit;
+      return rtn;
+    }
+    Limiter::Algorithm Limiter::GetAlgorithm() const { return algorithm; }
+    size_t             Limiter::GetMinLimit () const { return minLimit;  }
+    size_t             Limiter::GetMaxLimit () const { return maxLimit;  }
+    size_t             Limiter::GetLimit    () const { return limit;     }
+    size_t             Limiter::GetWindow   () const { return window;    }
+    double             Limiter::GetTolerance() const { return tolerance; }
+    double             Limiter::GetBackoff  () const { return backoff;   }
+    uint64_t           Limiter::NumUpdates  () const { return updates;   }
+    Time::Dur Limiter::GetBaseline() const {
+      return Time::FromSeconds(baseline);
+    }
+    Time::Dur Limiter::GetLatency() const {
+      return Time::FromSeconds(latency);
+    }
+    void Limiter::SetWindow(size_t window_) {
+      THROW_IF(window_==0, "Limiter window must hold at least one sample");
+      window = window_;
+    }
+    void Limiter::SetTolerance(double tolerance_) {
+      THROW_IF(!(tolerance_>=1.0), "Limiter tolerance must be at least 1, passed " << tolerance_);
+      tolerance = tolerance_;
+    }
+    void Limiter::SetBackoff(double backoff_) {
+      THROW_IF(!(backoff_>0.0 && backoff_<1.0),
+	       "Limiter backoff must be between 0 and 1, passed " << backoff_);
+      backoff = backoff_;
+    }
+    bool Limiter::Sample(const Time::Dur &sample, size_t inFlight) {
+      int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(sample).count();
+      sumNs += ns>0 ? uint64_t(ns) : 0;
+      size_t p = peak;
+      while (inFlight>p && !peak.compare_exchange_weak(p, inFlight)) {
+      }
+      if (count.fetch_add(1)+1<window) {
+	return false;
+      }
+      // one thread closes the window, the others carry on sampling
+      std::unique_lock<std::mutex> g(lock, std::try_to_lock);
+      if (!g.owns_lock()) {
+	return false;
+      }
+      size_t n = count.exchange(0);
+      if (n<window) {
+	// closed by another thread while this one waited for the lock
+	count += n;
+	return false;
+      }
+      uint64_t sum = sumNs.exchange(0);
+      return Update(sum/1e9/n, peak.exchange(0));
+    }
+    bool Limiter::Update(double lat, size_t inFlight) {
+      ++updates;
+      latency = lat;
+      double base = baseline;
+      if (base==0.0 || lat<base) {
+	base = lat;
+      } else {
+	base += (lat-base)*DRIFT;
+      }
+      baseline = base;
+      double cur       = estimate;
+      bool   saturated = lat>tolerance*base;
+      bool   used      = inFlight*2>=limit;
+      double next      = cur;
+      switch (algorithm) {
+      case Algorithm::AIMD:
+	if (saturated) {
+	  next = std::min(cur*backoff, cur-1);
+	} else if (used) {
+	  next = cur+1;
+	}
+	break;
+      case Algorithm::GRADIENT: {
+	double gradient = lat>0.0 ? std::max(0.5, std::min(1.0, tolerance*base/lat)) : 1.0;
+	double target   = cur*gradient + std::sqrt(cur);
+	if (!used) {
+	  target = std::min(target, cur);
+	}
+	next = cur*(1-SMOOTHING) + target*SMOOTHING;
+	break;
+      }
+      }
+      estimate = std::min(double(maxLimit), std::max(double(minLimit), next));
+      size_t n = size_t(estimate+0.5);
+      if (n==limit) {
+	return false;
+      }
+      limit = n;
+      return true;
+    }
+    std::ostream &operator<<(std::ostream &out, const Limiter &o) {
+      out << "threadingLimiter(algorithm = " << o.algorithm
+	  << ", limit = "    << o.limit
+	  << ", range = "    << o.minLimit << " to " << o.maxLimit
+	  << ", latency = "  << o.latency
+	  << ", baseline = " << o.baseline
+	  << ")";
+      return out;
+    }
+    std::ostream &operator<<(std::ostream &out, const Limiter::Algorithm &o) {
+      switch (o) {
+      case Limiter::Algorithm::AIMD:     out << "aimd";     break;
+      case Limiter::Algorithm::GRADIENT: out << "gradient"; break;
+      }
+      return out;
+    }
+    Limiter::Limiter()
+      : algorithm(Algorithm::AIMD),
+	minLimit(1),
+	maxLimit(1),
+	window(32),
+	tolerance(1.5),
+	backoff(0.9),
+	limit(1),
+	estimate(1),
+	baseline(0),
+	latency(0),
+	updates(0),
+	sumNs(0),
+	count(0),
+	peak(0) {
+    }
+
+  }
+}
@@ -0,0 +1,177 @@
+#ifndef INCLUDED_ALI_SYSTEM_THREADING_LIMITER
+#define INCLUDED_ALI_SYSTEM_THREADING_LIMITER
+
+#include <aliSystem_time.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+
+namespace aliSystem {
+  namespace Threading {
+
+    ///
+    /// @brief Derives a concurrency limit from observed run latency.
+    ///
+    /// A Limiter is fed the run time of each completed work unit and
+    /// periodically moves a concurrency limit between its bounds.  It is
+    /// used by a Threading::Queue in adaptive mode (see
+    /// Queue::SetAdaptiveConcurrency) in place of a hand tuned maximum
+    /// concurrency.
+    ///
+    /// Samples are gathered in windows of GetWindow() work units.  The
+    /// average latency of each window is compared to a baseline, the
+    /// lowest window average seen (drifting slowly upwards so that a
+    /// baseline taken under conditions that no longer hold is forgotten).
+    /// Latency rising above the baseline is taken as a sign that a shared
+    /// resource downstream is saturating:
+    ///
+    ///  - Algorithm::AIMD adds one to the limit after each window whose
+    ///    latency is within the tolerance of the baseline and multiplies
+    ///    the limit by the backoff factor after each window that is not.
+    ///
+    ///  - Algorithm::GRADIENT moves the limit towards
+    ///    limit*gradient + sqrt(limit), where the gradient is the ratio of
+    ///    the tolerated latency (tolerance*baseline) to the window's
+    ///    latency, capped at 1 and floored at 0.5.  The square root term
+    ///    lets the limit probe upwards while latency stays flat.
+    ///
+    /// Either way, the limit only grows while the work in flight is
+    /// using at least half of it, so a lightly loaded queue does not
+    /// drift up to its maximum.
+    ///
+    /// Sample only updates atomics, except for the one call per window
+    /// that recomputes the limit under the limiter's lock.
+    ///
+    struct Limiter {
+      using Ptr  = std::shared_ptr<Limiter>; ///< shared pointer
+      using WPtr = std::weak_ptr<Limiter>;   ///< weak pointer
+
+      /// @brief Algorithm identifies how the limit reacts to latency
+      enum class Algorithm {
+	AIMD,      ///< additive increase, multiplicative decrease
+	GRADIENT   ///< scale by the latency gradient, probe by sqrt(limit)
+      };
+
+      /// @brief Create a limiter
+      /// @param algorithm how the limit reacts to latency
+      /// @param minLimit lowest limit, at least 1
+      /// @param maxLimit highest limit, at least minLimit
+      /// @param initialLimit starting limit, clamped to the bounds
+      /// @return a limiter
+      static Ptr Create(Algorithm algorithm,
+			size_t    minLimit,
+			size_t    maxLimit,
+			size_t    initialLimit);
+
+      /// @brief Copy constructor is deleted
+      Limiter(const Limiter &) = delete;
+
+      /// @brief Assignment operator is deleted
+      Limiter &operator=(const Limiter &) = delete;
+
+      /// @brief retrieve the algorithm
+      /// @return how the limit reacts to latency
+      Algorithm GetAlgorithm() const;
+
+      /// @brief retrieve the lower bound
+      /// @return the lowest limit
+      size_t GetMinLimit() const;
+
+      /// @brief retrieve the upper bound
+      /// @return the highest limit
+      size_t GetMaxLimit() const;
+
+      /// @brief retrieve the current limit
+      /// @return the current concurrency limit
+      size_t GetLimit() const;
+
+      /// @brief retrieve the number of samples per window
+      /// @return samples between limit updates
+      size_t GetWindow() const;
+
+      /// @brief retrieve the latency tolerance
+      /// @return the multiple of the baseline latency that is tolerated
+      double GetTolerance() const;
+
+      /// @brief retrieve the AIMD backoff factor
+      /// @return the factor applied to the limit when latency is too high
+      double GetBackoff() const;
+
+      /// @brief retrieve the baseline latency
+      /// @return the lowest window average latency (zero before the first window)
+      Time::Dur GetBaseline() const;
+
+      /// @brief retrieve the last window's latency
+      /// @return the average latency of the last window (zero before the first window)
+      Time::Dur GetLatency() const;
+
+      /// @brief retrieve the number of limit updates
+      /// @return the number of windows processed
+      uint64_t NumUpdates() const;
+
+      /// @brief Set the number of samples per window
+      /// @param window samples between limit updates, at least 1
+      void SetWindow(size_t window);
+
+      /// @brief Set the latency tolerance
+      /// @param tolerance multiple of the baseline latency that does not
+      ///        count as saturation, at least 1
+      void SetTolerance(double tolerance);
+
+      /// @brief Set the AIMD backoff factor
+      /// @param backoff factor applied to the limit when latency is too
+      ///        high, in (0, 1)
+      void SetBackoff(double backoff);
+
+      /// @brief Record the run time of a completed work unit.
+      /// @param latency the work unit's run time
+      /// @param inFlight the number of work units running when it completed
+      /// @return true if the call closed a window and the limit changed
+      bool Sample(const Time::Dur &latency, size_t inFlight);
+
+      /// @brief Limiter serialization operator
+      /// @param out output stream to serialize the Limiter
+      /// @param o object to serialize
+      /// @return output stream
+      friend std::ostream &operator<<(std::ostream &out, const Limiter &o);
+
+    private:
+      /// @brief constructor
+      Limiter();
+
+      /// @brief recompute the limit from a window of samples
+      /// @param latency the window's average latency
+      /// @param inFlight the largest number of work units seen running in the window
+      /// @return true if the limit changed
+      bool Update(double latency, size_t inFlight);
+
+      std::mutex            lock;       ///< serializes limit updates
+      Algorithm             algorithm;  ///< how the limit reacts to latency
+      size_t                minLimit;   ///< lowest limit
+      size_t                maxLimit;   ///< highest limit
+      std::atomic<size_t>   window;     ///< samples per window
+      std::atomic<double>   tolerance;  ///< tolerated multiple of the baseline
+      std::atomic<double>   backoff;    ///< AIMD decrease factor
+      std::atomic<size_t>   limit;      ///< current limit
+      double                estimate;   ///< unrounded limit (under lock)
+      std::atomic<double>   baseline;   ///< lowest window latency, in seconds
+      std::atomic<double>   latency;    ///< last window latency, in seconds
+      std::atomic<uint64_t> updates;    ///< windows processed
+      std::atomic<uint64_t> sumNs;      ///< latency sum of the open window, in nanoseconds
+      std::atomic<size_t>   count;      ///< samples in the open window
+      std::atomic<size_t>   peak;       ///< most work in flight in the open window
+    };
+
+    /// @brief Algorithm serialization operator
+    /// @param out output stream to serialize the algorithm
+    /// @param o value to serialize
+    /// @return output stream
+    std::ostream &operator<<(std::ostream &out, const Limiter::Algorithm &o);
+
+  }
+}
+
+#endif
@@ -3,31 +3,150 @@
 #include <aliSystem_statsGuard.hpp>
 #include <aliSystem_threadingQueue.hpp>
 #include <aliSystem_threadingSemaphore.hpp>
+#include <aliSystem_threadingTopology.hpp>
+#include <aliSystem_trace.hpp>
+#include <algorithm>
+#include <string>
 #include <thread>
 
+namespace {
+
+  // pass advanced per dispatch for a queue of weight 1 under the weighted
+  // fair scheduler, a queue of weight w advances by STRIDE/w.
+  const uint64_t STRIDE = uint64_t(1) << 20;
+
+}
+
 namespace aliSystem {
   namespace Threading {
-  
+
+    // ****************************************************************************************
+    // Worker Implementation
+    struct Pool::Worker {
+      Worker(Pool *pool_, size_t index_)
+	: pool(pool_),
+	  index(index_),
+	  node(-1),
+	  active(false) {
+      }
+      void Push(const Queue::Ptr &queue) {
+	std::lock_guard<std::mutex> g(lock);
+	ready.push_back(queue);
+      }
+      // the owner drains its deque in order so no ready queue is starved
+      bool Pop(Queue::Ptr &queue) {
+	std::lock_guard<std::mutex> g(lock);
+	if (ready.empty()) {
+	  return false;
+	}
+	queue = ready.front();
+	ready.pop_front();
+	return true;
+      }
+      // thieves take from the opposite end to stay clear of the owner
+      bool Steal(Queue::Ptr &queue) {
+	std::lock_guard<std::mutex> g(lock);
+	if (ready.empty()) {
+	  return false;
+	}
+	queue = ready.back();
+	ready.pop_back();
+	return true;
+      }
+      Pool                  *pool;   ///< owning pool
+      size_t                 index;  ///< position within the pool's worker vector
+      int                    node;   ///< NUMA node of the thread servicing the worker (pool lock)
+      bool                   active; ///< true while a thread services the worker (pool lock)
+      std::mutex             lock;   ///< guards ready
+      std::deque<Queue::Ptr> ready;  ///< queues that have released a work unit
+    };
+
+    thread_local Pool::Worker *Pool::curWorker = nullptr;
+    thread_local Pool         *Pool::curPool   = nullptr;
+    thread_local int           Pool::curNode   = -1;
+
+    // ****************************************************************************************
+    // FairQueue Implementation
+    struct Pool::FairQueue {
+      FairQueue()
+	: weight(1),
+	  priority(0),
+	  pass(0),
+	  seq(0),
+	  released(0),
+	  isReady(false) {
+      }
+      // all members other than queue are guarded by the pool's readyLock,
+      // weight, priority, pass and seq may only change while the entry is
+      // not in the ready list.
+      Queue::WPtr queue;    ///< the scheduled queue
+      size_t      weight;   ///< queue's weight when it joined the ready list
+      size_t      priority; ///< queue's priority class when it joined the ready list
+      uint64_t    pass;     ///< stride scheduling pass
+      uint64_t    seq;      ///< arrival order, breaks ties between equal passes
+      size_t      released; ///< work units released but not yet dispatched
+      bool        isReady;  ///< true while in the ready list
+    };
+    bool Pool::FairOrder::operator()(const FairPtr &a, const FairPtr &b) const {
+      if (a->priority!=b->priority) {
+	return a->priority>b->priority;
+      }
+      if (a->pass!=b->pass) {
+	return a->pass<b->pass;
+      }
+      return a->seq<b->seq;
+    }
+
     // ****************************************************************************************
     // Pool Implementation
     Pool::Ptr Pool::Create(const std::string &name,
 			   size_t             numThreads,
-			   const Stats::Ptr  &stats) {
+			   const Stats::Ptr  &stats,
+			   const PoolOptions &options) {
+      THROW_IF(options.GetAffinity()==PoolOptions::Affinity::CPU_SET && options.GetCpus().empty(),
+	       "Pool " << name << " pinned to an empty CPU set");
+      if (options.GetAffinity()==PoolOptions::Affinity::SINGLE_NODE) {
+	Topology::NodeCpus(options.GetNode()); // throws if there is no such node
+      }
       Ptr rtn(new Pool);
       rtn->THIS       = rtn;
       rtn->name       = name;
       rtn->numThreads = 0;
       rtn->run        = true;
-      rtn->sPtr.reset(new Semaphore);
+      rtn->sPtr.reset(new Semaphore(0, options.GetSpinBudget()));
       rtn->stats      = stats ? stats : Stats::Create(name + " stats");
+      rtn->options    = options;
+      rtn->nextWorker = 0;
+      rtn->readySeq   = 0;
+      rtn->nextSlot   = 0;
+      rtn->numStarting = 0;
+      rtn->numIdle    = 0;
+      rtn->unstaffed  = true;
+      rtn->busyChecks = 0;
+      rtn->scaling    = false;
+      rtn->growStats   = Stats::Create(name + " grow");
+      rtn->shrinkStats = Stats::Create(name + " shrink");
+      if (options.IsAutoScale()) {
+	numThreads = std::min(std::max(numThreads, options.GetMinThreads()), options.GetMaxThreads());
+      }
+      if (options.GetScheduling()==PoolOptions::Scheduling::WORK_STEALING) {
+	// always keep at least one deque so work may be queued before
+	// any threads are started.
+	WorkerPtr first(new Worker(rtn.get(), 0));
+	rtn->workers = WVecPtr(new WorkerVec(1, first));
+      }
       rtn->SetNumThreads(numThreads);
       return rtn;
     }
     const std::string &Pool::Name() const { return name; }
     const Stats::Ptr &Pool::GetStats() { return stats; }
+    const Stats::Ptr &Pool::GetGrowStats() { return growStats; }
+    const Stats::Ptr &Pool::GetShrinkStats() { return shrinkStats; }
+    size_t Pool::GetNumIdle() const { return numIdle; }
+    const PoolOptions &Pool::GetOptions() const { return options; }
     void Pool::Flush() {
       static Stats::Ptr flushStats = Stats::Ptr(new Stats("flushing queues"));
-      size_t sz;
+      QVec           flushQueues;
       Semaphore::Ptr flushSem(new Semaphore);;
       Work::Ptr last = Work::Create(flushStats,
 				    [=](bool &) {
@@ -35,17 +154,16 @@ namespace aliSystem {
 					flushSem->Post();
 				      }
 				    });
-      if (true) {
-	std::lock_guard<std::mutex> g(lock);
-	sz = queues.size();
-	for (QVec::iterator it=queues.begin(); it!=queues.end(); ++it) {
-	  Queue::Ptr qPtr = *it;
-	  if (qPtr) {
-	    qPtr->StopAfter(last);
-	  }
+      // the queues are stopped outside of the lock, the work they
+      // release may need it to start a thread (see Wake).
+      GetQueues(flushQueues);
+      for (QVec::iterator it=flushQueues.begin(); it!=flushQueues.end(); ++it) {
+	Queue::Ptr qPtr = *it;
+	if (qPtr) {
+	  qPtr->StopAfter(last);
 	}
       }
-      for (size_t i=0;i<sz;++i) {
+      for (size_t i=0;i<flushQueues.size();++i) {
 	flushSem->Wait();
       }
     }
@@ -53,6 +171,9 @@ namespace aliSystem {
       if (true) {
 	run = false;
 	std::lock_guard<std::mutex> g(lock);
+	if (scaling && scaleTimer.Cancel()) {
+	  scaling = false;
+	}
 	for (size_t i=0;i<numThreads; ++i) {
 	  sPtr->Post();
 	}
@@ -69,53 +190,274 @@ namespace aliSystem {
       Ptr pool = THIS.lock();
       if (pool) {
 	run = true;
-	for (size_t i=numThreads;i<numThreads_; ++i) {
-	  std::thread t(Run, pool);
-	  t.detach();
+	if (options.IsAutoScale()) {
+	  numThreads_ = std::min(numThreads_, options.GetMaxThreads());
+	  if (!scaling) {
+	    scaling = true;
+	    ScheduleEvaluate(g);
+	  }
+	}
+	if (numThreads+numStarting<numThreads_) {
+	  StartThreads(pool, numThreads_-numThreads-numStarting);
 	}
       }
     }
+    void Pool::StartThreads(const Ptr &pool, size_t num) {
+      for (size_t i=0;i<num; ++i) {
+	++numStarting;
+	unstaffed = false;
+	std::thread t(Run, pool, nextSlot++);
+	t.detach();
+      }
+    }
     Queue::Ptr Pool::AddQueue(const std::string &queueName,
 			      size_t             maxConcurrency,
-			      const Stats::Ptr  &stats) {
-      Queue::Ptr rtn = Queue::Create(queueName, sPtr, maxConcurrency, stats);
+			      const Stats::Ptr  &stats,
+			      size_t             weight,
+			      size_t             priority,
+			      size_t             capacity,
+			      Queue::Overflow    overflow) {
+      THROW_IF(weight==0, "Attempt to add queue " << queueName << " with a zero weight");
+      Queue::Ptr rtn;
+      if (options.GetScheduling()==PoolOptions::Scheduling::WEIGHTED_FAIR) {
+	WPtr    wPool = THIS;
+	FairPtr fair(new FairQueue);
+	rtn = Queue::Create(queueName,
+			    [=](const Queue::Ptr &queue) {
+			      Ptr pool = wPool.lock();
+			      if (pool) {
+				pool->Ready(fair, queue);
+				pool->Wake(pool);
+			      }
+			    },
+			    maxConcurrency,
+			    stats);
+	// the new queue has no work, so it cannot be ready before this is set.
+	fair->queue = rtn;
+      } else if (options.GetScheduling()==PoolOptions::Scheduling::WORK_STEALING) {
+	WPtr wPool = THIS;
+	rtn = Queue::Create(queueName,
+			    [=](const Queue::Ptr &queue) {
+			      Ptr pool = wPool.lock();
+			      if (pool) {
+				pool->Push(queue);
+				pool->Wake(pool);
+			      }
+			    },
+			    maxConcurrency,
+			    stats);
+      } else if (options.IsAutoScale() && options.GetMinThreads()==0) {
+	// the pool may shrink to no threads, released work must be able
+	// to start one.
+	WPtr wPool = THIS;
+	rtn = Queue::Create(queueName,
+			    [=](const Queue::Ptr &) {
+			      Ptr pool = wPool.lock();
+			      if (pool) {
+				pool->Wake(pool);
+			      }
+			    },
+			    maxConcurrency,
+			    stats);
+      } else {
+	rtn = Queue::Create(queueName, sPtr, maxConcurrency, stats);
+      }
+      rtn->SetWeight(weight);
+      rtn->SetPriority(priority);
+      rtn->SetCapacity(capacity, overflow);
       std::lock_guard<std::mutex> g(lock);
       queues.push_back(rtn);
       return rtn;
     }
+    void Pool::RemoveQueue(const Queue::Ptr &queue) {
+      THROW_IF(!queue, "Attempt to remove an uninitialized queue from pool " << name);
+      queue->Stop();
+      std::lock_guard<std::mutex> g(lock);
+      queues.erase(std::remove(queues.begin(), queues.end(), queue), queues.end());
+    }
+    void Pool::GetQueues(QVec &queues_) {
+      std::lock_guard<std::mutex> g(lock);
+      queues_ = queues;
+    }
+    void Pool::GetThreadNodes(NodeMap &nodes) {
+      std::lock_guard<std::mutex> g(lock);
+      nodes.clear();
+      for (NodeMap::const_iterator it=nodeThreads.begin(); it!=nodeThreads.end(); ++it) {
+	if (it->second>0) {
+	  nodes.insert(*it);
+	}
+      }
+    }
+    bool Pool::IsPoolThread() const {
+      return curPool==this;
+    }
+    int Pool::CurrentNode() {
+      return curNode;
+    }
     std::ostream &operator<<(std::ostream &out, const Pool &o) {
       out << "aliSystem::Threading::Pool(name=" << o.Name() << ")";
       return out;
     }
     Pool::Pool() {}
-    void Pool::Run(Ptr pool) {
+    void Pool::Run(Ptr pool, size_t slot) {
       if (pool) {
+	WorkerPtr self;
+	bool      retired = false;
+	int       node    = pool->Place(slot);
 	if (true) {
 	  std::lock_guard<std::mutex> g(pool->lock);
+	  --pool->numStarting;
 	  ++pool->numThreads;
+	  ++pool->nodeThreads[node];
+	  if (pool->options.GetScheduling()==PoolOptions::Scheduling::WORK_STEALING) {
+	    self       = pool->ClaimWorker(g);
+	    self->node = node;
+	  }
 	}
+	curWorker = self.get();
+	curPool   = pool.get();
+	curNode   = node;
+	Trace::SetThreadName(pool->Name()+"-"+std::to_string(slot));
 	size_t     curIdx = 0;
 	Queue::Ptr queue;
 	Work::Ptr  work;
 	while (pool->run) {
-	  pool->Next(curIdx, queue, work);
+	  if (!pool->WaitForWork(retired)) {
+	    if (retired) {
+	      break;
+	    }
+	    continue;
+	  }
+	  if (self) {
+	    pool->Next(*self, queue, work);
+	  } else if (pool->options.GetScheduling()==PoolOptions::Scheduling::WEIGHTED_FAIR) {
+	    pool->Next(queue, work);
+	  } else {
+	    pool->Next(curIdx, queue, work);
+	  }
 	  if (work && queue) {
-	    StatsGuard statsGuard(pool->stats);
+	    StatsGuard statsGuard(pool->stats, StatsGuard::Clock::CHEAP);
 	    queue->Run(work);
 	  }
 	  work.reset();
 	  queue.reset();
 	}
+	curWorker = nullptr;
+	curPool   = nullptr;
+	curNode   = -1;
 	if (true) {
 	  std::lock_guard<std::mutex> g(pool->lock);
-	  --pool->numThreads;
+	  if (!retired) {
+	    // a retiring thread was already taken off the count
+	    --pool->numThreads;
+	    pool->unstaffed = pool->numThreads+pool->numStarting==0;
+	  }
+	  --pool->nodeThreads[node];
+	  if (self) {
+	    // anything left in the deque remains available to thieves
+	    self->active = false;
+	  }
 	}
 	pool->done.Post();
       }
     }
+    int Pool::Place(size_t slot) {
+      Topology::CpuVec cpus;
+      int              node = -1;
+      switch (options.GetAffinity()) {
+      case PoolOptions::Affinity::NONE:
+	break;
+      case PoolOptions::Affinity::CPU_SET:
+	cpus = options.GetCpus();
+	break;
+      case PoolOptions::Affinity::SPREAD_NODES:
+	node = slot % Topology::NumNodes();
+	cpus = Topology::NodeCpus(node);
+	break;
+      case PoolOptions::Affinity::SINGLE_NODE:
+	node = options.GetNode();
+	cpus = Topology::NodeCpus(node);
+	break;
+      }
+      if (!cpus.empty() && !Topology::Pin(cpus)) {
+	WARN("Pool " << name << " could not pin thread " << slot << " (" << options.GetAffinity() << ")");
+	node = -1;
+      }
+      if (node<0) {
+	// not tied to one node, record the node the thread starts on
+	node = Topology::NodeOfCpu(Topology::CurrentCpu());
+      }
+      return node;
+    }
+    bool Pool::WaitForWork(bool &retired) {
+      if (!options.IsAutoScale()) {
+	DEBUG("wating for next");
+	sPtr->Wait();
+	return true;
+      }
+      Time::TP start = Time::Now();
+      ++numIdle;
+      int rc = sPtr->TimedWait(options.GetIdleTimeout());
+      --numIdle;
+      if (rc==0) {
+	return true;
+      }
+      std::lock_guard<std::mutex> g(lock);
+      if (run && numThreads>options.GetMinThreads()) {
+	--numThreads;
+	if (numThreads+numStarting==0) {
+	  // work released before unstaffed was set only posted the
+	  // semaphore, so the last thread stays for it.
+	  unstaffed = true;
+	  std::atomic_thread_fence(std::memory_order_seq_cst);
+	  if (sPtr->TryWait()) {
+	    ++numThreads;
+	    unstaffed = false;
+	    return true;
+	  }
+	}
+	retired = true;
+	shrinkStats->Inc(Time::Now()-start);
+	DEBUG("pool " << name << " retiring a thread, " << numThreads << " remain");
+      }
+      return false;
+    }
+    void Pool::Evaluate(const WPtr &wPool) {
+      Ptr pool = wPool.lock();
+      if (pool) {
+	size_t backlog = 0;
+	std::lock_guard<std::mutex> g(pool->lock);
+	if (!pool->run) {
+	  pool->scaling = false;
+	  return;
+	}
+	for (QVec::const_iterator it=pool->queues.begin(); it!=pool->queues.end(); ++it) {
+	  backlog += (*it)->NumPending();
+	}
+	if (backlog>0 && pool->numIdle==0 && pool->numStarting==0) {
+	  ++pool->busyChecks;
+	} else {
+	  pool->busyChecks = 0;
+	}
+	if (pool->busyChecks>=pool->options.GetGrowAfter() &&
+	    pool->numThreads<pool->options.GetMaxThreads()) {
+	  DEBUG("pool " << pool->name << " growing, " << backlog << " work units pending");
+	  pool->growStats->Inc(pool->busyChecks*pool->options.GetScaleInterval());
+	  pool->busyChecks = 0;
+	  pool->StartThreads(pool, 1);
+	}
+	pool->ScheduleEvaluate(g);
+      }
+    }
+    void Pool::ScheduleEvaluate(std::lock_guard<std::mutex> &) {
+      WPtr wPool = THIS;
+      static Stats::Ptr scaleStats = Stats::Create("pool auto scaling");
+      scaleTimer = Scheduler::Schedule(Time::Now()+options.GetScaleInterval(),
+				       Work::Create(scaleStats, [=](bool &) {
+					   Evaluate(wPool);
+					 }));
+    }
     void Pool::Next(size_t &curIdx, Queue::Ptr &queue, Work::Ptr &work) {
-      DEBUG("wating for next");
-      sPtr->Wait();
       DEBUG("getting next");
       std::lock_guard<std::mutex> g(lock);
       size_t sz = queues.size();
@@ -131,6 +473,114 @@ namespace aliSystem {
       }
       //ERROR_IF(run,"Nothing found");
     }
+    void Pool::Next(Worker &self, Queue::Ptr &queue, Work::Ptr &work) {
+      if (!run) {
+	// the wake up may have been issued for a ready queue, pass it on
+	// so the queue is not stranded if the pool is restarted.
+	sPtr->Post();
+	return;
+      }
+      Queue::Ptr ready;
+      if (!self.Pop(ready)) {
+	WVecPtr wVec = std::atomic_load(&workers);
+	size_t  sz   = wVec->size();
+	for (size_t i=1; i<sz && !ready; ++i) {
+	  (*wVec)[(self.index+i)%sz]->Steal(ready);
+	}
+      }
+      if (ready) {
+	work = ready->Next();
+	if (work) {
+	  queue = ready;
+	}
+      }
+    }
+    void Pool::Next(Queue::Ptr &queue, Work::Ptr &work) {
+      if (!run) {
+	// as with work stealing, pass the wake up on for a restart
+	sPtr->Post();
+	return;
+      }
+      FairPtr fair;
+      if (true) {
+	std::lock_guard<std::mutex> g(readyLock);
+	if (!ready.empty()) {
+	  fair = *ready.begin();
+	  ready.erase(ready.begin());
+	  classPass[fair->priority] = fair->pass;
+	  fair->pass += STRIDE/fair->weight;
+	  --fair->released;
+	  if (fair->released>0) {
+	    ready.insert(fair);
+	  } else {
+	    fair->isReady = false;
+	  }
+	}
+      }
+      if (fair) {
+	Queue::Ptr ptr = fair->queue.lock();
+	if (ptr) {
+	  work = ptr->Next();
+	  if (work) {
+	    queue = ptr;
+	  }
+	}
+      }
+    }
+    void Pool::Ready(const FairPtr &fair, const Queue::Ptr &queue) {
+      if (true) {
+	std::lock_guard<std::mutex> g(readyLock);
+	++fair->released;
+	if (!fair->isReady) {
+	  // an idle queue rejoins at its class's current pass, it does
+	  // not accumulate credit while it has nothing to run.
+	  fair->weight   = queue->GetWeight();
+	  fair->priority = queue->GetPriority();
+	  fair->pass     = std::max(fair->pass, classPass[fair->priority]);
+	  fair->seq      = ++readySeq;
+	  fair->isReady  = true;
+	  ready.insert(fair);
+	}
+      }
+    }
+    void Pool::Push(const Queue::Ptr &queue) {
+      Worker *target = curWorker;
+      WVecPtr wVec;
+      if (!target || target->pool!=this) {
+	wVec   = std::atomic_load(&workers);
+	target = (*wVec)[nextWorker++ % wVec->size()].get();
+      }
+      target->Push(queue);
+    }
+    void Pool::Wake(const Ptr &pool) {
+      sPtr->Post();
+      if (options.IsAutoScale() && unstaffed) {
+	std::lock_guard<std::mutex> g(lock);
+	if (run && numThreads+numStarting==0) {
+	  DEBUG("pool " << name << " has no threads, starting one");
+	  growStats->Inc(Time::Dur::zero());
+	  StartThreads(pool, 1);
+	}
+      }
+    }
+    Pool::WorkerPtr Pool::ClaimWorker(std::lock_guard<std::mutex> &) {
+      WorkerPtr rtn;
+      for (WorkerVec::const_iterator it=workers->begin(); it!=workers->end() && !rtn; ++it) {
+	if (!(*it)->active) {
+	  rtn = *it;
+	}
+      }
+      if (!rtn) {
+	// publish a new vector so threads scanning the current one
+	// are not disturbed.
+	WorkerVec *wVec = new WorkerVec(*workers);
+	rtn.reset(new Worker(this, wVec->size()));
+	wVec->push_back(rtn);
+	std::atomic_store(&workers, WVecPtr(wVec));
+      }
+      rtn->active = true;
+      return rtn;
+    }
 
   }
 }
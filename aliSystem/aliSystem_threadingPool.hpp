@@ -1,11 +1,18 @@
 #ifndef INCLUDED_ALI_SYSTEM_THREADING_POOL
 #define INCLUDED_ALI_SYSTEM_THREADING_POOL
 
+#include <aliSystem_threadingPoolOptions.hpp>
 #include <aliSystem_threadingQueue.hpp>
+#include <aliSystem_threadingScheduler.hpp>
 #include <aliSystem_threadingSemaphore.hpp>
 #include <aliSystem_threadingWork.hpp>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -64,25 +71,82 @@ namespace aliSystem {
     /// their system's design when analyzing latency between enqueuing work to an
     /// empty queue and its execution.
     ///
+    /// The default scheduler (PoolOptions::Scheduling::ROUND_ROBIN) has every
+    /// thread wait on one shared semaphore and then scan the queues under the
+    /// pool's lock.  With many threads and many queues that lock becomes the
+    /// limit on throughput.  The work stealing scheduler
+    /// (PoolOptions::Scheduling::WORK_STEALING) instead gives each thread a
+    /// local deque of queues that have released a work unit.  A queue that
+    /// releases work while running on one of the pool's threads is pushed to
+    /// that thread's deque; work released from other threads is spread across
+    /// the deques.  A thread serves its own deque first and steals from its
+    /// peers when it runs dry.  In both modes the work itself is still drawn
+    /// through Queue::Next, so a queue's maximum concurrency and ordering
+    /// are unchanged.
+    ///
+    /// Neither of those schedulers distinguishes between queues, so a busy,
+    /// unimportant queue receives the same share of the threads as a latency
+    /// critical one.  The weighted fair scheduler
+    /// (PoolOptions::Scheduling::WEIGHTED_FAIR) keeps a ready list holding
+    /// only queues that have released work and serves it by stride
+    /// scheduling: each queue carries a weight and a priority class
+    /// (see Queue::SetWeight and Queue::SetPriority).  Ready queues in a
+    /// higher priority class always go first; within a class a queue of
+    /// weight w is served w times as often as a queue of weight 1.  A
+    /// queue that was idle rejoins at the current position of its class
+    /// rather than with credit for the time it had nothing to do.
+    /// Queue::NumDispatched reports how much of the pool each queue got.
+    ///
+    /// By default the pool's threads run wherever the OS schedules them.
+    /// PoolOptions::Affinity pins them instead, to a CPU set, to the CPUs
+    /// of a single NUMA node, or spread across the nodes in turn.  Each
+    /// thread records the node it runs on (see CurrentNode and
+    /// GetThreadNodes) so that state used by the work it runs, such as an
+    /// ExecEngine's Lua interpreter, can be allocated locally.  Queues are
+    /// not bound to nodes, so on a pool spread over several nodes such
+    /// state is local to the node it was allocated on, not to every
+    /// thread that later uses it.
+    ///
+    /// A pool created with PoolOptions::SetAutoScale sizes itself between
+    /// a minimum and a maximum number of threads.  Every scale interval
+    /// (driven by Threading::Scheduler) the pool checks whether work is
+    /// pending while none of its threads is idle; once that has held for
+    /// a number of consecutive checks a thread is added.  A thread that
+    /// waits for work longer than the idle timeout retires, finishing
+    /// its current work unit first, as long as more than the minimum
+    /// remain.  A pool whose minimum is zero may retire every thread;
+    /// the next work released then starts a thread at once rather than
+    /// waiting for the checks.  Each thread added is counted by
+    /// GetGrowStats and each thread retired by GetShrinkStats.
+    ///
     struct Pool {
-      using Ptr  = std::shared_ptr<Pool>;   ///< shared pointer
-      using WPtr = std::weak_ptr<Pool>;     ///< weak pointer
-      using QVec = std::vector<Queue::Ptr>; ///< vector of queues
+      using Ptr     = std::shared_ptr<Pool>;   ///< shared pointer
+      using WPtr    = std::weak_ptr<Pool>;     ///< weak pointer
+      using QVec    = std::vector<Queue::Ptr>; ///< vector of queues
+      using NodeMap = std::map<int, size_t>;   ///< NUMA node to number of threads
 
       /// @brief Create a thread pool.
       /// @param name name of the Threading::Pool
       /// @param numThreads initial number of threads for the pool.
       /// @param stats is a stats object to use to record stats for the
       ///        newly created thread pool.
+      /// @param options specialize the pool's behavior, such as which
+      ///        scheduling algorithm it uses and where its threads run.
       /// @note A Threading::Pool may be initialized with 0 initial threads
       ///       and later increased.
       /// @note A Threading::Pool's associated queues may allow more or less
       ///       concurrency than the thread pool.  The total limit of concurrency
       ///       will be the lessor of the thread pool's number of threads and
       ///       the sum of the associated queue's maximum concurrencies.
+      /// @note For an auto scaling pool numThreads is kept within the
+      ///       pool's minimum and maximum.
+      /// @note An exception is thrown if the options name an empty CPU
+      ///       set or a NUMA node that does not exist.  A thread the OS
+      ///       refuses to pin still runs, unpinned, and a warning is logged.
       static Ptr Create(const std::string &name,
 			size_t             numThreads,
-			const Stats::Ptr  &stats = nullptr);
+			const Stats::Ptr  &stats   = nullptr,
+			const PoolOptions &options = PoolOptions());
 
       /// @brief retrieve the name of the pool
       /// @return the name of the thread pool
@@ -93,6 +157,24 @@ namespace aliSystem {
       ///          as well as the time spent processing those units.
       const Stats::Ptr &GetStats();
 
+      /// @brief retrieve the auto scaling growth stats.
+      /// @return stats counting threads added by auto scaling, the time
+      ///         recorded for each is how long the backlog persisted.
+      const Stats::Ptr &GetGrowStats();
+
+      /// @brief retrieve the auto scaling retirement stats.
+      /// @return stats counting threads retired by auto scaling, the time
+      ///         recorded for each is how long the thread was idle.
+      const Stats::Ptr &GetShrinkStats();
+
+      /// @brief retrieve the number of threads waiting for work
+      /// @return number of idle threads (only tracked for auto scaling pools)
+      size_t GetNumIdle() const;
+
+      /// @brief retrieve the options the pool was created with.
+      /// @return the pool's options
+      const PoolOptions &GetOptions() const;
+
       /// @brief flush the associated Threading::Pool.
       ///
       /// Flush will return when whatever was in the queue at the time
@@ -130,6 +212,8 @@ namespace aliSystem {
       ///       will not repeatedly start & stop the pool.  If that is not
       ///       the case, then this aspect of the implementatoin should be
       ///       revisited.
+      /// @note An auto scaling pool does not grow beyond its maximum, it
+      ///       may later retire the threads added here down to its minimum.
       void SetNumThreads(size_t numThreads);
 
       /// @brief Add a queue to the thread pool.
@@ -139,13 +223,54 @@ namespace aliSystem {
       /// @param maxConcurrency maximum initial concurrency for the
       ///        new queue.
       /// @param stats stats to associate with the new queue.
+      /// @param weight scheduling weight of the queue (see Queue::SetWeight)
+      /// @param priority scheduling priority class of the queue
+      ///        (see Queue::SetPriority)
+      /// @param capacity maximum number of pending work units on the
+      ///        queue, 0 for no limit (see Queue::SetCapacity)
+      /// @param overflow what the queue does with work added while it
+      ///        is full
       /// @note It is possible to use the same stats object for multiple
       ///       queues.  How a designer leverages the queues and the stats
       ///       related to execution of work on those queues is up to the
       ///       system designer.
+      /// @note The weight and priority class only affect pools using the
+      ///       weighted fair scheduler.
       Queue::Ptr AddQueue(const std::string &queueName,
 			  size_t             maxConcurrency,
-			  const Stats::Ptr  &stats);
+			  const Stats::Ptr  &stats,
+			  size_t             weight   = 1,
+			  size_t             priority = 0,
+			  size_t             capacity = 0,
+			  Queue::Overflow    overflow = Queue::Overflow::BLOCK);
+
+      /// @brief stop a queue and detach it from the pool
+      ///
+      /// Use this for short lived queues so the pool does not keep
+      /// scanning and holding on to them.
+      /// @param queue the queue to remove
+      /// @note Work already pending on the queue is not run.  Work that
+      ///       is executing is not aborted.
+      void RemoveQueue(const Queue::Ptr &queue);
+
+      /// @brief retrieve the queues attached to the pool
+      /// @param queues [out] the pool's queues, in the order they were added
+      void GetQueues(QVec &queues);
+
+      /// @brief retrieve where the pool's live threads run
+      /// @param nodes [out] number of live threads on each NUMA node
+      void GetThreadNodes(NodeMap &nodes);
+
+      /// @brief check whether the calling thread belongs to this pool
+      /// @return true if called from one of the pool's threads
+      bool IsPoolThread() const;
+
+      /// @brief retrieve the NUMA node of the calling pool thread
+      /// @return the node recorded when the thread started (the node it is
+      ///         pinned to, or the node of the CPU it started on if it is
+      ///         not pinned to a single node), -1 if the caller is not a
+      ///         thread of any pool.
+      static int CurrentNode();
       
       /// @brief Serialize a Pool
       /// @param out is the stream to write information about the pool
@@ -155,12 +280,60 @@ namespace aliSystem {
       
     private:
 
+      struct Worker;                              ///< per thread state for work stealing
+      using WorkerPtr = std::shared_ptr<Worker>;  ///< shared worker pointer
+      using WorkerVec = std::vector<WorkerPtr>;   ///< vector of workers
+      using WVecPtr   = std::shared_ptr<const WorkerVec>; ///< published worker snapshot
+      struct FairQueue;                           ///< per queue state for weighted fair scheduling
+      using FairPtr   = std::shared_ptr<FairQueue>; ///< shared fair queue pointer
+      /// @brief ordering of the weighted fair ready list
+      struct FairOrder {
+	/// @brief compare two ready queues
+	/// @param a first queue
+	/// @param b second queue
+	/// @return true if a should be served before b
+	bool operator()(const FairPtr &a, const FairPtr &b) const;
+      };
+      using FairSet   = std::set<FairPtr, FairOrder>; ///< ready list
+      using PassMap   = std::map<size_t, uint64_t>; ///< priority class to current pass
+
       /// @brief constructor for a pool.
       Pool();
 
       /// @brief A thread poool's thread function.
       /// Each thread within a pool will run this function.
-      static void Run(Ptr pool);
+      /// @param pool the pool the thread belongs to
+      /// @param slot the ordinal of the thread within the pool, used to
+      ///        spread threads across NUMA nodes.
+      static void Run(Ptr pool, size_t slot);
+
+      /// @brief wait for a wake up on the pool's semaphore.
+      /// @param retired [out] set when the calling thread should exit
+      ///        because the pool has shrunk.
+      /// @return true if a wake up was consumed
+      /// @note Threads of an auto scaling pool wait at most the idle
+      ///       timeout, then retire if the pool has more than its
+      ///       minimum number of threads.
+      bool WaitForWork(bool &retired);
+
+      /// @brief auto scaling check, adds a thread if work has been
+      ///        pending with no idle thread for long enough.
+      /// @param wPool the pool to check
+      static void Evaluate(const WPtr &wPool);
+
+      /// @brief schedule the next auto scaling check
+      /// @param g a lock guard that holds the pool's lock.
+      void ScheduleEvaluate(std::lock_guard<std::mutex> &g);
+
+      /// @brief start threads, the pool's lock must be held
+      /// @param pool shared pointer to this pool
+      /// @param num number of threads to start
+      void StartThreads(const Ptr &pool, size_t num);
+
+      /// @brief pin the calling thread as required by the pool's options.
+      /// @param slot the ordinal of the thread within the pool
+      /// @return the NUMA node the thread runs on
+      int Place(size_t slot);
 
       /// @brief fetch the next work unit.
       ///
@@ -179,6 +352,46 @@ namespace aliSystem {
       /// @param work [out] the next unit of work
       void Next(size_t &curIdx, Queue::Ptr &queue, Work::Ptr &work);
 
+      /// @brief fetch the next work unit for the work stealing scheduler.
+      /// @param self the calling thread's worker.
+      /// @param queue [out] queue from which work was selected.
+      /// @param work [out] the next unit of work
+      /// @note The pool's lock is not taken.  The worker's own deque is
+      ///       checked first, then every other worker's deque is checked
+      ///       in turn, starting with the worker that follows self.
+      void Next(Worker &self, Queue::Ptr &queue, Work::Ptr &work);
+
+      /// @brief fetch the next work unit for the weighted fair scheduler.
+      /// @param queue [out] queue from which work was selected.
+      /// @param work [out] the next unit of work
+      /// @note The front of the ready list is chosen under readyLock, the
+      ///       lock is released before the work is drawn from the queue.
+      void Next(Queue::Ptr &queue, Work::Ptr &work);
+
+      /// @brief record that the given queue has released a work unit
+      ///        (weighted fair scheduler only).
+      /// @param fair the scheduling state of the queue
+      /// @param queue the queue that released work.
+      void Ready(const FairPtr &fair, const Queue::Ptr &queue);
+
+      /// @brief record that the given queue has released a work unit
+      ///        (work stealing scheduler only).
+      /// @param queue the queue that released work.
+      void Push(const Queue::Ptr &queue);
+
+      /// @brief wake a thread for released work, starting one if an
+      ///        auto scaling pool has retired all of its threads.
+      /// @param pool shared pointer to this pool
+      /// @note The pool's lock is only taken when the pool has no threads,
+      ///       a pool thread holding it never finds the pool unstaffed.
+      void Wake(const Ptr &pool);
+
+      /// @brief obtain an idle worker for a starting thread, creating
+      ///        one if every existing worker is in use.
+      /// @param g a lock guard that holds the pool's lock.
+      /// @return the claimed worker
+      WorkerPtr ClaimWorker(std::lock_guard<std::mutex> &g);
+
       std::mutex     lock;        ///< lock used to guard manipulations to various members
       WPtr           THIS;        ///< weak pointer to this object
       std::string    name;        ///< name of the pool
@@ -188,6 +401,27 @@ namespace aliSystem {
       Semaphore::Ptr sPtr;        ///< semaphore used by queues to trigger fetch cycles
       Semaphore      done;        ///< done semaphore used to coordinate stop that waits
       Stats::Ptr     stats;       ///< stats for the pool's execution
+      PoolOptions    options;     ///< options defined when the pool was created
+      WVecPtr        workers;     ///< work stealing workers, replaced (not modified) under lock
+      std::atomic<size_t> nextWorker; ///< round robin cursor for work released off the pool's threads
+      std::mutex     readyLock;   ///< guards ready, classPass and readySeq
+      FairSet        ready;       ///< weighted fair ready list
+      PassMap        classPass;   ///< pass of the last queue served in each priority class
+      uint64_t       readySeq;    ///< arrival counter used to break ties in the ready list
+      std::atomic<size_t> nextSlot; ///< ordinal of the next thread started
+      NodeMap        nodeThreads; ///< number of live threads on each NUMA node (lock)
+      size_t         numStarting; ///< threads started but not yet running (lock)
+      std::atomic<size_t> numIdle; ///< threads waiting for work (auto scaling only)
+      std::atomic<bool> unstaffed; ///< no thread is running or starting (written under lock)
+      size_t         busyChecks;  ///< consecutive checks with a backlog and no idle thread (lock)
+      bool           scaling;     ///< true while auto scaling checks are scheduled (lock)
+      Scheduler::Timer scaleTimer; ///< next auto scaling check (lock)
+      Stats::Ptr     growStats;   ///< threads added by auto scaling
+      Stats::Ptr     shrinkStats; ///< threads retired by auto scaling
+
+      static thread_local Worker *curWorker; ///< worker serviced by the calling thread (if any)
+      static thread_local Pool   *curPool;   ///< pool owning the calling thread (if any)
+      static thread_local int     curNode;   ///< NUMA node of the calling pool thread
     };
 
   }
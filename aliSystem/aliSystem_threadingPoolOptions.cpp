@@ -0,0 +1,103 @@
+#include <aliSystem_threadingPoolOptions.hpp>
+#include <aliSystem_logging.hpp>
+
+namespace aliSystem {
+  namespace Threading {
+
+    PoolOptions::PoolOptions(Scheduling scheduling_)
+      : scheduling(scheduling_),
+	affinity(Affinity::NONE),
+	node(0),
+	minThreads(0),
+	maxThreads(0),
+	scaleInterval(std::chrono::milliseconds(100)),
+	growAfter(2),
+	idleTimeout(std::chrono::seconds(10)),
+	spinBudget(Time::Dur::zero()) {
+    }
+
+    PoolOptions::Scheduling  PoolOptions::GetScheduling() const { return scheduling; }
+    PoolOptions::Affinity    PoolOptions::GetAffinity  () const { return affinity;   }
+    const Topology::CpuVec  &PoolOptions::GetCpus      () const { return cpus;       }
+    int                      PoolOptions::GetNode      () const { return node;       }
+    bool                     PoolOptions::IsAutoScale     () const { return maxThreads>0; }
+    size_t                   PoolOptions::GetMinThreads   () const { return minThreads;   }
+    size_t                   PoolOptions::GetMaxThreads   () const { return maxThreads;   }
+    const Time::Dur         &PoolOptions::GetScaleInterval() const { return scaleInterval; }
+    size_t                   PoolOptions::GetGrowAfter    () const { return growAfter;    }
+    const Time::Dur         &PoolOptions::GetIdleTimeout  () const { return idleTimeout;  }
+    const Time::Dur         &PoolOptions::GetSpinBudget   () const { return spinBudget;   }
+
+    void PoolOptions::SetScheduling(Scheduling              val_) { scheduling = val_; }
+    void PoolOptions::SetAffinity  (Affinity                val_) { affinity   = val_; }
+    void PoolOptions::SetCpus      (const Topology::CpuVec &val_) { cpus       = val_; }
+    void PoolOptions::SetNode      (int                     val_) { node       = val_; }
+
+    void PoolOptions::SetAutoScale(size_t minThreads_, size_t maxThreads_) {
+      THROW_IF(minThreads_>maxThreads_,
+	       "Auto scaling minimum " << minThreads_ << " exceeds maximum " << maxThreads_);
+      minThreads = minThreads_;
+      maxThreads = maxThreads_;
+    }
+    void PoolOptions::SetScaleInterval(const Time::Dur &val_) {
+      THROW_IF(val_<=Time::Dur::zero(), "Auto scaling interval must be positive");
+      scaleInterval = val_;
+    }
+    void PoolOptions::SetGrowAfter(size_t val_) {
+      THROW_IF(val_==0, "Auto scaling needs at least one busy check to grow");
+      growAfter = val_;
+    }
+    void PoolOptions::SetIdleTimeout(const Time::Dur &val_) {
+      THROW_IF(val_<=Time::Dur::zero(), "Auto scaling idle timeout must be positive");
+      idleTimeout = val_;
+    }
+    void PoolOptions::SetSpinBudget(const Time::Dur &val_) {
+      THROW_IF(val_<Time::Dur::zero(), "Spin budget must not be negative");
+      spinBudget = val_;
+    }
+
+    std::ostream &operator<<(std::ostream &out, const PoolOptions &o) {
+      out << "PoolOptions"
+	  << "\n   scheduling = " << o.scheduling
+	  << "\n   affinity   = " << o.affinity;
+      if (o.affinity==PoolOptions::Affinity::CPU_SET) {
+	out << "\n   cpus       =";
+	for (size_t i=0;i<o.cpus.size();++i) {
+	  out << " " << o.cpus[i];
+	}
+      } else if (o.affinity==PoolOptions::Affinity::SINGLE_NODE) {
+	out << "\n   node       = " << o.node;
+      }
+      if (o.IsAutoScale()) {
+	out << "\n   threads    = " << o.minThreads << " to " << o.maxThreads
+	    << "\n   interval   = " << Time::ToSeconds(o.scaleInterval)
+	    << "\n   growAfter  = " << o.growAfter
+	    << "\n   idle       = " << Time::ToSeconds(o.idleTimeout);
+      }
+      if (o.spinBudget>Time::Dur::zero()) {
+	out << "\n   spinBudget = " << Time::ToSeconds(o.spinBudget);
+      }
+      return out;
+    }
+
+    std::ostream &operator<<(std::ostream &out, const PoolOptions::Scheduling &o) {
+      switch (o) {
+      case PoolOptions::Scheduling::ROUND_ROBIN:   out << "round robin";   break;
+      case PoolOptions::Scheduling::WORK_STEALING: out << "work stealing"; break;
+      case PoolOptions::Scheduling::WEIGHTED_FAIR: out << "weighted fair"; break;
+      }
+      return out;
+    }
+
+    std::ostream &operator<<(std::ostream &out, const PoolOptions::Affinity &o) {
+      switch (o) {
+      case PoolOptions::Affinity::NONE:         out << "none";         break;
+      case PoolOptions::Affinity::CPU_SET:      out << "cpu set";      break;
+      case PoolOptions::Affinity::SPREAD_NODES: out << "spread nodes"; break;
+      case PoolOptions::Affinity::SINGLE_NODE:  out << "single node";  break;
+      }
+      return out;
+    }
+
+  }
+}
@@ -0,0 +1,183 @@
+#ifndef INCLUDED_ALI_SYSTEM_THREADING_POOL_OPTIONS
+#define INCLUDED_ALI_SYSTEM_THREADING_POOL_OPTIONS
+
+#include <aliSystem_threadingTopology.hpp>
+#include <aliSystem_time.hpp>
+#include <cstddef>
+#include <ostream>
+
+namespace aliSystem {
+  namespace Threading {
+
+    /// @brief PoolOptions defines a set of options that specialize the
+    ///        behavior of a Threading::Pool.
+    ///
+    /// The options are consumed when the pool is created and cannot
+    /// be altered for the life of the pool.
+    struct PoolOptions {
+
+      /// @brief Scheduling identifies the algorithm a Threading::Pool
+      ///        uses to hand work from its queues to its threads.
+      enum class Scheduling {
+	ROUND_ROBIN,   ///< threads share one semaphore and scan every queue under the pool's lock
+	WORK_STEALING, ///< each thread owns a local deque of ready queues and steals when it runs dry
+	WEIGHTED_FAIR  ///< stride scheduling by queue weight and priority class over ready queues only
+      };
+
+      /// @brief Affinity identifies where a Threading::Pool places its
+      ///        threads.
+      enum class Affinity {
+	NONE,         ///< threads run wherever the OS puts them
+	CPU_SET,      ///< every thread is pinned to the CPUs given by SetCpus
+	SPREAD_NODES, ///< threads are pinned to NUMA nodes in turn, thread i on node i%NumNodes
+	SINGLE_NODE   ///< every thread is pinned to the CPUs of the node given by SetNode
+      };
+
+      /// @brief constructor
+      /// @param scheduling the scheduling algorithm for the pool
+      explicit PoolOptions(Scheduling scheduling = Scheduling::ROUND_ROBIN);
+
+      //
+      // accessors
+
+      /// @brief GetScheduling returns the scheduling algorithm
+      /// @return scheduling algorithm
+      Scheduling GetScheduling() const;
+
+      /// @brief GetAffinity returns the thread placement policy
+      /// @return placement policy
+      Affinity GetAffinity() const;
+
+      /// @brief GetCpus returns the CPUs used by Affinity::CPU_SET
+      /// @return CPU set
+      const Topology::CpuVec &GetCpus() const;
+
+      /// @brief GetNode returns the NUMA node used by Affinity::SINGLE_NODE
+      /// @return NUMA node
+      int GetNode() const;
+
+      /// @brief IsAutoScale returns whether the pool sizes itself
+      /// @return true if auto scaling is enabled
+      bool IsAutoScale() const;
+
+      /// @brief GetMinThreads returns the fewest threads an auto scaling
+      ///        pool retires down to
+      /// @return minimum number of threads
+      size_t GetMinThreads() const;
+
+      /// @brief GetMaxThreads returns the most threads an auto scaling
+      ///        pool grows to
+      /// @return maximum number of threads
+      size_t GetMaxThreads() const;
+
+      /// @brief GetScaleInterval returns how often an auto scaling pool
+      ///        checks its backlog
+      /// @return check interval
+      const Time::Dur &GetScaleInterval() const;
+
+      /// @brief GetGrowAfter returns the number of consecutive checks that
+      ///        must find a backlog and no idle thread before a thread is added
+      /// @return number of checks
+      size_t GetGrowAfter() const;
+
+      /// @brief GetIdleTimeout returns how long a thread of an auto scaling
+      ///        pool waits for work before it retires
+      /// @return idle timeout
+      const Time::Dur &GetIdleTimeout() const;
+
+      /// @brief GetSpinBudget returns how long the pool's threads spin
+      ///        waiting for work before parking (see Semaphore)
+      /// @return spin budget
+      const Time::Dur &GetSpinBudget() const;
+
+      //
+      // manipulators
+
+      /// @brief SetScheduling allows reassigning the scheduling algorithm
+      /// @param val_ the new scheduling algorithm
+      void SetScheduling(Scheduling val_);
+
+      /// @brief SetAffinity allows reassigning the thread placement policy
+      /// @param val_ the new placement policy
+      void SetAffinity(Affinity val_);
+
+      /// @brief SetCpus allows reassigning the CPUs used by Affinity::CPU_SET
+      /// @param val_ the new CPU set
+      void SetCpus(const Topology::CpuVec &val_);
+
+      /// @brief SetNode allows reassigning the node used by Affinity::SINGLE_NODE
+      /// @param val_ the new NUMA node
+      void SetNode(int val_);
+
+      /// @brief SetAutoScale enables auto scaling between the given bounds.
+      ///
+      /// An auto scaling pool checks its queues every scale interval.  When
+      /// work is pending and no thread is idle for GetGrowAfter checks in a
+      /// row, one thread is added, up to maxThreads.  A thread that waits
+      /// longer than the idle timeout for work retires, down to minThreads.
+      /// Requiring a sustained backlog before growing and a long idle
+      /// period before retiring keeps the pool from oscillating.
+      /// @param minThreads_ the fewest threads to keep
+      /// @param maxThreads_ the most threads to run
+      /// @note Passing a zero maxThreads_ disables auto scaling.
+      void SetAutoScale(size_t minThreads_, size_t maxThreads_);
+
+      /// @brief SetScaleInterval allows reassigning the backlog check interval
+      /// @param val_ the new interval
+      void SetScaleInterval(const Time::Dur &val_);
+
+      /// @brief SetGrowAfter allows reassigning the number of busy checks
+      ///        needed to add a thread
+      /// @param val_ the new number of checks
+      void SetGrowAfter(size_t val_);
+
+      /// @brief SetIdleTimeout allows reassigning how long an idle thread
+      ///        waits before retiring
+      /// @param val_ the new idle timeout
+      void SetIdleTimeout(const Time::Dur &val_);
+
+      /// @brief SetSpinBudget allows reassigning how long the pool's
+      ///        threads spin waiting for work before parking.
+      ///
+      /// Spinning trades CPU for latency: a thread that is still spinning
+      /// when work is released picks it up without a system call or a
+      /// context switch.  It pays off for pools running many short work
+      /// units.  The spin adapts below the budget (see Semaphore).
+      /// @param val_ the new spin budget, zero disables spinning
+      void SetSpinBudget(const Time::Dur &val_);
+
+      /// @brief PoolOptions serialization operator
+      /// @param out output stream to serialize PoolOptions
+      /// @param o object to serialize
+      /// @return output stream
+      friend std::ostream &operator<<(std::ostream &out, const PoolOptions &o);
+
+    private:
+      Scheduling       scheduling;  ///< scheduling algorithm
+      Affinity         affinity;    ///< thread placement policy
+      Topology::CpuVec cpus;        ///< CPUs for Affinity::CPU_SET
+      int              node;        ///< NUMA node for Affinity::SINGLE_NODE
+      size_t           minThreads;  ///< auto scaling lower bound
+      size_t           maxThreads;  ///< auto scaling upper bound, 0 when disabled
+      Time::Dur        scaleInterval; ///< auto scaling backlog check interval
+      size_t           growAfter;   ///< busy checks in a row before adding a thread
+      Time::Dur        idleTimeout; ///< idle time before a thread retires
+      Time::Dur        spinBudget;  ///< longest a thread spins before parking
+    };
+
+    /// @brief Scheduling serialization operator
+    /// @param out output stream to serialize the scheduling value
+    /// @param o value to serialize
+    /// @return output stream
+    std::ostream &operator<<(std::ostream &out, const PoolOptions::Scheduling &o);
+
+    /// @brief Affinity serialization operator
+    /// @param out output stream to serialize the affinity value
+    /// @param o value to serialize
+    /// @return output stream
+    std::ostream &operator<<(std::ostream &out, const PoolOptions::Affinity &o);
+
+  }
+}
+
+#endif
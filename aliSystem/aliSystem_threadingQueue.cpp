@@ -2,7 +2,45 @@
 #include <aliSystem_logging.hpp>
 #include <aliSystem_statsGuard.hpp>
 #include <aliSystem_threadingWork.hpp>
+#include <aliSystem_trace.hpp>
+#include <algorithm>
 #include <exception>
+#include <utility>
+
+namespace {
+
+  // Queue::slots packs the number of work units released for execution
+  // (posted to the semaphore or post function, but not yet fetched by
+  // Next) into its high 32 bits, and the number executing into its low
+  // 32 bits, so both can be checked and updated with one atomic operation.
+  const uint64_t RELEASED  = uint64_t(1) << 32;
+  const uint64_t EXECUTING = 1;
+
+  size_t Released (uint64_t s) { return size_t(s >> 32);         }
+  size_t Executing(uint64_t s) { return size_t(s & 0xffffffffu); }
+
+  void ClearReleased(std::atomic<uint64_t> &slots) {
+    uint64_t s = slots;
+    while (!slots.compare_exchange_weak(s, s & 0xffffffffu)) {
+    }
+  }
+
+  // keep the released count within the pending count once pending
+  // work has been removed without being handed out by Next.
+  void ClampReleased(std::atomic<uint64_t> &slots, size_t numPending) {
+    uint64_t s = slots;
+    while (Released(s)>numPending
+	   && !slots.compare_exchange_weak(s, s-RELEASED)) {
+    }
+  }
+
+  // the time work is added, kept with it in the pending list for the
+  // "queued" span, only read while tracing.
+  aliSystem::Time::TP Stamp() {
+    return aliSystem::Trace::IsEnabled() ? aliSystem::Time::Now() : aliSystem::Time::TP();
+  }
+
+}
 
 namespace aliSystem {
   namespace Threading {
@@ -12,32 +50,92 @@ namespace aliSystem {
     Queue::Ptr Queue::Create(const std::string    &name,
 			     const Semaphore::Ptr &semPtr,
 			     size_t               maxConcurrency,
-			     const Stats::Ptr     &queueStats) {
+			     const Stats::Ptr     &queueStats,
+			     size_t               capacity,
+			     Overflow             overflow) {
       Ptr rtn(new Queue);
       rtn->THIS         = rtn;
       rtn->name         = name;
       rtn->queueStats   = queueStats;
-      rtn->stoppedStats = Stats::Create(name+":stopped");
+      rtn->stoppedStats = Stats::Create(name+":stopped", false);
       rtn->semPtr       = semPtr;
       rtn->onIdle       = QListeners::Create(name+"-onIdle");
       rtn->SetMaxConcurrency(maxConcurrency);
+      rtn->SetCapacity(capacity, overflow);
+      return rtn;
+    }
+    Queue::Ptr Queue::Create(const std::string &name,
+			     const PostFn      &postFn,
+			     size_t             maxConcurrency,
+			     const Stats::Ptr  &queueStats,
+			     size_t             capacity,
+			     Overflow           overflow) {
+      THROW_IF(!postFn, "Attempt to create a queue without a post function");
+      Ptr rtn(new Queue);
+      rtn->THIS         = rtn;
+      rtn->name         = name;
+      rtn->queueStats   = queueStats;
+      rtn->stoppedStats = Stats::Create(name+":stopped", false);
+      rtn->postFn       = postFn;
+      rtn->onIdle       = QListeners::Create(name+"-onIdle");
+      rtn->SetMaxConcurrency(maxConcurrency);
+      rtn->SetCapacity(capacity, overflow);
       return rtn;
     }
     Queue::~Queue() {}
     const std::string            &Queue::Name        () const { return name;         }
     const Stats::Ptr             &Queue::QueueStats  () const { return queueStats;   }
     const Stats::Ptr             &Queue::StoppedStats() const { return stoppedStats; }
-    bool                          Queue::IsBusy      () const { return isBusy;       }
+    bool                          Queue::IsBusy      () const { return outstanding>0; }
     bool                          Queue::IsStopped   () const { return isStopped;    }
     bool                          Queue::IsFrozen    () const { return isFrozen;     }
     const Queue::QListeners::Ptr &Queue::OnIdle      () const { return onIdle;       }
-    size_t                        Queue::CurrentConcurrency() const { return curConcurrency; }
+    size_t                        Queue::CurrentConcurrency() const { return Executing(slots); }
     size_t                        Queue::GetMaxConcurrency () const { return maxConcurrency; }
-    size_t                        Queue::NumPending        () const { return pending.size(); }
+    size_t                        Queue::NumPending        () const { return pending.Size()+held; }
+    size_t                        Queue::NumActiveKeys     () const { return activeKeys;     }
+    size_t                        Queue::GetWeight         () const { return weight;         }
+    size_t                        Queue::GetPriority       () const { return priority;       }
+    uint64_t                      Queue::NumDispatched     () const { return dispatched;     }
+    size_t                        Queue::GetCapacity       () const { return capacity;       }
+    Queue::Overflow               Queue::GetOverflow       () const { return overflow;       }
+    size_t                        Queue::GetHighWaterMark  () const {
+      // an unbounded queue does not track its occupancy
+      return capacity>0 ? highWater.load() : std::max<size_t>(highWater, pending.Size());
+    }
+    uint64_t                      Queue::NumSegmentsAllocated() const { return pending.NumAllocated(); }
+    uint64_t                      Queue::NumRejected       () const { return rejected;       }
+    uint64_t                      Queue::NumDropped        () const { return dropped;        }
+    uint64_t                      Queue::NumRanOnCaller    () const { return ranOnCaller;    }
+    uint64_t                      Queue::NumBlocked        () const { return blocked;        }
+    uint64_t                      Queue::NumExpired        () const { return expired;        }
+    void Queue::SetCapacity(size_t capacity_, Overflow overflow_) {
+      if (true) {
+	std::lock_guard<std::mutex> g(lock);
+	if (capacity==0 && capacity_>0) {
+	  // occupancy is not tracked while unbounded, start from what is
+	  // pending now.
+	  occupancy = pending.Size();
+	}
+	capacity = capacity_;
+	overflow = overflow_;
+      }
+      std::lock_guard<std::mutex> g(spaceLock);
+      spaceCv.notify_all();
+    }
+    void Queue::ResetHighWaterMark() {
+      highWater = capacity>0 ? occupancy.load() : 0;
+    }
+    void Queue::SetWeight(size_t weight_) {
+      THROW_IF(weight_==0, "Attempt to set a zero weight on queue " << name);
+      weight = weight_;
+    }
+    void Queue::SetPriority(size_t priority_) {
+      priority = priority_;
+    }
     void Queue::Freeze() {
       // perform this action under the lock so that it is not called
-      // in the middle of post or next or some other time that
-      // maxConcurrency is being used to control the object.
+      // in the middle of a SetMaxConcurrency call.
       std::lock_guard<std::mutex> g(lock);
       isFrozen = true;
     }
@@ -45,35 +143,135 @@ namespace aliSystem {
       std::lock_guard<std::mutex> g(lock);
       THROW_IF(isFrozen && maxConcurrency!=maxConcurrency_,
 	       "Attempt to change the maximum concurrency after the queue has been frozen");
-      size_t orig = maxConcurrency;
+      if (adaptive) {
+	adaptive = false;
+	std::atomic_store(&limiter, Limiter::Ptr());
+      }
       maxConcurrency = maxConcurrency_;
-      for (size_t i=orig; i<maxConcurrency_; ++i) {
-	Post(g);
+      TryPost(maxConcurrency_);
+    }
+    void Queue::SetAdaptiveConcurrency(const Limiter::Ptr &limiter_) {
+      std::lock_guard<std::mutex> g(lock);
+      THROW_IF(isFrozen && limiter_,
+	       "Attempt to make the concurrency of frozen queue " << name << " adaptive");
+      std::atomic_store(&limiter, limiter_);
+      adaptive = bool(limiter_);
+      if (limiter_) {
+	maxConcurrency = limiter_->GetLimit();
+	TryPost(maxConcurrency);
       }
     }
+    Limiter::Ptr Queue::GetLimiter() const {
+      return std::atomic_load(&limiter);
+    }
     void Queue::AddWork(const Work::Ptr &work) {
-      std::lock_guard<std::mutex> g(lock);
-      AddWork(g,work);
+      AddWork(Work::Ptr(work));
+    }
+    void Queue::AddWork(Work::Ptr &&work) {
+      THROW_IF(!work, "Attempt to add undefined work");
+      Trace::Span span("enqueue", "queue", "queue", name);
+      if (!Admit(1, !work->HasKey())) {
+	RunOnCaller(work);
+	return;
+      }
+      ++outstanding;
+      if (work->HasKey() && Hold(work)) {
+	return;
+      }
+      pending.Push(std::move(work), Stamp());
+      TryPost();
+      Shed();
+    }
+    void Queue::AddTask(const Stats::Ptr &stats, Task &&task) {
+      AddWork(Work::Create(stats, std::move(task)));
+    }
+    void Queue::AddWorkBatch(const WorkVec &works) {
+      AddWorkBatch(works.data(), works.size());
+    }
+    void Queue::AddWorkBatch(const Work::Ptr *works, size_t num) {
+      bool keyed = false;
+      for (size_t i=0;i<num;++i) {
+	THROW_IF(!works[i], "Attempt to add undefined work");
+	keyed = keyed || works[i]->HasKey();
+      }
+      if (num==0) {
+	return;
+      }
+      Trace::Span span("enqueue", "queue", "queue", name);
+      if (!Admit(num, !keyed)) {
+	for (size_t i=0;i<num;++i) {
+	  RunOnCaller(works[i]);
+	}
+	return;
+      }
+      PushBatch(works, num, keyed);
+    }
+    size_t Queue::TryAddWorkBatch(const WorkVec &works) {
+      size_t num   = works.size();
+      bool   keyed = false;
+      for (size_t i=0;i<num;++i) {
+	THROW_IF(!works[i], "Attempt to add undefined work");
+	keyed = keyed || works[i]->HasKey();
+      }
+      if (num==0) {
+	return 0;
+      }
+      Trace::Span span("enqueue", "queue", "queue", name);
+      // never wait for room, nor run the work here
+      if (capacity>0) {
+	if (overflow==Overflow::DROP_OLDEST) {
+	  Reserve(num);
+	} else {
+	  num = TryReserveUpTo(num);
+	}
+      }
+      if (num>0) {
+	PushBatch(works.data(), num, keyed);
+      }
+      return num;
+    }
+    void Queue::PushBatch(const Work::Ptr *works, size_t num, bool keyed) {
+      outstanding += num;
+      if (keyed) {
+	// keep the batch contiguous apart from the work held behind its key
+	WorkVec ready;
+	ready.reserve(num);
+	for (size_t i=0;i<num;++i) {
+	  if (!works[i]->HasKey() || !Hold(works[i])) {
+	    ready.push_back(works[i]);
+	  }
+	}
+	pending.Push(ready.data(), ready.size(), Stamp());
+	TryPost(ready.size());
+      } else {
+	pending.Push(works, num, Stamp());
+	TryPost(num);
+      }
+      Shed();
     }
     void Queue::Stop() {
       std::lock_guard<std::mutex> g(lock);
       isStopped = true;
-      posted    = 0;
+      ClearReleased(slots);
     }
     void Queue::StopAfter(const Work::Ptr &last) {
       THROW_IF(!last, "Attempt to add undefined work");
-      std::lock_guard<std::mutex> g(lock);
-      if (last) {
-	AddWork(g, last);
-	AddWork(g, Threading::Work::Create(stoppedStats,
-					   [=](bool &requeue) {
-					     requeue = false;
-					     Ptr ptr = THIS.lock();
-					     if (ptr) {
-					       ptr->Stop();
-					     }
-					   }));
-      }
+      THROW_IF(last->HasKey(), "Attempt to stop queue " << name << " after keyed work");
+      Work::Ptr works[2];
+      works[0] = last;
+      works[1] = Threading::Work::Create(stoppedStats,
+					 [=](bool &requeue) {
+					   requeue = false;
+					   Ptr ptr = THIS.lock();
+					   if (ptr) {
+					     ptr->Stop();
+					   }
+					 });
+      // push both together so no other work can land between them
+      Reserve(2);
+      outstanding += 2;
+      pending.Push(works, 2, Stamp());
+      TryPost(2);
     }
     void Queue::Start() {
       bool notify = false;
@@ -81,10 +279,8 @@ namespace aliSystem {
 	std::lock_guard<std::mutex> g(lock);
 	if (isStopped) {
 	  isStopped = false;
-	  notify = pending.empty() && curConcurrency==0;
-	  for (size_t i=0;i<maxConcurrency && i<pending.size();++i) {
-	    Post(g);
-	  }
+	  notify = outstanding==0;
+	  TryPost(maxConcurrency);
 	}
       }
       if (notify) {
@@ -93,77 +289,347 @@ namespace aliSystem {
     }
     void Queue::Clear() {
       std::lock_guard<std::mutex> g(lock);
-      pending.clear();
-      posted = 0;
+      // retire the keys whose work is dropped, keys with work executing
+      // stay active until it completes.
+      std::lock_guard<std::mutex> k(keyLock);
+      size_t    num = 0;
+      Work::Ptr work;
+      while (pending.Pop(work)) {
+	++num;
+	if (work->HasKey()) {
+	  keys.erase(work->GetKey());
+	}
+      }
+      for (KeyMap::iterator it=keys.begin(); it!=keys.end(); ++it) {
+	it->second.clear();
+      }
+      num       += held;
+      held       = 0;
+      activeKeys = keys.size();
+      outstanding -= num;
+      Vacate(num);
+      ClearReleased(slots);
     }
 
 
 
     std::ostream &operator<<(std::ostream &out, const Queue &o) {
+      uint64_t s = o.slots;
       out << "threadingQueue(name = "   << o.name
-	  << ", isBusy = "              << YES_NO(o.isBusy)
+	  << ", isBusy = "              << YES_NO(o.IsBusy())
 	  << ", isStopped = "           << YES_NO(o.isStopped)
-	  << ", posted = "              << o.posted
-	  << ", number pending = "      << o.pending.size()
-	  << ", current concurrency = " << o.curConcurrency
-	  << ", max concurrency = "     << o.maxConcurrency
-	  << ")";
+	  << ", posted = "              << Released(s)
+	  << ", number pending = "      << o.pending.Size()
+	  << ", current concurrency = " << Executing(s)
+	  << ", max concurrency = "     << o.maxConcurrency;
+      if (o.adaptive) {
+	out << ", adaptive = "          << o.GetLimiter()->GetAlgorithm();
+      }
+      if (o.capacity>0) {
+	out << ", capacity = "          << o.capacity
+	    << ", overflow = "          << o.GetOverflow()
+	    << ", high water mark = "   << o.highWater;
+      }
+      if (o.activeKeys>0) {
+	out << ", active keys = "       << o.activeKeys;
+      }
+      out << ")";
+      return out;
+    }
+    std::ostream &operator<<(std::ostream &out, const Queue::Overflow &o) {
+      switch (o) {
+      case Queue::Overflow::BLOCK:         out << "block";         break;
+      case Queue::Overflow::REJECT:        out << "reject";        break;
+      case Queue::Overflow::DROP_OLDEST:   out << "drop oldest";   break;
+      case Queue::Overflow::RUN_ON_CALLER: out << "run on caller"; break;
+      }
       return out;
     }
 
 
 
-    void Queue::AddWork(std::lock_guard<std::mutex> &g, const Work::Ptr &work) {
-      THROW_IF(!work, "Attempt to add undefined work");
-      isBusy = true;
-      pending.push_back(work);
-      Post(g);
+    bool Queue::Admit(size_t num, bool onCaller) {
+      if (capacity==0) {
+	return true;
+      }
+      if (overflow==Overflow::DROP_OLDEST) {
+	Reserve(num);
+	return true;
+      }
+      if (TryReserve(num)) {
+	return true;
+      }
+      switch (overflow.load()) {
+      case Overflow::REJECT:
+	rejected += num;
+	THROW("Queue " << name << " is full (capacity " << capacity << ")");
+      case Overflow::RUN_ON_CALLER:
+	if (!onCaller) {
+	  break;
+	}
+	ranOnCaller += num;
+	return false;
+      default:
+	break;
+      }
+      THROW_IF(num>capacity,
+	       "Attempt to add a batch of " << num << " to queue " << name
+	       << " with a capacity of " << capacity);
+      ++blocked;
+      std::unique_lock<std::mutex> g(spaceLock);
+      ++numWaiting;
+      spaceCv.wait(g, [&]() { return TryReserve(num); });
+      --numWaiting;
+      return true;
+    }
+    bool Queue::TryReserve(size_t num) {
+      size_t o = occupancy;
+      do {
+	size_t cap = capacity;
+	if (cap>0 && o+num>cap) {
+	  return false;
+	}
+      } while (!occupancy.compare_exchange_weak(o, o+num));
+      size_t h = highWater;
+      while (o+num>h && !highWater.compare_exchange_weak(h, o+num)) {
+      }
+      return true;
+    }
+    size_t Queue::TryReserveUpTo(size_t num) {
+      size_t o = occupancy;
+      size_t n;
+      do {
+	size_t cap = capacity;
+	n = cap==0 ? num : std::min(num, cap>o ? cap-o : 0);
+	if (n==0) {
+	  return 0;
+	}
+      } while (!occupancy.compare_exchange_weak(o, o+n));
+      size_t h = highWater;
+      while (o+n>h && !highWater.compare_exchange_weak(h, o+n)) {
+      }
+      return n;
+    }
+    void Queue::Reserve(size_t num) {
+      if (capacity==0) {
+	return;
+      }
+      size_t o = occupancy.fetch_add(num)+num;
+      size_t h = highWater;
+      while (o>h && !highWater.compare_exchange_weak(h, o)) {
+      }
+    }
+    void Queue::Vacate(size_t num) {
+      if (capacity==0) {
+	return;
+      }
+      // work added while the queue was unbounded holds no room
+      size_t o = occupancy;
+      while (o>0 && !occupancy.compare_exchange_weak(o, o-std::min(o, num))) {
+      }
+      // a producer registers as waiting before checking for room, so
+      // either it sees the room released here or it is seen waiting.
+      if (numWaiting>0) {
+	std::lock_guard<std::mutex> g(spaceLock);
+	spaceCv.notify_all();
+      }
     }
-    void Queue::Post(std::lock_guard<std::mutex> &) {
-      if (!isStopped && posted+curConcurrency < maxConcurrency && pending.size()>posted) {
-	++posted;
-	semPtr->Post();
+    void Queue::Shed() {
+      if (overflow!=Overflow::DROP_OLDEST || capacity==0 || occupancy<=capacity) {
+	return;
+      }
+      std::lock_guard<std::mutex> g(lock);
+      Work::Ptr oldest;
+      while (capacity>0 && occupancy>capacity && pending.Pop(oldest)) {
+	--outstanding;
+	++dropped;
+	Vacate(1);
+	if (oldest->HasKey()) {
+	  Release(oldest->GetKey());
+	}
+	oldest.reset();
+	// the dropped work may already have been released for execution
+	ClampReleased(slots, pending.Size());
+      }
+    }
+    void Queue::RunOnCaller(const Work::Ptr &work) {
+      bool requeue = false;
+      if (true) {
+	StatsGuard statsGuard(queueStats);
+	work->Run(requeue);
+      }
+      if (requeue) {
+	AddWork(work);
       }
     }
+    bool Queue::Hold(const Work::Ptr &work) {
+      std::lock_guard<std::mutex> g(keyLock);
+      std::pair<KeyMap::iterator, bool> r = keys.emplace(work->GetKey(), KeyMap::mapped_type());
+      if (r.second) {
+	++activeKeys;
+	return false;
+      }
+      r.first->second.push_back(work);
+      ++held;
+      return true;
+    }
+    void Queue::Release(uint64_t key) {
+      Work::Ptr next;
+      if (true) {
+	std::lock_guard<std::mutex> g(keyLock);
+	KeyMap::iterator it = keys.find(key);
+	if (it==keys.end()) {
+	  return;
+	}
+	if (it->second.empty()) {
+	  keys.erase(it);
+	  --activeKeys;
+	  return;
+	}
+	next = std::move(it->second.front());
+	it->second.pop_front();
+	--held;
+      }
+      // held work is stamped when its key frees up
+      pending.Push(std::move(next), Stamp());
+      TryPost();
+    }
+    void Queue::ApplyLimit(const Limiter::Ptr &l) {
+      std::lock_guard<std::mutex> g(lock);
+      if (std::atomic_load(&limiter)==l) {
+	maxConcurrency = l->GetLimit();
+	TryPost(maxConcurrency);
+      }
+    }
+    void Queue::Requeue(const Work::Ptr &work) {
+      Reserve(1);
+      ++outstanding;
+      pending.Push(work, Stamp());
+      TryPost();
+    }
+    size_t Queue::TryPost(size_t limit) {
+      size_t   num = 0;
+      uint64_t s   = slots;
+      do {
+	size_t busy    = Released(s)+Executing(s);
+	size_t max     = maxConcurrency;
+	size_t waiting = pending.Size();
+	if (isStopped || busy>=max || waiting<=Released(s)) {
+	  return 0;
+	}
+	num = std::min(limit, std::min(max-busy, waiting-Released(s)));
+      } while (!slots.compare_exchange_weak(s, s+num*RELEASED));
+      if (postFn) {
+	Ptr ptr = THIS.lock();
+	for (size_t i=0;i<num;++i) {
+	  postFn(ptr);
+	}
+      } else {
+	for (size_t i=0;i<num;++i) {
+	  semPtr->Post();
+	}
+      }
+      return num;
+    }
     void Queue::Run(const Work::Ptr &work) {
       bool notify = false;
       if (work) {
-	bool requeue = false;
+	bool               requeue = false;
+	Limiter::Ptr       l       = adaptive ? std::atomic_load(&limiter) : Limiter::Ptr();
+	Time::Dur          elapsed;
 	std::exception_ptr p;
 	try {
-	  StatsGuard statsGuard(queueStats);
+	  Trace::Span span("run", "queue", "queue", name);
+	  // the limiter compares individual run times, which the cheap
+	  // clock only resolves when it reads the TSC.
+	  StatsGuard statsGuard(queueStats,
+				l && !Time::HasTsc() ? StatsGuard::Clock::PRECISE : StatsGuard::Clock::CHEAP,
+				l ? &elapsed : nullptr);
 	  work->Run(requeue);
 	} catch (std::exception &e) {
 	  p = std::current_exception();
 	}
-	if (requeue) { AddWork(work); }
-	std::lock_guard<std::mutex> g2(lock);
-	--curConcurrency;
-	Post(g2);
-	if (curConcurrency==0 && posted==0 && pending.empty() && !isStopped) {
+	if (l && l->Sample(elapsed, Executing(slots))) {
+	  ApplyLimit(l);
+	}
+	if (requeue) {
+	  Requeue(work);
+	} else if (work->HasKey()) {
+	  Release(work->GetKey());
+	}
+	slots -= EXECUTING;
+	TryPost();
+	if (--outstanding==0 && !isStopped) {
 	  notify = true;
-	  isBusy = false;
 	}
 	if (p) {
 	  std::rethrow_exception(p);
 	}
       }
       if (notify) {
-	// outside of lock so a listener can post to the queue
 	onIdle->Notify(THIS);
       }
     }
     Work::Ptr Queue::Next() {
       Work::Ptr next;
-      std::lock_guard<std::mutex> g(lock);
-      if (!isStopped
-	  && posted>0
-	  && curConcurrency<maxConcurrency
-	  && !pending.empty()) {
-	next = pending.front();
-	pending.pop_front();
-	--posted;
-	++curConcurrency;
+      WorkVec   expiredWork;
+      bool      notify = false;
+      if (true) {
+	std::lock_guard<std::mutex> g(lock);
+	uint64_t s = slots;
+	if (!isStopped
+	    && Released(s)>0
+	    && Executing(s)<maxConcurrency) {
+	  Time::TP now;
+	  Time::TP enqueued;
+	  while (pending.Pop(next, enqueued)) {
+	    Vacate(1);
+	    if (!next->HasDeadline()) {
+	      break;
+	    }
+	    if (expiredWork.empty()) {
+	      now = Time::Now();
+	    }
+	    if (!next->IsExpired(now)) {
+	      break;
+	    }
+	    ++expired;
+	    if (--outstanding==0) {
+	      notify = true;
+	    }
+	    if (next->HasKey()) {
+	      Release(next->GetKey());
+	    }
+	    expiredWork.push_back(std::move(next));
+	    next.reset();
+	  }
+	  if (next) {
+	    // only this (locked) consumer lowers the released count, so
+	    // the count is still non-zero.
+	    slots += EXECUTING-RELEASED;
+	    ++dispatched;
+	    if (Trace::IsEnabled()) {
+	      // work added before Start carries no stamp, which Record discards
+	      Trace::Record("queued", "queue", "queue", name, enqueued, Time::Now());
+	    }
+	  }
+	  if (!expiredWork.empty()) {
+	    ClampReleased(slots, pending.Size());
+	  }
+	  // a producer may have seen the pending count drop before the
+	  // released count did and held back, so check again.
+	  TryPost();
+	}
+      }
+      for (WorkVec::iterator it=expiredWork.begin(); it!=expiredWork.end(); ++it) {
+	try {
+	  (*it)->Expire();
+	} catch (std::exception &e) {
+	  WARN("Expiry function for queue " << name << " failed: " << e.what());
+	}
+      }
+      if (notify && !isStopped) {
+	onIdle->Notify(THIS);
       }
       return next;
     }
@@ -171,12 +637,27 @@ namespace aliSystem {
 
     
     Queue::Queue()
-      : isBusy(false),
+      : isFrozen(false),
 	isStopped(false),
-	isFrozen(false),
 	maxConcurrency(0),
-	curConcurrency(0),
-	posted(0) {
+	weight(1),
+	priority(0),
+	adaptive(false),
+	slots(0),
+	outstanding(0),
+	dispatched(0),
+	occupancy(0),
+	capacity(0),
+	overflow(Overflow::BLOCK),
+	highWater(0),
+	numWaiting(0),
+	rejected(0),
+	dropped(0),
+	ranOnCaller(0),
+	blocked(0),
+	expired(0),
+	held(0),
+	activeKeys(0) {
     }
 
 
@@ -5,11 +5,20 @@
 #include <aliSystem_listeners.hpp>
 #include <aliSystem_stats.hpp>
 #include <aliSystem_threadingSemaphore.hpp>
+#include <aliSystem_threading.hpp>
+#include <aliSystem_threadingLimiter.hpp>
 #include <aliSystem_threadingWork.hpp>
-#include <memory>
+#include <aliSystem_threadingWorkList.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <ostream>
+#include <unordered_map>
+#include <vector>
 
 namespace aliSystem {
   namespace Threading {
@@ -32,12 +41,53 @@ namespace aliSystem {
     /// a queue should align to the intended purpose of the queue.
     /// Failing to do this may result in unexpected system behaviors.
     ///
+    /// Adding work does not take the queue's lock.  Pending work is held
+    /// in a lock free Threading::WorkList and the concurrency accounting
+    /// (work released for execution, work executing and work outstanding)
+    /// is kept in atomics, so producers on many threads do not serialize
+    /// with each other or with the queue's consumer.  The lock is only
+    /// used to serialize the consumer side (Next, Clear) and state changes
+    /// such as Stop, Start and SetMaxConcurrency.
+    ///
+    /// By default a queue holds any amount of pending work.  A queue can
+    /// be given a capacity, in which case the Overflow policy decides what
+    /// happens to work added while capacity work units are pending.  Work
+    /// that is executing does not count against the capacity, nor do the
+    /// markers added by StopAfter or work that requeues itself.
+    ///
+    /// Work carrying a key (see Work::SetKey) is serialized per key: work
+    /// with the same key never runs concurrently and runs in the order it
+    /// was added, while different keys share the queue's concurrency like
+    /// unkeyed work does.  At most one work unit per key is in the pending
+    /// list or executing at a time (its key is "active"), later work for
+    /// an active key waits in that key's list and moves to the end of the
+    /// pending list when its predecessor completes.  The pending list is
+    /// therefore the queue's set of ready keys, so adding and dispatching
+    /// keyed work is O(1) however many keys the queue has.  A key's state
+    /// is discarded as soon as it has no work left.
+    ///
+    /// The maximum concurrency is normally fixed by SetMaxConcurrency.  In
+    /// adaptive mode (SetAdaptiveConcurrency) it instead follows a
+    /// Threading::Limiter fed with the run time of each work unit.
+    ///
     struct Queue {
       using Ptr        = std::shared_ptr<Queue>;  ///< shared pointer
       using WPtr       = std::weak_ptr<Queue>;    ///< weak pointer
-      using WorkQueue  = std::list<Work::Ptr>;    ///< list of work
+      using WorkQueue  = WorkList;                ///< list of work
+      using WorkVec    = std::vector<Work::Ptr>;  ///< batch of work
       using QListener  = Listener<const WPtr&>;   ///< listener
       using QListeners = Listeners<const WPtr&>;  ///< listeners
+      using PostFn     = std::function<void(const Ptr &queue)>; ///< dispatch notification
+      using KeyMap     = std::unordered_map<uint64_t, std::list<Work::Ptr> >; ///< waiting work by key
+
+      /// @brief Overflow identifies what a bounded queue does with work
+      ///        added while it is full.
+      enum class Overflow {
+	BLOCK,          ///< the producer waits until there is room
+	REJECT,         ///< AddWork throws an exception
+	DROP_OLDEST,    ///< the oldest pending work is discarded to make room
+	RUN_ON_CALLER   ///< the work runs immediately on the producer's thread
+      };
 
       /// @brief Create a Threading::Queue.
       /// In general, one would not call this function directly.  Instead,
@@ -59,6 +109,9 @@ namespace aliSystem {
       ///        queue's stats need not be dedicaed to a single queue or only
       ///        to queue objects.  Its up to the system designer to choose
       ///        the meaning of stats objects and their associations.
+      /// @param capacity maximum number of pending work units, 0 for no
+      ///        limit (see SetCapacity)
+      /// @param overflow what to do with work added to a full queue
       /// @return a queue object
       /// @note Queues are always created in a 'running' state. If one does not
       ///       want the queue to immediately start running added work, they
@@ -66,7 +119,33 @@ namespace aliSystem {
       static Ptr Create(const std::string    &name,
 			const Semaphore::Ptr &semPtr,
 			size_t                maxConcurrency,
-			const Stats::Ptr     &queueStats);
+			const Stats::Ptr     &queueStats,
+			size_t                capacity = 0,
+			Overflow              overflow = Overflow::BLOCK);
+
+      /// @brief Create a Threading::Queue that reports dispatchable work
+      ///        through a function rather than a semaphore.
+      /// This variant exists for Threading::Pool schedulers that need to
+      /// know which queue has work (for example, the work stealing
+      /// scheduler pushes the queue onto a thread's local deque).
+      /// @param name name of the queue
+      /// @param postFn function called once for each work unit the queue
+      ///        releases for execution.  Each call should eventually be
+      ///        paired with a call to Next().  The function may be called
+      ///        concurrently from any thread that adds or runs work.
+      /// @param maxConcurrency initial concurrency for the returned queue
+      /// @param queueStats stats used to record stats related to the
+      ///        execution of work units passing through the queue.
+      /// @param capacity maximum number of pending work units, 0 for no
+      ///        limit (see SetCapacity)
+      /// @param overflow what to do with work added to a full queue
+      /// @return a queue object
+      static Ptr Create(const std::string &name,
+			const PostFn      &postFn,
+			size_t             maxConcurrency,
+			const Stats::Ptr  &queueStats,
+			size_t             capacity = 0,
+			Overflow           overflow = Overflow::BLOCK);
 
       /// @brief queue destructor
       ~Queue();
@@ -95,6 +174,8 @@ namespace aliSystem {
       /// @note A busy state is defined as the condition where either:
       ///       a) a queue has pending items
       ///       b) a queue has something currently executing through the queue
+      /// @note This is true of a stopped queue too, so a stopped queue with
+      ///       no pending or executing work is not busy.
       /// @note One can trigger on a transition to idle state by adding a listener
       ///       to the 'OnIdle' Listeners object.
       bool IsBusy() const;
@@ -130,9 +211,104 @@ namespace aliSystem {
       size_t GetMaxConcurrency() const;
 
       /// @brief retrieve the number of pending work units
-      /// @return the number of pending work units.
+      /// @return the number of pending work units, including keyed
+      ///         work waiting for its key.
       size_t NumPending() const;
 
+      /// @brief retrieve the number of active keys
+      /// @return the number of keys with work pending or executing
+      size_t NumActiveKeys() const;
+
+      /// @brief scheduling weight for the queue
+      /// @return the queue's weight (at least 1)
+      /// @note The weight is only used by Threading::Pool's weighted fair
+      ///       scheduler, where a ready queue of weight w is served w times
+      ///       as often as a ready queue of weight 1 in the same priority class.
+      size_t GetWeight() const;
+
+      /// @brief Set the queue's scheduling weight.
+      /// @param weight the new weight, must be greater than zero
+      /// @note The new weight applies from the next time the queue
+      ///       releases work.
+      void SetWeight(size_t weight);
+
+      /// @brief scheduling priority class for the queue
+      /// @return the queue's priority class
+      /// @note Like the weight, the priority class is only used by the
+      ///       weighted fair scheduler.  Ready queues in a higher priority
+      ///       class are always served before those in a lower class.
+      size_t GetPriority() const;
+
+      /// @brief Set the queue's scheduling priority class.
+      /// @param priority the new priority class (0 is the lowest)
+      void SetPriority(size_t priority);
+
+      /// @brief retrieve the number of work units handed out by Next
+      /// @return the number of work units dispatched for execution
+      /// @note Comparing this count across the queues of a pool shows the
+      ///       share of the pool's threads each queue received.
+      uint64_t NumDispatched() const;
+
+      /// @brief retrieve the queue's capacity
+      /// @return the maximum number of pending work units, 0 if unbounded
+      size_t GetCapacity() const;
+
+      /// @brief retrieve the queue's overflow policy
+      /// @return what the queue does with work added while it is full
+      Overflow GetOverflow() const;
+
+      /// @brief Bound the number of pending work units.
+      /// @param capacity the maximum number of pending work units, 0
+      ///        removes the limit
+      /// @param overflow what to do with work added while the queue is full
+      /// @note Lowering the capacity below the current number of pending
+      ///       work units does not discard any work, the queue simply
+      ///       stays full until it drains below the new capacity.
+      /// @note Producers blocked on a full queue are woken to re-check
+      ///       against the new capacity.
+      void SetCapacity(size_t capacity, Overflow overflow);
+
+      /// @brief retrieve the queue's occupancy high-water mark
+      /// @return the largest number of pending work units seen since the
+      ///         queue was created or the mark was last reset
+      /// @note Occupancy is only tracked while the queue has a capacity,
+      ///       an unbounded queue reports its current number of pending
+      ///       work units if that is larger than the mark.
+      size_t GetHighWaterMark() const;
+
+      /// @brief reset the occupancy high-water mark to the current occupancy
+      void ResetHighWaterMark();
+
+      /// @brief retrieve the number of blocks the pending work list has
+      ///        obtained from the heap
+      /// @return the number of work list segments allocated, a queue
+      ///         whose backlog stays within a segment or two stops
+      ///         allocating once warm
+      uint64_t NumSegmentsAllocated() const;
+
+      /// @brief retrieve the number of work units rejected (Overflow::REJECT)
+      /// @return the number of work units refused because the queue was full
+      uint64_t NumRejected() const;
+
+      /// @brief retrieve the number of work units dropped (Overflow::DROP_OLDEST)
+      /// @return the number of pending work units discarded to make room
+      uint64_t NumDropped() const;
+
+      /// @brief retrieve the number of work units run by their producer
+      ///        (Overflow::RUN_ON_CALLER)
+      /// @return the number of work units run on the adding thread
+      uint64_t NumRanOnCaller() const;
+
+      /// @brief retrieve the number of times a producer waited for room
+      ///        (Overflow::BLOCK)
+      /// @return the number of calls to AddWork or AddWorkBatch that blocked
+      uint64_t NumBlocked() const;
+
+      /// @brief retrieve the number of work units that expired
+      /// @return the number of work units dropped by Next because their
+      ///         deadline had passed
+      uint64_t NumExpired() const;
+
       /// @brief Freeze maximum concurrency value.
       /// @note Once called, the 'frozen' state of a queue cannot be removed.
       void Freeze();
@@ -149,8 +325,22 @@ namespace aliSystem {
       ///       then the max value will be increased and its possible
       ///       that a number of work units matching the incrase in
       ///       concurrency may begin executing immediately.
+      /// @note Setting the maximum concurrency leaves adaptive mode.
       void SetMaxConcurrency(size_t maxConcurrency);
 
+      /// @brief Let a limiter set the maximum concurrency (adaptive mode).
+      /// The run time of every work unit run through the queue is fed to
+      /// the limiter and the queue's maximum concurrency follows the
+      /// limiter's limit, see Threading::Limiter.
+      /// @param limiter the limiter, null leaves adaptive mode (keeping
+      ///        the current maximum concurrency).
+      /// @note Throws an exception if the queue has been frozen.
+      void SetAdaptiveConcurrency(const Limiter::Ptr &limiter);
+
+      /// @brief retrieve the limiter used in adaptive mode
+      /// @return the limiter, null if the queue is not adaptive
+      Limiter::Ptr GetLimiter() const;
+
       /// @brief add work to a queue
       /// Append work to the queue.  Note that all work is added to the
       /// end of a queue.  Despite this, it is possible to execute work
@@ -159,8 +349,68 @@ namespace aliSystem {
       /// work unit that they refer to depends on some alternative ordering
       /// algorithm.
       /// @param work work to add to the queue
+      /// @note If the queue is full, the queue's Overflow policy applies:
+      ///       the call may block, throw, discard the oldest pending work
+      ///       or run work before returning.  A producer running on the
+      ///       pool serving a blocking queue should take care, it may
+      ///       wait on work that only its own thread would run.
+      /// @note Keyed work is never run on the caller, since that could
+      ///       overtake or overlap other work with the same key.  A
+      ///       run-on-caller queue blocks the producer of keyed work
+      ///       instead.
       void AddWork(const Work::Ptr &work);
 
+      /// @brief add work to a queue, taking over the caller's reference
+      /// @param work work to add to the queue, it is left null
+      /// @note This saves a reference count increment and decrement
+      ///       per work unit over the previous form.
+      void AddWork(Work::Ptr &&work);
+
+      /// @brief create a work unit for a task and add it to the queue
+      /// @param stats stats for the work unit (may be null)
+      /// @param task the function to run
+      /// @see Work::Create
+      void AddTask(const Stats::Ptr &stats, Task &&task);
+
+      /// @brief add a batch of work to a queue
+      /// The work units are appended to the end of the queue as one
+      /// contiguous block, in the order given.  Regardless of the batch's
+      /// size, the pending list is updated once and the queue releases
+      /// (posts) at most as many work units as its concurrency limit
+      /// currently allows, so a large batch does not wake more threads
+      /// than can run its work.
+      /// @param works work to add to the queue
+      /// @note Throws an exception (before anything is queued) if any of
+      ///       the passed work units are undefined.
+      /// @note A bounded queue admits the batch as a whole: a blocking
+      ///       queue waits until the entire batch fits (and throws if the
+      ///       batch is larger than its capacity), a rejecting queue
+      ///       throws unless the entire batch fits and a run-on-caller
+      ///       queue runs the entire batch on the caller.  A drop-oldest
+      ///       queue adds the batch and then drops the oldest pending work
+      ///       down to its capacity.
+      void AddWorkBatch(const WorkVec &works);
+
+      /// @brief add a batch of work to a queue
+      /// @param works pointer to the first of num work units
+      /// @param num number of work units to add
+      /// @see AddWorkBatch(const WorkVec &)
+      void AddWorkBatch(const Work::Ptr *works, size_t num);
+
+      /// @brief add as much of a batch of work to a queue as fits
+      ///        without waiting for room
+      /// Like AddWorkBatch, except that a bounded queue that can not take
+      /// the entire batch now only takes the leading work units it has
+      /// room for, whatever its overflow policy (other than
+      /// Overflow::DROP_OLDEST, which makes room as usual).  The work is
+      /// never run on the caller and the work left over is not counted
+      /// as rejected, it remains the caller's to add later.
+      /// @param works work to add to the queue
+      /// @return the number of leading work units added
+      /// @note Meant for producers that must not stall, such as the
+      ///       Scheduler's thread.
+      size_t TryAddWorkBatch(const WorkVec &works);
+
       /// @brief Stop will trigger the queue to stop returning work from
       /// the Next() function.
       /// Stop will not abort any currently running work, it can only
@@ -172,6 +422,7 @@ namespace aliSystem {
       /// is stopped after an internal work unit that triggers the stopping
       /// of a queue.
       /// @param last a unit of work after which, the queue should be stopped.
+      /// @note last may not carry a key.
       void StopAfter(const Work::Ptr &last);
 
       /// @brief Re-start a queue queue.
@@ -183,6 +434,8 @@ namespace aliSystem {
       void Start();
 
       /// @brief Drop all items from the queue.
+      /// @note Keyed work waiting for its key is dropped too.  Keys with
+      ///       work executing stay active until that work completes.
       void Clear();
 
       /// @brief Write a short summary of the queue object to the given ostream.
@@ -218,6 +471,10 @@ namespace aliSystem {
       /// Next is used to fetch the next item to work on.  If the
       /// queue has no work, is stopped, or has dispatched its
       /// concurrency limit.
+      /// Work whose deadline has passed is skipped: it is dropped,
+      /// counted as expired and its expiry function is called (after
+      /// the queue's lock is released).  Work without a deadline costs
+      /// no clock reads.
       /// @return work - null or a pointer to next work unit
       /// @note This function should only be used by the queue
       ///       owner (generally aliSystem::Threading::Pool).
@@ -225,44 +482,128 @@ namespace aliSystem {
       
     private:
 
-      /// @brief an internal add function.
-      /// This fucntion is used to add work to the queue and is defined
-      /// to ensure consistency regardless of the location from which
-      /// Add is called.
-      /// @param g a lock guard that holds the queue's lock
-      /// @param work the work to add to the queue
-      /// @note The lock guard is not passed to this functcion, and whether
-      ///       the passed guard holds the queue's lock is not verified.
-      ///       The argumennt is meant to serve as a reminder to anyone
-      ///       developing this class to ensure that they should only call
-      ///       this function from a routine that already owns the lock.
-      void AddWork(std::lock_guard<std::mutex> &g, const Work::Ptr &work);
-
-      /// @brief post to the semaphore if the queue has pending work
-      /// that has not already been signaled via the semaphore.
-      /// @param g a lock guard that holds the queue's lock.
-      /// @note See the note about the guard passed to the Add() function.
-      void Post(std::lock_guard<std::mutex> &g);
+      /// @brief apply the capacity and overflow policy to num work units
+      ///        about to be pushed.
+      /// @param num number of work units
+      /// @param onCaller false if the work may not run on the caller, in
+      ///        which case Overflow::RUN_ON_CALLER waits for room.
+      /// @return true if room for the work units was reserved, false if
+      ///         the caller should run them itself (Overflow::RUN_ON_CALLER).
+      /// @note Throws an exception for Overflow::REJECT, waits for room
+      ///       for Overflow::BLOCK.
+      bool Admit(size_t num, bool onCaller);
+
+      /// @brief reserve room for num work units if it is available
+      /// @param num number of work units
+      /// @return false if reserving the room would exceed the capacity
+      bool TryReserve(size_t num);
+
+      /// @brief reserve room for as many of num work units as is available
+      /// @param num number of work units
+      /// @return the number of work units room was reserved for
+      size_t TryReserveUpTo(size_t num);
+
+      /// @brief reserve room for num work units regardless of capacity
+      /// @param num number of work units
+      void Reserve(size_t num);
+
+      /// @brief release the room held by num work units that left the
+      ///        pending list, waking blocked producers.
+      /// @param num number of work units
+      void Vacate(size_t num);
+
+      /// @brief push an admitted batch onto the pending list
+      /// @param works pointer to the first of num work units
+      /// @param num number of work units
+      /// @param keyed true if any of the work units carries a key
+      void PushBatch(const Work::Ptr *works, size_t num, bool keyed);
+
+      /// @brief drop the oldest pending work units while the queue is
+      ///        above capacity (Overflow::DROP_OLDEST).
+      void Shed();
+
+      /// @brief run work on the calling thread (Overflow::RUN_ON_CALLER).
+      /// @param work the work to run
+      void RunOnCaller(const Work::Ptr &work);
+
+      /// @brief hold keyed work behind its key's active work
+      /// @param work keyed work that has been admitted
+      /// @return false if the key was idle, it is now active and the
+      ///         caller pushes the work to the pending list
+      bool Hold(const Work::Ptr &work);
+
+      /// @brief the active work of a key has completed or been dropped,
+      ///        make the key's next work pending or retire the key.
+      /// @param key the key
+      void Release(uint64_t key);
+
+      /// @brief adopt a limit computed by the limiter
+      /// @param l the limiter that computed it, ignored if it is no
+      ///        longer the queue's limiter
+      void ApplyLimit(const Limiter::Ptr &l);
+
+      /// @brief add work to the queue without applying the capacity
+      /// @param work the work to add
+      void Requeue(const Work::Ptr &work);
+
+      /// @brief release pending work units for execution if the queue is
+      /// running, it has pending work that has not already been released,
+      /// and the concurrency limit allows it.
+      /// @param limit maximum number of work units to release
+      /// @return the number of work units released
+      /// @note Does not require the queue's lock.
+      size_t TryPost(size_t limit=1);
 
       /// @brief queue's constructor.
       Queue();
 
-      std::mutex      lock;            ///< lock used for various member values
-      WPtr            THIS;            ///< weak pointer to self
-      std::string     name;            ///< name of the queue
-      Stats::Ptr      queueStats;      ///< stats for work passed through the queue
-      Stats::Ptr      stoppedStats;    ///< stats for stop work passed throug the queue
-      Semaphore::Ptr  semPtr;          ///< semaphore to trigger when work may be executed
-      bool            isBusy;          ///< flag to indicate whether or not the queue is busy
-      bool            isStopped;       ///< flag to indicate that the queue is stopped
-      bool            isFrozen;        ///< flag to indicate that the max concurrency is fixed
-      QListeners::Ptr onIdle;          ///< notifications sent when isBusy->false
-      WorkQueue       pending;         ///< list of pending work
-      size_t          maxConcurrency;  ///< maximum specified concurrency for an instance
-      size_t          curConcurrency;  ///< current concurrency for an instance
-      size_t          posted;          ///< variable to track number of outstandng posts
+      std::mutex            lock;            ///< serializes the consumer and state changes
+      WPtr                  THIS;            ///< weak pointer to self
+      std::string           name;            ///< name of the queue
+      Stats::Ptr            queueStats;      ///< stats for work passed through the queue
+      Stats::Ptr            stoppedStats;    ///< stats for stop work passed throug the queue
+      Semaphore::Ptr        semPtr;          ///< semaphore to trigger when work may be executed
+      PostFn                postFn;          ///< alternative to semPtr, called with the queue
+      QListeners::Ptr       onIdle;          ///< notifications sent when isBusy->false
+      bool                  isFrozen;        ///< flag to indicate that the max concurrency is fixed
+      std::atomic<bool>     isStopped;       ///< flag to indicate that the queue is stopped
+      std::atomic<size_t>   maxConcurrency;  ///< maximum specified concurrency for an instance
+      std::atomic<size_t>   weight;          ///< weighted fair scheduling weight
+      std::atomic<size_t>   priority;        ///< weighted fair scheduling priority class
+      std::atomic<bool>     adaptive;        ///< flag indicating limiter is set
+      Limiter::Ptr          limiter;         ///< adaptive mode limiter (accessed atomically)
+      char                  pad0[CacheLineSize];
+      std::atomic<uint64_t> slots;           ///< released (high 32 bits) and executing (low 32 bits) work units
+      char                  pad1[CacheLineSize];
+      std::atomic<size_t>   outstanding;     ///< pending plus executing work units, non-zero while busy
+      char                  pad2[CacheLineSize];
+      std::atomic<uint64_t> dispatched;      ///< work units returned by Next
+      char                  pad3[CacheLineSize];
+      std::atomic<size_t>   occupancy;       ///< room reserved in, or held by, the pending list
+      std::atomic<size_t>   capacity;        ///< maximum occupancy, 0 if unbounded
+      std::atomic<Overflow> overflow;        ///< policy applied when the queue is full
+      std::atomic<size_t>   highWater;       ///< occupancy high-water mark
+      std::atomic<size_t>   numWaiting;      ///< producers waiting for room
+      std::atomic<uint64_t> rejected;        ///< work units rejected
+      std::atomic<uint64_t> dropped;         ///< work units dropped
+      std::atomic<uint64_t> ranOnCaller;     ///< work units run by their producer
+      std::atomic<uint64_t> blocked;         ///< producer waits for room
+      std::atomic<uint64_t> expired;         ///< work units dropped past their deadline
+      std::atomic<size_t>   held;            ///< keyed work units waiting for their key
+      std::atomic<size_t>   activeKeys;      ///< number of entries in keys
+      std::mutex            spaceLock;       ///< guards waiting for room
+      std::condition_variable spaceCv;       ///< signalled when room is released
+      WorkQueue             pending;         ///< list of pending work
+      std::mutex            keyLock;         ///< guards keys
+      KeyMap                keys;            ///< active keys and the work waiting for them
     };
 
+    /// @brief Overflow serialization operator
+    /// @param out the stream to write to
+    /// @param o the overflow policy to write
+    /// @return the stream passed as the out parameter
+    std::ostream &operator<<(std::ostream &out, const Queue::Overflow &o);
+
   }
 }
 
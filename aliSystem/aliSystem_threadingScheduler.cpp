@@ -4,7 +4,9 @@
 #include <aliSystem_logging.hpp>
 #include <aliSystem_threadingPool.hpp>
 #include <aliSystem_threadingSemaphore.hpp>
-#include <queue>
+#include <aliSystem_threadingTimerWheel.hpp>
+#include <exception>
+#include <utility>
 #include <vector>
 
 namespace aliSystem {
@@ -17,28 +19,27 @@ namespace aliSystem {
 	void Fini();
       };
 
-      struct Item {
-	using Ptr       = std::shared_ptr<Item>;
-	using ItemQueue = std::priority_queue<Ptr,
-					      std::vector<Ptr>,
-					      std::function<bool(Ptr,Ptr)>>;
-	Time::TP   targetTime;
-	Queue::Ptr targetQueue;
-	Work::Ptr  targetWork;
-	static bool Less(const Ptr &a, const Ptr &b);
-      };
-      
+      using Entry     = TimerWheel::Entry;
+      using EntryList = TimerWheel::EntryList;
+
+      // timers are kept to a tenth of a millisecond
+      const Time::Dur TICK = std::chrono::microseconds(100);
+
       struct Monitor {
 	using Ptr = std::shared_ptr<Monitor>;
 	Monitor();
 	static void Run(const Ptr &ptr, bool &requeue);
 	void Run(bool &requeue);
 	void Post() { sem.Post(); }
-	void Schedule(Item::Ptr &item);
+	void Schedule(const Entry::Ptr &entry);
+	bool Cancel(const Entry::Ptr &entry);
+	bool IsPending(const Entry::Ptr &entry);
       private:
-	std::mutex      lock;
-	Item::ItemQueue pending;
-	Semaphore       sem;
+	static void Dispatch(EntryList &expired, EntryList &deferred);
+	std::mutex lock;
+	TimerWheel wheel;
+	Time::TP   wakeTime;  ///< time the monitor is waiting for (max if none)
+	Semaphore  sem;
       };
 
       // ****************************************************************************************
@@ -76,15 +77,11 @@ namespace aliSystem {
 	monitor.reset();
       }	
 
-      // ****************************************************************************************
-      // Item implementation
-      bool Item::Less(const Ptr &a, const Ptr &b) {
-	return b->targetTime < a->targetTime;
-      }
       // ****************************************************************************************
       // MonitorWork implementation
       Monitor::Monitor()
-	: pending(Item::Less) {
+	: wheel(Time::Now(), TICK),
+	  wakeTime(Time::TP::max()) {
       }
       void Monitor::Run(const Ptr &ptr, bool &requeue) {
 	if (ptr) {
@@ -93,52 +90,136 @@ namespace aliSystem {
       }
       void Monitor::Run(bool &requeue) {
 	requeue = true; // ignored when queue is stopped
-	Time::TP tm     = Time::Now();
-	Time::TP target = tm + std::chrono::seconds(30);
+	EntryList expired;
+	EntryList deferred;
+	bool      haveNext;
+	Time::TP  next;
 	if (true) {
 	  std::lock_guard<std::mutex> g(lock);
-	  while (!pending.empty() && pending.top()->targetTime <= tm) {
-	    const Item::Ptr &iPtr = pending.top();
-	    iPtr->targetQueue->AddWork(iPtr->targetWork);
-	    pending.pop();
-	  }
-	  if (!pending.empty()) {
-	    target = pending.top()->targetTime;
+	  wheel.Advance(Time::Now(), expired);
+	}
+	Dispatch(expired, deferred);
+	if (true) {
+	  std::lock_guard<std::mutex> g(lock);
+	  // timers whose queue is full expire again on the next tick
+	  for (EntryList::iterator it=deferred.begin(); it!=deferred.end(); ++it) {
+	    wheel.Insert(*it);
 	  }
+	  haveNext = wheel.NextTime(next);
+	  wakeTime = haveNext ? next : Time::TP::max();
+	}
+	if (haveNext) {
+	  sem.TimedWait(next);
+	} else {
+	  sem.Wait();
 	}
-	sem.TimedWait(target);
       }
-      void Monitor::Schedule(Item::Ptr &item) {
+      void Monitor::Schedule(const Entry::Ptr &entry) {
 	std::lock_guard<std::mutex> g(lock);
-	pending.push(item);
-	if (pending.top()==item) {
+	wheel.Insert(entry);
+	if (entry->targetTime<wakeTime) {
+	  wakeTime = entry->targetTime;
 	  sem.Post();
 	}
       }
+      bool Monitor::Cancel(const Entry::Ptr &entry) {
+	// no need to wake the monitor, it copes with waking up early
+	std::lock_guard<std::mutex> g(lock);
+	return wheel.Remove(entry);
+      }
+      bool Monitor::IsPending(const Entry::Ptr &entry) {
+	std::lock_guard<std::mutex> g(lock);
+	return entry->slot!=nullptr;
+      }
+      void Monitor::Dispatch(EntryList &expired, EntryList &deferred) {
+	// hand each queue everything that expired for it as one batch,
+	// keeping the expiry order within each queue.
+	struct Batch {
+	  Queue::Ptr              queue;
+	  Queue::WorkVec          works;
+	  std::vector<Entry::Ptr> entries;
+	};
+	std::vector<Batch> batches;
+	for (EntryList::iterator it=expired.begin(); it!=expired.end(); ++it) {
+	  const Entry::Ptr &entry = *it;
+	  size_t i = 0;
+	  while (i<batches.size() && batches[i].queue!=entry->targetQueue) {
+	    ++i;
+	  }
+	  if (i==batches.size()) {
+	    batches.push_back(Batch());
+	    batches[i].queue = entry->targetQueue;
+	  }
+	  batches[i].works.push_back(entry->targetWork);
+	  batches[i].entries.push_back(entry);
+	}
+	// this thread serves every timer, it must neither wait for room in
+	// a full queue nor let one queue's failure lose the other batches.
+	// A full queue takes what it has room for, the rest is deferred.
+	for (size_t i=0;i<batches.size();++i) {
+	  const Batch &batch = batches[i];
+	  size_t       added = 0;
+	  try {
+	    added = batch.queue->TryAddWorkBatch(batch.works);
+	  } catch (std::exception &e) {
+	    WARN("Scheduler failed to add " << batch.works.size()
+		 << " expired timers to queue " << batch.queue->Name() << ": " << e.what());
+	    continue;
+	  }
+	  if (added==batch.entries.size()) {
+	    continue;
+	  }
+	  if (batch.queue->IsStopped()) {
+	    // a stopped queue may never drain, do not retry it every tick
+	    WARN("Scheduler dropped " << batch.entries.size()-added
+		 << " expired timers, stopped queue " << batch.queue->Name() << " is full");
+	  } else {
+	    deferred.insert(deferred.end(), batch.entries.begin()+added, batch.entries.end());
+	  }
+	}
+      }
     }
 
    void Scheduler::RegisterInitFini(ComponentRegistry &cr) {
-      cr.Register("aliSystem::Threading::Scheduler", Init, Fini);
+      Component::Ptr ptr = cr.Register("aliSystem::Threading::Scheduler", Init, Fini);
+      // the scheduler's pool measures its work with the tick counter
+      ptr->AddDependency("aliSystem::Time");
+    }
+
+    bool Scheduler::Timer::Cancel() {
+      Entry::Ptr   ePtr = entry.lock();
+      Monitor::Ptr mPtr = monitor;
+      entry.reset();
+      return ePtr && mPtr && mPtr->Cancel(ePtr);
+    }
+
+    bool Scheduler::Timer::IsPending() const {
+      Entry::Ptr   ePtr = entry.lock();
+      Monitor::Ptr mPtr = monitor;
+      return ePtr && mPtr && mPtr->IsPending(ePtr);
     }
 
-    void Scheduler::Schedule(const Queue::Ptr &targetQueue,
-		  const Time::TP   &targetTime,
-		  const Work::Ptr  &targetWork) {
+    Scheduler::Timer Scheduler::Schedule(const Queue::Ptr &targetQueue,
+					 const Time::TP   &targetTime,
+					 const Work::Ptr  &targetWork) {
+      Timer rtn;
       if (targetQueue && targetWork) {
 	Monitor::Ptr mPtr = monitor;
 	if (mPtr) {
-	  Item::Ptr item(new Item);
-	  item->targetTime  = targetTime;
-	  item->targetQueue = targetQueue;
-	  item->targetWork  = targetWork;
-	  mPtr->Schedule(item);
+	  Entry::Ptr entry(new Entry);
+	  entry->targetTime  = targetTime;
+	  entry->targetQueue = targetQueue;
+	  entry->targetWork  = targetWork;
+	  rtn.entry          = entry;
+	  mPtr->Schedule(entry);
 	}
       }
+      return rtn;
     }
 
-    void Scheduler::Schedule(const Time::TP  &targetTime,
-		  const Work::Ptr &targetWork) {
-      Schedule(sharedQueue, targetTime, targetWork);
+    Scheduler::Timer Scheduler::Schedule(const Time::TP  &targetTime,
+					 const Work::Ptr &targetWork) {
+      return Schedule(sharedQueue, targetTime, targetWork);
     }
 
   }
@@ -2,6 +2,7 @@
 #define INCLUDED_ALI_SYSTEM_THREADING_SCHEDULER
 
 #include <aliSystem_threadingQueue.hpp>
+#include <aliSystem_threadingTimerWheel.hpp>
 #include <aliSystem_threadingWork.hpp>
 #include <aliSystem_time.hpp>
 
@@ -15,6 +16,32 @@ namespace aliSystem {
     ///        within a aliSystem::Threading::Pool.
     struct Scheduler {
 
+      /// @brief A handle to scheduled work.
+      ///
+      /// The handle is returned by Schedule and may be used to cancel the
+      /// work before it is injected into its queue.  It only holds a weak
+      /// reference, so keeping a handle around does not keep the work
+      /// alive, and a cancelled timer releases its work right away rather
+      /// than at its target time.  A default constructed handle refers to
+      /// nothing.
+      struct Timer {
+
+	/// @brief Cancel the scheduled work.
+	/// @return true if the work was removed before being injected into
+	///         its queue, false if it was already injected, cancelled or
+	///         the handle refers to nothing.
+	/// @note This is O(1) and may be called from any thread.
+	bool Cancel();
+
+	/// @brief Check whether the work is still waiting for its time.
+	/// @return true if the work has neither been injected nor cancelled
+	bool IsPending() const;
+
+      private:
+	friend struct Scheduler;
+	TimerWheel::Entry::WPtr entry;  ///< the scheduled entry
+      };
+
       /// @brief Initialize hold module
       /// @param cr is a component registry to which any initialzation
       ///        and finalization logic should be registered.
@@ -26,21 +53,30 @@ namespace aliSystem {
       ///
       /// The scheduler runs a background thread that takes care of injecting the targeted work
       /// functions into the targeted queue as soon after the targeted time as possible.  In
-      /// general, this should be quite accurate, however if a large number of items are 
-      /// specified to execute at the same time, they will be injected one after the other.
-      /// Also delays can occur due to actual thread execution scheduling determined by the OS.
+      /// general, this should be quite accurate.  Pending work is held in a
+      /// Threading::TimerWheel with a tick of 100 microseconds, so scheduling is O(1)
+      /// regardless of the number of pending items and work is injected at most one tick
+      /// after its targeted time.  Everything that expires in the same tick for the same
+      /// queue is injected as one batch (see Queue::AddWorkBatch).  Delays can still occur
+      /// due to actual thread execution scheduling determined by the OS.
+      ///
+      /// A bounded queue that is full takes the work it has room for, whatever its
+      /// overflow policy, and the rest stays scheduled and is retried every tick until
+      /// the queue has room (see Queue::TryAddWorkBatch).  Such work can still be
+      /// cancelled while it waits.  Work for a stopped queue that is full is dropped.
       ///
       ///   \param targetQueue - the queue in which the target work will be injected.
       ///   \param targetWork  - the work that will be injected into the targeted queue.
       ///   \param targetTime  - the time at which the work should be injected.
+      ///   \return a handle that can be used to cancel the work before it is injected.  The
+      ///           handle refers to nothing if the work or queue is undefined or the scheduler
+      ///           is not running.
       ///
-      ///  Notes, this library does not currently support work revocation.  In general, one can
-      ///  define their work objects however they like.  To support revocable work at this time,
-      ///  simply design the work object to support revocation by a flag or weak pointer or
-      ///  something of that nature that will allow its Work::Run function to essentially do
-      ///  nothing.
+      ///  Work that is no longer needed (a timeout for something that completed, for example)
+      ///  should be cancelled with Timer::Cancel so that it does not stay in the scheduler
+      ///  until its target time.
       ///
-      static void Schedule(const Queue::Ptr &targetQueue,
+      static Timer Schedule(const Queue::Ptr &targetQueue,
 			   const Time::TP   &targetTime,
 			   const Work::Ptr  &targetWork);
 
@@ -54,7 +90,7 @@ namespace aliSystem {
       /// is somewhat flexible since it could be delayed by other work scheduled on this
       /// generic pool.
       ///
-      static void Schedule(const Time::TP  &targetTime,
+      static Timer Schedule(const Time::TP  &targetTime,
 			   const Work::Ptr &targetWork);
 
     };
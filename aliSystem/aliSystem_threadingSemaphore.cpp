@@ -1,32 +1,136 @@
 #include <aliSystem_threadingSemaphore.hpp>
+#include <aliSystem_threading.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 #include <time.h>
+#include <unistd.h>
+
+namespace {
+
+  using Steady = std::chrono::steady_clock;
+
+  // shortest spin limit the adaptation will shrink to before giving up
+  // on spinning altogether (until a spin succeeds again).
+  const int64_t MIN_SPIN_NS = 100;
+
+  // number of polls between clock reads while spinning
+  const int POLLS_PER_CHECK = 32;
+
+  int Futex(std::atomic<int> *addr, int op, int val, const struct timespec *timeout) {
+    return syscall(SYS_futex, reinterpret_cast<int*>(addr), op, val, timeout, nullptr, 0);
+  }
+
+}
 
 namespace aliSystem {
   namespace Threading {
 
-    Semaphore::Ptr Semaphore::Create(size_t count) {
-      return Ptr(new Semaphore(count));
+    Semaphore::Ptr Semaphore::Create(size_t count, const Time::Dur &spinBudget) {
+      return Ptr(new Semaphore(count, spinBudget));
     }
 
-    Semaphore::Semaphore(size_t count) {
-      sem_init(&sem, 0, count);
+    Semaphore::Semaphore(size_t count_, const Time::Dur &spinBudget_)
+      : count(count_),
+	waiters(0),
+	spinBudget(std::max(spinBudget_, Time::Dur::zero())),
+	spinLimit(std::chrono::duration_cast<std::chrono::nanoseconds>(spinBudget).count()),
+	spinAcquired(0),
+	parked(0) {
     }
     Semaphore::~Semaphore() {
-      sem_destroy(&sem);
     }
     int Semaphore::Post() {
-      return sem_post(&sem);
+      count.fetch_add(1);
+      if (waiters.load()>0) {
+	Futex(&count, FUTEX_WAKE_PRIVATE, 1, nullptr);
+      }
+      return 0;
     }
     int Semaphore::Wait() {
-      return sem_wait(&sem);
+      if (TryAcquire() || Spin(SteadyTP::max())) {
+	return 0;
+      }
+      return Park(nullptr);
+    }
+    bool Semaphore::TryWait() {
+      return TryAcquire();
     }
     int Semaphore::TimedWait(const Time::TP &tm) {
-      static struct timespec   waitTime;
-      static const long long   nano = 1000*1000*1000;
-      std::chrono::nanoseconds dur  = tm.time_since_epoch();
-      waitTime.tv_sec  = dur.count()/nano;
-      waitTime.tv_nsec = dur.count()%nano;
-      return sem_timedwait(&sem, &waitTime);
+      return TimedWait(tm - Time::Now());
+    }
+    int Semaphore::TimedWait(const Time::Dur &timeout) {
+      SteadyTP deadline = Steady::now() + std::chrono::duration_cast<Steady::duration>(timeout);
+      if (TryAcquire() || Spin(deadline)) {
+	return 0;
+      }
+      return Park(&deadline);
+    }
+    Time::Dur Semaphore::GetSpinBudget  () const { return spinBudget;   }
+    size_t    Semaphore::NumSpinAcquired() const { return spinAcquired; }
+    size_t    Semaphore::NumParked      () const { return parked;       }
+    bool Semaphore::TryAcquire() {
+      int cur = count.load(std::memory_order_relaxed);
+      while (cur>0) {
+	if (count.compare_exchange_weak(cur, cur-1, std::memory_order_acquire)) {
+	  return true;
+	}
+      }
+      return false;
+    }
+    bool Semaphore::Spin(const SteadyTP &deadline) {
+      int64_t limit = spinLimit.load(std::memory_order_relaxed);
+      if (limit<MIN_SPIN_NS) {
+	return false;
+      }
+      SteadyTP end = std::min(deadline, Steady::now() + std::chrono::nanoseconds(limit));
+      do {
+	for (int i=0;i<POLLS_PER_CHECK;++i) {
+	  if (count.load(std::memory_order_relaxed)>0 && TryAcquire()) {
+	    // it paid off, allow a longer spin next time
+	    int64_t budget = std::chrono::duration_cast<std::chrono::nanoseconds>(spinBudget).count();
+	    spinLimit.store(std::min(budget, std::max(limit, MIN_SPIN_NS)*2), std::memory_order_relaxed);
+	    ++spinAcquired;
+	    return true;
+	  }
+	  CpuRelax();
+	}
+      } while (Steady::now()<end);
+      spinLimit.store(limit/2, std::memory_order_relaxed);
+      return false;
+    }
+    int Semaphore::Park(const SteadyTP *deadline) {
+      ++parked;
+      ++waiters;
+      int rtn = 0;
+      while (!TryAcquire()) {
+	struct timespec  rel;
+	struct timespec *relPtr = nullptr;
+	if (deadline) {
+	  SteadyTP now = Steady::now();
+	  if (now>=*deadline) {
+	    errno = ETIMEDOUT;
+	    rtn   = -1;
+	    break;
+	  }
+	  std::chrono::nanoseconds left = *deadline - now;
+	  rel.tv_sec  = left.count()/1000000000;
+	  rel.tv_nsec = left.count()%1000000000;
+	  relPtr      = &rel;
+	}
+	// FUTEX_WAIT measures a relative timeout on the monotonic clock
+	Futex(&count, FUTEX_WAIT_PRIVATE, 0, relPtr);
+      }
+      --waiters;
+      if (rtn==0 && spinBudget>Time::Dur::zero() && spinLimit.load(std::memory_order_relaxed)<MIN_SPIN_NS) {
+	// spinning was switched off, give it another chance now and then
+	if (parked%64==0) {
+	  spinLimit.store(MIN_SPIN_NS, std::memory_order_relaxed);
+	}
+      }
+      return rtn;
     }
 
   }
@@ -2,25 +2,42 @@
 #define INCLUDED_ALI_SYSTEM_THREADING_SEMAPHORE
 
 #include <aliSystem_time.hpp>
+#include <atomic>
 #include <memory>
-#include <mutex>
-#include <semaphore.h>
 
 namespace aliSystem {
   namespace Threading {
 
     /// @brief semaphore class
+    ///
+    /// The semaphore parks waiting threads on a futex.  Handing a count
+    /// from Post to a parked thread costs a system call on each side and
+    /// a context switch, which dominates when the work being handed off
+    /// only takes microseconds.  A semaphore constructed with a spin
+    /// budget first polls the count for up to that long before parking.
+    /// The time actually spent spinning adapts: it is doubled (up to the
+    /// budget) when spinning acquires the count and halved when the
+    /// waiter has to park anyway, so an idle semaphore soon stops burning
+    /// CPU.  The default budget of zero never spins.
     struct Semaphore {
       using Ptr = std::shared_ptr<Semaphore>;  ///< shared poiter
 
       /// @brief construct a semaphore pointer
       /// @param count specifies the initial count for the semaphore
+      /// @param spinBudget the longest a waiter spins before parking
       /// @return the constructed semaphore pointer.
-      static Ptr Create(size_t count=0);
+      static Ptr Create(size_t count=0, const Time::Dur &spinBudget=Time::Dur::zero());
 
       /// @brief constructor
       /// @param count specifies the initial count for the semaphore
-      explicit Semaphore(size_t count=0);
+      /// @param spinBudget the longest a waiter spins before parking
+      explicit Semaphore(size_t count=0, const Time::Dur &spinBudget=Time::Dur::zero());
+
+      /// @brief Copy constructor is deleted
+      Semaphore(const Semaphore &) = delete;
+
+      /// @brief Assignment operator is deleted
+      Semaphore &operator=(const Semaphore &) = delete;
 
       /// @brief destructor
       ~Semaphore();
@@ -33,16 +50,67 @@ namespace aliSystem {
       /// @return 0 on success, non-zero indicates an error
       int Wait();
 
+      /// @brief take a count without waiting
+      /// @return true if a count was taken
+      bool TryWait();
+
       /// @brief Timedwait will wait until the count exceeds 0 or the time
       /// reaches the passed value.
       /// @param tp is the absolute time to wait until
-      /// @return 0 on success, non-zero indicates an error
-      /// @note The passed time is an absolute utc time.
+      /// @return 0 on success, non-zero indicates an error (errno is
+      ///         ETIMEDOUT if the time was reached)
+      /// @note The passed time is an absolute utc time.  It is converted
+      ///       to a delay once, on entry, and the wait itself is measured
+      ///       on the monotonic clock, so changes to the system time do
+      ///       not shorten or extend it.
+      /// @note This may be called concurrently from any number of threads.
       int TimedWait(const Time::TP &tp);
+
+      /// @brief Timedwait will wait until the count exceeds 0 or the
+      /// given time has elapsed.
+      /// @param timeout how long to wait, measured on the monotonic clock
+      /// @return 0 on success, non-zero indicates an error (errno is
+      ///         ETIMEDOUT if the time elapsed)
+      int TimedWait(const Time::Dur &timeout);
+
+      /// @brief retrieve the spin budget
+      /// @return the longest a waiter spins before parking
+      Time::Dur GetSpinBudget() const;
+
+      /// @brief retrieve the number of waits satisfied while spinning
+      /// @return number of waits that did not park
+      size_t NumSpinAcquired() const;
+
+      /// @brief retrieve the number of waits that parked
+      /// @return number of waits that parked on the futex
+      size_t NumParked() const;
       
     private:
-      
-      sem_t  sem; ///< raw os semaphore
+
+      using SteadyTP = std::chrono::steady_clock::time_point;  ///< monotonic time point
+
+      /// @brief take a count if one is available
+      /// @return true if a count was taken
+      bool TryAcquire();
+
+      /// @brief spin for a count, for no longer than the adaptive spin
+      ///        limit or the deadline
+      /// @param deadline monotonic time at which to give up
+      /// @return true if a count was taken
+      bool Spin(const SteadyTP &deadline);
+
+      /// @brief park until a count is taken or the deadline passes
+      /// @param deadline monotonic time at which to give up, or nullptr
+      ///        to wait indefinitely
+      /// @return 0 if a count was taken, -1 with errno set to ETIMEDOUT
+      int Park(const SteadyTP *deadline);
+
+      std::atomic<int>                        count;   ///< available count (futex word)
+      std::atomic<int>                        waiters; ///< threads parked or about to park
+      Time::Dur                               spinBudget; ///< upper bound of spinLimit
+      std::atomic<int64_t>                    spinLimit;  ///< current spin limit in nanoseconds
+      std::atomic<size_t>                     spinAcquired; ///< waits satisfied while spinning
+      std::atomic<size_t>                     parked;       ///< waits that parked
     };
 
   }
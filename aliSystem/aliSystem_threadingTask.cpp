@@ -0,0 +1,51 @@
+#include <aliSystem_threadingTask.hpp>
+#include <aliSystem_logging.hpp>
+
+namespace aliSystem {
+  namespace Threading {
+
+    Task::Task() noexcept
+      : ops(nullptr) {}
+    Task::Task(std::nullptr_t) noexcept
+      : ops(nullptr) {}
+    Task::Task(Task &&o) noexcept
+      : ops(o.ops) {
+      if (ops) {
+	ops->move(storage, o.storage);
+	o.ops = nullptr;
+      }
+    }
+    Task &Task::operator=(Task &&o) noexcept {
+      if (this!=&o) {
+	Reset();
+	if (o.ops) {
+	  o.ops->move(storage, o.storage);
+	  ops   = o.ops;
+	  o.ops = nullptr;
+	}
+      }
+      return *this;
+    }
+    Task::~Task() {
+      Reset();
+    }
+    Task::operator bool() const {
+      return ops!=nullptr;
+    }
+    bool Task::IsInline() const {
+      return ops && ops->isInline;
+    }
+    void Task::operator()(bool &requeue) const {
+      THROW_IF(!ops, "Attempt to run an empty task");
+      ops->invoke(storage, requeue);
+    }
+    void Task::Reset() {
+      if (ops) {
+	const Ops *o = ops;
+	ops = nullptr;
+	o->destroy(storage);
+      }
+    }
+
+  }
+}
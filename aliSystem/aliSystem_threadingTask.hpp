@@ -0,0 +1,172 @@
+#ifndef INCLUDED_ALI_SYSTEM_THREADING_TASK
+#define INCLUDED_ALI_SYSTEM_THREADING_TASK
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace aliSystem {
+  namespace Threading {
+
+    ///
+    /// @brief A move-only callable with the Work function signature.
+    ///
+    /// Task is what a Threading::Work object runs.  It plays the role
+    /// std::function plays for Work::WorkFn, with two differences that
+    /// matter on the submit path:
+    ///
+    ///  - a callable of up to INLINE_SIZE bytes (that can be moved
+    ///    without throwing) is stored inside the Task itself, so
+    ///    wrapping a lambda with a few captures does not allocate.
+    ///    Larger callables are moved to the heap.
+    ///
+    ///  - a Task can not be copied, so the callable's captures are moved
+    ///    rather than copied (with the reference count traffic that
+    ///    copying shared pointers implies) on the way into a Work object.
+    ///
+    /// A default constructed Task, or one built from a null function
+    /// pointer or an empty std::function, is empty.
+    ///
+    struct Task {
+      static const size_t INLINE_SIZE = 80; ///< bytes of inline storage for callables
+
+      /// @brief construct an empty task
+      Task() noexcept;
+
+      /// @brief construct an empty task
+      Task(std::nullptr_t) noexcept;
+
+      /// @brief construct a task from a callable
+      /// @param fn a callable with the signature void(bool &requeue)
+      template<typename Fn,
+	       typename = typename std::enable_if<!std::is_same<typename std::decay<Fn>::type,
+								Task>::value>::type>
+      Task(Fn &&fn);
+
+      /// @brief move constructor, o is left empty
+      Task(Task &&o) noexcept;
+
+      /// @brief move assignment, o is left empty
+      Task &operator=(Task &&o) noexcept;
+
+      /// @brief Copy constructor is deleted
+      Task(const Task &) = delete;
+
+      /// @brief Assignment operator is deleted
+      Task &operator=(const Task &) = delete;
+
+      /// @brief destructor
+      ~Task();
+
+      /// @brief test if the task holds a callable
+      /// @return true if the task is not empty
+      explicit operator bool() const;
+
+      /// @brief test where the callable is stored
+      /// @return true if the callable is held in the task's inline
+      ///         storage, false if it is on the heap or the task is empty
+      bool IsInline() const;
+
+      /// @brief run the callable
+      /// @param requeue passed to the callable
+      /// @note Calling an empty task throws an exception.
+      void operator()(bool &requeue) const;
+
+      /// @brief release the callable, leaving the task empty
+      void Reset();
+
+    private:
+
+      /// @brief type specific operations on the stored callable
+      struct Ops {
+	void (*invoke) (void *fn, bool &requeue); ///< call the callable
+	void (*move)   (void *to, void *from);    ///< move construct to from from, destroying from
+	void (*destroy)(void *fn);                ///< destroy the callable
+	bool   isInline;                          ///< callable is held in storage
+      };
+
+      /// @brief operations for a callable held in storage
+      template<typename F>
+      struct InlineOps {
+	static void Invoke (void *fn, bool &requeue) { (*static_cast<F*>(fn))(requeue); }
+	static void Move   (void *to, void *from) {
+	  new (to) F(std::move(*static_cast<F*>(from)));
+	  static_cast<F*>(from)->~F();
+	}
+	static void Destroy(void *fn)             { static_cast<F*>(fn)->~F(); }
+	static const Ops ops;
+      };
+
+      /// @brief operations for a callable on the heap, storage holds its address
+      template<typename F>
+      struct HeapOps {
+	static void Invoke (void *fn, bool &requeue) { (**static_cast<F**>(fn))(requeue); }
+	static void Move   (void *to, void *from)    { *static_cast<F**>(to) = *static_cast<F**>(from); }
+	static void Destroy(void *fn)                { delete *static_cast<F**>(fn); }
+	static const Ops ops;
+      };
+
+      /// @brief test for the null forms of a callable
+      template<typename F>
+      static bool IsNull(const F &) { return false; }
+      template<typename S>
+      static bool IsNull(const std::function<S> &fn) { return !fn; }
+      template<typename R, typename... A>
+      static bool IsNull(R (*fn)(A...)) { return !fn; }
+
+      /// @brief test if a callable can be held in storage
+      template<typename F>
+      struct Fits;
+
+      /// @brief store a callable inline
+      template<typename Fn>
+      void Store(Fn &&fn, std::true_type);
+
+      /// @brief store a callable on the heap
+      template<typename Fn>
+      void Store(Fn &&fn, std::false_type);
+
+      const Ops *ops;                                          ///< null when empty
+      alignas(std::max_align_t) mutable char storage[INLINE_SIZE]; ///< callable or its address
+    };
+
+    template<typename F>
+    const Task::Ops Task::InlineOps<F>::ops = { Invoke, Move, Destroy, true };
+
+    template<typename F>
+    const Task::Ops Task::HeapOps<F>::ops   = { Invoke, Move, Destroy, false };
+
+    template<typename F>
+    struct Task::Fits
+      : std::integral_constant<bool,
+			       sizeof(F)<=INLINE_SIZE
+			       && alignof(F)<=alignof(std::max_align_t)
+			       && std::is_nothrow_move_constructible<F>::value> {};
+
+    template<typename Fn, typename>
+    Task::Task(Fn &&fn)
+      : ops(nullptr) {
+      if (!IsNull(fn)) {
+	using F = typename std::decay<Fn>::type;
+	Store(std::forward<Fn>(fn), Fits<F>());
+      }
+    }
+    template<typename Fn>
+    void Task::Store(Fn &&fn, std::true_type) {
+      using F = typename std::decay<Fn>::type;
+      new (storage) F(std::forward<Fn>(fn));
+      ops = &InlineOps<F>::ops;
+    }
+    template<typename Fn>
+    void Task::Store(Fn &&fn, std::false_type) {
+      using F = typename std::decay<Fn>::type;
+      *reinterpret_cast<F**>(storage) = new F(std::forward<Fn>(fn));
+      ops = &HeapOps<F>::ops;
+    }
+
+  }
+}
+
+#endif
@@ -0,0 +1,138 @@
+#include <aliSystem_threadingTimerWheel.hpp>
+#include <aliSystem_logging.hpp>
+#include <algorithm>
+
+namespace {
+
+  using TimerWheel = aliSystem::Threading::TimerWheel;
+
+  const uint64_t MASK = TimerWheel::SLOTS-1;
+  const uint64_t SPAN = uint64_t(1) << (TimerWheel::BITS*TimerWheel::LEVELS);
+
+  uint64_t LevelSpan(size_t level) {
+    return uint64_t(1) << (TimerWheel::BITS*level);
+  }
+
+}
+
+namespace aliSystem {
+  namespace Threading {
+
+    TimerWheel::TimerWheel(const Time::TP &epoch_, const Time::Dur &tickDuration_)
+      : epoch(epoch_),
+	tickDuration(tickDuration_),
+	curTick(0),
+	size(0) {
+      THROW_IF(tickDuration<=Time::Dur::zero(), "Timer wheel tick duration must be positive");
+      for (size_t level=0;level<LEVELS;++level) {
+	counts[level] = 0;
+      }
+    }
+    void TimerWheel::Insert(const Entry::Ptr &entry) {
+      THROW_IF(!entry, "Attempt to insert an undefined timer");
+      Time::Dur since = entry->targetTime - epoch;
+      uint64_t  tick  = 0;
+      if (since>Time::Dur::zero()) {
+	// round up so the entry never expires before its target time
+	tick = (since.count()+tickDuration.count()-1)/tickDuration.count();
+      }
+      THROW_IF(entry->slot, "Attempt to insert a timer that is already in a wheel");
+      entry->tick = std::max(tick, curTick+1);
+      Place(entry);
+      ++size;
+    }
+    bool TimerWheel::Remove(const Entry::Ptr &entry) {
+      if (!entry || !entry->slot) {
+	return false;
+      }
+      --counts[entry->level];
+      --size;
+      EntryList *slot = entry->slot;
+      entry->slot = nullptr;
+      slot->erase(entry->pos);
+      return true;
+    }
+    void TimerWheel::Advance(const Time::TP &now, EntryList &expired) {
+      Time::Dur since = now - epoch;
+      uint64_t  to    = since>Time::Dur::zero() ? since.count()/tickDuration.count() : 0;
+      while (curTick<to) {
+	if (size==0) {
+	  curTick = to;
+	  break;
+	}
+	// skip straight to the next tick where a non-empty level cascades
+	size_t lowest = 0;
+	while (counts[lowest]==0) {
+	  ++lowest;
+	}
+	if (lowest>0) {
+	  uint64_t boundary = (curTick | (LevelSpan(lowest)-1))+1;
+	  if (boundary>to) {
+	    curTick = to;
+	    break;
+	  }
+	  curTick = boundary-1;
+	}
+	++curTick;
+	for (size_t level=1; level<LEVELS && (curTick & (LevelSpan(level)-1))==0; ++level) {
+	  Cascade(level);
+	}
+	EntryList &slot = slots[0][curTick & MASK];
+	for (EntryList::iterator it=slot.begin(); it!=slot.end(); ++it) {
+	  (*it)->slot = nullptr;
+	}
+	counts[0] -= slot.size();
+	size      -= slot.size();
+	expired.splice(expired.end(), slot);
+      }
+    }
+    bool TimerWheel::NextTime(Time::TP &tp) const {
+      if (size==0) {
+	return false;
+      }
+      uint64_t next = UINT64_MAX;
+      for (size_t level=0;level<LEVELS;++level) {
+	if (counts[level]>0) {
+	  uint64_t block = curTick >> (BITS*level);
+	  for (uint64_t i=1;i<=SLOTS;++i) {
+	    if (!slots[level][(block+i) & MASK].empty()) {
+	      next = std::min(next, (block+i) << (BITS*level));
+	      break;
+	    }
+	  }
+	}
+      }
+      tp = epoch + next*tickDuration;
+      return true;
+    }
+    size_t   TimerWheel::Size       () const { return size;    }
+    uint64_t TimerWheel::CurrentTick() const { return curTick; }
+    void TimerWheel::Place(const Entry::Ptr &entry) {
+      uint64_t delta = entry->tick-curTick;
+      uint64_t place = entry->tick;
+      size_t   level = 0;
+      while (level+1<LEVELS && delta>=LevelSpan(level+1)) {
+	++level;
+      }
+      if (delta>=SPAN) {
+	// beyond the wheel, park it in the furthest slot and re-place it
+	// when that slot cascades.
+	place = curTick+SPAN-1;
+      }
+      EntryList &slot = slots[level][(place >> (BITS*level)) & MASK];
+      entry->level = level;
+      entry->slot  = &slot;
+      entry->pos   = slot.insert(slot.end(), entry);
+      ++counts[level];
+    }
+    void TimerWheel::Cascade(size_t level) {
+      EntryList moving;
+      moving.swap(slots[level][(curTick >> (BITS*level)) & MASK]);
+      counts[level] -= moving.size();
+      for (EntryList::iterator it=moving.begin(); it!=moving.end(); ++it) {
+	Place(*it);
+      }
+    }
+
+  }
+}
@@ -0,0 +1,130 @@
+#ifndef INCLUDED_ALI_SYSTEM_THREADING_TIMER_WHEEL
+#define INCLUDED_ALI_SYSTEM_THREADING_TIMER_WHEEL
+
+#include <aliSystem_threadingQueue.hpp>
+#include <aliSystem_threadingWork.hpp>
+#include <aliSystem_time.hpp>
+#include <cstdint>
+#include <list>
+#include <memory>
+
+namespace aliSystem {
+  namespace Threading {
+
+    ///
+    /// @brief A hierarchical timing wheel of scheduled work.
+    ///
+    /// TimerWheel backs the Threading::Scheduler.  Time is divided into
+    /// ticks of a fixed duration counted from an epoch.  The wheel has
+    /// LEVELS levels of SLOTS slots each: a timer that expires within
+    /// SLOTS ticks is kept in a level 0 slot, one that expires within
+    /// SLOTS^2 ticks in a level 1 slot and so on.  Inserting a timer only
+    /// computes its level and slot, so it is O(1) no matter how many
+    /// timers are pending.  Each time the wheel's level 0 slots wrap
+    /// around, the next slot of the level above is redistributed
+    /// (cascaded) to the levels below, so every timer is moved at most
+    /// LEVELS-1 times before it expires.  Timers that are further out than
+    /// the wheel's span wait in the last slot of the top level and are
+    /// re-placed each time it cascades.
+    ///
+    /// Each entry remembers where it is held, so a timer can be removed
+    /// before it expires in O(1) as well.
+    ///
+    /// All timers expiring in the same tick are released together and in
+    /// the order they were inserted.
+    ///
+    /// A timer expires in the first tick that starts at or after its
+    /// target time, so it is never released early and at most one tick
+    /// late (in addition to however late the caller advances the wheel).
+    ///
+    /// TimerWheel does no locking of its own, the caller is expected to
+    /// serialize access.
+    ///
+    struct TimerWheel {
+      static const size_t BITS   = 8;             ///< bits of the tick consumed by each level
+      static const size_t SLOTS  = 1 << BITS;     ///< slots per level
+      static const size_t LEVELS = 4;             ///< number of levels
+
+      /// @brief A scheduled unit of work.
+      struct Entry {
+	using Ptr  = std::shared_ptr<Entry>;  ///< shared pointer
+	using WPtr = std::weak_ptr<Entry>;    ///< weak pointer
+	using List = std::list<Ptr>;          ///< list of entries
+	Time::TP       targetTime;        ///< time at which the work should be released
+	Queue::Ptr     targetQueue;       ///< queue to release the work to
+	Work::Ptr      targetWork;        ///< work to release
+	uint64_t       tick  = 0;         ///< tick in which the entry expires (set by Insert)
+	size_t         level = 0;         ///< level holding the entry (maintained by the wheel)
+	List          *slot  = nullptr;   ///< slot holding the entry, null once out of the wheel
+	List::iterator pos;               ///< position within slot (maintained by the wheel)
+      };
+      using EntryList = Entry::List;            ///< list of entries
+
+      /// @brief constructor
+      /// @param epoch the start of tick 0
+      /// @param tickDuration the length of a tick
+      TimerWheel(const Time::TP &epoch, const Time::Dur &tickDuration);
+
+      /// @brief Copy constructor is deleted
+      TimerWheel(const TimerWheel &) = delete;
+
+      /// @brief Assignment operator is deleted
+      TimerWheel &operator=(const TimerWheel &) = delete;
+
+      /// @brief Add an entry to the wheel.
+      /// @param entry the entry to add, its tick is assigned from its
+      ///        target time.
+      /// @note An entry whose target time has already passed expires
+      ///       in the next tick.
+      void Insert(const Entry::Ptr &entry);
+
+      /// @brief Take an entry out of the wheel before it expires.
+      /// @param entry the entry to remove
+      /// @return false if the entry was not in the wheel (it has already
+      ///         expired or been removed)
+      /// @note This is O(1), the entry tracks its own slot and position.
+      bool Remove(const Entry::Ptr &entry);
+
+      /// @brief Move the wheel forward to the given time.
+      /// @param now the current time
+      /// @param expired [out] entries that expired are appended to this
+      ///        list, in expiry order.
+      void Advance(const Time::TP &now, EntryList &expired);
+
+      /// @brief Compute the next time the wheel has something to do.
+      /// @param tp [out] the time at which Advance should next be called.
+      ///        This may be a tick where entries are only cascaded rather
+      ///        than expired.
+      /// @return false if the wheel is empty (tp is not set)
+      bool NextTime(Time::TP &tp) const;
+
+      /// @brief retrieve the number of entries in the wheel
+      /// @return the number of entries
+      size_t Size() const;
+
+      /// @brief retrieve the tick the wheel has advanced to.
+      /// @return the current tick
+      uint64_t CurrentTick() const;
+
+    private:
+
+      /// @brief place an entry in the slot matching its tick
+      /// @param entry the entry to place
+      void Place(const Entry::Ptr &entry);
+
+      /// @brief redistribute the current slot of a level
+      /// @param level the level to cascade
+      void Cascade(size_t level);
+
+      Time::TP  epoch;                  ///< start of tick 0
+      Time::Dur tickDuration;           ///< length of a tick
+      uint64_t  curTick;                ///< last tick processed
+      size_t    size;                   ///< number of entries
+      size_t    counts[LEVELS];         ///< number of entries in each level
+      EntryList slots[LEVELS][SLOTS];   ///< the wheel
+    };
+
+  }
+}
+
+#endif
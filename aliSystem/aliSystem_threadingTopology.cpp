@@ -0,0 +1,119 @@
+#include <aliSystem_threadingTopology.hpp>
+#include <aliSystem_logging.hpp>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+
+namespace {
+
+  using CpuVec = aliSystem::Threading::Topology::CpuVec;
+
+  struct Layout {
+    Layout();
+    std::vector<CpuVec> nodes;    ///< CPUs of each node
+    std::map<int,int>   cpuNode;  ///< node of each CPU
+  };
+
+  Layout::Layout() {
+    for (int node=0;;++node) {
+      std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+      std::string   str;
+      if (!in || !std::getline(in, str)) {
+	break;
+      }
+      CpuVec cpus;
+      aliSystem::Threading::Topology::ParseCpuList(str, cpus);
+      nodes.push_back(cpus);
+    }
+    if (nodes.empty()) {
+      CpuVec cpus;
+      unsigned num = std::thread::hardware_concurrency();
+      for (unsigned cpu=0;cpu<std::max(num, 1u);++cpu) {
+	cpus.push_back(cpu);
+      }
+      nodes.push_back(cpus);
+    }
+    for (size_t node=0;node<nodes.size();++node) {
+      for (size_t i=0;i<nodes[node].size();++i) {
+	cpuNode[nodes[node][i]] = node;
+      }
+    }
+  }
+
+  // read a decimal number at pos, advancing pos past it
+  bool ReadNumber(const std::string &str, size_t &pos, int &val) {
+    size_t start = pos;
+    val = 0;
+    while (pos<str.size() && str[pos]>='0' && str[pos]<='9') {
+      val = val*10 + (str[pos]-'0');
+      ++pos;
+    }
+    return pos>start;
+  }
+
+  const Layout &GetLayout() {
+    static const Layout layout;
+    return layout;
+  }
+
+}
+
+namespace aliSystem {
+  namespace Threading {
+
+    size_t Topology::NumNodes() {
+      return GetLayout().nodes.size();
+    }
+    const Topology::CpuVec &Topology::NodeCpus(int node) {
+      const Layout &layout = GetLayout();
+      THROW_IF(node<0 || size_t(node)>=layout.nodes.size(),
+	       "NUMA node " << node << " out of range, there are " << layout.nodes.size());
+      return layout.nodes[node];
+    }
+    int Topology::NodeOfCpu(int cpu) {
+      const Layout &layout = GetLayout();
+      std::map<int,int>::const_iterator it = layout.cpuNode.find(cpu);
+      return it==layout.cpuNode.end() ? -1 : it->second;
+    }
+    int Topology::CurrentCpu() {
+      return sched_getcpu();
+    }
+    bool Topology::Pin(const CpuVec &cpus) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for (CpuVec::const_iterator it=cpus.begin(); it!=cpus.end(); ++it) {
+	if (*it>=0 && *it<CPU_SETSIZE) {
+	  CPU_SET(*it, &set);
+	}
+      }
+      return CPU_COUNT(&set)>0 && pthread_setaffinity_np(pthread_self(), sizeof(set), &set)==0;
+    }
+    void Topology::ParseCpuList(const std::string &str, CpuVec &cpus) {
+      size_t pos = 0;
+      size_t end = str.find_last_not_of(" \n");
+      end = end==std::string::npos ? 0 : end+1;
+      while (pos<end) {
+	int first;
+	int last;
+	THROW_IF(!ReadNumber(str, pos, first), "Malformed CPU list '" << str << "'");
+	last = first;
+	if (pos<end && str[pos]=='-') {
+	  ++pos;
+	  THROW_IF(!ReadNumber(str, pos, last) || last<first, "Malformed CPU list '" << str << "'");
+	}
+	THROW_IF(pos<end && str[pos]!=',', "Malformed CPU list '" << str << "'");
+	for (int cpu=first;cpu<=last;++cpu) {
+	  cpus.push_back(cpu);
+	}
+	if (pos<end) {
+	  ++pos;
+	  THROW_IF(pos==end, "Malformed CPU list '" << str << "'");
+	}
+      }
+    }
+
+  }
+}
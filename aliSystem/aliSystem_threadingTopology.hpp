@@ -0,0 +1,56 @@
+#ifndef INCLUDED_ALI_SYSTEM_THREADING_TOPOLOGY
+#define INCLUDED_ALI_SYSTEM_THREADING_TOPOLOGY
+
+#include <string>
+#include <vector>
+
+namespace aliSystem {
+  namespace Threading {
+
+    ///
+    /// @brief Topology describes the CPUs and NUMA nodes of the machine.
+    ///
+    /// The layout is read once from /sys/devices/system/node.  When that
+    /// is not available (a kernel without NUMA support, for example) the
+    /// machine is treated as a single node 0 holding every online CPU.
+    /// Threading::Pool uses it to place its threads (see
+    /// PoolOptions::Affinity).
+    ///
+    struct Topology {
+      using CpuVec = std::vector<int>;  ///< list of CPU numbers
+
+      /// @brief retrieve the number of NUMA nodes
+      /// @return number of nodes, at least 1
+      static size_t NumNodes();
+
+      /// @brief retrieve the CPUs of a NUMA node
+      /// @param node the node, between 0 and NumNodes()-1
+      /// @return the node's CPUs in ascending order
+      /// @note This throws an exception if node is out of range.
+      static const CpuVec &NodeCpus(int node);
+
+      /// @brief retrieve the NUMA node of a CPU
+      /// @param cpu the CPU number
+      /// @return the CPU's node, or -1 if the CPU is unknown
+      static int NodeOfCpu(int cpu);
+
+      /// @brief retrieve the CPU the calling thread is running on
+      /// @return CPU number, or -1 if it cannot be determined
+      static int CurrentCpu();
+
+      /// @brief Restrict the calling thread to a set of CPUs.
+      /// @param cpus the CPUs the thread may run on
+      /// @return false if the set is empty or the OS rejected it
+      static bool Pin(const CpuVec &cpus);
+
+      /// @brief Parse a CPU list as used by the kernel (e.g. "0-3,8,10-11").
+      /// @param str the list to parse
+      /// @param cpus [out] the CPUs named in the list, in the order listed
+      /// @note This throws an exception if the list is malformed.
+      static void ParseCpuList(const std::string &str, CpuVec &cpus);
+    };
+
+  }
+}
+
+#endif
@@ -1,39 +1,136 @@
 #include <aliSystem_threadingWork.hpp>
 #include <aliSystem_logging.hpp>
 #include <aliSystem_statsGuard.hpp>
+#include <aliSystem_threadingFreeList.hpp>
+#include <aliSystem_threadingSemaphore.hpp>
+#include <aliSystem_trace.hpp>
+#include <atomic>
+#include <exception>
+
+namespace {
+
+  using FreeList = aliSystem::Threading::FreeList;
+
+  /// free list backing work and its control block, set on first use
+  std::atomic<const FreeList*> storage(nullptr);
+
+  /// free list allocator that records the list std::allocate_shared
+  /// rebinds it to
+  template<typename T>
+  struct Allocator : FreeList::Allocator<T> {
+    template<typename U>
+    struct rebind {
+      using other = Allocator<U>;
+    };
+    Allocator() noexcept {}
+    template<typename U>
+    Allocator(const Allocator<U> &) noexcept {}
+    T *allocate(size_t n) {
+      static bool once = (storage = &FreeList::Allocator<T>::List(), true);
+      (void)once;
+      return FreeList::Allocator<T>::allocate(n);
+    }
+  };
+
+  const std::string NO_STATS;
+
+}
 
 namespace aliSystem {
   namespace Threading {
 
     Work::Ptr Work::Create(const aliSystem::Stats::Ptr &stats,
-			   const WorkFn                &workFn) {
-      THROW_IF(!workFn, "Attempt to create undefined work");
-      Ptr rtn(new Work);
-      rtn->workFn = workFn;
-      rtn->stats  = stats;
+			   Task                       &&task) {
+      THROW_IF(!task, "Attempt to create undefined work");
+      Ptr rtn = std::allocate_shared<Work>(Allocator<Work>(), Key());
+      rtn->task  = std::move(task);
+      rtn->stats = stats;
+      return rtn;
+    }
+    Work::Ptr Work::Create(const aliSystem::Stats::Ptr &stats,
+			   Task                       &&task,
+			   const Time::TP              &deadline,
+			   const ExpireFn              &onExpire) {
+      Ptr rtn = Create(stats, std::move(task));
+      rtn->deadline = deadline;
+      rtn->onExpire = onExpire;
       return rtn;
     }
+    uint64_t Work::NumAllocated() {
+      const FreeList *list = storage;
+      return list ? list->NumAllocated() : 0;
+    }
+    void Work::RunAndWait(const aliSystem::Stats::Ptr        &stats,
+			  const std::function<void(Ptr &&)> &add,
+			  const std::function<void()>       &fn) {
+      Semaphore          done;
+      std::exception_ptr error;
+      add(Create(stats, [&](bool &) {
+	    try {
+	      fn();
+	    } catch (...) {
+	      error = std::current_exception();
+	    }
+	    done.Post();
+	  }));
+      done.Wait();
+      if (error) {
+	std::rethrow_exception(error);
+      }
+    }
     Work::~Work() {}
+    bool Work::HasDeadline() const {
+      return deadline!=Time::TP::max();
+    }
+    const Time::TP &Work::GetDeadline() const {
+      return deadline;
+    }
+    bool Work::IsExpired(const Time::TP &now) const {
+      return deadline<now;
+    }
+    bool Work::HasKey() const {
+      return hasKey;
+    }
+    uint64_t Work::GetKey() const {
+      return key;
+    }
+    void Work::SetKey(uint64_t key_) {
+      key    = key_;
+      hasKey = true;
+    }
+    void Work::Expire() const {
+      if (onExpire) {
+	onExpire();
+      }
+    }
     const aliSystem::Stats::Ptr &Work::GetStats() const {
       return stats;
     }
     void Work::Run(bool &requeue) const {
       requeue = false;
-      if (workFn) {
-	StatsGuard g(stats);
-	workFn(requeue);
+      if (task) {
+	Trace::Span span("Work::Run", "work", "stats", stats ? stats->Name() : NO_STATS);
+	StatsGuard  g(stats, StatsGuard::Clock::CHEAP);
+	task(requeue);
       }
     }
     std::ostream &operator<<(std::ostream &out, const Work &o) {
       aliSystem::Stats::Ptr stats = o.stats;
       if (stats) {
-	out << "threadingWork(stats = " << stats->Name() << ")";
+	out << "threadingWork(stats = " << stats->Name();
       } else {
-	out << "threadingWork()";
+	out << "threadingWork(";
+      }
+      if (o.hasKey) {
+	out << (stats ? ", " : "") << "key = " << o.key;
       }
+      out << ")";
       return out;
     }
-    Work::Work() {}
+    Work::Work(Key)
+      : deadline(Time::TP::max()),
+	key(0),
+	hasKey(false) {}
 
   }
 }
@@ -2,6 +2,9 @@
 #define INCLUDED_ALI_SYSTEM_THREADING_WORK
 
 #include <aliSystem_stats.hpp>
+#include <aliSystem_threadingTask.hpp>
+#include <aliSystem_time.hpp>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <ostream>
@@ -38,17 +41,75 @@ namespace aliSystem {
     /// work elements, it might also make sense to manage statistics by these composite
     /// jobs.  Outside of the Work class, a Threading::Queue and Threading::Pool classes
     /// also provides hooks for collecting runtime statistics.
+    ///
+    /// The work function is held in a Threading::Task, so a function whose
+    /// captures fit the task's inline storage is not copied to the heap,
+    /// and work objects (together with their shared pointer control blocks)
+    /// are allocated from a Threading::FreeList.  Once the free list is warm,
+    /// creating, queueing and running such work does not allocate.
+    ///
+    /// Work may carry a deadline.  A Threading::Queue does not run work
+    /// whose deadline has passed by the time it would be handed out,
+    /// instead it drops the work and calls its expiry function.
+    ///
+    /// Work may also carry a key.  Within a Threading::Queue, work with
+    /// the same key never runs concurrently and runs in the order it was
+    /// added, while work with different keys (or no key) shares the
+    /// queue's concurrency.
     struct Work {
-      using Ptr    = std::shared_ptr<Work>;              ///< shared pointer
-      using WorkFn = std::function<void(bool &requeue)>; ///< work function signature
+      using Ptr      = std::shared_ptr<Work>;              ///< shared pointer
+      using WorkFn   = std::function<void(bool &requeue)>; ///< work function signature
+      using ExpireFn = std::function<void()>;             ///< expiry function signature
+
+      /// @brief Create a work object
+      /// @param stats the stats object to use to track execution time.
+      ///        This value may be null if one does not wish to accumulate
+      ///        statistics.
+      /// @param task is the function to run when the item is to be processed.
+      static Ptr Create(const aliSystem::Stats::Ptr &stats,
+			Task                       &&task);
 
       /// @brief Create a work object
       /// @param stats the stats object to use to track execution time.
       ///        This value may be null if one does not wish to accumulate
       ///        statistics.
       /// @param workFn is the function to run when the item is to be processed.
+      ///        Any callable with the WorkFn signature is accepted, it is
+      ///        moved (or copied) directly into the work's Task.
+      template<typename Fn>
       static Ptr Create(const aliSystem::Stats::Ptr &stats,
-			const WorkFn                &workFn);
+			Fn                         &&workFn) {
+	return Create(stats, Task(std::forward<Fn>(workFn)));
+      }
+
+      /// @brief Create a work object with a deadline
+      /// @param stats the stats object to use to track execution time.
+      ///        This value may be null if one does not wish to accumulate
+      ///        statistics.
+      /// @param task is the function to run when the item is to be processed.
+      /// @param deadline the latest time at which the work may start
+      /// @param onExpire called instead of task if the work is dropped
+      ///        because its deadline passed, may be null.
+      static Ptr Create(const aliSystem::Stats::Ptr &stats,
+			Task                       &&task,
+			const Time::TP              &deadline,
+			const ExpireFn              &onExpire);
+
+      /// @brief Hand a function to another thread and wait for it to run.
+      /// @param stats the stats object to use to track execution time,
+      ///        may be null.
+      /// @param add hands the work to the queue or worker that runs it.
+      /// @param fn the function to run.
+      /// @note Anything fn throws is rethrown on the calling thread.  The
+      ///       caller must not be the only thread able to run the work.
+      static void RunAndWait(const aliSystem::Stats::Ptr        &stats,
+			     const std::function<void(Ptr &&)> &add,
+			     const std::function<void()>       &fn);
+
+      /// @brief retrieve the number of work blocks obtained from the system
+      /// @return the number of blocks the work free list has allocated,
+      ///         each holds a work object and its control block
+      static uint64_t NumAllocated();
 
       /// @brief Work destructor.
       ~Work();
@@ -70,6 +131,38 @@ namespace aliSystem {
       ///       needs to requeue itself independently of other instances.
       void Run(bool &requeue) const;
 
+      /// @brief test whether the work carries a deadline
+      /// @return true if the work was created with a deadline
+      bool HasDeadline() const;
+
+      /// @brief retrieve the work's deadline
+      /// @return the deadline, Time::TP::max() if the work has none
+      const Time::TP &GetDeadline() const;
+
+      /// @brief test whether the work's deadline has passed
+      /// @param now the current time
+      /// @return true if the work has a deadline and it is before now
+      bool IsExpired(const Time::TP &now) const;
+
+      /// @brief test whether the work carries a key
+      /// @return true if SetKey has been called
+      bool HasKey() const;
+
+      /// @brief retrieve the work's key
+      /// @return the key, 0 if the work has none
+      uint64_t GetKey() const;
+
+      /// @brief Assign the key used to serialize the work within a queue.
+      /// @param key the key, work sharing a key is run one at a time in
+      ///        the order it is added to a queue.
+      /// @note The key must be set before the work is added to a queue.
+      void SetKey(uint64_t key);
+
+      /// @brief call the work's expiry function, if it has one.
+      /// @note This is called by Threading::Queue when it drops the
+      ///       work rather than running it.
+      void Expire() const;
+
       /// @brief stream output function for the work object.
       /// @param out the stream to which teh object should be serialized
       /// @param o the object to serialize
@@ -77,12 +170,23 @@ namespace aliSystem {
       friend std::ostream &operator<<(std::ostream &out, const Work &o);
       
     private:
-      
+      /// @brief tag restricting construction to Create
+      struct Key {};
+
+    public:
       /// @brief work constructor.
-      Work();
-      
-      WorkFn            workFn; ///< instance's work fucntion
-      Stats::Ptr        stats;  ///< instance's stats object (may be null)
+      /// @note Public only so std::allocate_shared can reach it, the
+      ///       Key type can only be named by Work.
+      explicit Work(Key);
+
+    private:
+
+      Task              task;     ///< instance's work fucntion
+      Stats::Ptr        stats;    ///< instance's stats object (may be null)
+      Time::TP          deadline; ///< latest start time, max if none
+      ExpireFn          onExpire; ///< called when dropped past the deadline
+      uint64_t          key;      ///< serialization key
+      bool              hasKey;   ///< flag indicating the key is set
     };
 
   }
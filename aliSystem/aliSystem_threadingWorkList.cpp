@@ -0,0 +1,170 @@
+#include <aliSystem_threadingWorkList.hpp>
+#include <thread>
+
+namespace aliSystem {
+  namespace Threading {
+
+    struct WorkList::Segment {
+      static const size_t SIZE = 64; ///< number of slots per segment
+      struct Slot {
+	std::atomic<bool> ready;     ///< set once work has been stored
+	Work::Ptr         work;      ///< stored work
+	Time::TP          enqueued;  ///< time the work was pushed, if recorded
+      };
+      explicit Segment(size_t base_) {
+	Reset(base_);
+      }
+      void Reset(size_t base_) {
+	base = base_;
+	next = nullptr;
+	for (size_t i=0;i<SIZE;++i) {
+	  slots[i].ready = false;
+	}
+      }
+      std::atomic<Segment*> next;        ///< following segment
+      size_t                base;        ///< list index of slots[0]
+      Slot                  slots[SIZE]; ///< work slots
+    };
+
+    WorkList::WorkList()
+      : tailIdx(0),
+	inPush(0),
+	size(0),
+	spare(nullptr),
+	numAllocated(1),
+	headIdx(0) {
+      headSeg = new Segment(0);
+      tailSeg = headSeg;
+    }
+    WorkList::~WorkList() {
+      while (headSeg) {
+	Segment *next = headSeg->next;
+	delete headSeg;
+	headSeg = next;
+      }
+      for (std::vector<Segment*>::iterator it=retired.begin(); it!=retired.end(); ++it) {
+	delete *it;
+      }
+      delete spare.load();
+    }
+    void WorkList::Push(const Work::Ptr &work, const Time::TP &enqueued) {
+      Push(&work, 1, enqueued);
+    }
+    void WorkList::Push(Work::Ptr &&work, const Time::TP &enqueued) {
+      ++inPush;
+      Segment *seg = tailSeg;
+      size_t   idx = tailIdx.fetch_add(1);
+      seg = Walk(seg, idx);
+      Segment::Slot &slot = seg->slots[idx-seg->base];
+      slot.work     = std::move(work);
+      slot.enqueued = enqueued;
+      slot.ready    = true;
+      ++size;
+      --inPush;
+    }
+    void WorkList::Push(const Work::Ptr *works, size_t num, const Time::TP &enqueued) {
+      if (num==0) {
+	return;
+      }
+      ++inPush;
+      // load the segment before reserving slots so the segment can not
+      // begin after the reserved index.
+      Segment *seg = tailSeg;
+      size_t   idx = tailIdx.fetch_add(num);
+      for (size_t i=0;i<num;++i,++idx) {
+	seg = Walk(seg, idx);
+	Segment::Slot &slot = seg->slots[idx-seg->base];
+	slot.work     = works[i];
+	slot.enqueued = enqueued;
+	slot.ready    = true;
+      }
+      size += num;
+      --inPush;
+    }
+    bool WorkList::Pop(Work::Ptr &work) {
+      Time::TP enqueued;
+      return Pop(work, enqueued);
+    }
+    bool WorkList::Pop(Work::Ptr &work, Time::TP &enqueued) {
+      if (size==0) {
+	return false;
+      }
+      if (headIdx==headSeg->base+Segment::SIZE) {
+	Segment *next = headSeg->next;
+	while (!next) {
+	  std::this_thread::yield();
+	  next = headSeg->next;
+	}
+	Retire(headSeg, next);
+	headSeg = next;
+      }
+      Segment::Slot &slot = headSeg->slots[headIdx-headSeg->base];
+      while (!slot.ready) {
+	std::this_thread::yield();
+      }
+      work     = std::move(slot.work);
+      enqueued = slot.enqueued;
+      slot.work.reset();
+      ++headIdx;
+      --size;
+      return true;
+    }
+    size_t WorkList::Clear() {
+      size_t    rtn = 0;
+      Work::Ptr work;
+      while (Pop(work)) {
+	++rtn;
+      }
+      return rtn;
+    }
+    size_t WorkList::Size() const {
+      return size;
+    }
+    uint64_t WorkList::NumAllocated() const {
+      return numAllocated;
+    }
+    WorkList::Segment *WorkList::Walk(Segment *seg, size_t idx) {
+      while (idx >= seg->base+Segment::SIZE) {
+	Segment *next = seg->next;
+	if (!next) {
+	  Segment *added = NewSegment(seg->base+Segment::SIZE);
+	  if (seg->next.compare_exchange_strong(next, added)) {
+	    next = added;
+	  } else {
+	    SpareSegment(added);
+	  }
+	}
+	Segment *expected = seg;
+	tailSeg.compare_exchange_strong(expected, next);
+	seg = next;
+      }
+      return seg;
+    }
+    WorkList::Segment *WorkList::NewSegment(size_t base) {
+      Segment *rtn = spare.exchange(nullptr);
+      if (rtn) {
+	rtn->Reset(base);
+      } else {
+	rtn = new Segment(base);
+	++numAllocated;
+      }
+      return rtn;
+    }
+    void WorkList::SpareSegment(Segment *seg) {
+      delete spare.exchange(seg);
+    }
+    void WorkList::Retire(Segment *seg, Segment *next) {
+      // producers arriving after this point start at or after next
+      Segment *expected = seg;
+      tailSeg.compare_exchange_strong(expected, next);
+      retired.push_back(seg);
+      if (inPush==0) {
+	for (std::vector<Segment*>::iterator it=retired.begin(); it!=retired.end(); ++it) {
+	  SpareSegment(*it);
+	}
+	retired.clear();
+      }
+    }
+
+  }
+}
@@ -0,0 +1,138 @@
+#ifndef INCLUDED_ALI_SYSTEM_THREADING_WORK_LIST
+#define INCLUDED_ALI_SYSTEM_THREADING_WORK_LIST
+
+#include <aliSystem_threading.hpp>
+#include <aliSystem_threadingWork.hpp>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace aliSystem {
+  namespace Threading {
+
+    ///
+    /// @brief A lock free, multiple producer, single consumer list of work.
+    ///
+    /// WorkList backs the pending work of a Threading::Queue.  Any number
+    /// of threads may call Push concurrently without taking a lock.  Only
+    /// one thread at a time may call Pop or Clear; Threading::Queue ensures
+    /// this by calling them while holding its own lock.
+    ///
+    /// Work is stored in fixed size segments that are chained together, so
+    /// a heap allocation is only required when a segment fills.  Consumed
+    /// segments are recycled, so a list whose length stays within a segment
+    /// or two does not allocate at all once it is warm.  A consumed segment
+    /// is only recycled (or released) at a moment when no producer is inside
+    /// Push, since a producer might still be walking from it.  Under
+    /// continuous producer pressure consumed segments are therefore held a
+    /// little longer than strictly necessary.
+    ///
+    /// Items pushed by a single producer are popped in the order they were
+    /// pushed.  Items pushed together through one call to Push are adjacent
+    /// in the list.
+    ///
+    struct WorkList {
+
+      /// @brief constructor
+      WorkList();
+
+      /// @brief destructor
+      ~WorkList();
+
+      /// @brief Copy constructor is deleted
+      WorkList(const WorkList &) = delete;
+
+      /// @brief Assignment operator is deleted
+      WorkList &operator=(const WorkList &) = delete;
+
+      /// @brief Append a work unit.
+      /// @param work the work to append
+      /// @param enqueued the time the work was added, kept with it in the
+      ///        list and returned by Pop
+      /// @note May be called from any thread.
+      void Push(const Work::Ptr &work, const Time::TP &enqueued=Time::TP());
+
+      /// @brief Append a work unit, taking over the caller's reference.
+      /// @param work the work to append, it is left null
+      /// @param enqueued the time the work was added
+      /// @note May be called from any thread.
+      void Push(Work::Ptr &&work, const Time::TP &enqueued=Time::TP());
+
+      /// @brief Append a number of work units such that they are
+      ///        adjacent within the list.
+      /// @param works pointer to the first of num work units
+      /// @param num number of work units to append
+      /// @param enqueued the time the work was added
+      /// @note May be called from any thread.
+      void Push(const Work::Ptr *works, size_t num, const Time::TP &enqueued=Time::TP());
+
+      /// @brief Remove the work unit at the front of the list.
+      /// @param work [out] the removed work unit
+      /// @return false if the list was empty.
+      /// @note Only one thread may call Pop (or Clear) at a time.
+      /// @note If a producer has reserved the front position but not
+      ///       yet stored its work, Pop yields until it has.
+      bool Pop(Work::Ptr &work);
+
+      /// @brief Remove the work unit at the front of the list.
+      /// @param work [out] the removed work unit
+      /// @param enqueued [out] the time passed to Push with the work
+      /// @return false if the list was empty.
+      /// @see Pop(Work::Ptr &)
+      bool Pop(Work::Ptr &work, Time::TP &enqueued);
+
+      /// @brief Remove every work unit in the list.
+      /// @return the number of work units removed
+      /// @note Only one thread may call Clear (or Pop) at a time.
+      size_t Clear();
+
+      /// @brief retrieve the number of work units in the list.
+      /// @return the number of work units
+      /// @note Work is counted once a call to Push completes.
+      size_t Size() const;
+
+      /// @brief retrieve the number of segments obtained from the heap
+      /// @return the number of segments allocated since construction
+      uint64_t NumAllocated() const;
+
+    private:
+      struct Segment;  ///< fixed size block of work
+
+      /// @brief find the segment holding a reserved index, adding
+      ///        segments to the list as needed.
+      /// @param seg a segment at or before idx
+      /// @param idx the reserved index
+      /// @return the segment holding idx
+      Segment *Walk(Segment *seg, size_t idx);
+
+      /// @brief obtain a segment, recycling a spare segment if one is available
+      /// @param base index of the first slot in the segment
+      Segment *NewSegment(size_t base);
+
+      /// @brief offer a segment for reuse, releasing any segment it displaces
+      void SpareSegment(Segment *seg);
+
+      /// @brief retire the consumed head segment and recycle retired segments
+      ///        if no producer is inside Push.
+      void Retire(Segment *seg, Segment *next);
+
+      // producer side
+      std::atomic<size_t>    tailIdx;            ///< index of the next free slot
+      std::atomic<Segment*>  tailSeg;            ///< segment at or before tailIdx
+      std::atomic<size_t>    inPush;             ///< number of producers inside Push
+      char                   pad0[CacheLineSize];
+      // shared
+      std::atomic<size_t>    size;               ///< number of completed pushes not yet popped
+      std::atomic<Segment*>  spare;              ///< recycled segment for the next producer that needs one
+      std::atomic<uint64_t>  numAllocated;       ///< segments obtained from the heap
+      char                   pad1[CacheLineSize];
+      // consumer side
+      Segment               *headSeg;            ///< segment holding headIdx
+      size_t                 headIdx;            ///< index of the next slot to pop
+      std::vector<Segment*>  retired;            ///< consumed segments awaiting recycling
+    };
+
+  }
+}
+
+#endif
@@ -0,0 +1,193 @@
+#include <aliSystem_threadingWorker.hpp>
+#include <aliSystem_logging.hpp>
+#include <aliSystem_statsGuard.hpp>
+#include <aliSystem_threadingTopology.hpp>
+#include <aliSystem_trace.hpp>
+#include <exception>
+#include <utility>
+
+namespace aliSystem {
+  namespace Threading {
+
+    Worker::Ptr Worker::Create(const std::string &name,
+			       Idle               idle,
+			       const Stats::Ptr  &stats,
+			       int                cpu,
+			       const Time::Dur   &spinBudget) {
+      Ptr rtn(new Worker);
+      rtn->THIS     = rtn;
+      rtn->name     = name;
+      rtn->stats    = stats;
+      rtn->cpu      = cpu;
+      rtn->idle     = idle;
+      rtn->onIdle   = WListeners::Create(name+"-onIdle");
+      rtn->wakeup   = Semaphore::Create(0, spinBudget);
+      rtn->thread   = std::thread(Main, rtn);
+      return rtn;
+    }
+    Worker::~Worker() {
+      if (thread.joinable()) {
+	// only reached if the thread exited without Stop being called
+	thread.detach();
+      }
+    }
+    const std::string          &Worker::Name      () const { return name;        }
+    Worker::Idle                Worker::GetIdle   () const { return idle;        }
+    int                         Worker::GetCpu    () const { return cpu;         }
+    bool                        Worker::IsBusy    () const { return outstanding>0; }
+    bool                        Worker::IsStopped () const { return stopped;     }
+    size_t                      Worker::NumPending() const { return pending.Size(); }
+    uint64_t                    Worker::NumRun    () const { return numRun;      }
+    uint64_t                    Worker::NumExpired() const { return numExpired;  }
+    uint64_t                    Worker::NumParked () const { return numParked;   }
+    const Worker::WListeners::Ptr &Worker::OnIdle () const { return onIdle;      }
+    void Worker::SetIdle(Idle idle_) {
+      idle = idle_;
+      // a parked thread re-checks the policy once woken
+      Wake();
+    }
+    bool Worker::IsWorkerThread() const {
+      return std::this_thread::get_id()==threadId;
+    }
+    void Worker::AddWork(const Work::Ptr &work) {
+      AddWork(Work::Ptr(work));
+    }
+    void Worker::AddWork(Work::Ptr &&work) {
+      THROW_IF(!work, "Attempt to add undefined work");
+      if (stopped) {
+	return;
+      }
+      ++outstanding;
+      pending.Push(std::move(work));
+      Wake();
+    }
+    void Worker::AddWorkBatch(const Work::Ptr *works, size_t num) {
+      for (size_t i=0;i<num;++i) {
+	THROW_IF(!works[i], "Attempt to add undefined work");
+      }
+      if (num==0 || stopped) {
+	return;
+      }
+      outstanding += num;
+      pending.Push(works, num);
+      Wake();
+    }
+    void Worker::Stop() {
+      if (stopped.exchange(true)) {
+	return;
+      }
+      wakeup->Post();
+      if (IsWorkerThread()) {
+	thread.detach();
+      } else {
+	thread.join();
+      }
+    }
+    std::ostream &operator<<(std::ostream &out, const Worker &o) {
+      out << "threadingWorker(name = "  << o.name
+	  << ", idle = "                << o.GetIdle()
+	  << ", cpu = "                 << o.cpu
+	  << ", isBusy = "              << YES_NO(o.IsBusy())
+	  << ", isStopped = "           << YES_NO(o.stopped)
+	  << ", number pending = "      << o.pending.Size()
+	  << ", number run = "          << o.numRun
+	  << ")";
+      return out;
+    }
+    std::ostream &operator<<(std::ostream &out, const Worker::Idle &o) {
+      switch (o) {
+      case Worker::Idle::SPIN:  out << "spin";  break;
+      case Worker::Idle::YIELD: out << "yield"; break;
+      case Worker::Idle::PARK:  out << "park";  break;
+      }
+      return out;
+    }
+
+
+
+    void Worker::Main(Ptr self) {
+      // set before any work runs, work may ask IsWorkerThread
+      self->threadId = std::this_thread::get_id();
+      Trace::SetThreadName(self->name);
+      if (self->cpu>=0 && !Topology::Pin(Topology::CpuVec(1, self->cpu))) {
+	WARN("Worker " << self->name << " could not pin its thread to cpu " << self->cpu);
+      }
+      Work::Ptr work;
+      while (!self->stopped) {
+	if (self->pending.Pop(work)) {
+	  self->Run(work);
+	  work.reset();
+	} else {
+	  self->WaitForWork();
+	}
+      }
+      self->pending.Clear();
+    }
+    void Worker::Run(const Work::Ptr &work) {
+      if (work->HasDeadline() && work->IsExpired(Time::Now())) {
+	++numExpired;
+	try {
+	  work->Expire();
+	} catch (std::exception &e) {
+	  WARN("Expiry function for worker " << name << " failed: " << e.what());
+	}
+      } else {
+	bool requeue = false;
+	try {
+	  Trace::Span span("run", "worker", "worker", name);
+	  StatsGuard  statsGuard(stats, StatsGuard::Clock::CHEAP);
+	  work->Run(requeue);
+	} catch (std::exception &e) {
+	  WARN("Work on worker " << name << " failed: " << e.what());
+	}
+	++numRun;
+	if (requeue) {
+	  ++outstanding;
+	  pending.Push(work);
+	}
+      }
+      if (--outstanding==0) {
+	onIdle->Notify(THIS);
+      }
+    }
+    void Worker::WaitForWork() {
+      switch (idle.load()) {
+      case Idle::SPIN:
+	CpuRelax();
+	break;
+      case Idle::YIELD:
+	std::this_thread::yield();
+	break;
+      case Idle::PARK:
+	// announce the sleep before the final check, so a producer either
+	// sees the thread sleeping or the thread sees its work.
+	sleeping = true;
+	if (pending.Size()>0 || stopped || idle!=Idle::PARK) {
+	  sleeping = false;
+	  break;
+	}
+	++numParked;
+	wakeup->Wait();
+	sleeping = false;
+	break;
+      }
+    }
+    void Worker::Wake() {
+      if (sleeping && sleeping.exchange(false)) {
+	wakeup->Post();
+      }
+    }
+    Worker::Worker()
+      : cpu(-1),
+	idle(Idle::PARK),
+	stopped(false),
+	threadId(std::thread::id()),
+	numRun(0),
+	numExpired(0),
+	numParked(0),
+	outstanding(0),
+	sleeping(false) {
+    }
+
+  }
+}
@@ -0,0 +1,201 @@
+#ifndef INCLUDED_ALI_SYSTEM_THREADING_WORKER
+#define INCLUDED_ALI_SYSTEM_THREADING_WORKER
+
+#include <aliSystem_listener.hpp>
+#include <aliSystem_listeners.hpp>
+#include <aliSystem_stats.hpp>
+#include <aliSystem_threading.hpp>
+#include <aliSystem_threadingSemaphore.hpp>
+#include <aliSystem_threadingWork.hpp>
+#include <aliSystem_threadingWorkList.hpp>
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+
+namespace aliSystem {
+  namespace Threading {
+
+    ///
+    /// @brief A dedicated thread running the work added to it in order.
+    ///
+    /// A Worker is the single thread alternative to a Threading::Queue
+    /// with a maximum concurrency of 1 on a shared Threading::Pool.  All
+    /// of its work runs on the one thread, so state used only by that work
+    /// (for example a Lua interpreter) needs no lock and stays in that
+    /// thread's (and, when pinned, that core's) cache.
+    ///
+    /// Work is handed to the thread through a lock free WorkList: adding
+    /// work never takes a lock and, while the thread is awake, never makes
+    /// a system call.  What the thread does when it runs out of work is
+    /// set by its Idle policy, trading CPU for the latency of picking up
+    /// the next work unit.
+    ///
+    /// Work with a deadline that has passed by the time the thread reaches
+    /// it is dropped and its expiry function is called, as in a
+    /// Threading::Queue.  Work keys are ignored, a worker runs everything
+    /// in order anyway.
+    ///
+    /// The thread keeps the worker alive until Stop is called.
+    ///
+    struct Worker {
+      using Ptr        = std::shared_ptr<Worker>;  ///< shared pointer
+      using WPtr       = std::weak_ptr<Worker>;    ///< weak pointer
+      using WListener  = Listener<const WPtr&>;    ///< listener
+      using WListeners = Listeners<const WPtr&>;   ///< listeners
+
+      /// @brief Idle identifies what the worker's thread does while it
+      ///        has no work.
+      enum class Idle {
+	SPIN,    ///< poll continuously, the lowest latency and a full core
+	YIELD,   ///< poll, yielding the processor between polls
+	PARK     ///< sleep until work is added (see Semaphore)
+      };
+
+      /// @brief Create a worker and start its thread.
+      /// @param name name of the worker
+      /// @param idle what the thread does while it has no work
+      /// @param stats stats recording each work unit's run time (may be null)
+      /// @param cpu the CPU to pin the thread to, -1 leaves it unpinned
+      /// @param spinBudget for Idle::PARK, how long the thread spins
+      ///        before it sleeps (see Semaphore)
+      /// @return the worker
+      static Ptr Create(const std::string &name,
+			Idle               idle,
+			const Stats::Ptr  &stats,
+			int                cpu        = -1,
+			const Time::Dur   &spinBudget = Time::Dur::zero());
+
+      /// @brief destructor
+      ~Worker();
+
+      /// @brief Copy constructor is deleted
+      Worker(const Worker &) = delete;
+
+      /// @brief Assignment operator is deleted
+      Worker &operator=(const Worker &) = delete;
+
+      /// @brief fetch the worker's name
+      /// @return the worker's name
+      const std::string &Name() const;
+
+      /// @brief retrieve the idle policy
+      /// @return what the thread does while it has no work
+      Idle GetIdle() const;
+
+      /// @brief Set the idle policy.
+      /// @param idle what the thread does while it has no work, applies
+      ///        from the next time the thread runs out of work
+      void SetIdle(Idle idle);
+
+      /// @brief retrieve the CPU the thread is pinned to
+      /// @return the CPU, -1 if the thread is not pinned
+      int GetCpu() const;
+
+      /// @brief test whether the worker has work pending or running
+      /// @return the busy flag
+      bool IsBusy() const;
+
+      /// @brief test whether the worker has been stopped
+      /// @return true once Stop has been called
+      bool IsStopped() const;
+
+      /// @brief test whether the caller is the worker's thread
+      /// @return true if called from the worker's thread
+      bool IsWorkerThread() const;
+
+      /// @brief retrieve the number of pending work units
+      /// @return the number of work units waiting to run
+      size_t NumPending() const;
+
+      /// @brief retrieve the number of work units run
+      /// @return the number of work units the thread has run
+      uint64_t NumRun() const;
+
+      /// @brief retrieve the number of work units that expired
+      /// @return the number of work units dropped past their deadline
+      uint64_t NumExpired() const;
+
+      /// @brief retrieve the number of times the thread went to sleep
+      /// @return the number of times the thread parked (Idle::PARK)
+      uint64_t NumParked() const;
+
+      /// @brief get the 'on idle' listeners object.
+      /// Listeners are notified, on the worker's thread, each time the
+      /// worker runs out of work.
+      const WListeners::Ptr &OnIdle() const;
+
+      /// @brief add work to the worker
+      /// @param work work to add
+      /// @note Work added after Stop is discarded.
+      void AddWork(const Work::Ptr &work);
+
+      /// @brief add work to the worker, taking over the caller's reference
+      /// @param work work to add, it is left null
+      void AddWork(Work::Ptr &&work);
+
+      /// @brief add a batch of work to the worker
+      /// @param works pointer to the first of num work units
+      /// @param num number of work units to add
+      void AddWorkBatch(const Work::Ptr *works, size_t num);
+
+      /// @brief Stop the thread after the work it is running.
+      /// Pending work is discarded.  Unless called from the worker's own
+      /// thread, this waits for the thread to exit.
+      void Stop();
+
+      /// @brief Write a short summary of the worker to the given ostream.
+      /// @param out the stream to write to
+      /// @param o the Worker instance to write
+      /// @return the stream passed as the out parameter
+      friend std::ostream &operator<<(std::ostream &out, const Worker &o);
+
+    private:
+      /// @brief constructor
+      Worker();
+
+      /// @brief the thread's main loop
+      /// @param self keeps the worker alive while its thread runs
+      static void Main(Ptr self);
+
+      /// @brief run one work unit
+      /// @param work the work to run
+      void Run(const Work::Ptr &work);
+
+      /// @brief wait for work according to the idle policy
+      void WaitForWork();
+
+      /// @brief wake the thread if it is asleep
+      void Wake();
+
+      WPtr                  THIS;        ///< weak pointer to self
+      std::string           name;        ///< name of the worker
+      Stats::Ptr            stats;       ///< run time of each work unit
+      int                   cpu;         ///< pinned CPU, -1 if unpinned
+      std::atomic<Idle>     idle;        ///< idle policy
+      std::atomic<bool>     stopped;     ///< set by Stop
+      WListeners::Ptr       onIdle;      ///< notifications sent when the worker runs dry
+      Semaphore::Ptr        wakeup;      ///< posted to wake a sleeping thread
+      std::thread           thread;      ///< the worker's thread
+      std::atomic<std::thread::id> threadId; ///< id of the worker's thread, set by the thread itself
+      std::atomic<uint64_t> numRun;      ///< work units run
+      std::atomic<uint64_t> numExpired;  ///< work units dropped past their deadline
+      std::atomic<uint64_t> numParked;   ///< times the thread slept
+      char                  pad0[CacheLineSize];
+      std::atomic<size_t>   outstanding; ///< pending plus running work units
+      std::atomic<bool>     sleeping;    ///< the thread is (about to go) asleep
+      char                  pad1[CacheLineSize];
+      WorkList              pending;     ///< work waiting to run
+    };
+
+    /// @brief Idle serialization operator
+    /// @param out the stream to write to
+    /// @param o the idle policy to write
+    /// @return the stream passed as the out parameter
+    std::ostream &operator<<(std::ostream &out, const Worker::Idle &o);
+
+  }
+}
+
+#endif
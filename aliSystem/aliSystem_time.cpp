@@ -1,18 +1,100 @@
 #include <aliSystem_time.hpp>
+#include <aliSystem_componentRegistry.hpp>
 #include <cmath>
 #include <cstdio>
+#include <thread>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
 
 
 namespace {
   const long long nano = 1000*1000*1000;
+
+  // how long the time stamp counter is compared with the steady clock
+  const std::chrono::milliseconds CALIBRATION(20);
+
+  // The source of Time::Ticks, chosen and calibrated by the component's
+  // Init, or on first use if that comes earlier.  The
+  // TSC is only used if it is invariant, that is it ticks at a constant
+  // rate regardless of frequency scaling and sleep states, and is kept in
+  // step across cores.
+  struct TickSource {
+    bool   tsc;        // ticks are read from the TSC
+    double nsPerTick;  // tick length in nanoseconds
+    TickSource()
+      : tsc(false),
+	nsPerTick(1.0) {
+#if defined(__x86_64__) || defined(__i386__)
+      unsigned int a = 0, b = 0, c = 0, d = 0;
+      if (__get_cpuid(0x80000000, &a, &b, &c, &d) && a>=0x80000007
+	  && __get_cpuid(0x80000007, &a, &b, &c, &d) && (d & (1u<<8))) {
+	using Steady = std::chrono::steady_clock;
+	Steady::time_point t0 = Steady::now();
+	uint64_t           c0 = __rdtsc();
+	std::this_thread::sleep_for(CALIBRATION);
+	Steady::time_point t1 = Steady::now();
+	uint64_t           c1 = __rdtsc();
+	double             ns = std::chrono::duration<double, std::nano>(t1-t0).count();
+	if (c1>c0 && ns>0) {
+	  tsc       = true;
+	  nsPerTick = ns/(c1-c0);
+	}
+      }
+#endif
+    }
+  };
+
+  const TickSource &Source() {
+    static const TickSource source;
+    return source;
+  }
+
+  // calibrate before any pool or engine thread reads the counter
+  void Init() { Source(); }
+  void Fini() {}
+
+  uint64_t MonotonicNs() {
+    // not the coarse clock, its intervals snap to a multi millisecond
+    // tick and would wreck the run time percentiles
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec)*nano + ts.tv_nsec;
+  }
 }
 
 namespace aliSystem {
 
+  void Time::RegisterInitFini(ComponentRegistry &cr) {
+    cr.Register("aliSystem::Time", Init, Fini);
+  }
   Time::TP Time::Now() {
     TP now = std::chrono::high_resolution_clock::now();
     return now;
   }
+  uint64_t Time::Ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    if (Source().tsc) {
+      return __rdtsc();
+    }
+#endif
+    return MonotonicNs();
+  }
+  Time::Dur Time::FromTicks(uint64_t ticks) {
+    const TickSource &source = Source();
+    if (!source.tsc) {
+      return std::chrono::duration_cast<Dur>(std::chrono::nanoseconds(ticks));
+    }
+    return std::chrono::duration_cast<Dur>(std::chrono::nanoseconds((long long)(ticks*source.nsPerTick)));
+  }
+  bool Time::HasTsc() {
+    return Source().tsc;
+  }
+  double Time::TicksPerSecond() {
+    return nano/Source().nsPerTick;
+  }
   double Time::ToSeconds(const Dur &dur) {
     std::chrono::nanoseconds ns = dur;
     return double(ns.count()/nano) + double(ns.count()%nano)/nano;
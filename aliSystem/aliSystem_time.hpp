@@ -2,20 +2,60 @@
 #define INCLUDED_ALI_SYSTEM_TIME
 
 #include <chrono>
+#include <cstdint>
 #include <ostream>
 
 namespace aliSystem {
 
+  struct ComponentRegistry;
+
   /// @brief Time provides a simplified interface for
   ///        commont time related logic.
+  ///
+  /// Besides the clock behind Now, Time offers a cheap tick counter for
+  /// measuring short intervals on hot paths (see Ticks).  On x86 processors
+  /// with an invariant time stamp counter the ticks are read with rdtsc,
+  /// which costs nanoseconds rather than the tens of nanoseconds of a
+  /// clock read, and are converted to durations with a rate calibrated
+  /// against the steady clock when the aliSystem::Time component is
+  /// initialized (or, failing that, the first time the counter is used,
+  /// which then stalls the first reader for the calibration).
+  /// Elsewhere the ticks are CLOCK_MONOTONIC nanoseconds, which cost as
+  /// much as Now but keep the resolution latency histograms (as kept by
+  /// aliSystem::Stats) need for sub-millisecond intervals.
   struct Time {
 
     using CLOCK = std::chrono::high_resolution_clock;  ///< clock type
     using TP    = CLOCK::time_point;                   ///< time point type
     using Dur   = CLOCK::duration;                     ///< durationn type
 
+    /// @brief Initialize time module, calibrating the tick counter.
+    /// @param cr is a component registry to which any initialzation
+    ///        and finalization logic should be registered.
+    /// @note This function should only be called from aliSystem::RegisterInitFini.
+    static void RegisterInitFini(ComponentRegistry &cr);
+
     /// @brief obtain the current time
     static TP Now();
+
+    /// @brief read the cheap tick counter
+    /// @return the current tick count, only differences between two
+    ///         reads on the same machine are meaningful
+    static uint64_t Ticks();
+
+    /// @brief convert a number of ticks to a duration
+    /// @param ticks the difference between two calls to Ticks
+    /// @return the equivalent duration
+    static Dur FromTicks(uint64_t ticks);
+
+    /// @brief test whether Ticks reads the time stamp counter
+    /// @return true if the ticks come from a calibrated TSC, false if
+    ///         they are monotonic clock nanoseconds
+    static bool HasTsc();
+
+    /// @brief retrieve the tick rate
+    /// @return the number of ticks per second
+    static double TicksPerSecond();
     
     /// @brief Convert a duration to a double value.
     /// @param dur is a duration to convert.
@@ -0,0 +1,242 @@
+#include <aliSystem_trace.hpp>
+#include <aliSystem_logging.hpp>
+#include <aliSystem_util.hpp>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+  using Time = aliSystem::Time;
+
+  struct Event {
+    std::string name;
+    const char *category;
+    const char *argName;
+    std::string argValue;
+    int64_t     start;     // nanoseconds since the epoch
+    int64_t     duration;  // nanoseconds
+  };
+
+  // The spans of one thread.  Only the owning thread appends, the lock is
+  // contended only while Start or Dump run.
+  struct Buffer {
+    std::mutex         lock;
+    std::vector<Event> events;
+    uint64_t           tid;
+    std::string        threadName;
+    bool               closed;
+  };
+  using BufferPtr = std::shared_ptr<Buffer>;
+
+  struct Tracer {
+    Tracer()
+      : capacity(65536),
+	dropped(0),
+	started(0),
+	nextTid(1) {
+    }
+    std::mutex             lock;     // guards buffers and nextTid
+    std::vector<BufferPtr> buffers;
+    std::atomic<size_t>    capacity;
+    std::atomic<uint64_t>  dropped;
+    std::atomic<int64_t>   started;  // nanoseconds since the epoch of the last Start
+    uint64_t               nextTid;
+  };
+
+  // spans may be recorded while static objects are destroyed
+  Tracer &GetTracer() {
+    static Tracer *tracer = new Tracer;
+    return *tracer;
+  }
+
+  // the calling thread's buffer and name, the buffer is created on the
+  // thread's first span and kept for Dump after the thread exits.
+  struct ThreadState {
+    ~ThreadState() {
+      if (buffer) {
+	std::lock_guard<std::mutex> g(buffer->lock);
+	buffer->closed = true;
+      }
+    }
+    BufferPtr   buffer;
+    std::string name;
+  };
+  thread_local ThreadState threadState;
+
+  Buffer &ThreadBuffer() {
+    if (!threadState.buffer) {
+      Tracer   &tracer = GetTracer();
+      BufferPtr buffer = std::make_shared<Buffer>();
+      buffer->closed   = false;
+      std::lock_guard<std::mutex> g(tracer.lock);
+      buffer->tid        = tracer.nextTid++;
+      buffer->threadName = threadState.name.empty()
+	? "thread " + std::to_string(buffer->tid)
+	: threadState.name;
+      tracer.buffers.push_back(buffer);
+      threadState.buffer = buffer;
+    }
+    return *threadState.buffer;
+  }
+
+  int64_t Nanoseconds(const Time::TP &tp) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count();
+  }
+
+  // chrome trace times are in (fractional) microseconds
+  std::string Micros(int64_t ns) {
+    std::ostringstream out;
+    out << ns/1000 << "." << std::setw(3) << std::setfill('0') << ns%1000;
+    return out.str();
+  }
+
+}
+
+namespace aliSystem {
+
+  std::atomic<bool> Trace::enabled(false);
+
+  Trace::Span::Span(const char *name, const char *category_)
+    : cName(name),
+      sName(nullptr),
+      category(category_),
+      argName(nullptr),
+      argValue(nullptr),
+      active(IsEnabled()) {
+    if (active) {
+      start = Time::Now();
+    }
+  }
+  Trace::Span::Span(const char *name, const char *category_,
+		    const char *argName_, const std::string &argValue_)
+    : cName(name),
+      sName(nullptr),
+      category(category_),
+      argName(argName_),
+      argValue(&argValue_),
+      active(IsEnabled()) {
+    if (active) {
+      start = Time::Now();
+    }
+  }
+  Trace::Span::Span(const std::string &name, const char *category_)
+    : cName(nullptr),
+      sName(&name),
+      category(category_),
+      argName(nullptr),
+      argValue(nullptr),
+      active(IsEnabled()) {
+    if (active) {
+      start = Time::Now();
+    }
+  }
+  Trace::Span::~Span() {
+    if (active) {
+      Record(sName ? *sName : std::string(cName), category,
+	     argName, argValue ? *argValue : std::string(),
+	     start, Time::Now());
+    }
+  }
+  void Trace::Start(size_t capacity) {
+    THROW_IF(capacity==0, "Trace buffers must hold at least one span");
+    Tracer &tracer = GetTracer();
+    std::lock_guard<std::mutex> g(tracer.lock);
+    std::vector<BufferPtr> kept;
+    for (std::vector<BufferPtr>::const_iterator it=tracer.buffers.begin(); it!=tracer.buffers.end(); ++it) {
+      std::lock_guard<std::mutex> g2((*it)->lock);
+      if (!(*it)->closed) {
+	(*it)->events.clear();
+	kept.push_back(*it);
+      }
+    }
+    tracer.buffers.swap(kept);
+    tracer.capacity = capacity;
+    tracer.dropped  = 0;
+    tracer.started  = Nanoseconds(Time::Now());
+    enabled         = true;
+  }
+  void Trace::Stop() {
+    enabled = false;
+  }
+  void Trace::Record(const std::string &name,
+		     const char        *category,
+		     const char        *argName,
+		     const std::string &argValue,
+		     const Time::TP    &start,
+		     const Time::TP    &end) {
+    Tracer &tracer = GetTracer();
+    int64_t s      = Nanoseconds(start);
+    if (s<tracer.started.load(std::memory_order_relaxed)) {
+      return;
+    }
+    Buffer &buffer = ThreadBuffer();
+    std::lock_guard<std::mutex> g(buffer.lock);
+    if (buffer.events.size()>=tracer.capacity) {
+      ++tracer.dropped;
+      return;
+    }
+    int64_t d = std::max<int64_t>(0, Nanoseconds(end)-s);
+    buffer.events.push_back(Event { name, category, argName, argValue, s, d });
+  }
+  void Trace::SetThreadName(const std::string &name) {
+    threadState.name = name;
+    if (threadState.buffer) {
+      std::lock_guard<std::mutex> g(threadState.buffer->lock);
+      threadState.buffer->threadName = name;
+    }
+  }
+  size_t Trace::NumEvents() {
+    Tracer &tracer = GetTracer();
+    size_t  rtn    = 0;
+    std::lock_guard<std::mutex> g(tracer.lock);
+    for (std::vector<BufferPtr>::const_iterator it=tracer.buffers.begin(); it!=tracer.buffers.end(); ++it) {
+      std::lock_guard<std::mutex> g2((*it)->lock);
+      rtn += (*it)->events.size();
+    }
+    return rtn;
+  }
+  uint64_t Trace::NumDropped() {
+    return GetTracer().dropped;
+  }
+  void Trace::Dump(std::ostream &out) {
+    Tracer     &tracer = GetTracer();
+    const pid_t pid    = getpid();
+    const char *sep    = "\n";
+    std::lock_guard<std::mutex> g(tracer.lock);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    for (std::vector<BufferPtr>::const_iterator it=tracer.buffers.begin(); it!=tracer.buffers.end(); ++it) {
+      std::lock_guard<std::mutex> g2((*it)->lock);
+      const Buffer &b = **it;
+      out << sep << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << b.tid
+	  << ",\"args\":{\"name\":" << Util::JsonQuote(b.threadName) << "}}";
+      sep = ",\n";
+      for (std::vector<Event>::const_iterator e=b.events.begin(); e!=b.events.end(); ++e) {
+	out << sep << "{\"name\":" << Util::JsonQuote(e->name)
+	    << ",\"cat\":\"" << e->category << "\""
+	    << ",\"ph\":\"X\",\"ts\":" << Micros(e->start)
+	    << ",\"dur\":" << Micros(e->duration)
+	    << ",\"pid\":" << pid << ",\"tid\":" << b.tid;
+	if (e->argName) {
+	  out << ",\"args\":{\"" << e->argName << "\":" << Util::JsonQuote(e->argValue) << "}";
+	}
+	out << "}";
+      }
+    }
+    out << "\n]}\n";
+  }
+  void Trace::Dump(const std::string &path) {
+    std::ofstream out(path, std::ios::trunc);
+    THROW_IF(!out, "Unable to open " << path << " for the trace");
+    Dump(out);
+    out.close();
+    THROW_IF(!out, "Unable to write the trace to " << path);
+  }
+
+}
@@ -0,0 +1,137 @@
+#ifndef INCLUDED_ALI_SYSTEM_TRACE
+#define INCLUDED_ALI_SYSTEM_TRACE
+
+#include <aliSystem_time.hpp>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace aliSystem {
+
+  ///
+  /// @brief A timeline of spans recorded across threads, dumped in the
+  ///        Chrome trace event format.
+  ///
+  /// While tracing is on, each span (a name, a category, an optional
+  /// argument such as the queue or engine it belongs to, and its start
+  /// and end times) is appended to a buffer owned by the thread recording
+  /// it, so threads do not contend with each other.  Dump writes the
+  /// spans of every thread as a JSON trace that chrome://tracing and
+  /// Perfetto display as a timeline, one track per thread, with nested
+  /// spans stacked.
+  ///
+  /// The library records spans for adding work to a queue ("enqueue"),
+  /// the time work waited in a queue ("queued"), running work from a
+  /// queue or worker ("run"), waiting for and running an ExecEngine
+  /// ("lock", "exec") and each call of a C function registered with Lua.
+  ///
+  /// Tracing is off by default, and while it is off a span costs one
+  /// relaxed atomic load.  Each thread keeps at most the capacity passed
+  /// to Start spans; further spans are counted by NumDropped.
+  ///
+  struct Trace {
+
+    ///
+    /// @brief Records a span from its construction to its destruction.
+    ///
+    /// Nothing is recorded if tracing was off at construction.  The
+    /// name, category and argument are not copied until the span is
+    /// recorded, so they must outlive the span.
+    ///
+    struct Span {
+      /// @brief start a span
+      /// @param name name of the span, usually a string literal
+      /// @param category category of the span, a string literal
+      Span(const char *name, const char *category);
+
+      /// @brief start a span with an argument
+      /// @param name name of the span, usually a string literal
+      /// @param category category of the span, a string literal
+      /// @param argName name of the argument, a string literal
+      /// @param argValue value of the argument
+      Span(const char *name, const char *category,
+	   const char *argName, const std::string &argValue);
+
+      /// @brief start a span with a computed name
+      /// @param name name of the span
+      /// @param category category of the span, a string literal
+      Span(const std::string &name, const char *category);
+
+      /// @brief destructor, records the span
+      ~Span();
+
+      /// @brief Copy constructor is deleted
+      Span(const Span &) = delete;
+
+      /// @brief Assignment operator is deleted
+      Span &operator=(const Span &) = delete;
+
+    private:
+      const char        *cName;     ///< name, if given as a C string
+      const std::string *sName;     ///< name, if given as a string
+      const char        *category;  ///< category
+      const char        *argName;   ///< argument name, may be null
+      const std::string *argValue;  ///< argument value
+      bool               active;    ///< tracing was on at construction
+      Time::TP           start;     ///< start time
+    };
+
+    /// @brief test whether tracing is on
+    /// @return true between Start and Stop
+    static bool IsEnabled() {
+      return enabled.load(std::memory_order_relaxed);
+    }
+
+    /// @brief Discard any recorded spans and start tracing.
+    /// @param capacity the number of spans each thread keeps
+    static void Start(size_t capacity=65536);
+
+    /// @brief Stop tracing, the recorded spans are kept for Dump.
+    static void Stop();
+
+    /// @brief record a span
+    /// @param name name of the span
+    /// @param category category of the span, a string literal
+    /// @param argName name of the argument, a string literal or null
+    /// @param argValue value of the argument
+    /// @param start start of the span
+    /// @param end end of the span
+    /// @note Recorded even if tracing is off, callers check IsEnabled.
+    ///       Spans starting before the last Start are discarded.
+    static void Record(const std::string &name,
+		       const char        *category,
+		       const char        *argName,
+		       const std::string &argValue,
+		       const Time::TP    &start,
+		       const Time::TP    &end);
+
+    /// @brief name the calling thread's track in the trace
+    /// @param name name of the thread
+    static void SetThreadName(const std::string &name);
+
+    /// @brief retrieve the number of recorded spans
+    /// @return the number of spans held for Dump
+    static size_t NumEvents();
+
+    /// @brief retrieve the number of spans dropped
+    /// @return the number of spans not recorded because a thread's buffer
+    ///         was full, since the last Start
+    static uint64_t NumDropped();
+
+    /// @brief Write the recorded spans as a Chrome trace.
+    /// @param out the stream to write to
+    static void Dump(std::ostream &out);
+
+    /// @brief Write the recorded spans as a Chrome trace to a file.
+    /// @param path the file to write
+    /// @note throws if the file cannot be written
+    static void Dump(const std::string &path);
+
+  private:
+    static std::atomic<bool> enabled;  ///< tracing is on
+  };
+
+}
+
+#endif
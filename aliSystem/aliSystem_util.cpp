@@ -1,6 +1,8 @@
 #include <aliSystem_util.hpp>
 #include <algorithm>
 #include <cstring>
+#include <iomanip>
+#include <sstream>
 
 namespace aliSystem {
   namespace Util {
@@ -38,5 +40,28 @@ namespace aliSystem {
     bool Always() { return true;  }
     bool Never()   { return false; }
 
+    std::string JsonQuote(const std::string &str) {
+      std::ostringstream out;
+      out << '"';
+      for (std::string::const_iterator it=str.begin(); it!=str.end(); ++it) {
+	unsigned char c = *it;
+	switch (c) {
+	case '\\': out << "\\\\"; break;
+	case '"':  out << "\\\"";  break;
+	case '\n': out << "\\n";  break;
+	case '\t': out << "\\t";  break;
+	default:
+	  if (c<0x20) {
+	    out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec;
+	  } else {
+	    out << *it;
+	  }
+	  break;
+	}
+      }
+      out << '"';
+      return out.str();
+    }
+
   }
 }
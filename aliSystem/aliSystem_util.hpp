@@ -64,6 +64,12 @@ namespace aliSystem {
 
     /// \brief Never is a trival commit function that always returns false.
     bool     Never();
+
+    /// \brief JsonQuote quotes a string for use in JSON output.
+    /// \param str - the string to quote.
+    /// \returns the string in double quotes, with quotes, backslashes and
+    ///          control characters escaped.
+    std::string JsonQuote(const std::string &str);
     
   }
 }
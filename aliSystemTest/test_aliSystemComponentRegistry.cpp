@@ -1,5 +1,10 @@
 #include "gtest/gtest.h"
 #include <aliSystem.hpp>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
 
 namespace {
 
@@ -185,3 +190,85 @@ TEST(ComponentRegistry, undefinedThrows) {
   ptr->AddDependency("aXXX");
   ASSERT_ANY_THROW(cr.Init());
 }
+
+TEST(ComponentRegistry, parallelInit) {
+  using TP = aliSystem::Time::TP;
+  std::mutex                                 lock;
+  std::map<std::string, std::pair<TP, TP>>   ran;
+  SVPtr                                      svPtr(new SVVec);
+  auto Timed = [&](const std::string &name, size_t ms) {
+    return [&, name, ms]() {
+      TP start = aliSystem::Time::Now();
+      std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+      std::lock_guard<std::mutex> g(lock);
+      ran[name] = std::make_pair(start, aliSystem::Time::Now());
+    };
+  };
+  CR   cr;
+  CPtr a = cr.Register("a", Timed("a",  50), GetFn(svPtr, "a-fini"));
+  CPtr b = cr.Register("b", Timed("b", 200), GetFn(svPtr, "b-fini"));
+  CPtr c = cr.Register("c", Timed("c", 100), GetFn(svPtr, "c-fini"));
+  CPtr d = cr.Register("d", Timed("d",  50), GetFn(svPtr, "d-fini"));
+  CPtr e = cr.Register("e", Timed("e", 100), GetFn(svPtr, "e-fini"));
+  b->AddDependency("a");
+  c->AddDependency("a");
+  d->AddDependency("b");
+  d->AddDependency("c");
+  aliSystem::Threading::Pool::Ptr pool = aliSystem::Threading::Pool::Create("crPool", 4);
+  cr.Init(pool);
+  ASSERT_TRUE(cr.HasInit());
+  ASSERT_EQ(ran.size(), 5u);
+  ASSERT_LE(ran["a"].second, ran["b"].first);
+  ASSERT_LE(ran["a"].second, ran["c"].first);
+  ASSERT_LE(ran["b"].second, ran["d"].first);
+  ASSERT_LE(ran["c"].second, ran["d"].first);
+  // b and c, and e with everything, ran concurrently
+  ASSERT_LT(ran["c"].first, ran["b"].second);
+  ASSERT_LT(ran["b"].first, ran["c"].second);
+  ASSERT_LT(ran["e"].first, ran["a"].second);
+  ASSERT_LT(ran["a"].first, ran["e"].second);
+  // the init queue does not outlive Init
+  aliSystem::Threading::Pool::QVec queues;
+  pool->GetQueues(queues);
+  ASSERT_TRUE(queues.empty());
+
+  CR::TimingVec timings;
+  cr.GetTimings(timings);
+  ASSERT_EQ(timings.size(), 5u);
+  CR::TimingVec path;
+  cr.GetCriticalPath(path);
+  ASSERT_EQ(path.size(), 3u);
+  ASSERT_EQ(path[0].component, a);
+  ASSERT_EQ(path[1].component, b);
+  ASSERT_EQ(path[2].component, d);
+  ASSERT_GE(aliSystem::Time::ToSeconds(path[1].duration), 0.2);
+
+  cr.Fini();
+  ASSERT_EQ(svPtr->size(), 5u);
+  // the reverse of the init order: components without dependencies first
+  SVVec expected = { "d-fini", "c-fini", "b-fini", "e-fini", "a-fini" };
+  ASSERT_EQ(*svPtr, expected);
+}
+
+TEST(ComponentRegistry, parallelInitFailure) {
+  SVPtr svPtr(new SVVec);
+  CR    cr;
+  cr.Register("a", []() { std::this_thread::sleep_for(std::chrono::milliseconds(50)); THROW("a failed"); }, GetFn(svPtr, "a-fini"));
+  cr.Register("b", []() { THROW("b failed"); },                                                        GetFn(svPtr, "b-fini"));
+  CPtr c = cr.Register("c", GetFn(svPtr, "c-init"), GetFn(svPtr, "c-fini"));
+  c->AddDependency("b");
+  aliSystem::Threading::Pool::Ptr pool = aliSystem::Threading::Pool::Create("crFailPool", 2);
+  try {
+    cr.Init(pool);
+    FAIL() << "Init should have thrown";
+  } catch (std::exception &e) {
+    // both failed, a is first in the init order
+    ASSERT_NE(std::string(e.what()).find("a failed"), std::string::npos) << e.what();
+  }
+  ASSERT_FALSE(c->WasInit());
+  ASSERT_TRUE(std::find(svPtr->begin(), svPtr->end(), "c-init")==svPtr->end());
+  aliSystem::Threading::Pool::QVec queues;
+  pool->GetQueues(queues);
+  ASSERT_TRUE(queues.empty());
+  ASSERT_ANY_THROW(cr.Init(pool));
+}
@@ -0,0 +1,68 @@
+#include "gtest/gtest.h"
+#include <aliSystem.hpp>
+#include <thread>
+#include <vector>
+
+namespace {
+  using Histogram = aliSystem::Histogram;
+}
+
+TEST(aliSystemHistogram, buckets) {
+  // small values are exact
+  for (uint64_t v=0;v<Histogram::SubBuckets;++v) {
+    ASSERT_EQ(Histogram::BucketOf(v), v);
+    ASSERT_EQ(Histogram::LowerBound(v), v);
+    ASSERT_EQ(Histogram::Width(v), 1u);
+  }
+  // every bucket starts where the previous one ends
+  for (size_t b=1;b<Histogram::NumBuckets;++b) {
+    ASSERT_EQ(Histogram::LowerBound(b), Histogram::LowerBound(b-1)+Histogram::Width(b-1)) << b;
+    ASSERT_EQ(Histogram::BucketOf(Histogram::LowerBound(b)), b) << b;
+    ASSERT_EQ(Histogram::BucketOf(Histogram::LowerBound(b)-1), b-1) << b;
+  }
+  // the relative error is bounded whatever the magnitude
+  for (uint64_t v=1;v<(uint64_t(1)<<Histogram::MaxExponent);v=v*3+1) {
+    size_t b = Histogram::BucketOf(v);
+    ASSERT_LE(Histogram::Width(b), Histogram::LowerBound(b)/Histogram::SubBuckets+1) << v;
+  }
+  ASSERT_EQ(Histogram::BucketOf(~uint64_t(0)), Histogram::NumBuckets-1);
+}
+
+TEST(aliSystemHistogram, percentiles) {
+  Histogram h;
+  ASSERT_EQ(h.Count(), 0u);
+  ASSERT_EQ(h.Percentile(0.5), 0u);
+  for (uint64_t v=1;v<=1000;++v) {
+    h.Record(v*1000);
+  }
+  ASSERT_EQ(h.Count(), 1000u);
+  ASSERT_NEAR(double(h.Percentile(0.5)),   500000, 500000/8);
+  ASSERT_NEAR(double(h.Percentile(0.99)),  990000, 990000/8);
+  ASSERT_NEAR(double(h.Percentile(0.999)), 999000, 999000/8);
+  ASSERT_NEAR(double(h.Percentile(0)),       1000, 1000/8);
+  Histogram o;
+  o.Record(5);
+  o.Add(h);
+  ASSERT_EQ(o.Count(), 1001u);
+  ASSERT_EQ(o.Percentile(0), 5u);
+  o.Clear();
+  ASSERT_EQ(o.Count(), 0u);
+}
+
+TEST(aliSystemHistogram, threads) {
+  const size_t             numThreads = 4;
+  const size_t             numValues  = 100000;
+  Histogram                h;
+  std::vector<std::thread> threads;
+  for (size_t t=0;t<numThreads;++t) {
+    threads.push_back(std::thread([&]() {
+	  for (size_t i=0;i<numValues;++i) {
+	    h.Record(i);
+	  }
+	}));
+  }
+  for (std::vector<std::thread>::iterator it=threads.begin(); it!=threads.end(); ++it) {
+    it->join();
+  }
+  ASSERT_EQ(h.Count(), numThreads*numValues);
+}
@@ -10,6 +10,25 @@ namespace {
   namespace Threading = aliSystem::Threading;
 }
 
+// runs before order, whose WaitForHolds releases the process
+TEST(aliSystemHold, timeout) {
+  Hold::Ptr h1 = Hold::Create("timeoutFile", 7, "timeoutTest");
+  Hold::Ptr h2 = Hold::Create("timeoutFile", 7, "timeoutTest");
+  Hold::Ptr h3 = Hold::Create("timeoutFile", 9, "timeoutTest");
+  ASSERT_GE(Hold::NumHolds(), 3u);
+  Hold::Counts counts;
+  Hold::GetCounts(counts);
+  ASSERT_EQ(counts["timeoutTest (timeoutFile:7)"], 2u);
+  ASSERT_EQ(counts["timeoutTest (timeoutFile:9)"], 1u);
+  Time::TP start = Time::Now();
+  ASSERT_FALSE(Hold::WaitForHolds(std::chrono::milliseconds(20)));
+  ASSERT_TRUE(Time::Now()-start>=std::chrono::milliseconds(20));
+  h2.reset();
+  counts.clear();
+  Hold::GetCounts(counts);
+  ASSERT_EQ(counts["timeoutTest (timeoutFile:7)"], 1u);
+}
+
 TEST(aliSystemHold, order) {
   std::string name = "holdTest";
   Hold::Ptr h1 = Hold::Create(__FILE__,    __LINE__, name);
@@ -34,4 +53,8 @@ TEST(aliSystemHold, order) {
   Hold::WaitForHolds();
   Time::TP end = Time::Now();
   ASSERT_TRUE(end-start >std::chrono::seconds(1));
+  // woken by the last release rather than a polling interval
+  ASSERT_TRUE(end-start <std::chrono::seconds(5));
+  ASSERT_EQ(Hold::NumHolds(), 0u);
+  ASSERT_TRUE(Hold::WaitForHolds(std::chrono::milliseconds(0)));
 }
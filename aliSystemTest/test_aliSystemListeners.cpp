@@ -1,5 +1,9 @@
 #include "gtest/gtest.h"
 #include <aliSystem.hpp>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace {
   using     LS   = aliSystem::Listeners<size_t>;
@@ -58,3 +62,119 @@ TEST(aliSystemListeners, general) {
   ASSERT_EQ(abSum,  (size_t)1101010);
   ASSERT_EQ(xyzSum, (size_t)   1010);
 }
+
+TEST(aliSystemListeners, unregister) {
+  size_t  cnt  = 0;
+  LS::Ptr lPtr = LS::Create("onUnregister");
+  L::Ptr  l1   = LS::Register(lPtr, "strong", [&](size_t) { ++cnt; }, false);
+  L::Ptr  l2   = LS::Register(lPtr, "weak",   [&](size_t) { ++cnt; }, true);
+  lPtr->Register(l1, false);
+  ASSERT_EQ(lPtr->Size(), 2u);
+  lPtr->Notify(0);
+  ASSERT_EQ(cnt, 2u);
+  ASSERT_TRUE (lPtr->Unregister(l1));
+  ASSERT_FALSE(lPtr->Unregister(l1));
+  ASSERT_TRUE (lPtr->Unregister(l2));
+  ASSERT_EQ(lPtr->Size(), 0u);
+  lPtr->Notify(0);
+  ASSERT_EQ(cnt, 2u);
+}
+
+TEST(aliSystemListeners, registerWhileNotifying) {
+  LS::Ptr              lPtr = LS::Create("onReentrant");
+  std::vector<L::Ptr>  added;
+  size_t               cnt  = 0;
+  LS::Register(lPtr, "adder", [&](size_t) {
+      // a listener registered during a notification waits for the next one
+      added.push_back(LS::Register(lPtr, "added", [&](size_t) { ++cnt; }, true));
+    }, false);
+  lPtr->Notify(0);
+  ASSERT_EQ(cnt, 0u);
+  lPtr->Notify(0);
+  ASSERT_EQ(cnt, 1u);
+
+  // a slow listener does not block registration on other threads
+  std::atomic<bool> inside(false);
+  std::atomic<bool> release(false);
+  LS::Ptr           slow = LS::Create("onSlow");
+  LS::Register(slow, "slow", [&](size_t) {
+      inside = true;
+      while (!release) {
+	std::this_thread::yield();
+      }
+    }, false);
+  std::thread t([&]() { slow->Notify(0); });
+  while (!inside) {
+    std::this_thread::yield();
+  }
+  L::Ptr other = LS::Register(slow, "other", [](size_t) {}, true);
+  ASSERT_EQ(slow->Size(), 2u);
+  release = true;
+  t.join();
+}
+
+TEST(aliSystemListeners, pruneReleased) {
+  LS::Ptr             lPtr = LS::Create("onPrune");
+  std::vector<L::Ptr> held;
+  size_t              cnt  = 0;
+  for (size_t i=0;i<100;++i) {
+    held.push_back(LS::Register(lPtr, "weak", [&](size_t) { ++cnt; }, true));
+  }
+  held.resize(90);
+  lPtr->Notify(0);
+  ASSERT_EQ(cnt, 90u);
+  // too few released listeners to be worth a new snapshot
+  ASSERT_EQ(lPtr->Size(), 100u);
+  held.resize(50);
+  lPtr->Notify(0);
+  ASSERT_EQ(cnt, 140u);
+  ASSERT_EQ(lPtr->Size(), 50u);
+}
+
+TEST(aliSystemListeners, keyed) {
+  using Match = LS::KeyMatch;
+  LS::Ptr lPtr = LS::Create("onKeyed");
+  size_t  exact = 0, prefix = 0, any = 0, plain = 0;
+  L::Ptr  l1 = LS::RegisterKeyed(lPtr, "orders.eu", Match::EXACT,  [&](size_t) { ++exact;  }, false);
+  L::Ptr  l2 = LS::RegisterKeyed(lPtr, "orders.",   Match::PREFIX, [&](size_t) { ++prefix; }, true);
+  L::Ptr  l3 = LS::RegisterKeyed(lPtr, "",          Match::ANY,    [&](size_t) { ++any;    }, true);
+  L::Ptr  l4 = LS::Register     (lPtr, "orders.eu",                [&](size_t) { ++plain;  }, true);
+  ASSERT_EQ(lPtr->Size(), 4u);
+
+  lPtr->NotifyKey(0, "orders.eu");
+  ASSERT_EQ(exact, 1u); ASSERT_EQ(prefix, 1u); ASSERT_EQ(any, 1u); ASSERT_EQ(plain, 0u);
+  lPtr->NotifyKey(0, "orders.us");
+  ASSERT_EQ(exact, 1u); ASSERT_EQ(prefix, 2u); ASSERT_EQ(any, 2u);
+  lPtr->NotifyKey(0, "orders");
+  ASSERT_EQ(exact, 1u); ASSERT_EQ(prefix, 2u); ASSERT_EQ(any, 3u);
+  ASSERT_FALSE(lPtr->NotifyKey(0, "orders.eu", []()->bool { return false; }));
+  ASSERT_EQ(any, 3u);
+
+  // keyed listeners are not notified by Notify
+  lPtr->Notify(0);
+  ASSERT_EQ(exact, 1u); ASSERT_EQ(prefix, 2u); ASSERT_EQ(any, 3u); ASSERT_EQ(plain, 1u);
+
+  ASSERT_TRUE(lPtr->Unregister(l1));
+  lPtr->NotifyKey(0, "orders.eu");
+  ASSERT_EQ(exact, 1u); ASSERT_EQ(prefix, 3u); ASSERT_EQ(any, 4u);
+  l2.reset();
+  l3.reset();
+  lPtr->NotifyKey(0, "orders.eu");
+  ASSERT_EQ(prefix, 3u); ASSERT_EQ(any, 4u);
+  ASSERT_EQ(lPtr->Size(), 1u);
+}
+
+TEST(aliSystemListeners, keyedMany) {
+  LS::Ptr             lPtr = LS::Create("onKeyedMany");
+  std::vector<size_t> counts(1000, 0);
+  for (size_t i=0;i<counts.size();++i) {
+    LS::RegisterKeyed(lPtr, "topic."+std::to_string(i), LS::KeyMatch::EXACT,
+		      [&counts,i](size_t val) { counts[i] += val; }, false);
+  }
+  for (size_t i=0;i<counts.size();i+=10) {
+    lPtr->NotifyKey(i, "topic."+std::to_string(i));
+  }
+  for (size_t i=0;i<counts.size();++i) {
+    ASSERT_EQ(counts[i], i%10==0 ? i : 0u);
+  }
+}
@@ -1,5 +1,8 @@
 #include "gtest/gtest.h"
 #include <aliSystem.hpp>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 TEST(aliSystemLogging, general) {
   int caught = 0;
@@ -27,3 +30,85 @@ TEST(aliSystemLogging, general) {
   }
   ASSERT_EQ(caught,2);
 }
+
+namespace {
+  using Level    = aliSystem::Logging::Level;
+  using Overflow = aliSystem::Logging::Overflow;
+
+  // redirects std::cout for the life of the capture
+  struct Capture {
+    Capture() : old(std::cout.rdbuf(out.rdbuf())) {}
+    ~Capture() { std::cout.rdbuf(old); }
+    size_t Count(const std::string &marker) {
+      size_t      rtn = 0;
+      std::string line;
+      while (std::getline(out, line)) {
+	rtn += line.find(marker)!=std::string::npos ? 1 : 0;
+      }
+      return rtn;
+    }
+    std::stringstream  out;
+    std::streambuf    *old;
+  };
+}
+
+TEST(aliSystemLogging, level) {
+  Level level = aliSystem::Logging::GetLevel();
+  ASSERT_EQ(level, Level::INFO);
+  ASSERT_FALSE(aliSystem::Logging::IsDebug());
+  Capture c;
+  aliSystem::Logging::SetLevel(Level::DEBUG);
+  ASSERT_TRUE(aliSystem::Logging::IsDebug());
+  DEBUG("level marker");
+  aliSystem::Logging::SetLevel(aliSystem::Logging::ToLevel("warn"));
+  DEBUG("level marker");
+  INFO("level marker");
+  WARN("level marker");
+  aliSystem::Logging::SetLevel(Level::NONE);
+  ERROR("level marker");
+  ASSERT_THROW(THROW("level marker, not logged but thrown"), std::exception);
+  ASSERT_THROW(aliSystem::Logging::ToLevel("loud"), std::exception);
+  aliSystem::Logging::SetLevel(level);
+  ASSERT_EQ(c.Count("level marker"), 2u);
+}
+
+TEST(aliSystemLogging, async) {
+  const size_t             numThreads = 4;
+  const size_t             numLines   = 1000;
+  std::vector<std::thread> threads;
+  Capture                  c;
+  aliSystem::Logging::StartAsync(64, Overflow::BLOCK);
+  ASSERT_TRUE(aliSystem::Logging::IsAsync());
+  for (size_t t=0;t<numThreads;++t) {
+    threads.push_back(std::thread([=]() {
+	  for (size_t i=0;i<numLines;++i) {
+	    INFO("async marker " << t << " " << i);
+	  }
+	}));
+  }
+  for (std::vector<std::thread>::iterator it=threads.begin(); it!=threads.end(); ++it) {
+    it->join();
+  }
+  INFO("async marker main");
+  aliSystem::Logging::Flush();
+  ASSERT_EQ(c.Count("async marker"), numThreads*numLines+1) << "blocking rings lose nothing";
+  aliSystem::Logging::StopAsync();
+  ASSERT_FALSE(aliSystem::Logging::IsAsync());
+}
+
+TEST(aliSystemLogging, asyncDrop) {
+  const size_t numLines = 10000;
+  uint64_t     dropped  = aliSystem::Logging::NumDropped();
+  Capture      c;
+  // a new thread, so its ring is created with the small capacity
+  std::thread  t([=]() {
+      aliSystem::Logging::StartAsync(2, Overflow::DROP);
+      for (size_t i=0;i<numLines;++i) {
+	INFO("drop marker " << i);
+      }
+      aliSystem::Logging::StopAsync();
+    });
+  t.join();
+  dropped = aliSystem::Logging::NumDropped()-dropped;
+  ASSERT_EQ(c.Count("drop marker")+dropped, numLines) << "every line is either written or counted";
+}
@@ -1,5 +1,8 @@
 #include "gtest/gtest.h"
 #include <aliSystem.hpp>
+#include <set>
+#include <thread>
+#include <vector>
 
 namespace {
   struct RegObj {
@@ -61,3 +64,55 @@ TEST(aliSystemRegistry, general) {
   vPtr = wPtr.lock();
   ASSERT_FALSE(vPtr);
 }
+
+TEST(aliSystemRegistry, snapshot) {
+  aliSystem::Registry::Ptr  reg = aliSystem::Registry::Create("snapshotRegistry");
+  std::vector<RegObj::Ptr>  objs;
+  size_t                    val = 0;
+  for (size_t i=0;i<100;++i) {
+    objs.push_back(RegObj::Ptr(new RegObj(&val)));
+    reg->Register(objs.back());
+  }
+  reg->Register(objs.front());
+  ASSERT_EQ(reg->Size(), (size_t)100);
+  aliSystem::Registry::Items items = reg->Snapshot();
+  ASSERT_EQ(items.size(), (size_t)100);
+  std::set<const void*> addrs;
+  for (aliSystem::Registry::Items::const_iterator it=items.begin(); it!=items.end(); ++it) {
+    addrs.insert(it->get());
+  }
+  for (size_t i=0;i<objs.size();++i) {
+    ASSERT_EQ(addrs.count(objs[i].get()), (size_t)1);
+  }
+  for (size_t i=0;i<objs.size();i+=2) {
+    reg->Unregister(objs[i]);
+  }
+  ASSERT_EQ(reg->Size(), (size_t)50);
+  ASSERT_EQ(reg->Snapshot().size(), (size_t)50);
+}
+
+TEST(aliSystemRegistry, threads) {
+  aliSystem::Registry::Ptr reg = aliSystem::Registry::Create("threadRegistry");
+  std::vector<std::thread> threads;
+  for (size_t t=0;t<4;++t) {
+    threads.push_back(std::thread([reg]() {
+	  size_t val = 0;
+	  for (size_t i=0;i<10000;++i) {
+	    RegObj::Ptr ptr(new RegObj(&val));
+	    reg->Register(ptr);
+	    ASSERT_EQ(reg->Get(ptr.get()), ptr);
+	    if (i%2) {
+	      reg->Unregister(ptr);
+	      ASSERT_FALSE(reg->Get(ptr.get()));
+	    }
+	  }
+	}));
+  }
+  for (size_t i=0;i<100;++i) {
+    ASSERT_LE(reg->Snapshot().size(), (size_t)20000);
+  }
+  for (size_t t=0;t<threads.size();++t) {
+    threads[t].join();
+  }
+  ASSERT_EQ(reg->Size(), (size_t)20000);
+}
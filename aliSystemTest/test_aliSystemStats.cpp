@@ -1,5 +1,7 @@
 #include "gtest/gtest.h"
 #include <aliSystem.hpp>
+#include <thread>
+#include <vector>
 
 namespace {
   using Stats = aliSystem::Stats;
@@ -23,3 +25,45 @@ TEST(aliSystemStats, Basic) {
   ASSERT_EQ(stats->Count(),(size_t)numCycles);
   ASSERT_NEAR(Time::ToSeconds(stats->RunTime()), numCycles*Time::ToSeconds(inc), Time::ToSeconds(us));
 }
+
+TEST(aliSystemStats, Percentiles) {
+  std::chrono::microseconds  us(1);
+  const size_t               numThreads = 4;
+  const size_t               numCycles  = 1000;
+  Stats::Ptr                 stats      = Stats::Create("percentiles");
+  std::vector<std::thread>   threads;
+  ASSERT_EQ(stats->Percentile(0.99), Time::Dur::zero());
+  // every thread records run times of 1 to numCycles microseconds
+  for (size_t t=0;t<numThreads;++t) {
+    threads.push_back(std::thread([&]() {
+	  for (size_t i=1;i<=numCycles;++i) {
+	    stats->Inc(i*us);
+	  }
+	}));
+  }
+  for (std::vector<std::thread>::iterator it=threads.begin(); it!=threads.end(); ++it) {
+    it->join();
+  }
+  ASSERT_EQ(stats->Count(), numThreads*numCycles);
+  ASSERT_EQ(stats->RunTime(), numThreads*(numCycles*(numCycles+1)/2)*us);
+  ASSERT_NEAR(Time::ToSeconds(stats->Percentile(0.5)),   500e-6, 500e-6/8);
+  ASSERT_NEAR(Time::ToSeconds(stats->Percentile(0.99)),  990e-6, 990e-6/8);
+  ASSERT_NEAR(Time::ToSeconds(stats->Percentile(0.999)), 999e-6, 999e-6/8);
+  aliSystem::Histogram latency;
+  stats->Latencies(latency);
+  ASSERT_EQ(latency.Count(), numThreads*numCycles);
+}
+
+TEST(aliSystemStats, noLatencies) {
+  Stats::Ptr stats = Stats::Create("no latencies", false);
+  stats->Inc(std::chrono::milliseconds(1));
+  stats->Inc(std::chrono::milliseconds(3));
+  ASSERT_EQ(stats->Count(), 2u);
+  ASSERT_EQ(stats->RunTime(), std::chrono::milliseconds(4));
+  ASSERT_EQ(stats->Percentile(0.5), Time::Dur::zero());
+  aliSystem::Histogram latency;
+  stats->Latencies(latency);
+  ASSERT_EQ(latency.Count(), 0u);
+  // the histogram is not part of the stats object itself
+  ASSERT_LT(sizeof(Stats), sizeof(aliSystem::Histogram));
+}
@@ -0,0 +1,138 @@
+#include "gtest/gtest.h"
+#include <aliSystem.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+  using Stats         = aliSystem::Stats;
+  using StatsExporter = aliSystem::StatsExporter;
+  using StatsRegistry = aliSystem::StatsRegistry;
+  using Format        = StatsExporter::Format;
+  std::chrono::milliseconds ms(1);
+
+  std::vector<std::string> ReadLines(const std::string &path) {
+    std::vector<std::string> rtn;
+    std::ifstream            in(path);
+    std::string              line;
+    while (std::getline(in, line)) {
+      rtn.push_back(line);
+    }
+    return rtn;
+  }
+
+  // the lines mentioning the given stats object
+  std::vector<std::string> Find(const std::vector<std::string> &lines, const Stats::Ptr &stats) {
+    std::vector<std::string> rtn;
+    std::ostringstream       id;
+    id << "\"id\":" << stats->Id() << ",";
+    std::ostringstream       label;
+    label << "id=\"" << stats->Id() << "\"";
+    for (std::vector<std::string>::const_iterator it=lines.begin(); it!=lines.end(); ++it) {
+      if (it->find(id.str())!=std::string::npos || it->find(label.str())!=std::string::npos) {
+	rtn.push_back(*it);
+      }
+    }
+    return rtn;
+  }
+}
+
+TEST(aliSystemStatsExporter, registry) {
+  size_t     before = StatsRegistry::Size();
+  Stats::Ptr a      = Stats::Create("registry a");
+  Stats::Ptr b      = Stats::Create("registry b");
+  ASSERT_LT(a->Id(), b->Id());
+  ASSERT_EQ(StatsRegistry::Size(), before+2);
+  b->Inc(2*ms);
+  bool found = false;
+  StatsRegistry::Samples samples = StatsRegistry::Snapshot();
+  for (StatsRegistry::Samples::const_iterator it=samples.begin(); it!=samples.end(); ++it) {
+    if (it->id==b->Id()) {
+      found = true;
+      ASSERT_EQ(it->name, "registry b");
+      ASSERT_EQ(it->count, 1u);
+      ASSERT_EQ(it->runTime, 2*ms);
+      ASSERT_NEAR(aliSystem::Time::ToSeconds(it->p99), 0.002, 0.002/8);
+    }
+  }
+  ASSERT_TRUE(found);
+  b.reset();
+  ASSERT_EQ(StatsRegistry::Size(), before+1) << "the registry does not keep stats alive";
+}
+
+TEST(aliSystemStatsExporter, registryChurn) {
+  // stats come and go while snapshots read them
+  std::atomic<bool>        done(false);
+  std::vector<std::thread> threads;
+  for (size_t t=0;t<4;++t) {
+    threads.push_back(std::thread([&]() {
+	  while (!done) {
+	    Stats::Ptr s = Stats::Create("registry churn");
+	    s->Inc(ms);
+	  }
+	}));
+  }
+  for (size_t i=0;i<200;++i) {
+    StatsRegistry::Samples samples = StatsRegistry::Snapshot();
+    for (StatsRegistry::Samples::const_iterator it=samples.begin(); it!=samples.end(); ++it) {
+      if (it->name=="registry churn") {
+	ASSERT_LE(it->count, 1u);
+      }
+    }
+  }
+  done = true;
+  for (std::vector<std::thread>::iterator it=threads.begin(); it!=threads.end(); ++it) {
+    it->join();
+  }
+}
+
+TEST(aliSystemStatsExporter, json) {
+  const std::string  path     = testing::TempDir() + "aliSystemStatsExporter.json";
+  Stats::Ptr         stats    = Stats::Create("json \"quoted\"");
+  std::remove(path.c_str());
+  StatsExporter::Ptr exporter = StatsExporter::Create(path, Format::JSON, aliSystem::Time::Dur::zero());
+  stats->Inc(ms);
+  stats->Inc(ms);
+  exporter->Export();
+  stats->Inc(ms);
+  exporter->Export();
+  ASSERT_EQ(exporter->NumExports(), 2u);
+  std::vector<std::string> lines = Find(ReadLines(path), stats);
+  ASSERT_EQ(lines.size(), 2u) << "one line per export";
+  ASSERT_NE(lines[0].find("\"name\":\"json \\\"quoted\\\"\""), std::string::npos) << lines[0];
+  ASSERT_NE(lines[0].find("\"count\":2,"),      std::string::npos) << lines[0];
+  ASSERT_NE(lines[0].find("\"countDelta\":2,"), std::string::npos) << lines[0];
+  ASSERT_NE(lines[1].find("\"count\":3,"),      std::string::npos) << lines[1];
+  ASSERT_NE(lines[1].find("\"countDelta\":1,"), std::string::npos) << lines[1];
+  std::remove(path.c_str());
+}
+
+TEST(aliSystemStatsExporter, prometheus) {
+  const std::string  path     = testing::TempDir() + "aliSystemStatsExporter.prom";
+  Stats::Ptr         stats    = Stats::Create("prometheus");
+  StatsExporter::Ptr exporter = StatsExporter::Create(path, Format::PROMETHEUS, 5*ms);
+  stats->Inc(ms);
+  while (exporter->NumExports()<2) {
+    std::this_thread::sleep_for(ms);
+  }
+  exporter->Stop();
+  uint64_t exports = exporter->NumExports();
+  std::this_thread::sleep_for(20*ms);
+  ASSERT_EQ(exporter->NumExports(), exports) << "no exports once stopped";
+  std::vector<std::string> all   = ReadLines(path);
+  std::vector<std::string> lines = Find(all, stats);
+  ASSERT_EQ(lines.size(), 10u) << "count, run time, two deltas, rate and the latency summary";
+  ASSERT_EQ(lines[0], "ali_stats_count{name=\"prometheus\",id=\"" + std::to_string(stats->Id()) + "\"} 1");
+  ASSERT_EQ(lines[2], "ali_stats_count_delta{name=\"prometheus\",id=\"" + std::to_string(stats->Id()) + "\"} 0")
+    << "the first export took the increment";
+  ASSERT_EQ(all[0], "# HELP ali_stats_count number of times the stats object was incremented");
+  ASSERT_EQ(all[1], "# TYPE ali_stats_count counter");
+  ASSERT_NE(std::find(all.begin(), all.end(), "# TYPE ali_stats_latency_seconds summary"), all.end());
+  ASSERT_EQ(lines[9], "ali_stats_latency_seconds_count{name=\"prometheus\",id=\"" + std::to_string(stats->Id()) + "\"} 1");
+  std::remove(path.c_str());
+}
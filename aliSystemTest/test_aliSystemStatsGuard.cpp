@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 #include <aliSystem.hpp>
+#include <thread>
 
 namespace {
   using Stats      = aliSystem::Stats;
@@ -23,3 +24,21 @@ TEST(aliSystemStatsGuard, general) {
   EXPECT_TRUE(stats->RunTime() - 2*sec <  2*ms);
   EXPECT_EQ(stats->Count(), (size_t)2);
 }
+
+TEST(aliSystemStatsGuard, cheap) {
+  Stats::Ptr           stats(new Stats("cheapItem"));
+  aliSystem::Time::Dur elapsed;
+  {
+    StatsGuard g(stats, StatsGuard::Clock::CHEAP, &elapsed);
+    std::this_thread::sleep_for(50*ms);
+  }
+  EXPECT_EQ(stats->Count(), (size_t)1);
+  EXPECT_EQ(stats->RunTime(), elapsed);
+  EXPECT_TRUE(elapsed > 40*ms && elapsed < 100*ms);
+  {
+    // a null stats object still reports the elapsed time
+    StatsGuard g(nullptr, StatsGuard::Clock::CHEAP, &elapsed);
+    std::this_thread::sleep_for(20*ms);
+  }
+  EXPECT_TRUE(elapsed > 10*ms);
+}
@@ -0,0 +1,83 @@
+#include "gtest/gtest.h"
+#include <aliSystem.hpp>
+#include <thread>
+#include <vector>
+
+namespace {
+  using FreeList = aliSystem::Threading::FreeList;
+  using PVec     = std::vector<void*>;
+
+  struct Block {
+    char data[48];
+  };
+  using Allocator = FreeList::Allocator<Block>;
+}
+
+TEST(aliSystemThreadingFreeList, reuse) {
+  FreeList        list(1);
+  FreeList::Cache cache(list);
+  ASSERT_EQ(list.BlockSize(), sizeof(void*)) << "blocks hold at least a link";
+  void *a = cache.Allocate();
+  cache.Release(a);
+  void *b = cache.Allocate();
+  ASSERT_EQ(a, b) << "the most recently released block is reused first";
+  cache.Release(b);
+  ASSERT_EQ(list.NumAllocated(), 1u);
+}
+
+TEST(aliSystemThreadingFreeList, crossThread) {
+  // one thread allocates and another releases, once warm the blocks
+  // cycle through the depot without allocating.
+  const size_t num       = 10*FreeList::BATCH;
+  FreeList    &list      = Allocator::List();
+  Allocator    allocator;
+  auto         round     = [&]() {
+    std::vector<Block*> blocks;
+    for (size_t i=0;i<num;++i) {
+      blocks.push_back(allocator.allocate(1));
+    }
+    std::thread t([&]() {
+      for (size_t i=0;i<blocks.size();++i) {
+	allocator.deallocate(blocks[i], 1);
+      }
+    });
+    t.join();
+  };
+  round();
+  uint64_t allocated = list.NumAllocated();
+  ASSERT_GE(allocated, num-FreeList::BATCH);
+  for (size_t i=0;i<10;++i) {
+    round();
+  }
+  ASSERT_EQ(list.NumAllocated(), allocated);
+  ASSERT_EQ(list.NumFreed(), 0u);
+}
+
+TEST(aliSystemThreadingFreeList, threadExit) {
+  // a block released by a thread exit handler that runs after the
+  // thread's cache is destroyed goes to the depot.
+  struct Late {
+    char data[40];
+  };
+  using LateAllocator = FreeList::Allocator<Late>;
+  struct Holder {
+    Late *late = nullptr;
+    ~Holder() {
+      if (late) {
+	LateAllocator().deallocate(late, 1);
+      }
+    }
+  };
+  FreeList &list = LateAllocator::List();
+  std::thread t([]() {
+    // constructed before the cache, so destroyed after it
+    static thread_local Holder holder;
+    holder.late = LateAllocator().allocate(1);
+  });
+  t.join();
+  ASSERT_EQ(list.NumAllocated(), 1u);
+  LateAllocator allocator;
+  Late *late = allocator.allocate(1);
+  ASSERT_EQ(list.NumAllocated(), 1u) << "the late release reached the depot";
+  allocator.deallocate(late, 1);
+}
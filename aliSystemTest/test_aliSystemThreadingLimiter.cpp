@@ -0,0 +1,108 @@
+#include "gtest/gtest.h"
+#include <aliSystem.hpp>
+#include <chrono>
+
+namespace {
+  using Limiter   = aliSystem::Threading::Limiter;
+  using Algorithm = Limiter::Algorithm;
+  using Queue     = aliSystem::Threading::Queue;
+  using Sem       = aliSystem::Threading::Semaphore;
+  using Work      = aliSystem::Threading::Work;
+  using Time      = aliSystem::Time;
+
+  const std::chrono::milliseconds ms(1);
+}
+
+TEST(aliSystemThreadingLimiter, aimd) {
+  Limiter::Ptr limiter = Limiter::Create(Algorithm::AIMD, 1, 10, 4);
+  limiter->SetWindow(1);
+  limiter->SetBackoff(0.5);
+  ASSERT_EQ(limiter->GetLimit(), 4u);
+  // flat latency with the limit in use grows it by one per window
+  ASSERT_TRUE(limiter->Sample(ms, 4));
+  ASSERT_EQ(limiter->GetLimit(), 5u);
+  ASSERT_TRUE(limiter->Sample(ms, 5));
+  ASSERT_EQ(limiter->GetLimit(), 6u);
+  // ... but not while most of the limit goes unused
+  ASSERT_FALSE(limiter->Sample(ms, 1));
+  ASSERT_EQ(limiter->GetLimit(), 6u);
+  // latency beyond the tolerance backs off
+  ASSERT_TRUE(limiter->Sample(3*ms, 6));
+  ASSERT_EQ(limiter->GetLimit(), 3u);
+  ASSERT_NEAR(Time::ToSeconds(limiter->GetLatency()), 0.003, 1e-9);
+  // the limit stays within its bounds
+  for (size_t i=0;i<10;++i) {
+    limiter->Sample(100*ms, 10);
+  }
+  ASSERT_EQ(limiter->GetLimit(), 1u);
+  for (size_t i=0;i<100;++i) {
+    limiter->Sample(std::chrono::microseconds(1), 10);
+  }
+  ASSERT_EQ(limiter->GetLimit(), 10u);
+  ASSERT_EQ(limiter->NumUpdates(), 114u);
+}
+
+TEST(aliSystemThreadingLimiter, gradient) {
+  Limiter::Ptr limiter = Limiter::Create(Algorithm::GRADIENT, 2, 64, 16);
+  limiter->SetWindow(1);
+  for (size_t i=0;i<5;++i) {
+    limiter->Sample(ms, 16);
+  }
+  size_t grown = limiter->GetLimit();
+  ASSERT_GT(grown, 16u) << "flat latency probes upwards";
+  for (size_t i=0;i<10;++i) {
+    limiter->Sample(4*ms, grown);
+  }
+  ASSERT_LT(limiter->GetLimit(), 16u) << "rising latency shrinks the limit";
+  ASSERT_GE(limiter->GetLimit(), 2u);
+}
+
+TEST(aliSystemThreadingLimiter, window) {
+  Limiter::Ptr limiter = Limiter::Create(Algorithm::AIMD, 1, 10, 2);
+  limiter->SetWindow(4);
+  ASSERT_THROW(limiter->SetWindow(0),      std::exception);
+  ASSERT_THROW(limiter->SetTolerance(0.5), std::exception);
+  ASSERT_THROW(limiter->SetBackoff(1.0),   std::exception);
+  ASSERT_THROW(Limiter::Create(Algorithm::AIMD, 0, 10, 2), std::exception);
+  ASSERT_THROW(Limiter::Create(Algorithm::AIMD, 5, 4,  4), std::exception);
+  for (size_t i=0;i<3;++i) {
+    ASSERT_FALSE(limiter->Sample(ms, 2));
+  }
+  ASSERT_EQ(limiter->NumUpdates(), 0u);
+  ASSERT_TRUE(limiter->Sample(3*ms, 2));
+  ASSERT_EQ(limiter->NumUpdates(), 1u);
+  ASSERT_NEAR(Time::ToSeconds(limiter->GetLatency()), 0.0015, 1e-9) << "a window reports its average latency";
+  ASSERT_EQ(limiter->GetLimit(), 3u);
+}
+
+TEST(aliSystemThreadingLimiter, queue) {
+  Sem::Ptr     sem     = Sem::Create();
+  Queue::Ptr   queue   = Queue::Create("adaptive", sem, 1, nullptr);
+  Limiter::Ptr limiter = Limiter::Create(Algorithm::AIMD, 1, 8, 2);
+  limiter->SetWindow(1);
+  // run times of a few microseconds vary too much for a tight tolerance
+  limiter->SetTolerance(1000);
+  queue->SetAdaptiveConcurrency(limiter);
+  ASSERT_EQ(queue->GetMaxConcurrency(), 2u);
+  ASSERT_EQ(queue->GetLimiter(), limiter);
+  Work::Ptr w1 = Work::Create(nullptr, [](bool &) {});
+  Work::Ptr w2 = Work::Create(nullptr, [](bool &) {});
+  queue->AddWork(w1);
+  queue->AddWork(w2);
+  Work::Ptr n1 = queue->Next();
+  Work::Ptr n2 = queue->Next();
+  ASSERT_TRUE(n1 && n2);
+  queue->Run(n1);
+  ASSERT_EQ(queue->GetMaxConcurrency(), 3u) << "the queue follows the limiter";
+  queue->Run(n2);
+  ASSERT_EQ(limiter->NumUpdates(), 2u);
+  // a fixed maximum concurrency leaves adaptive mode
+  queue->SetMaxConcurrency(5);
+  ASSERT_FALSE(queue->GetLimiter());
+  queue->AddWork(w1);
+  queue->Run(queue->Next());
+  ASSERT_EQ(limiter->NumUpdates(), 2u);
+  ASSERT_EQ(queue->GetMaxConcurrency(), 5u);
+  queue->Freeze();
+  ASSERT_THROW(queue->SetAdaptiveConcurrency(limiter), std::exception);
+}
@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 #include <aliSystem.hpp>
+#include <set>
 #include <vector>
 
 namespace {
@@ -165,3 +166,280 @@ TEST(aliSystemThreadingPool, statsCheck) {
   ASSERT_NEAR(1-Time::ToSeconds(queueTime) / totalRunTime, 0, overheadLimit);
   ASSERT_NEAR(1-Time::ToSeconds(poolTime)  / totalRunTime, 0, overheadLimit);
 }
+
+TEST(aliSystemThreadingPool, workStealing) {
+  using Opt  = aliSystem::Threading::PoolOptions;
+  using IVec = std::vector<size_t>;
+  struct QState {
+    std::mutex lock;
+    size_t     inFlight    = 0;
+    size_t     maxInFlight = 0;
+    IVec       order;
+  };
+  using QSPtr = std::shared_ptr<QState>;
+  QVec               queues;
+  std::vector<QSPtr> states;
+  size_t             numQueues  = 8;
+  size_t             numThreads = 4;
+  size_t             numItems   = 50;
+  Stats::Ptr         queueStats = Stats::Create("work stealing queue stats");
+  Stats::Ptr         workStats  = Stats::Create("work stealing work stats");
+  Pool::Ptr          pool       = Pool::Create("work stealing pool",
+					       numThreads,
+					       nullptr,
+					       Opt(Opt::Scheduling::WORK_STEALING));
+  ASSERT_EQ(pool->GetOptions().GetScheduling(), Opt::Scheduling::WORK_STEALING);
+  for (size_t i=0;i<numQueues;++i) {
+    // the last queue is allowed 2 concurrent work units, the rest 1
+    size_t concurrency = i+1==numQueues ? 2 : 1;
+    queues.push_back(pool->AddQueue("workStealingQueue", concurrency, queueStats));
+    states.push_back(QSPtr(new QState));
+  }
+  for (size_t item=0;item<numItems;++item) {
+    for (size_t i=0;i<numQueues;++i) {
+      QSPtr state = states[i];
+      queues[i]->AddWork(Work::Create(workStats, [=](bool &) {
+	    if (true) {
+	      std::lock_guard<std::mutex> g(state->lock);
+	      ++state->inFlight;
+	      state->maxInFlight = std::max(state->maxInFlight, state->inFlight);
+	      state->order.push_back(item);
+	    }
+	    msleep(1);
+	    std::lock_guard<std::mutex> g(state->lock);
+	    --state->inFlight;
+	  }));
+    }
+  }
+  pool->Flush();
+  ASSERT_EQ(workStats->Count(), numItems*numQueues);
+  for (size_t i=0;i<numQueues;++i) {
+    QSPtr state = states[i];
+    ASSERT_EQ(state->order.size(), numItems) << "queue " << i;
+    if (i+1==numQueues) {
+      ASSERT_LE(state->maxInFlight, 2u) << "queue " << i;
+    } else {
+      ASSERT_EQ(state->maxInFlight, 1u) << "queue " << i;
+      for (size_t item=0;item<numItems;++item) {
+	ASSERT_EQ(state->order[item], item) << "queue " << i << " ran out of order";
+      }
+    }
+  }
+  pool->Stop(true);
+  ASSERT_EQ(pool->GetNumThreads(), 0u);
+}
+
+TEST(aliSystemThreadingPool, workStealingRestart) {
+  using Opt  = aliSystem::Threading::PoolOptions;
+  using IPtr = std::shared_ptr<size_t>;
+  IPtr       runCount(new size_t(0));
+  size_t     numItems  = 20;
+  Stats::Ptr workStats = Stats::Create("work stealing restart stats");
+  Pool::Ptr  pool      = Pool::Create("work stealing restart pool",
+					0,
+					nullptr,
+					Opt(Opt::Scheduling::WORK_STEALING));
+  Queue::Ptr queue     = pool->AddQueue("workStealingRestartQueue", 1, workStats);
+  Work::Ptr  work      = Work::Create(workStats, [=](bool &) {
+      static std::mutex lock;
+      std::lock_guard<std::mutex> g(lock);
+      ++(*runCount);
+    });
+  // work queued before any threads exist waits for the first thread
+  for (size_t i=0;i<numItems;++i) {
+    queue->AddWork(work);
+  }
+  msleep(10);
+  ASSERT_EQ(*runCount, 0u);
+  pool->SetNumThreads(2);
+  pool->Flush();
+  ASSERT_EQ(*runCount, numItems);
+  pool->Stop(true);
+  ASSERT_EQ(pool->GetNumThreads(), 0u);
+  queue->Start();
+  for (size_t i=0;i<numItems;++i) {
+    queue->AddWork(work);
+  }
+  pool->SetNumThreads(3);
+  pool->Flush();
+  ASSERT_EQ(*runCount, 2*numItems);
+  pool->Stop(true);
+}
+
+TEST(aliSystemThreadingPool, weightedFair) {
+  using Opt  = aliSystem::Threading::PoolOptions;
+  using CVec = std::vector<char>;
+  struct Order {
+    std::mutex lock;
+    CVec       ran;
+  };
+  std::shared_ptr<Order> order(new Order);
+  size_t     numLow    = 40;
+  size_t     numHigh   = 120;
+  size_t     numUrgent = 10;
+  Stats::Ptr stats     = Stats::Create("weighted fair stats");
+  Pool::Ptr  pool      = Pool::Create("weighted fair pool",
+				      0,
+				      nullptr,
+				      Opt(Opt::Scheduling::WEIGHTED_FAIR));
+  Queue::Ptr low       = pool->AddQueue("low",    1, stats);
+  Queue::Ptr high      = pool->AddQueue("high",   1, stats, 3);
+  Queue::Ptr urgent    = pool->AddQueue("urgent", 1, stats, 1, 1);
+  QVec       all;
+  pool->GetQueues(all);
+  ASSERT_EQ(all.size(), 3u);
+  ASSERT_EQ(high->GetWeight(), 3u);
+  ASSERT_EQ(urgent->GetPriority(), 1u);
+  ASSERT_THROW(pool->AddQueue("zero", 1, stats, 0), std::exception);
+  auto add = [=](const Queue::Ptr &queue, char id, size_t num) {
+    Work::Ptr work = Work::Create(stats, [=](bool &) {
+	std::lock_guard<std::mutex> g(order->lock);
+	order->ran.push_back(id);
+      });
+    for (size_t i=0;i<num;++i) {
+      queue->AddWork(work);
+    }
+  };
+  // queue everything before the only thread starts so every queue is ready
+  add(low,    'l', numLow);
+  add(high,   'h', numHigh);
+  add(urgent, 'u', numUrgent);
+  pool->SetNumThreads(1);
+  pool->Flush();
+  ASSERT_EQ(order->ran.size(), numLow+numHigh+numUrgent);
+  for (size_t i=0;i<numUrgent;++i) {
+    ASSERT_EQ(order->ran[i], 'u') << "higher priority class should run first";
+  }
+  size_t numHighRan = std::count(order->ran.begin()+numUrgent,
+				 order->ran.begin()+numUrgent+40,
+				 'h');
+  ASSERT_NEAR(numHighRan, 30u, 2) << "weight 3 queue should get 3/4 of the thread";
+  // each queue also dispatched Flush's last work unit, its stop marker
+  // may still be on the way when Flush returns.
+  ASSERT_GE(low   ->NumDispatched(), numLow+1);
+  ASSERT_GE(high  ->NumDispatched(), numHigh+1);
+  ASSERT_GE(urgent->NumDispatched(), numUrgent+1);
+  pool->Stop(true);
+}
+
+TEST(aliSystemThreadingPool, affinity) {
+  using Opt      = aliSystem::Threading::PoolOptions;
+  using Topology = aliSystem::Threading::Topology;
+  struct Seen {
+    std::mutex lock;
+    std::set<int> cpus;
+    std::set<int> nodes;
+    bool          isPoolThread = true;
+  };
+  std::shared_ptr<Seen> seen(new Seen);
+  const int  cpu   = Topology::CurrentCpu();
+  const int  node  = Topology::NodeOfCpu(cpu);
+  Stats::Ptr stats = Stats::Create("affinity stats");
+  Opt        opt;
+  opt.SetAffinity(Opt::Affinity::CPU_SET);
+  ASSERT_THROW(Pool::Create("empty cpu set", 1, nullptr, opt), std::exception);
+  opt.SetAffinity(Opt::Affinity::SINGLE_NODE);
+  opt.SetNode(Topology::NumNodes());
+  ASSERT_THROW(Pool::Create("missing node", 1, nullptr, opt), std::exception);
+  ASSERT_EQ(Pool::CurrentNode(), -1);
+  opt.SetAffinity(Opt::Affinity::CPU_SET);
+  opt.SetCpus({ cpu });
+  Pool::Ptr  pool  = Pool::Create("affinity pool", 2, nullptr, opt);
+  Queue::Ptr queue = pool->AddQueue("affinity queue", 2, stats);
+  Pool::WPtr wPool = pool;
+  Work::Ptr  work  = Work::Create(stats, [=](bool &) {
+      std::lock_guard<std::mutex> g(seen->lock);
+      seen->cpus .insert(Topology::CurrentCpu());
+      seen->nodes.insert(Pool::CurrentNode());
+      seen->isPoolThread = seen->isPoolThread && wPool.lock()->IsPoolThread();
+    });
+  for (size_t i=0;i<20;++i) {
+    queue->AddWork(work);
+  }
+  pool->Flush();
+  ASSERT_FALSE(pool->IsPoolThread());
+  ASSERT_TRUE(seen->isPoolThread);
+  ASSERT_EQ(seen->cpus,  std::set<int>({ cpu  })) << "thread ran outside its CPU set";
+  ASSERT_EQ(seen->nodes, std::set<int>({ node })) << "thread recorded the wrong node";
+  Pool::NodeMap nodes;
+  pool->GetThreadNodes(nodes);
+  ASSERT_EQ(nodes.size(), 1u);
+  ASSERT_GE(nodes[node], 1u);
+  ASSERT_LE(nodes[node], 2u);
+  pool->Stop(true);
+  pool->GetThreadNodes(nodes);
+  ASSERT_TRUE(nodes.empty());
+}
+
+TEST(aliSystemThreadingPool, autoScale) {
+  using Opt = aliSystem::Threading::PoolOptions;
+  Opt opt;
+  opt.SetAutoScale(1, 4);
+  opt.SetScaleInterval(std::chrono::milliseconds(10));
+  opt.SetGrowAfter(2);
+  opt.SetIdleTimeout(std::chrono::milliseconds(200));
+  Stats::Ptr stats = Stats::Create("auto scale stats");
+  Pool::Ptr  pool  = Pool::Create("auto scale pool", 0, nullptr, opt);
+  Queue::Ptr queue = pool->AddQueue("auto scale queue", 8, Stats::Create("auto scale queue stats"));
+  Work::Ptr  work  = Work::Create(stats, [](bool &) { msleep(50); });
+  msleep(50);
+  ASSERT_EQ(pool->GetNumThreads(), 1u) << "should start at the minimum";
+  ASSERT_EQ(pool->GetNumIdle(), 1u);
+  for (size_t i=0;i<40;++i) {
+    queue->AddWork(work);
+  }
+  msleep(300);
+  ASSERT_EQ(pool->GetNumThreads(), 4u) << "backlog should grow the pool to its maximum";
+  ASSERT_EQ(pool->GetGrowStats()->Count(), 3u);
+  pool->SetNumThreads(10);
+  msleep(10);
+  ASSERT_EQ(pool->GetNumThreads(), 4u) << "SetNumThreads should respect the maximum";
+  // let the backlog drain, then the extra threads retire
+  for (size_t i=0;i<100 && stats->Count()<40;++i) {
+    msleep(10);
+  }
+  ASSERT_EQ(stats->Count(), 40u);
+  msleep(400);
+  ASSERT_EQ(pool->GetNumThreads(), 1u) << "idle threads should retire down to the minimum";
+  ASSERT_EQ(pool->GetShrinkStats()->Count(), 3u);
+  ASSERT_GE(pool->GetShrinkStats()->RunTime(), std::chrono::milliseconds(3*200));
+  // the pool still works after shrinking
+  queue->AddWork(work);
+  msleep(100);
+  ASSERT_EQ(stats->Count(), 41u);
+  pool->Stop(true);
+  ASSERT_EQ(pool->GetNumThreads(), 0u);
+}
+
+TEST(aliSystemThreadingPool, autoScaleFromZero) {
+  using Opt = aliSystem::Threading::PoolOptions;
+  Opt::Scheduling schedulings[] = { Opt::Scheduling::ROUND_ROBIN,
+				    Opt::Scheduling::WEIGHTED_FAIR,
+				    Opt::Scheduling::WORK_STEALING };
+  for (Opt::Scheduling scheduling : schedulings) {
+    // the checks are far too slow to be what restarts the pool
+    Opt opt(scheduling);
+    opt.SetAutoScale(0, 2);
+    opt.SetScaleInterval(std::chrono::milliseconds(1000));
+    opt.SetGrowAfter(10);
+    opt.SetIdleTimeout(std::chrono::milliseconds(50));
+    Stats::Ptr stats = Stats::Create("auto scale from zero stats");
+    Pool::Ptr  pool  = Pool::Create("auto scale from zero pool", 1, nullptr, opt);
+    Queue::Ptr queue = pool->AddQueue("auto scale from zero queue", 2, Stats::Create("auto scale from zero queue stats"));
+    Work::Ptr  work  = Work::Create(stats, [](bool &) {});
+    for (size_t i=0;i<100 && pool->GetShrinkStats()->Count()<1;++i) {
+      msleep(10);
+    }
+    ASSERT_EQ(pool->GetNumThreads(), 0u) << "idle threads should retire down to none";
+    ASSERT_EQ(pool->GetShrinkStats()->Count(), 1u);
+    // work submitted after the pool has shrunk to nothing starts a thread
+    queue->AddWork(work);
+    for (size_t i=0;i<20 && stats->Count()<1;++i) {
+      msleep(10);
+    }
+    ASSERT_EQ(stats->Count(), 1u) << "work should not wait for the scaling checks";
+    ASSERT_EQ(pool->GetGrowStats()->Count(), 1u);
+    pool->Stop(true);
+    ASSERT_EQ(pool->GetNumThreads(), 0u);
+  }
+}
@@ -0,0 +1,83 @@
+#include "gtest/gtest.h"
+#include <aliSystem.hpp>
+#include <sstream>
+
+namespace {
+  using Opt        = aliSystem::Threading::PoolOptions;
+  using Scheduling = Opt::Scheduling;
+  using Affinity   = Opt::Affinity;
+}
+
+TEST(aliSystemThreadingPoolOptions, defaults) {
+  Opt opt;
+  ASSERT_EQ(opt.GetScheduling(), Scheduling::ROUND_ROBIN);
+  ASSERT_EQ(opt.GetAffinity(),   Affinity::NONE);
+  ASSERT_TRUE(opt.GetCpus().empty());
+}
+
+TEST(aliSystemThreadingPoolOptions, constructorScheduling) {
+  Opt opt(Scheduling::WORK_STEALING);
+  ASSERT_EQ(opt.GetScheduling(), Scheduling::WORK_STEALING);
+}
+
+TEST(aliSystemThreadingPoolOptions, setGetScheduling) {
+  Opt opt;
+  opt.SetScheduling(Scheduling::WORK_STEALING);
+  ASSERT_EQ(opt.GetScheduling(), Scheduling::WORK_STEALING);
+  opt.SetScheduling(Scheduling::WEIGHTED_FAIR);
+  ASSERT_EQ(opt.GetScheduling(), Scheduling::WEIGHTED_FAIR);
+  opt.SetScheduling(Scheduling::ROUND_ROBIN);
+  ASSERT_EQ(opt.GetScheduling(), Scheduling::ROUND_ROBIN);
+}
+
+TEST(aliSystemThreadingPoolOptions, serialize) {
+  std::ostringstream ss;
+  ss << Opt(Scheduling::WORK_STEALING);
+  ASSERT_NE(ss.str().find("work stealing"), std::string::npos) << ss.str();
+  ss.str("");
+  ss << Scheduling::WEIGHTED_FAIR;
+  ASSERT_EQ(ss.str(), "weighted fair");
+}
+
+TEST(aliSystemThreadingPoolOptions, setGetAffinity) {
+  Opt opt;
+  opt.SetAffinity(Affinity::CPU_SET);
+  opt.SetCpus({0, 2});
+  ASSERT_EQ(opt.GetAffinity(), Affinity::CPU_SET);
+  ASSERT_EQ(opt.GetCpus().size(), 2u);
+  ASSERT_EQ(opt.GetCpus()[1], 2);
+  opt.SetAffinity(Affinity::SINGLE_NODE);
+  opt.SetNode(1);
+  ASSERT_EQ(opt.GetAffinity(), Affinity::SINGLE_NODE);
+  ASSERT_EQ(opt.GetNode(), 1);
+  std::ostringstream ss;
+  ss << opt;
+  ASSERT_NE(ss.str().find("single node"), std::string::npos) << ss.str();
+  ss.str("");
+  ss << Affinity::SPREAD_NODES;
+  ASSERT_EQ(ss.str(), "spread nodes");
+}
+
+TEST(aliSystemThreadingPoolOptions, autoScale) {
+  Opt opt;
+  ASSERT_FALSE(opt.IsAutoScale());
+  opt.SetAutoScale(2, 8);
+  ASSERT_TRUE(opt.IsAutoScale());
+  ASSERT_EQ(opt.GetMinThreads(), 2u);
+  ASSERT_EQ(opt.GetMaxThreads(), 8u);
+  ASSERT_THROW(opt.SetAutoScale(3, 2), std::exception);
+  ASSERT_THROW(opt.SetGrowAfter(0), std::exception);
+  ASSERT_THROW(opt.SetIdleTimeout(aliSystem::Time::Dur::zero()), std::exception);
+  opt.SetGrowAfter(3);
+  ASSERT_EQ(opt.GetGrowAfter(), 3u);
+  opt.SetAutoScale(0, 0);
+  ASSERT_FALSE(opt.IsAutoScale());
+}
+
+TEST(aliSystemThreadingPoolOptions, spinBudget) {
+  Opt opt;
+  ASSERT_EQ(opt.GetSpinBudget(), aliSystem::Time::Dur::zero());
+  opt.SetSpinBudget(std::chrono::microseconds(20));
+  ASSERT_EQ(opt.GetSpinBudget(), std::chrono::microseconds(20));
+  ASSERT_THROW(opt.SetSpinBudget(-std::chrono::microseconds(1)), std::exception);
+}
@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 #include <aliSystem.hpp>
+#include <thread>
 #include <vector>
 
 namespace {
@@ -217,3 +218,331 @@ TEST_F(DetailedTest, runTime) {
 	      double(cnt*usDelay)/1000/1000, 0.050);
 }
 
+TEST_F(DetailedTest, addWorkBatch) {
+  std::shared_ptr<size_t> posts(new size_t(0));
+  Queue::WorkVec          works(10, work);
+  Queue::Ptr              batchQueue = Queue::Create(name+" batch queue",
+						     [=](const Queue::Ptr &) { ++(*posts); },
+						     initialMaxConcurrency,
+						     queueStats);
+  batchQueue->AddWorkBatch(works);
+  ASSERT_EQ(batchQueue->NumPending(), works.size());
+  ASSERT_EQ(*posts, initialMaxConcurrency) << "released beyond the concurrency limit";
+  for (size_t i=0;i<works.size();++i) {
+    Work::Ptr next = batchQueue->Next();
+    ASSERT_TRUE(next);
+    batchQueue->Run(next);
+  }
+  ASSERT_EQ(*runCount, works.size());
+  ASSERT_EQ(*posts, works.size());
+  ASSERT_FALSE(batchQueue->IsBusy());
+  works.push_back(Work::Ptr());
+  ASSERT_THROW(batchQueue->AddWorkBatch(works), std::exception);
+  ASSERT_EQ(batchQueue->NumPending(), 0u) << "nothing queued from a bad batch";
+}
+
+TEST(aliSystemThreadingQueue, concurrentProducers) {
+  using TVec = std::vector<std::thread>;
+  const size_t numProducers = 4;
+  const size_t numItems     = 2000;
+  std::shared_ptr<std::atomic<size_t>> inFlight(new std::atomic<size_t>(0));
+  std::shared_ptr<std::atomic<size_t>> maxInFlight(new std::atomic<size_t>(0));
+  Pool::Ptr  pool      = Pool::Create("queueProducerPool", 4);
+  Stats::Ptr workStats = Stats::Create("queue producer work stats");
+  Queue::Ptr queue     = pool->AddQueue("queueProducerQueue", 1, Stats::Create("queue producer stats"));
+  Work::Ptr  work      = Work::Create(workStats, [=](bool &) {
+      size_t cur = ++(*inFlight);
+      if (cur>*maxInFlight) {
+	*maxInFlight = cur;
+      }
+      --(*inFlight);
+    });
+  TVec producers;
+  for (size_t p=0;p<numProducers;++p) {
+    producers.push_back(std::thread([=]() {
+	  for (size_t i=0;i<numItems;++i) {
+	    queue->AddWork(work);
+	  }
+	}));
+  }
+  for (TVec::iterator it=producers.begin(); it!=producers.end(); ++it) {
+    it->join();
+  }
+  pool->Flush();
+  ASSERT_EQ(workStats->Count(), numProducers*numItems);
+  ASSERT_EQ(*maxInFlight, 1u);
+  pool->Stop(true);
+}
+
+TEST(aliSystemThreadingQueue, capacityReject) {
+  Sem::Ptr   sem   = Sem::Create();
+  Queue::Ptr queue = Queue::Create("reject", sem, 1, nullptr, 2, Queue::Overflow::REJECT);
+  Work::Ptr  work  = Work::Create(nullptr, [](bool &) {});
+  ASSERT_EQ(queue->GetCapacity(), 2u);
+  ASSERT_EQ(queue->GetOverflow(), Queue::Overflow::REJECT);
+  queue->AddWork(work);
+  queue->AddWork(work);
+  ASSERT_THROW(queue->AddWork(work), std::exception);
+  ASSERT_THROW(queue->AddWorkBatch(Queue::WorkVec(1, work)), std::exception);
+  ASSERT_EQ(queue->NumPending(), 2u);
+  ASSERT_EQ(queue->NumRejected(), 2u);
+  ASSERT_EQ(queue->GetHighWaterMark(), 2u);
+  // running work does not count against the capacity
+  Work::Ptr next = queue->Next();
+  ASSERT_TRUE(next);
+  queue->AddWork(work);
+  ASSERT_THROW(queue->AddWork(work), std::exception);
+  queue->Run(next);
+  queue->Clear();
+  ASSERT_EQ(queue->GetHighWaterMark(), 2u);
+  queue->ResetHighWaterMark();
+  ASSERT_EQ(queue->GetHighWaterMark(), 0u);
+  queue->SetCapacity(0, Queue::Overflow::REJECT);
+  queue->AddWorkBatch(Queue::WorkVec(10, work));
+  ASSERT_EQ(queue->NumPending(), 10u) << "unbounded";
+  ASSERT_EQ(queue->GetHighWaterMark(), 10u) << "derived from the pending work";
+  // bounding the queue again counts the work added while unbounded
+  queue->SetCapacity(12, Queue::Overflow::REJECT);
+  queue->AddWorkBatch(Queue::WorkVec(2, work));
+  ASSERT_THROW(queue->AddWork(work), std::exception);
+  ASSERT_EQ(queue->NumPending(), 12u);
+}
+
+TEST(aliSystemThreadingQueue, tryAddWorkBatch) {
+  Sem::Ptr       sem   = Sem::Create();
+  Queue::Ptr     queue = Queue::Create("try", sem, 1, nullptr, 5, Queue::Overflow::BLOCK);
+  Queue::WorkVec works(6, Work::Create(nullptr, [](bool &) {}));
+  // takes the leading work it has room for, without blocking
+  ASSERT_EQ(queue->TryAddWorkBatch(works), 5u);
+  ASSERT_EQ(queue->NumPending(), 5u);
+  ASSERT_EQ(queue->TryAddWorkBatch(works), 0u);
+  ASSERT_EQ(queue->NumBlocked(),  0u);
+  ASSERT_EQ(queue->NumRejected(), 0u) << "the rest is left to the caller";
+  queue->Run(queue->Next());
+  ASSERT_EQ(queue->TryAddWorkBatch(works), 1u);
+  queue->SetCapacity(0, Queue::Overflow::BLOCK);
+  ASSERT_EQ(queue->TryAddWorkBatch(works), 6u);
+  ASSERT_EQ(queue->NumPending(), 11u);
+}
+
+TEST(aliSystemThreadingQueue, capacityDropOldest) {
+  Sem::Ptr            sem   = Sem::Create();
+  Queue::Ptr          queue = Queue::Create("drop", sem, 1, nullptr, 3, Queue::Overflow::DROP_OLDEST);
+  std::vector<size_t> ran;
+  for (size_t i=0;i<5;++i) {
+    queue->AddWork(Work::Create(nullptr, [&ran, i](bool &) { ran.push_back(i); }));
+  }
+  ASSERT_EQ(queue->NumPending(), 3u);
+  ASSERT_EQ(queue->NumDropped(), 2u);
+  while (Work::Ptr work = queue->Next()) {
+    queue->Run(work);
+  }
+  ASSERT_EQ(ran, std::vector<size_t>({2, 3, 4}));
+  ASSERT_FALSE(queue->IsBusy());
+}
+
+TEST(aliSystemThreadingQueue, capacityRunOnCaller) {
+  Sem::Ptr        sem    = Sem::Create();
+  Stats::Ptr      qStats = Stats::Create("run on caller queue");
+  Queue::Ptr      queue  = Queue::Create("caller", sem, 1, qStats, 1, Queue::Overflow::RUN_ON_CALLER);
+  std::thread::id ranOn;
+  Work::Ptr       work   = Work::Create(nullptr, [&ranOn](bool &) { ranOn = std::this_thread::get_id(); });
+  queue->AddWork(work);
+  ASSERT_EQ(ranOn, std::thread::id()) << "queued";
+  queue->AddWork(work);
+  ASSERT_EQ(ranOn, std::this_thread::get_id()) << "ran on the caller";
+  ASSERT_EQ(queue->NumRanOnCaller(), 1u);
+  ASSERT_EQ(queue->NumPending(), 1u);
+  ASSERT_EQ(qStats->Count(), 1u);
+}
+
+TEST(aliSystemThreadingQueue, capacityBlock) {
+  Pool::Ptr           pool  = Pool::Create("block", 1);
+  Queue::Ptr          queue = pool->AddQueue("block", 1, nullptr, 1, 0, 2, Queue::Overflow::BLOCK);
+  std::atomic<size_t> ran(0);
+  std::atomic<bool>   release(false);
+  Work::Ptr           hold  = Work::Create(nullptr, [&](bool &) {
+    while (!release) {
+      std::this_thread::yield();
+    }
+    ++ran;
+  });
+  Work::Ptr           work  = Work::Create(nullptr, [&](bool &) { ++ran; });
+  queue->AddWork(hold);
+  while (queue->CurrentConcurrency()==0) {
+    std::this_thread::yield();
+  }
+  queue->AddWork(work);
+  queue->AddWork(work);
+  std::atomic<bool> added(false);
+  std::thread producer([&]() {
+    queue->AddWork(work);
+    added = true;
+  });
+  usleep(50000);
+  ASSERT_FALSE(added) << "producer waits while the queue is full";
+  ASSERT_EQ(queue->NumPending(), 2u);
+  release = true;
+  producer.join();
+  ASSERT_TRUE(added);
+  ASSERT_EQ(queue->NumBlocked(), 1u);
+  while (queue->IsBusy()) {
+    std::this_thread::yield();
+  }
+  ASSERT_EQ(ran, 4u);
+  ASSERT_LE(queue->GetHighWaterMark(), 2u);
+  pool->Stop(true);
+}
+
+TEST(aliSystemThreadingQueue, expired) {
+  Sem::Ptr            sem     = Sem::Create();
+  Queue::Ptr          queue   = Queue::Create("expiry", sem, 1, nullptr);
+  Time::TP            past    = Time::Now()-std::chrono::seconds(1);
+  Time::TP            future  = Time::Now()+std::chrono::seconds(60);
+  std::vector<size_t> ran;
+  std::vector<size_t> expired;
+  size_t              idle    = 0;
+  Listener::Ptr       lPtr    = Listener::Create("expiry", [&](const Queue::WPtr &) { ++idle; });
+  queue->OnIdle()->Register(lPtr, true);
+  for (size_t i=0;i<6;++i) {
+    auto run    = [&ran, i](bool &) { ran.push_back(i); };
+    auto expire = [&expired, i]() { expired.push_back(i); };
+    if (i==0) {
+      queue->AddWork(Work::Create(nullptr, run));
+    } else {
+      queue->AddWork(Work::Create(nullptr, run, i%2 ? past : future, expire));
+    }
+  }
+  while (Work::Ptr work = queue->Next()) {
+    queue->Run(work);
+  }
+  ASSERT_EQ(ran,     std::vector<size_t>({0, 2, 4}));
+  ASSERT_EQ(expired, std::vector<size_t>({1, 3, 5}));
+  ASSERT_EQ(queue->NumExpired(), 3u);
+  ASSERT_EQ(queue->NumDispatched(), 3u);
+  ASSERT_FALSE(queue->IsBusy());
+  ASSERT_EQ(idle, 1u) << "the queue went idle once, when the last work expired";
+  // only expired work was pending, the queue can still release new work
+  queue->AddWork(Work::Create(nullptr, [&ran](bool &) { ran.push_back(6); }));
+  Work::Ptr work = queue->Next();
+  ASSERT_TRUE(work);
+  queue->Run(work);
+  ASSERT_EQ(ran.back(), 6u);
+}
+
+TEST(aliSystemThreadingQueue, keyed) {
+  Sem::Ptr            sem   = Sem::Create();
+  Queue::Ptr          queue = Queue::Create("keyed", sem, 4, nullptr);
+  std::vector<size_t> ran;
+  auto keyed = [&ran](uint64_t key, size_t id) {
+    Work::Ptr rtn = Work::Create(nullptr, [&ran, id](bool &) { ran.push_back(id); });
+    rtn->SetKey(key);
+    return rtn;
+  };
+  // ids are key*10 + sequence within the key
+  queue->AddWork(keyed(1, 11));
+  queue->AddWork(keyed(1, 12));
+  queue->AddWork(keyed(2, 21));
+  queue->AddWork(keyed(1, 13));
+  queue->AddWorkBatch(Queue::WorkVec({ keyed(2, 22), keyed(3, 31) }));
+  ASSERT_EQ(queue->NumPending(),    6u);
+  ASSERT_EQ(queue->NumActiveKeys(), 3u);
+  // one work unit per key is dispatched, although the concurrency allows four
+  Work::Ptr w1 = queue->Next();
+  Work::Ptr w2 = queue->Next();
+  Work::Ptr w3 = queue->Next();
+  ASSERT_TRUE(w1 && w2 && w3);
+  ASSERT_FALSE(queue->Next()) << "dispatched work while its key was active";
+  queue->Run(w1);
+  Work::Ptr w4 = queue->Next();
+  ASSERT_TRUE(w4);
+  queue->Run(w3);
+  queue->Run(w2);
+  queue->Run(w4);
+  while (Work::Ptr work = queue->Next()) {
+    queue->Run(work);
+  }
+  ASSERT_EQ(ran, std::vector<size_t>({11, 31, 21, 12, 22, 13}));
+  ASSERT_EQ(queue->NumActiveKeys(), 0u);
+  ASSERT_FALSE(queue->IsBusy());
+
+  // keys are retired as they drain, so many distinct keys leave no state behind
+  const size_t numKeys = 100000;
+  ran.clear();
+  for (size_t i=0;i<numKeys;++i) {
+    queue->AddWork(keyed(i, i));
+  }
+  ASSERT_EQ(queue->NumActiveKeys(), numKeys);
+  while (Work::Ptr work = queue->Next()) {
+    queue->Run(work);
+  }
+  ASSERT_EQ(ran.size(), numKeys);
+  ASSERT_EQ(queue->NumActiveKeys(), 0u);
+}
+
+TEST(aliSystemThreadingQueue, keyedClear) {
+  Sem::Ptr   sem   = Sem::Create();
+  Queue::Ptr queue = Queue::Create("keyedClear", sem, 2, nullptr);
+  size_t     ran   = 0;
+  for (size_t i=0;i<6;++i) {
+    Work::Ptr work = Work::Create(nullptr, [&ran](bool &) { ++ran; });
+    work->SetKey(i%2);
+    queue->AddWork(work);
+  }
+  Work::Ptr running = queue->Next();
+  ASSERT_TRUE(running);
+  queue->Clear();
+  ASSERT_EQ(queue->NumPending(),    0u);
+  ASSERT_EQ(queue->NumActiveKeys(), 1u) << "the executing work's key stays active";
+  // new work for the executing key waits for it
+  Work::Ptr work = Work::Create(nullptr, [&ran](bool &) { ++ran; });
+  work->SetKey(running->GetKey());
+  queue->AddWork(work);
+  ASSERT_FALSE(queue->Next());
+  queue->Run(running);
+  work = queue->Next();
+  ASSERT_TRUE(work);
+  queue->Run(work);
+  ASSERT_EQ(ran, 2u);
+  ASSERT_EQ(queue->NumActiveKeys(), 0u);
+  ASSERT_FALSE(queue->IsBusy());
+}
+
+TEST(aliSystemThreadingQueue, keyedPool) {
+  using Seq = std::vector<size_t>;
+  const size_t numKeys  = 16;
+  const size_t numItems = 200;
+  Pool::Ptr                        pool    = Pool::Create("keyedPool", 8);
+  Queue::Ptr                       queue   = pool->AddQueue("keyedPoolQueue", 8, Stats::Create("keyed pool stats"));
+  std::vector<Seq>                 seqs(numKeys);
+  std::vector<std::atomic<bool> >  running(numKeys);
+  std::atomic<size_t>              overlaps(0);
+  for (size_t k=0;k<numKeys;++k) {
+    running[k] = false;
+  }
+  for (size_t i=0;i<numItems;++i) {
+    for (size_t k=0;k<numKeys;++k) {
+      Work::Ptr work = Work::Create(nullptr, [&, k, i](bool &) {
+	  if (running[k].exchange(true)) {
+	    ++overlaps;
+	  }
+	  seqs[k].push_back(i);
+	  running[k] = false;
+	});
+      work->SetKey(k);
+      queue->AddWork(std::move(work));
+    }
+  }
+  while (queue->IsBusy()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  pool->Stop(true);
+  ASSERT_EQ(overlaps, 0u) << "work with the same key ran concurrently";
+  for (size_t k=0;k<numKeys;++k) {
+    ASSERT_EQ(seqs[k].size(), numItems);
+    for (size_t i=0;i<numItems;++i) {
+      ASSERT_EQ(seqs[k][i], i) << "key " << k << " ran out of order";
+    }
+  }
+  ASSERT_EQ(queue->NumActiveKeys(), 0u);
+}
@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 #include <aliSystem.hpp>
+#include <atomic>
 #include <vector>
 
 namespace {
@@ -50,3 +51,105 @@ TEST(aliSystemThreadingScheduler, general) {
 		ms) << " expected-d0 vs triggered-d0 i=" << i;
   }
 }
+
+TEST(aliSystemThreadingScheduler, batchExpiry) {
+  const size_t numItems  = 10000;
+  Pool::Ptr    pool      = Pool::Create("testSchedulingBatchPool", 2);
+  Stats::Ptr   workStats = Stats::Create("scheduler batch test stats");
+  Queue::Ptr   queue     = pool->AddQueue("testSchedulingBatchQueue",
+					  2,
+					  Stats::Create("scheduler batch queue stats"));
+  Work::Ptr    work      = Work::Create(workStats, [](bool &) {});
+  Time::TP     target    = Time::Now() + std::chrono::milliseconds(100);
+  for (size_t i=0;i<numItems;++i) {
+    // spread over a few ticks, half sharing one expiry
+    Time::TP tp = i%2 ? target : target + std::chrono::microseconds(i%1000);
+    Scheduler::Schedule(queue, tp, work);
+  }
+  usleep(50*1000);
+  ASSERT_EQ(workStats->Count(), 0u) << "work released early";
+  usleep(500*1000);
+  pool->Flush();
+  ASSERT_EQ(workStats->Count(), numItems);
+}
+
+TEST(aliSystemThreadingScheduler, cancel) {
+  Pool::Ptr  pool      = Pool::Create("testSchedulingCancelPool", 1);
+  Stats::Ptr workStats = Stats::Create("scheduler cancel test stats");
+  Queue::Ptr queue     = pool->AddQueue("testSchedulingCancelQueue",
+					1,
+					Stats::Create("scheduler cancel queue stats"));
+  Work::Ptr  work      = Work::Create(workStats, [](bool &) {});
+  Time::TP   target    = Time::Now() + std::chrono::milliseconds(100);
+  Scheduler::Timer none;
+  ASSERT_FALSE(none.Cancel());
+  Scheduler::Timer cancelled = Scheduler::Schedule(queue, target, work);
+  Scheduler::Timer kept      = Scheduler::Schedule(queue, target, work);
+  work.reset();
+  ASSERT_TRUE (cancelled.IsPending());
+  ASSERT_TRUE (cancelled.Cancel());
+  ASSERT_FALSE(cancelled.IsPending());
+  ASSERT_FALSE(cancelled.Cancel()) << "cancelled twice";
+  usleep(300*1000);
+  pool->Flush();
+  ASSERT_EQ(workStats->Count(), 1u);
+  ASSERT_FALSE(kept.IsPending());
+  ASSERT_FALSE(kept.Cancel()) << "cancelled after being injected";
+  // a cancelled timer does not hold on to its work
+  Work::Ptr  late  = Work::Create(workStats, [](bool &) {});
+  std::weak_ptr<Work> wLate = late;
+  Scheduler::Timer timer = Scheduler::Schedule(queue, Time::Now() + std::chrono::seconds(60), late);
+  late.reset();
+  ASSERT_FALSE(wLate.expired());
+  ASSERT_TRUE(timer.Cancel());
+  ASSERT_TRUE(wLate.expired());
+}
+
+TEST(aliSystemThreadingScheduler, fullQueue) {
+  using Semaphore = aliSystem::Threading::Semaphore;
+  Pool::Ptr  pool      = Pool::Create("testSchedulingFullPool", 1);
+  Stats::Ptr workStats = Stats::Create("scheduler full test stats");
+  Queue::Ptr reject    = pool->AddQueue("testSchedulingRejectQueue", 1,
+					Stats::Create("scheduler reject queue stats"),
+					1, 0, 5, Queue::Overflow::REJECT);
+  Queue::Ptr block     = pool->AddQueue("testSchedulingBlockQueue", 1,
+					Stats::Create("scheduler block queue stats"),
+					1, 0, 1, Queue::Overflow::BLOCK);
+  Queue::Ptr open      = pool->AddQueue("testSchedulingOpenQueue", 1,
+					Stats::Create("scheduler open queue stats"));
+  Semaphore  gate;
+  Semaphore  ran;
+  Work::Ptr  work      = Work::Create(workStats, [](bool &) {});
+  // occupy the pool's only thread, then fill the blocking queue
+  open ->AddWork(Work::Create(nullptr, [&](bool &) { gate.Wait(); }));
+  usleep(20*1000);
+  block->AddWork(work);
+  // six timers for a queue with room for five, two for a full queue
+  Time::TP target = Time::Now() + std::chrono::milliseconds(50);
+  for (size_t i=0;i<6;++i) {
+    Scheduler::Schedule(reject, target, work);
+  }
+  Scheduler::Schedule(block, target, work);
+  Scheduler::Schedule(block, target, work);
+  Scheduler::Schedule(open,  target, Work::Create(nullptr, [&](bool &) { ran.Post(); }));
+  // what fits is added, the rest waits without stalling the scheduler
+  usleep(300*1000);
+  ASSERT_EQ(reject->NumPending(),  5u);
+  ASSERT_EQ(block ->NumPending(),  1u);
+  ASSERT_EQ(reject->NumRejected(), 0u);
+  ASSERT_EQ(block ->NumBlocked(),  0u);
+  // other timers are not held up
+  std::atomic<bool> other(false);
+  Scheduler::Schedule(Time::Now(), Work::Create(nullptr, [&](bool &) { other = true; }));
+  usleep(100*1000);
+  ASSERT_TRUE(other);
+  // once the queues drain, none of the timers is lost
+  gate.Post();
+  ASSERT_EQ(ran.TimedWait(std::chrono::seconds(5)), 0);
+  Time::TP giveUp = Time::Now() + std::chrono::seconds(5);
+  while (workStats->Count()<9 && Time::Now()<giveUp) {
+    usleep(10*1000);
+  }
+  ASSERT_EQ(workStats->Count(), 9u);
+  ASSERT_EQ(reject->NumRejected(), 0u);
+}
@@ -1,5 +1,8 @@
 #include "gtest/gtest.h"
 #include <aliSystem.hpp>
+#include <cerrno>
+#include <thread>
+#include <vector>
 
 namespace {
   using Semaphore = aliSystem::Threading::Semaphore;
@@ -35,3 +38,62 @@ TEST(aliSystemSemaphore, DoNothing) {
 	      Time::ToSeconds(ms)) << "Confirming wait";
 }
 
+
+TEST(aliSystemSemaphore, concurrentTimedWait) {
+  // each thread waits a different amount of time, a shared timespec
+  // would mix the deadlines up.
+  const size_t              numThreads = 8;
+  std::chrono::milliseconds ms(1);
+  Semaphore                 sem;
+  std::vector<double>       waited(numThreads);
+  std::vector<std::thread>  threads;
+  for (size_t i=0;i<numThreads;++i) {
+    threads.push_back(std::thread([&, i]() {
+	  Time::TP start = Time::Now();
+	  int      rc    = sem.TimedWait(start + (i+1)*20*ms);
+	  int      err   = errno;
+	  waited[i] = Time::ToSeconds(Time::Now()-start);
+	  EXPECT_NE(rc, 0);
+	  EXPECT_EQ(err, ETIMEDOUT);
+	}));
+  }
+  for (size_t i=0;i<numThreads;++i) {
+    threads[i].join();
+  }
+  for (size_t i=0;i<numThreads;++i) {
+    EXPECT_NEAR(waited[i], Time::ToSeconds((i+1)*20*ms), Time::ToSeconds(5*ms)) << "thread " << i;
+  }
+  ASSERT_NE(sem.TimedWait(Time::Dur(10*ms)), 0);
+  sem.Post();
+  ASSERT_EQ(sem.TimedWait(Time::Dur(10*ms)), 0);
+}
+
+TEST(aliSystemSemaphore, spinThenPark) {
+  const size_t numPosts = 10000;
+  Semaphore    sem(0, std::chrono::milliseconds(1));
+  Semaphore    plain;
+  ASSERT_EQ(sem  .GetSpinBudget(), std::chrono::milliseconds(1));
+  ASSERT_EQ(plain.GetSpinBudget(), Time::Dur::zero());
+  std::thread consumer([&]() {
+      for (size_t i=0;i<numPosts;++i) {
+	sem.Wait();
+      }
+    });
+  for (size_t i=0;i<numPosts;++i) {
+    sem.Post();
+  }
+  consumer.join();
+  ASSERT_LE(sem.NumSpinAcquired()+sem.NumParked(), numPosts) << "waits that found a count right away neither spin nor park";
+  ASSERT_NE(sem.TimedWait(Time::Dur(std::chrono::milliseconds(5))), 0) << "every post consumed";
+  // a waiter with nothing to take ends up parked
+  size_t parked = sem.NumParked();
+  std::thread waiter([&]() { sem.Wait(); });
+  usleep(20*1000);
+  sem.Post();
+  waiter.join();
+  ASSERT_GT(sem.NumParked(), parked);
+  // with nothing to spin for, the plain semaphore never spins
+  plain.Post();
+  plain.Wait();
+  ASSERT_EQ(plain.NumSpinAcquired(), 0u);
+}
@@ -0,0 +1,128 @@
+#include "gtest/gtest.h"
+#include <aliSystem.hpp>
+#include <array>
+#include <atomic>
+#include <thread>
+
+namespace {
+  using Pool      = aliSystem::Threading::Pool;
+  using Queue     = aliSystem::Threading::Queue;
+  using Semaphore = aliSystem::Threading::Semaphore;
+  using Stats     = aliSystem::Stats;
+  using Task      = aliSystem::Threading::Task;
+  using Work      = aliSystem::Threading::Work;
+  using IPtr      = std::shared_ptr<std::atomic<size_t>>;
+
+  void Increment(bool &requeue) {
+    requeue = true;
+  }
+}
+
+TEST(aliSystemThreadingTask, storage) {
+  IPtr count(new std::atomic<size_t>(0));
+  bool requeue = false;
+  Task small([=](bool &) { ++(*count); });
+  ASSERT_TRUE(small);
+  ASSERT_TRUE(small.IsInline());
+  small(requeue);
+  ASSERT_EQ(*count, 1u);
+
+  std::array<char, Task::INLINE_SIZE+1> big;
+  big.fill(1);
+  Task large([=](bool &) { *count += big[Task::INLINE_SIZE]; });
+  ASSERT_TRUE(large);
+  ASSERT_FALSE(large.IsInline()) << "capture larger than the inline storage";
+  large(requeue);
+  ASSERT_EQ(*count, 2u);
+
+  Task fnPtr(Increment);
+  ASSERT_TRUE(fnPtr.IsInline());
+  fnPtr(requeue);
+  ASSERT_TRUE(requeue);
+}
+
+TEST(aliSystemThreadingTask, empty) {
+  bool requeue = false;
+  void (*nullFn)(bool &) = nullptr;
+  Task none;
+  ASSERT_FALSE(none);
+  ASSERT_FALSE(Task(nullptr));
+  ASSERT_FALSE(Task(nullFn));
+  ASSERT_FALSE(Task(Work::WorkFn()));
+  ASSERT_THROW(none(requeue), std::exception);
+  ASSERT_THROW(Work::Create(nullptr, Work::WorkFn()), std::exception);
+  ASSERT_THROW(Work::Create(nullptr, Task()),         std::exception);
+}
+
+TEST(aliSystemThreadingTask, move) {
+  IPtr count(new std::atomic<size_t>(0));
+  bool requeue = false;
+  Task a([=](bool &) { ++(*count); });
+  ASSERT_EQ(count.use_count(), 2);
+  Task b(std::move(a));
+  ASSERT_FALSE(a);
+  ASSERT_TRUE(b.IsInline());
+  ASSERT_EQ(count.use_count(), 2) << "moving a task does not copy its captures";
+  b(requeue);
+  Task c;
+  c = std::move(b);
+  ASSERT_FALSE(b);
+  c(requeue);
+  ASSERT_EQ(*count, 2u);
+  c.Reset();
+  ASSERT_FALSE(c);
+  ASSERT_EQ(count.use_count(), 1) << "reset releases the captures";
+}
+
+TEST(aliSystemThreadingTask, noAllocations) {
+  // once warm, work comes from the work free list, its function fits the
+  // task's inline storage and the queue's pending list recycles its
+  // segments, so neither obtains more memory.
+  const size_t   num   = 10000;
+  IPtr           count(new std::atomic<size_t>(0));
+  Stats::Ptr     stats = Stats::Create("task allocation testing");
+  Semaphore::Ptr sem   = Semaphore::Create();
+  Queue::Ptr     queue = Queue::Create("task allocation testing", sem, 1, nullptr);
+  auto           fn    = [count](bool &) { ++(*count); };
+  auto           cycle = [&](size_t n) {
+    for (size_t i=0;i<n;++i) {
+      queue->AddTask(stats, fn);
+      queue->Run(queue->Next());
+    }
+  };
+  ASSERT_TRUE(Task(fn).IsInline());
+  cycle(num);
+  uint64_t works    = Work::NumAllocated();
+  uint64_t segments = queue->NumSegmentsAllocated();
+  ASSERT_GT(works, 0u);
+  cycle(num);
+  ASSERT_EQ(*count, 2*num);
+  ASSERT_EQ(Work::NumAllocated(), works) << "submit to run on a single thread";
+  ASSERT_EQ(queue->NumSegmentsAllocated(), segments);
+
+  // work created on this thread and released on a pool thread, in
+  // bursts that fit a work list segment (a deeper backlog grows the
+  // queue's pending list).
+  Pool::Ptr  pool  = Pool::Create("task allocation testing", 1);
+  Queue::Ptr pQueue = pool->AddQueue("task allocation testing", 1, nullptr);
+  auto       cross = [&](size_t n) {
+    size_t target = *count+n;
+    for (size_t i=0;i<n;++i) {
+      pQueue->AddTask(stats, fn);
+    }
+    while (*count<target || pQueue->IsBusy()) {
+      std::this_thread::yield();
+    }
+  };
+  for (size_t i=0;i<num/50;++i) {
+    cross(50);
+  }
+  works    = Work::NumAllocated();
+  segments = pQueue->NumSegmentsAllocated();
+  for (size_t i=0;i<num/50;++i) {
+    cross(50);
+  }
+  ASSERT_EQ(Work::NumAllocated(), works) << "submit to run across threads";
+  ASSERT_EQ(pQueue->NumSegmentsAllocated(), segments);
+  pool->Stop(true);
+}
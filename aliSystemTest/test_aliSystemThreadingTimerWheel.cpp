@@ -0,0 +1,125 @@
+#include "gtest/gtest.h"
+#include <aliSystem.hpp>
+#include <vector>
+
+namespace {
+  using Time       = aliSystem::Time;
+  using Stats      = aliSystem::Stats;
+  using Work       = aliSystem::Threading::Work;
+  using TimerWheel = aliSystem::Threading::TimerWheel;
+  using Entry      = TimerWheel::Entry;
+  using EntryList  = TimerWheel::EntryList;
+  using EVec       = std::vector<Entry::Ptr>;
+
+  const Time::Dur tick = std::chrono::microseconds(1);
+
+  Entry::Ptr MakeEntry(const Time::TP &epoch, uint64_t ticks) {
+    static Stats::Ptr stats = Stats::Create("timer wheel testing");
+    Entry::Ptr rtn(new Entry);
+    rtn->targetTime = epoch + ticks*tick;
+    rtn->targetWork = Work::Create(stats, [](bool &) {});
+    return rtn;
+  }
+}
+
+TEST(aliSystemThreadingTimerWheel, expiry) {
+  // ticks chosen to land on each level, on slot boundaries and
+  // beyond the span of the wheel.
+  const uint64_t span    = uint64_t(1) << (TimerWheel::BITS*TimerWheel::LEVELS);
+  const uint64_t ticks[] = { 1, 2, 255, 256, 257, 300, 511, 65535, 65536, 70000,
+			     (1u<<24)+5, span-1, span+7, 2*span+3 };
+  Time::TP   epoch;
+  TimerWheel wheel(epoch, tick);
+  EVec       entries;
+  for (size_t i=0;i<sizeof(ticks)/sizeof(ticks[0]);++i) {
+    entries.push_back(MakeEntry(epoch, ticks[i]));
+    wheel.Insert(entries.back());
+  }
+  ASSERT_EQ(wheel.Size(), entries.size());
+  size_t   next = 0;
+  Time::TP tp;
+  while (wheel.NextTime(tp)) {
+    EntryList expired;
+    // stop just short of the next event, nothing may expire
+    wheel.Advance(tp-tick, expired);
+    ASSERT_TRUE(expired.empty());
+    wheel.Advance(tp, expired);
+    for (EntryList::iterator it=expired.begin(); it!=expired.end(); ++it) {
+      ASSERT_LT(next, entries.size());
+      ASSERT_EQ(it->get(), entries[next].get()) << "entry " << next << " out of order";
+      ASSERT_EQ(wheel.CurrentTick(), ticks[next]) << "entry " << next << " expired in the wrong tick";
+      ++next;
+    }
+  }
+  ASSERT_EQ(next, entries.size());
+  ASSERT_EQ(wheel.Size(), 0u);
+}
+
+TEST(aliSystemThreadingTimerWheel, sameTick) {
+  Time::TP   epoch;
+  TimerWheel wheel(epoch, tick);
+  EVec       entries;
+  EntryList  expired;
+  for (size_t i=0;i<100;++i) {
+    entries.push_back(MakeEntry(epoch, 1000));
+    wheel.Insert(entries.back());
+  }
+  wheel.Advance(epoch + 999*tick, expired);
+  ASSERT_TRUE(expired.empty());
+  wheel.Advance(epoch + 5000*tick, expired);
+  ASSERT_EQ(expired.size(), entries.size());
+  size_t i = 0;
+  for (EntryList::iterator it=expired.begin(); it!=expired.end(); ++it, ++i) {
+    ASSERT_EQ(it->get(), entries[i].get()) << "entry " << i << " out of order";
+  }
+}
+
+TEST(aliSystemThreadingTimerWheel, roundsUpAndPast) {
+  Time::TP   epoch;
+  TimerWheel wheel(epoch, tick);
+  EntryList  expired;
+  Entry::Ptr between = MakeEntry(epoch, 10);
+  between->targetTime += tick/2;
+  wheel.Insert(between);
+  wheel.Advance(epoch + 10*tick, expired);
+  ASSERT_TRUE(expired.empty()) << "released before its target time";
+  wheel.Advance(epoch + 11*tick, expired);
+  ASSERT_EQ(expired.size(), 1u);
+  expired.clear();
+  // an entry in the past expires in the next tick
+  wheel.Insert(MakeEntry(epoch, 3));
+  wheel.Advance(epoch + 11*tick, expired);
+  ASSERT_TRUE(expired.empty());
+  wheel.Advance(epoch + 12*tick, expired);
+  ASSERT_EQ(expired.size(), 1u);
+  Time::TP tp;
+  ASSERT_FALSE(wheel.NextTime(tp));
+}
+
+TEST(aliSystemThreadingTimerWheel, remove) {
+  Time::TP   epoch;
+  TimerWheel wheel(epoch, tick);
+  EntryList  expired;
+  Entry::Ptr near  = MakeEntry(epoch, 5);
+  Entry::Ptr far   = MakeEntry(epoch, 100000);
+  Entry::Ptr keep  = MakeEntry(epoch, 300);
+  wheel.Insert(near);
+  wheel.Insert(far);
+  wheel.Insert(keep);
+  ASSERT_TRUE (wheel.Remove(near));
+  ASSERT_FALSE(wheel.Remove(near)) << "removed twice";
+  ASSERT_TRUE (wheel.Remove(far));
+  ASSERT_EQ(wheel.Size(), 1u);
+  wheel.Advance(epoch + 200000*tick, expired);
+  ASSERT_EQ(expired.size(), 1u);
+  ASSERT_EQ(expired.front().get(), keep.get());
+  ASSERT_FALSE(wheel.Remove(keep)) << "removed after expiring";
+  // an entry that cascaded down a level can still be removed
+  Entry::Ptr cascaded = MakeEntry(epoch, 200000+1000);
+  wheel.Insert(cascaded);
+  wheel.Advance(epoch + (200000+900)*tick, expired);
+  ASSERT_TRUE(wheel.Remove(cascaded));
+  ASSERT_EQ(wheel.Size(), 0u);
+  Time::TP tp;
+  ASSERT_FALSE(wheel.NextTime(tp));
+}
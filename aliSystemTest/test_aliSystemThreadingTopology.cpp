@@ -0,0 +1,34 @@
+#include "gtest/gtest.h"
+#include <aliSystem.hpp>
+
+namespace {
+  using Topology = aliSystem::Threading::Topology;
+  using CpuVec   = Topology::CpuVec;
+}
+
+TEST(aliSystemThreadingTopology, parseCpuList) {
+  CpuVec cpus;
+  Topology::ParseCpuList("0-3,8,10-11\n", cpus);
+  CpuVec expected = { 0, 1, 2, 3, 8, 10, 11 };
+  ASSERT_EQ(cpus, expected);
+  cpus.clear();
+  Topology::ParseCpuList("", cpus);
+  ASSERT_TRUE(cpus.empty());
+  ASSERT_THROW(Topology::ParseCpuList("3-1",  cpus), std::exception);
+  ASSERT_THROW(Topology::ParseCpuList("1,",   cpus), std::exception);
+  ASSERT_THROW(Topology::ParseCpuList("1,,2", cpus), std::exception);
+  ASSERT_THROW(Topology::ParseCpuList("x",    cpus), std::exception);
+}
+
+TEST(aliSystemThreadingTopology, layout) {
+  ASSERT_GE(Topology::NumNodes(), 1u);
+  for (size_t node=0;node<Topology::NumNodes();++node) {
+    const CpuVec &cpus = Topology::NodeCpus(node);
+    for (size_t i=0;i<cpus.size();++i) {
+      ASSERT_EQ(Topology::NodeOfCpu(cpus[i]), (int)node);
+    }
+  }
+  ASSERT_THROW(Topology::NodeCpus(Topology::NumNodes()), std::exception);
+  ASSERT_THROW(Topology::NodeCpus(-1), std::exception);
+  ASSERT_GE(Topology::NodeOfCpu(Topology::CurrentCpu()), 0);
+}
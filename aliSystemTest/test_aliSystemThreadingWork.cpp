@@ -1,8 +1,10 @@
 #include "gtest/gtest.h"
 #include <aliSystem.hpp>
+#include <thread>
 
 namespace {
   using Stats = aliSystem::Stats;
+  using Time  = aliSystem::Time;
   using Work  = aliSystem::Threading::Work;
   using IPtr  = std::shared_ptr<size_t>;
 }
@@ -29,3 +31,38 @@ TEST(aliSystemThreadingWork, general) {
   ASSERT_TRUE(requeue);
 }
 
+
+TEST(aliSystemThreadingWork, deadline) {
+  bool      requeue  = false;
+  size_t    expired  = 0;
+  Time::TP  deadline = Time::Now();
+  Work::Ptr plain    = Work::Create(nullptr, [](bool &) {});
+  Work::Ptr timed    = Work::Create(nullptr, [](bool &) {}, deadline, [&]() { ++expired; });
+  ASSERT_FALSE(plain->HasDeadline());
+  ASSERT_FALSE(plain->IsExpired(Time::TP::max()));
+  ASSERT_TRUE (timed->HasDeadline());
+  ASSERT_EQ   (timed->GetDeadline(), deadline);
+  ASSERT_FALSE(timed->IsExpired(deadline));
+  ASSERT_TRUE (timed->IsExpired(deadline+std::chrono::nanoseconds(1)));
+  timed->Run(requeue);
+  ASSERT_EQ(expired, 0u) << "running does not expire the work";
+  timed->Expire();
+  plain->Expire();
+  ASSERT_EQ(expired, 1u);
+}
+
+TEST(aliSystemThreadingWork, runAndWait) {
+  using Worker = aliSystem::Threading::Worker;
+  Worker::Ptr worker = Worker::Create("runAndWait", Worker::Idle::PARK, nullptr);
+  std::thread::id ran;
+  Work::RunAndWait(nullptr,
+		   [&](Work::Ptr &&w) { worker->AddWork(std::move(w)); },
+		   [&]() { ran = std::this_thread::get_id(); });
+  ASSERT_NE(ran, std::thread::id());
+  ASSERT_NE(ran, std::this_thread::get_id()) << "run on the worker";
+  // a failure on the worker reaches the caller instead of leaving it waiting
+  ASSERT_THROW(Work::RunAndWait(nullptr,
+				[&](Work::Ptr &&w) { worker->AddWork(std::move(w)); },
+				[]() { THROW("state init failed"); }),
+	       std::exception);
+}
@@ -0,0 +1,129 @@
+#include "gtest/gtest.h"
+#include <aliSystem.hpp>
+#include <thread>
+#include <vector>
+
+namespace {
+  using Stats    = aliSystem::Stats;
+  using Work     = aliSystem::Threading::Work;
+  using WorkList = aliSystem::Threading::WorkList;
+  using WVec     = std::vector<Work::Ptr>;
+
+  WVec MakeWork(size_t num) {
+    WVec       rtn;
+    Stats::Ptr stats = Stats::Create("work list testing");
+    for (size_t i=0;i<num;++i) {
+      rtn.push_back(Work::Create(stats, [](bool &) {}));
+    }
+    return rtn;
+  }
+}
+
+TEST(aliSystemThreadingWorkList, order) {
+  // enough work to span several segments
+  WVec      works = MakeWork(1000);
+  WorkList  list;
+  Work::Ptr work;
+  ASSERT_EQ(list.Size(), 0u);
+  ASSERT_FALSE(list.Pop(work));
+  for (size_t round=0;round<3;++round) {
+    for (size_t i=0;i<works.size();++i) {
+      list.Push(works[i]);
+    }
+    ASSERT_EQ(list.Size(), works.size());
+    for (size_t i=0;i<works.size();++i) {
+      ASSERT_TRUE(list.Pop(work));
+      ASSERT_EQ(work.get(), works[i].get()) << "round " << round << " item " << i;
+    }
+    ASSERT_EQ(list.Size(), 0u);
+    ASSERT_FALSE(list.Pop(work));
+  }
+}
+
+TEST(aliSystemThreadingWorkList, pushMany) {
+  WVec      works = MakeWork(150);
+  WorkList  list;
+  Work::Ptr work;
+  list.Push(works[0]);
+  list.Push(&works[1], works.size()-1);
+  list.Push(&works[0], 0);
+  ASSERT_EQ(list.Size(), works.size());
+  for (size_t i=0;i<works.size();++i) {
+    ASSERT_TRUE(list.Pop(work));
+    ASSERT_EQ(work.get(), works[i].get()) << "item " << i;
+  }
+}
+
+TEST(aliSystemThreadingWorkList, clear) {
+  WVec      works = MakeWork(100);
+  WorkList  list;
+  Work::Ptr work;
+  list.Push(&works[0], works.size());
+  ASSERT_EQ(list.Clear(), works.size());
+  ASSERT_EQ(list.Size(), 0u);
+  ASSERT_FALSE(list.Pop(work));
+  list.Push(works[7]);
+  ASSERT_TRUE(list.Pop(work));
+  ASSERT_EQ(work.get(), works[7].get());
+}
+
+TEST(aliSystemThreadingWorkList, enqueued) {
+  using Time = aliSystem::Time;
+  WorkList  list;
+  WVec      works = MakeWork(3);
+  Time::TP  t1    = Time::Now();
+  Time::TP  t2    = t1 + std::chrono::seconds(1);
+  Work::Ptr work;
+  Time::TP  enqueued;
+  // the same work may be pushed again with its own time
+  list.Push(works[0], t1);
+  list.Push(works[0], t2);
+  list.Push(works.data()+1, 2);
+  ASSERT_TRUE(list.Pop(work, enqueued));
+  ASSERT_EQ(enqueued, t1);
+  ASSERT_TRUE(list.Pop(work, enqueued));
+  ASSERT_EQ(enqueued, t2);
+  ASSERT_TRUE(list.Pop(work, enqueued));
+  ASSERT_EQ(enqueued, Time::TP()) << "no time given";
+}
+
+TEST(aliSystemThreadingWorkList, concurrentProducers) {
+  using TVec = std::vector<std::thread>;
+  const size_t numProducers = 4;
+  const size_t numItems     = 20000;
+  WorkList     list;
+  WVec         works = MakeWork(numProducers);
+  TVec         producers;
+  std::atomic<bool> start(false);
+  for (size_t p=0;p<numProducers;++p) {
+    producers.push_back(std::thread([&, p]() {
+	  while (!start) {
+	    std::this_thread::yield();
+	  }
+	  for (size_t i=0;i<numItems;++i) {
+	    list.Push(works[p]);
+	  }
+	}));
+  }
+  std::vector<size_t> counts(numProducers, 0);
+  size_t              total = 0;
+  Work::Ptr           work;
+  start = true;
+  while (total<numProducers*numItems) {
+    if (list.Pop(work)) {
+      for (size_t p=0;p<numProducers;++p) {
+	if (work==works[p]) {
+	  ++counts[p];
+	}
+      }
+      ++total;
+    }
+  }
+  for (TVec::iterator it=producers.begin(); it!=producers.end(); ++it) {
+    it->join();
+  }
+  ASSERT_EQ(list.Size(), 0u);
+  for (size_t p=0;p<numProducers;++p) {
+    ASSERT_EQ(counts[p], numItems) << "producer " << p;
+  }
+}
@@ -0,0 +1,122 @@
+#include "gtest/gtest.h"
+#include <aliSystem.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+  using Stats    = aliSystem::Stats;
+  using Time     = aliSystem::Time;
+  using Work     = aliSystem::Threading::Work;
+  using Worker   = aliSystem::Threading::Worker;
+  using Sem      = aliSystem::Threading::Semaphore;
+  using Listener = Worker::WListener;
+  using TVec     = std::vector<std::thread>;
+
+  void WaitIdle(const Worker::Ptr &worker) {
+    while (worker->IsBusy()) {
+      std::this_thread::yield();
+    }
+  }
+
+  // every work unit runs on the worker's thread and in the order added
+  void CheckOrder(Worker::Idle idle) {
+    const size_t numProducers = 4;
+    const size_t numItems     = 2000;
+    Worker::Ptr              worker = Worker::Create("worker order", idle, Stats::Create("worker stats"));
+    std::vector<size_t>      last(numProducers, 0);
+    std::atomic<size_t>      misordered(0);
+    std::atomic<size_t>      offThread(0);
+    TVec                     producers;
+    for (size_t p=0;p<numProducers;++p) {
+      producers.push_back(std::thread([&, p]() {
+	    for (size_t i=1;i<=numItems;++i) {
+	      worker->AddWork(Work::Create(nullptr, [&, p, i](bool &) {
+		    if (!worker->IsWorkerThread()) {
+		      ++offThread;
+		    }
+		    if (last[p]+1!=i) {
+		      ++misordered;
+		    }
+		    last[p] = i;
+		  }));
+	    }
+	  }));
+    }
+    for (TVec::iterator it=producers.begin(); it!=producers.end(); ++it) {
+      it->join();
+    }
+    WaitIdle(worker);
+    ASSERT_EQ(worker->NumRun(), numProducers*numItems) << idle;
+    ASSERT_EQ(misordered, 0u) << idle;
+    ASSERT_EQ(offThread,  0u) << idle;
+    ASSERT_FALSE(worker->IsWorkerThread());
+    worker->Stop();
+    ASSERT_TRUE(worker->IsStopped());
+  }
+}
+
+TEST(aliSystemThreadingWorker, spin)  { CheckOrder(Worker::Idle::SPIN);  }
+TEST(aliSystemThreadingWorker, yield) { CheckOrder(Worker::Idle::YIELD); }
+TEST(aliSystemThreadingWorker, park)  { CheckOrder(Worker::Idle::PARK);  }
+
+TEST(aliSystemThreadingWorker, workerThreadAtStart) {
+  // the worker's thread knows itself before it runs its first work unit
+  std::atomic<size_t> offThread(0);
+  for (size_t i=0;i<50;++i) {
+    Worker::Ptr worker = Worker::Create("worker start", Worker::Idle::SPIN, nullptr);
+    worker->AddWork(Work::Create(nullptr, [&, worker](bool &) {
+	  if (!worker->IsWorkerThread()) {
+	    ++offThread;
+	  }
+	}));
+    WaitIdle(worker);
+    worker->Stop();
+  }
+  ASSERT_EQ(offThread, 0u);
+}
+
+TEST(aliSystemThreadingWorker, parkAndWake) {
+  Worker::Ptr worker = Worker::Create("worker park", Worker::Idle::PARK, nullptr);
+  Sem         ran;
+  for (size_t i=0;i<5;++i) {
+    // give the thread time to go to sleep before each work unit
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    worker->AddWork(Work::Create(nullptr, [&](bool &) { ran.Post(); }));
+    ASSERT_EQ(ran.TimedWait(std::chrono::seconds(5)), 0) << "a parked worker was not woken";
+  }
+  ASSERT_GE(worker->NumParked(), 5u);
+  worker->SetIdle(Worker::Idle::SPIN);
+  ASSERT_EQ(worker->GetIdle(), Worker::Idle::SPIN);
+  worker->AddWork(Work::Create(nullptr, [&](bool &) { ran.Post(); }));
+  ASSERT_EQ(ran.TimedWait(std::chrono::seconds(5)), 0);
+  worker->Stop();
+}
+
+TEST(aliSystemThreadingWorker, requeueExpireIdle) {
+  Worker::Ptr   worker = Worker::Create("worker misc", Worker::Idle::YIELD, nullptr);
+  size_t        count  = 0;
+  bool          expired = false;
+  Sem           idle;
+  Listener::Ptr lPtr   = Listener::Create("worker idle", [&](const Worker::WPtr &) { idle.Post(); });
+  worker->OnIdle()->Register(lPtr, true);
+  Work::Ptr     works[2] = {
+    Work::Create(nullptr, [&](bool &requeue) { requeue = ++count<3; }),
+    Work::Create(nullptr, [&](bool &) { count += 100; },
+		 Time::Now()-std::chrono::seconds(1), [&]() { expired = true; })
+  };
+  worker->AddWorkBatch(works, 2);
+  ASSERT_EQ(idle.TimedWait(std::chrono::seconds(5)), 0);
+  ASSERT_EQ(count, 3u) << "requeued work ran again, expired work did not run";
+  ASSERT_TRUE(expired);
+  ASSERT_EQ(worker->NumExpired(), 1u);
+  ASSERT_EQ(worker->NumRun(),     3u);
+  // a worker can be stopped from its own thread
+  worker->AddWork(Work::Create(nullptr, [=](bool &) { worker->Stop(); }));
+  while (!worker->IsStopped()) {
+    std::this_thread::yield();
+  }
+  worker->AddWork(Work::Create(nullptr, [&](bool &) { ++count; }));
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ASSERT_EQ(count, 3u) << "work ran after the worker stopped";
+}
@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 #include <aliSystem.hpp>
+#include <thread>
 #include <time.h>
 
 namespace {
@@ -42,3 +43,16 @@ TEST(aliSystemTime, ToFromTimeSpec) {
   double          b               = Time::ToSeconds(nowFromTimeSpec.time_since_epoch());
   ASSERT_NEAR(a,b,1);
 }
+
+TEST(aliSystemTime, Ticks) {
+  ASSERT_GT(Time::TicksPerSecond(), 0);
+  Time::TP start = Time::Now();
+  uint64_t a     = Time::Ticks();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  uint64_t b     = Time::Ticks();
+  double   real  = Time::ToSeconds(Time::Now()-start);
+  ASSERT_GE(b, a);
+  double   tol   = 0.002;
+  ASSERT_NEAR(Time::ToSeconds(Time::FromTicks(b-a)), real, tol);
+  ASSERT_EQ(Time::FromTicks(0), Time::Dur::zero());
+}
@@ -0,0 +1,106 @@
+#include "gtest/gtest.h"
+#include <aliSystem.hpp>
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+  using Pool  = aliSystem::Threading::Pool;
+  using Queue = aliSystem::Threading::Queue;
+  using Stats = aliSystem::Stats;
+  using Trace = aliSystem::Trace;
+  using Work  = aliSystem::Threading::Work;
+  std::chrono::milliseconds ms(1);
+
+  std::string Dump() {
+    std::ostringstream out;
+    Trace::Dump(out);
+    return out.str();
+  }
+}
+
+TEST(aliSystemTrace, disabled) {
+  Trace::Stop();
+  Trace::Start();
+  Trace::Stop();
+  ASSERT_FALSE(Trace::IsEnabled());
+  if (true) {
+    Trace::Span span("disabled span", "test");
+  }
+  ASSERT_EQ(Trace::NumEvents(), 0u);
+  ASSERT_EQ(Dump().find("disabled span"), std::string::npos);
+}
+
+TEST(aliSystemTrace, spans) {
+  Trace::Start();
+  ASSERT_TRUE(Trace::IsEnabled());
+  std::thread t([]() {
+      const std::string value("a \"quoted\" value");
+      Trace::SetThreadName("span thread");
+      Trace::Span outer("outer", "test", "arg", value);
+      std::this_thread::sleep_for(2*ms);
+      const std::string name("inner");
+      Trace::Span       inner(name, "test");
+    });
+  t.join();
+  Trace::Stop();
+  ASSERT_EQ(Trace::NumEvents(), 2u);
+  std::string json = Dump();
+  ASSERT_EQ(json.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["), 0u);
+  ASSERT_NE(json.find("\"args\":{\"name\":\"span thread\"}"), std::string::npos);
+  ASSERT_NE(json.find("{\"name\":\"outer\",\"cat\":\"test\",\"ph\":\"X\""), std::string::npos);
+  ASSERT_NE(json.find("\"args\":{\"arg\":\"a \\\"quoted\\\" value\"}"), std::string::npos);
+  ASSERT_NE(json.find("{\"name\":\"inner\""), std::string::npos);
+
+  // starting again discards the spans of exited threads
+  Trace::Start();
+  Trace::Stop();
+  ASSERT_EQ(Trace::NumEvents(), 0u);
+  ASSERT_EQ(Dump().find("span thread"), std::string::npos);
+}
+
+TEST(aliSystemTrace, queue) {
+  Pool::Ptr           pool  = Pool::Create("tracePool", 2);
+  Queue::Ptr          queue = pool->AddQueue("traceQueue", 2, Stats::Create("traceQueueStats"));
+  std::atomic<size_t> count(0);
+  Work::Ptr           work  = Work::Create(Stats::Create("traceWork"), [&count](bool &) { ++count; });
+  Trace::Start();
+  for (size_t i=0;i<10;++i) {
+    queue->AddWork(work);
+  }
+  while (count<10) {
+    std::this_thread::sleep_for(ms);
+  }
+  queue->Stop();
+  Trace::Stop();
+  std::string json = Dump();
+  ASSERT_NE(json.find("{\"name\":\"enqueue\",\"cat\":\"queue\""), std::string::npos) << json;
+  ASSERT_NE(json.find("{\"name\":\"queued\",\"cat\":\"queue\""), std::string::npos) << json;
+  ASSERT_NE(json.find("\"args\":{\"queue\":\"traceQueue\"}"), std::string::npos) << json;
+  ASSERT_NE(json.find("\"args\":{\"stats\":\"traceWork\"}"), std::string::npos) << json;
+  ASSERT_NE(json.find("\"args\":{\"name\":\"tracePool-0\"}"), std::string::npos) << json;
+}
+
+TEST(aliSystemTrace, capacity) {
+  Trace::Start(5);
+  for (size_t i=0;i<8;++i) {
+    Trace::Span span("span", "test");
+  }
+  Trace::Stop();
+  ASSERT_EQ(Trace::NumEvents(), 5u);
+  ASSERT_EQ(Trace::NumDropped(), 3u);
+  ASSERT_THROW(Trace::Start(0), std::exception);
+}
+
+TEST(aliSystemTrace, earlierSpans) {
+  aliSystem::Time::TP before = aliSystem::Time::Now();
+  Trace::Start();
+  Trace::Record("before", "test", nullptr, std::string(), before, aliSystem::Time::Now());
+  Trace::Record("after", "test", nullptr, std::string(), aliSystem::Time::Now(), aliSystem::Time::Now());
+  Trace::Stop();
+  ASSERT_EQ(Trace::NumEvents(), 1u);
+  std::string json = Dump();
+  ASSERT_EQ(json.find("\"before\""), std::string::npos);
+  ASSERT_NE(json.find("\"after\""), std::string::npos);
+}
@@ -5,7 +5,9 @@
 #include <app2.hpp>
 #include <app3.hpp>
 #include <app4.hpp>
+#include <cstdlib>
 #include <exception>
+#include <string>
 
 const int RC_OK                = 0;
 const int RC_ERROR_THROWN      = 1;
@@ -43,6 +45,13 @@ int main(int argc, char *argv[]) {
       app3::RegisterInitFini(cr);
       app4::RegisterInitFini(cr);
       cr.Init();
+      // ALI_ASYNC_LOG=1 hands log lines to a background writer, so pool
+      // threads logging from Lua do not wait for stdout (scripts can
+      // also use lib.aliLua.io.StartAsyncLog)
+      const char *asyncLog = std::getenv("ALI_ASYNC_LOG");
+      if (asyncLog && *asyncLog && std::string(asyncLog)!="0") {
+	aliSystem::Logging::StartAsync();
+      }
 
       std::string     engineName = "engineName";
       std::string     poolName   = "poolName";